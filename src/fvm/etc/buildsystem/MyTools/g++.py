@@ -33,6 +33,9 @@ def generate(env):
 
     if env['OPENMP']:
         env.Append(CXXFLAGS=['-fopenmp'])
+    else:
+        # the omp pragmas are left in place for the serial builds
+        env.Append(CXXFLAGS=['-Wno-unknown-pragmas'])
 
     if env['PARALLEL']:
         env['CXX'] = 'mpicxx'
@@ -52,6 +52,7 @@ class COMETESBGKDiscretizer
   typedef Vector<T,10> VectorT10; 
   typedef Array<VectorT10> VectorT10Array;
   typedef DistFunctFields<T> TDistFF;
+  typedef typename TDistFF::DirectionView DirectionView;
   typedef Quadrature<T> TQuad;
   typedef Gradient<T> GradType;
   typedef Array<GradType> GradArray;
@@ -64,7 +65,8 @@ class COMETESBGKDiscretizer
 			const T dT, const int order, const bool transient,const T underRelaxation,
 			const T rho_init, const T T_init, const T MW, const int conOrder,
 			COMETBCMap& bcMap, map<int, vector<int> > faceReflectionArrayMap,
-			const IntArray& BCArray, const IntArray& BCfArray,const IntArray& ZCArray):
+			const IntArray& BCArray, const IntArray& BCfArray,const IntArray& ZCArray,
+			const bool cellMajor=false):
   _mesh(mesh),
     _geomFields(geomfields),
     _cells(mesh.getCells()),
@@ -114,10 +116,13 @@ class COMETESBGKDiscretizer
   _temperature(dynamic_cast<TArray&>(_macroFields.temperature[_cells])),
   _stress(dynamic_cast<VectorT6Array&>(_macroFields.Stress[_cells])),
   _collisionFrequency(dynamic_cast<TArray&>(_macroFields.collisionFrequency[_cells])),
-  _coeffg(dynamic_cast<VectorT10Array&>(_macroFields.coeffg[_cells]))
+  _coeffg(dynamic_cast<VectorT10Array&>(_macroFields.coeffg[_cells])),
+  _cellMajor(cellMajor),
+  _fDirections(),
+  _fBlock(0),
+  _fBlockStride(0)
 
   {
-    _fArrays = new TArray*[_numDir];
     _fN1Arrays = new TArray*[_numDir];
     _fN2Arrays = new TArray*[_numDir];
     _fEqESArrays = new TArray*[_numDir];
@@ -126,14 +131,12 @@ class COMETESBGKDiscretizer
     
     for(int direction=0;direction<_numDir;direction++)
     {
-        Field& fnd = *_dsfPtr.dsf[direction];
         Field& fN1nd = *_dsfPtr1.dsf[direction];
         Field& fN2nd = *_dsfPtr2.dsf[direction];
         Field& fndEqES = *_dsfEqPtrES.dsf[direction];
         Field& fndRes = *_dsfPtrRes.dsf[direction];
         Field& fndFAS = *_dsfPtrFAS.dsf[direction];
 
-        _fArrays[direction] = &dynamic_cast<TArray&>(fnd[_cells]); 
 	_fEqESArrays[direction] = &dynamic_cast<TArray&>(fndEqES[_cells]);
         _fResArrays[direction] = &dynamic_cast<TArray&>(fndRes[_cells]);
 	if (fN1nd.hasArray(_cells))
@@ -147,89 +150,104 @@ class COMETESBGKDiscretizer
     if (_macroFields.velocityFASCorrection.hasArray(_cells))
       _velocityFASCorrection = &dynamic_cast<VectorT3Array&>
         (_macroFields.velocityFASCorrection[_cells]);
+  }
+
+  /**
+   * With cellMajor the sweeps and the residual work on the cell-major
+   * block of _dsfPtr so that the directions of a cell are next to each
+   * other. The sweeps copy it back to the direction arrays at the end, so
+   * as long as the model has not changed the arrays itself the next sweep
+   * or residual only copies the ghost cells in again. Otherwise they work
+   * on the direction arrays themselves.
+   */
+  void loadValues()
+  {
+    if (_cellMajor)
+    {
+        _fBlock = &_dsfPtr.gatherBlock(_cells)[0];
+        _fBlockStride = _dsfPtr.getBlockStride();
+    }
+    else if (_fDirections.empty())
+    {
+        for(int dir=0;dir<_numDir;dir++)
+          _fDirections.push_back(&dynamic_cast<TArray&>((*_dsfPtr.dsf[dir])[_cells])[0]);
+    }
+  }
+
+  void storeValues()
+  {
+    if (_cellMajor)
+      _dsfPtr.scatterBlock(_cells);
+  }
 
+  DirectionView fDirection(const int dir) const
+  {
+    if (_cellMajor)
+      return DirectionView(_fBlock+dir,_fBlockStride);
+    return DirectionView(_fDirections[dir],1);
   }
 
-    void COMETSolveFine(const int sweep, const int level)
+  void getCellValues(const int c, TArray& fVal) const
+  {
+    if (_cellMajor)
     {
-      const int cellcount=_cells.getSelfCount();
-      const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
-      int start;
-      
-      if(sweep==1)
-        start=0;
-      if(sweep==-1)
-        start=cellcount-1;
+        const T* fc = _fBlock + c*_fBlockStride;
+        for(int dir=0;dir<_numDir;dir++)
+          fVal[dir]=fc[dir];
+    }
+    else
+      for(int dir=0;dir<_numDir;dir++)
+        fVal[dir]=_fDirections[dir][c];
+  }
 
-      TArray Bvec(_numDir+3);
-      TArray Resid(_numDir+3);
-      TArrow AMat(_numDir+3);
+  /**
+   * Gauss-Seidel sweep over the owned cells in the second order scheme,
+   * forward (sweep=1) or backward (sweep=-1). With more than one thread
+   * the cells are visited by colour instead, see COMETSolveColored.
+   */
+  void COMETSolveFine(const int sweep, const int level, const int nThreads=1)
+  {
+    loadValues();
+    if (nThreads > 1)
+    {
+        COMETSolveColored(sweep,level,true,nThreads);
+        storeValues();
+        return;
+    }
 
-      TArray fVal(_numDir);
+    const int cellcount=_cells.getSelfCount();
+    const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
+    int start;
 
-      GradMatrix& gradMatrix=GradModelType::getGradientMatrix(_mesh,_geomFields);
+    if(sweep==1)
+      start=0;
+    if(sweep==-1)
+      start=cellcount-1;
 
-      for(int c=start;((c<cellcount)&&(c>-1));c+=sweep)
-	{
-          if (ibType[c] == Mesh::IBTYPE_FLUID){
-            for(int dir=0;dir<_numDir;dir++)
-              fVal[dir]=(*_fArrays[dir])[c];
-            if(_BCArray[c]==0)
-	      {
-                Bvec.zero();
-                Resid.zero();
-                AMat.zero();
-            
-                if(_transient)
-                  COMETUnsteady(c,&AMat,Bvec);
+    TArray Bvec(_numDir+3);
+    TArray Resid(_numDir+3);
+    TArrow AMat(_numDir+3);
 
-                COMETConvectionFine(c,AMat,Bvec,cellcount,gradMatrix);
-                COMETTest(c,&AMat,Bvec,fVal);
-                //COMETCollision(c,&AMat,Bvec);
-                //COMETMacro(c,&AMat,Bvec);
+    TArray fVal(_numDir);
 
-                if(level>0)
-                  addFAS(c,Bvec);
+    GradMatrix& gradMatrix=GradModelType::getGradientMatrix(_mesh,_geomFields);
 
-                Resid=Bvec;
-            
-                AMat.Solve(Bvec);
-                Distribute(c,Bvec,Resid);
-                setBoundaryValFine(c,cellcount,gradMatrix);
-                //ComputeMacroparameters(c);            
-	      }
-            else if(_BCArray[c]==1)
-	      {
-                Bvec.zero();
-                Resid.zero();
-                AMat.zero();
-
-                if(_transient)
-                  COMETUnsteady(c,&AMat,Bvec);
-
-                COMETConvectionFine(c,AMat,Bvec,gradMatrix);
-                COMETTest(c,&AMat,Bvec,fVal);
-                //COMETCollision(c,&AMat,Bvec);
-                //COMETMacro(c,&AMat,Bvec);
-
-                if(level>0)
-                  addFAS(c,Bvec);
-           
-                Resid=Bvec;
-
-                AMat.Solve(Bvec);
-                Distribute(c,Bvec,Resid);
-                setBoundaryValFine(c,cellcount,gradMatrix);
-                //ComputeMacroparameters(c);            
-	      }
-            else
-              throw CException("Unexpected value for boundary cell map.");
-          }
-	}
+    for(int c=start;((c<cellcount)&&(c>-1));c+=sweep)
+      if (ibType[c] == Mesh::IBTYPE_FLUID)
+        COMETSolveCellFine(c,level,cellcount,gradMatrix,Bvec,Resid,AMat,fVal);
+    storeValues();
+  }
+
+  void COMETSolve(const int sweep, const int level, const int nThreads=1)
+  {
+    loadValues();
+    if (nThreads > 1)
+    {
+        COMETSolveColored(sweep,level,false,nThreads);
+        storeValues();
+        return;
     }
 
-   void COMETSolve(const int sweep, const int level)
-   {
     const int cellcount=_cells.getSelfCount();
     const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
     int start;
@@ -246,60 +264,129 @@ class COMETESBGKDiscretizer
     TArray fVal(_numDir);
 
     for(int c=start;((c<cellcount)&&(c>-1));c+=sweep)
-    {
-      if (ibType[c] == Mesh::IBTYPE_FLUID){
-        for(int dir=0;dir<_numDir;dir++)
-	  fVal[dir]=(*_fArrays[dir])[c];
-	if(_BCArray[c]==0)
-	{
-	    Bvec.zero();
-	    Resid.zero();
-	    AMat.zero();
-	    
-	    if(_transient)
-	      COMETUnsteady(c,&AMat,Bvec);	
-	
-	    COMETConvection(c,AMat,Bvec,cellcount);
-	    COMETTest(c,&AMat,Bvec,fVal);
-	    //COMETCollision(c,&AMat,Bvec);
-	    //COMETMacro(c,&AMat,Bvec);
-
-            if(level>0)
-              addFAS(c,Bvec);
+      if (ibType[c] == Mesh::IBTYPE_FLUID)
+        COMETSolveCell(c,level,cellcount,Bvec,Resid,AMat,fVal);
+    storeValues();
+  }
 
-	    Resid=Bvec;
-	    
-	    AMat.Solve(Bvec);
-	    Distribute(c,Bvec,Resid);
-	    //ComputeMacroparameters(c);	    
-	}
-        else if(_BCArray[c]==1)
-	{
-	    Bvec.zero();
-	    Resid.zero();
-	    AMat.zero();
+  /**
+   * Multicolour variant of the sweeps above. A cell only changes its own
+   * values and, in the second order scheme, those of its boundary ghosts,
+   * while it reads its neighbours and, for the gradients, theirs too. The
+   * cells of one colour are therefore independent when they are more than
+   * one (first order) or two (second order) cells apart, and are divided
+   * among nThreads threads, each with its own small system. The colours
+   * are taken in reverse order for a backward sweep. The order in which
+   * the cells are updated differs from the sequential sweep.
+   */
+  void COMETSolveColored(const int sweep, const int level, const bool fine,
+                         const int nThreads)
+  {
+    const int cellcount=_cells.getSelfCount();
+    const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
+    const CRConnectivity& cellColors = _mesh.getCellColoring(fine ? 2 : 1);
+    const int nColors = cellColors.getRowDim();
 
-            if(_transient)
-              COMETUnsteady(c,&AMat,Bvec);
+    const GradMatrix* gradMatrix =
+      fine ? &GradModelType::getGradientMatrix(_mesh,_geomFields) : 0;
 
-            COMETConvection(c,AMat,Bvec);
-	    COMETTest(c,&AMat,Bvec,fVal);
-            //COMETCollision(c,&AMat,Bvec);
-            //COMETMacro(c,&AMat,Bvec);
+    string error;
+#pragma omp parallel num_threads(nThreads)
+    {
+      TArray Bvec(_numDir+3);
+      TArray Resid(_numDir+3);
+      TArrow AMat(_numDir+3);
 
-            if(level>0)
-              addFAS(c,Bvec);
-           
-	    Resid=Bvec;
+      TArray fVal(_numDir);
 
-	    AMat.Solve(Bvec);
-	    Distribute(c,Bvec,Resid);
-	    //ComputeMacroparameters(c);	    
-	}
-        else
-          throw CException("Unexpected value for boundary cell map.");
+      for(int n=0;n<nColors;n++)
+      {
+          const int color = (sweep==1) ? n : nColors-1-n;
+          const int colorCount = cellColors.getCount(color);
+#pragma omp for schedule(dynamic,16)
+          for(int i=0;i<colorCount;i++)
+          {
+              const int c=cellColors(color,i);
+              if (ibType[c] != Mesh::IBTYPE_FLUID)
+                continue;
+              try
+              {
+                  if (fine)
+                    COMETSolveCellFine(c,level,cellcount,*gradMatrix,
+                                       Bvec,Resid,AMat,fVal);
+                  else
+                    COMETSolveCell(c,level,cellcount,Bvec,Resid,AMat,fVal);
+              }
+              catch (std::exception& e)
+              {
+#pragma omp critical
+                  error = e.what();
+              }
+          }
       }
     }
+    if (!error.empty())
+      throw CException(error);
+  }
+
+  void COMETSolveCellFine(const int c, const int level, const int cellcount,
+                          const GradMatrix& gradMatrix, TArray& Bvec,
+                          TArray& Resid, TArrow& AMat, TArray& fVal)
+  {
+    getCellValues(c,fVal);
+    if((_BCArray[c]!=0)&&(_BCArray[c]!=1))
+      throw CException("Unexpected value for boundary cell map.");
+
+    Bvec.zero();
+    Resid.zero();
+    AMat.zero();
+
+    if(_transient)
+      COMETUnsteady(c,&AMat,Bvec);
+
+    if(_BCArray[c]==0)
+      COMETConvectionFine(c,AMat,Bvec,cellcount,gradMatrix);
+    else
+      COMETConvectionFine(c,AMat,Bvec,gradMatrix);
+    COMETTest(c,&AMat,Bvec,fVal);
+
+    if(level>0)
+      addFAS(c,Bvec);
+
+    Resid=Bvec;
+
+    AMat.Solve(Bvec);
+    Distribute(c,Bvec,Resid);
+    setBoundaryValFine(c,cellcount,gradMatrix);
+  }
+
+  void COMETSolveCell(const int c, const int level, const int cellcount,
+                      TArray& Bvec, TArray& Resid, TArrow& AMat, TArray& fVal)
+  {
+    getCellValues(c,fVal);
+    if((_BCArray[c]!=0)&&(_BCArray[c]!=1))
+      throw CException("Unexpected value for boundary cell map.");
+
+    Bvec.zero();
+    Resid.zero();
+    AMat.zero();
+
+    if(_transient)
+      COMETUnsteady(c,&AMat,Bvec);
+
+    if(_BCArray[c]==0)
+      COMETConvection(c,AMat,Bvec,cellcount);
+    else
+      COMETConvection(c,AMat,Bvec);
+    COMETTest(c,&AMat,Bvec,fVal);
+
+    if(level>0)
+      addFAS(c,Bvec);
+
+    Resid=Bvec;
+
+    AMat.Solve(Bvec);
+    Distribute(c,Bvec,Resid);
   }
 
   template<class MatrixType>
@@ -354,7 +441,7 @@ class COMETESBGKDiscretizer
     for(int dir=0;dir<_numDir;dir++)
       {
         limitCoeff1[dir]=T(1.e20);
-        const TArray& f = *_fArrays[dir];
+        const DirectionView f = fDirection(dir);
         min1[dir]=f[cell];
         max1[dir]=f[cell];
       }
@@ -375,7 +462,7 @@ class COMETESBGKDiscretizer
 
         for(int dir=0;dir<_numDir;dir++)
 	  {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             Grads[dir].accumulate(Gcoeff,f[cell2]-f[cell]);
             if(min1[dir]>f[cell2])min1[dir]=f[cell2];
             if(max1[dir]<f[cell2])max1[dir]=f[cell2];
@@ -389,7 +476,7 @@ class COMETESBGKDiscretizer
         SuperbeeLimiter lf;
         for(int dir=0;dir<_numDir;dir++)
 	  {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             GradType& grad=Grads[dir];
 
             VectorT3 fVec=faceCoords[face]-cellCoords[cell];
@@ -418,7 +505,7 @@ class COMETESBGKDiscretizer
         for(int dir=0;dir<_numDir;dir++)
           {
             limitCoeff2[dir]=T(1.e20);
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             min2[dir]=f[cell2];
             max2[dir]=f[cell2];
           }
@@ -438,7 +525,7 @@ class COMETESBGKDiscretizer
 
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 NeibGrads[dir].accumulate(Gcoeff,f[cell22]-f[cell2]);
                 if(min2[dir]>f[cell22])min2[dir]=f[cell22];
                 if(max2[dir]<f[cell22])max2[dir]=f[cell22];
@@ -453,7 +540,7 @@ class COMETESBGKDiscretizer
             SuperbeeLimiter lf;
             for(int dir=0;dir<_numDir;dir++)
               {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 GradType& neibGrad=NeibGrads[dir];
 
                 VectorT3 fVec=faceCoords[f1]-cellCoords[cell2];
@@ -466,7 +553,7 @@ class COMETESBGKDiscretizer
         int count=1;
         for(int dir=0;dir<_numDir;dir++)
 	  {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
             const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
             
@@ -574,7 +661,7 @@ class COMETESBGKDiscretizer
         int count=1;
         for(int dir=0;dir<_numDir;dir++)
 	{
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
             const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
             
@@ -637,7 +724,7 @@ class COMETESBGKDiscretizer
     for(int dir=0;dir<_numDir;dir++)
       {
         limitCoeff1[dir]=T(1.e20);
-        const TArray& f = *_fArrays[dir];
+        const DirectionView f = fDirection(dir);
         min1[dir]=f[cell];
         max1[dir]=f[cell];
       }
@@ -658,7 +745,7 @@ class COMETESBGKDiscretizer
 
         for(int dir=0;dir<_numDir;dir++)
           {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             Grads[dir].accumulate(Gcoeff,f[cell2]-f[cell]);
             if(min1[dir]>f[cell2])min1[dir]=f[cell2];
             if(max1[dir]<f[cell2])max1[dir]=f[cell2];
@@ -672,7 +759,7 @@ class COMETESBGKDiscretizer
         SuperbeeLimiter lf;
         for(int dir=0;dir<_numDir;dir++)
           {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             GradType& grad=Grads[dir];
 
             VectorT3 fVec=faceCoords[face]-cellCoords[cell];
@@ -701,7 +788,7 @@ class COMETESBGKDiscretizer
         for(int dir=0;dir<_numDir;dir++)
           {
             limitCoeff2[dir]=T(1.e20);
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             min2[dir]=f[cell2];
             max2[dir]=f[cell2];
           }
@@ -721,7 +808,7 @@ class COMETESBGKDiscretizer
 
             for(int dir=0;dir<_numDir;dir++)
               {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 NeibGrads[dir].accumulate(Gcoeff,f[cell22]-f[cell2]);
                 if(min2[dir]>f[cell22])min2[dir]=f[cell22];
                 if(max2[dir]<f[cell22])max2[dir]=f[cell22];
@@ -736,7 +823,7 @@ class COMETESBGKDiscretizer
             SuperbeeLimiter lf;
             for(int dir=0;dir<_numDir;dir++)
               {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 GradType& neibGrad=NeibGrads[dir];
 
                 VectorT3 fVec=faceCoords[f1]-cellCoords[cell2];
@@ -768,7 +855,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir1=0;dir1<_numDir;dir1++)
 	      {
-                const TArray& f = *_fArrays[dir1];
+                const DirectionView f = fDirection(dir1);
                 const T fwall = 1.0/pow(pi*Twall,1.5)*exp(-(pow(_cx[dir1]-uwall,2.0)+pow(_cy[dir1]-vwall,2.0)+pow(_cz[dir1]-wwall,2.0))/Twall);
                 flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
                 const T c_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
@@ -805,7 +892,7 @@ class COMETESBGKDiscretizer
             count=1;
             for(int dir1=0;dir1<_numDir;dir1++)
 	      {
-                const TArray& f = *_fArrays[dir1];
+                const DirectionView f = fDirection(dir1);
                 flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
                 const T c1_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
                 if((c1_dot_en-wallV_dot_en)<T_Scalar(0))
@@ -814,7 +901,7 @@ class COMETESBGKDiscretizer
                     if(m1alpha!=zero)
 		      {
                         const int direction_incident = vecReflection[dir1];
-                        const TArray& dsfi = *_fArrays[direction_incident];
+                        const DirectionView dsfi = fDirection(direction_incident);
                         GradType& grad=Grads[direction_incident];
                         VectorT3 fVec=faceCoords[face]-cellCoords[cell];
                         T SOU=(grad[0]*fVec[0]+grad[1]*fVec[1]+grad[2]*fVec[2]);
@@ -895,7 +982,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
                 GradType& grad=Grads[count-1];
@@ -936,7 +1023,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
                 GradType& grad=Grads[count-1];
@@ -969,7 +1056,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir1=0;dir1<_numDir;dir1++)
 	      {
-                const TArray& f = *_fArrays[dir1];
+                const DirectionView f = fDirection(dir1);
                 flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
                 const T c_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
                 GradType& grad=Grads[count-1];
@@ -988,7 +1075,7 @@ class COMETESBGKDiscretizer
                 else
 		  {
                     const int direction_incident = vecReflection[dir1];
-                    const TArray& dsfi = *_fArrays[direction_incident];
+                    const DirectionView dsfi = fDirection(direction_incident);
                     BVec[count-1]-=flux*dsfi[cell];
 		  }
                 count++;
@@ -999,7 +1086,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1030,7 +1117,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1071,7 +1158,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	      {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1133,7 +1220,7 @@ class COMETESBGKDiscretizer
 	    int count=1;
 	    for(int dir1=0;dir1<_numDir;dir1++)
 	    {
-		const TArray& f = *_fArrays[dir1];
+		const DirectionView f = fDirection(dir1);
 		const T fwall = 1.0/pow(pi*Twall,1.5)*exp(-(pow(_cx[dir1]-uwall,2.0)+pow(_cy[dir1]-vwall,2.0)+pow(_cz[dir1]-wwall,2.0))/Twall);
 		flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
 		const T c_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
@@ -1157,7 +1244,7 @@ class COMETESBGKDiscretizer
 	    count=1;
 	    for(int dir1=0;dir1<_numDir;dir1++)
 	    {		
-		const TArray& f = *_fArrays[dir1];
+		const DirectionView f = fDirection(dir1);
 		flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
 		const T c1_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
 		if((c1_dot_en-wallV_dot_en)<T_Scalar(0))
@@ -1166,7 +1253,7 @@ class COMETESBGKDiscretizer
 		    if(m1alpha!=zero)
 		    {
 			const int direction_incident = vecReflection[dir1];
-			const TArray& dsfi = *_fArrays[direction_incident];
+			const DirectionView dsfi = fDirection(direction_incident);
 			//Amat.getElement(count,direction_incident+1)-=flux*m1alpha;
 			BVec[count-1]-=flux*m1alpha*dsfi[cell];
 		    }
@@ -1241,7 +1328,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	    {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1263,7 +1350,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	    {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1286,7 +1373,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir1=0;dir1<_numDir;dir1++)
 	    {
-                const TArray& f = *_fArrays[dir1];
+                const DirectionView f = fDirection(dir1);
                 flux=_cx[dir1]*Af[0]+_cy[dir1]*Af[1]+_cz[dir1]*Af[2];
                 const T c_dot_en = _cx[dir1]*en[0]+_cy[dir1]*en[1]+_cz[dir1]*en[2];
                 if(c_dot_en>T_Scalar(0))
@@ -1297,7 +1384,7 @@ class COMETESBGKDiscretizer
                 else
 		{
                     const int direction_incident = vecReflection[dir1];
-                    const TArray& dsfi = *_fArrays[direction_incident];
+                    const DirectionView dsfi = fDirection(direction_incident);
                     BVec[count-1]-=flux*dsfi[cell];
 		}
                 count++;
@@ -1308,7 +1395,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	    {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1339,7 +1426,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	    {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1358,7 +1445,7 @@ class COMETESBGKDiscretizer
             int count=1;
             for(int dir=0;dir<_numDir;dir++)
 	    {
-                const TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 flux=_cx[dir]*Af[0]+_cy[dir]*Af[1]+_cz[dir]*Af[2];
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
 
@@ -1390,7 +1477,7 @@ class COMETESBGKDiscretizer
     
     for(int direction=0;direction<_numDir;direction++)
     {
-      //const TArray& f = *_fArrays[direction];
+      //const DirectionView f = fDirection(direction);
 	const TArray& fEqES = *_fEqESArrays[direction];
 	coeff =_cellVolume[cell]*_collisionFrequency[cell];
 	
@@ -1436,7 +1523,7 @@ class COMETESBGKDiscretizer
     
     for(int direction=0;direction<_numDir;direction++)
     {
-        const TArray& f = *_fArrays[direction];
+        const DirectionView f = fDirection(direction);
 	coeff =_cellVolume[cell]*_collisionFrequency[cell];
 
 	T C1=(_cx[direction]-v[cell][0]);
@@ -1469,7 +1556,7 @@ class COMETESBGKDiscretizer
     T density(0.);
     for(int dir=0;dir<_numDir;dir++)
     {
-        const TArray& f = *_fArrays[dir];
+        const DirectionView f = fDirection(dir);
 	density+=f[cell]*_wts[dir];
     }
     
@@ -1477,7 +1564,7 @@ class COMETESBGKDiscretizer
 
     for(int dir=0;dir<_numDir;dir++)
     {
-        const TArray& f = *_fArrays[dir];
+        const DirectionView f = fDirection(dir);
         T C1=(_cx[dir]-v[cell][0]);
         T C2=(_cy[dir]-v[cell][1]);
         T C3=(_cz[dir]-v[cell][2]);
@@ -1505,7 +1592,7 @@ class COMETESBGKDiscretizer
 
     for(int direction=0;direction<_numDir;direction++)
     {
-	TArray& f = *_fArrays[direction];
+	const DirectionView f = fDirection(direction);
 	TArray& fRes = *_fResArrays[direction];
         f[cell]-=_underRelaxation*BVec[direction];
 	fRes[cell]=-Rvec[direction];
@@ -1546,7 +1633,7 @@ class COMETESBGKDiscretizer
 
     for(int dir=0;dir<_numDir;dir++)
     {
-	const TArray& f = *_fArrays[dir];
+	const DirectionView f = fDirection(dir);
 	_density[cell] = _density[cell]+_wts[dir]*f[cell];
 	_temperature[cell]= _temperature[cell]+(SQR(_cx[dir])+SQR(_cy[dir])
 					      +SQR(_cz[dir]))*f[cell]*_wts[dir];
@@ -1560,7 +1647,7 @@ class COMETESBGKDiscretizer
 
     for(int dir=0;dir<_numDir;dir++)
     {	  
-	const TArray& f = *_fArrays[dir];
+	const DirectionView f = fDirection(dir);
 	_stress[cell][0] +=SQR((_cx[dir]-v[cell][0]))*f[cell]*_wts[dir];
 	_stress[cell][1] +=SQR((_cy[dir]-v[cell][1]))*f[cell]*_wts[dir];
 	_stress[cell][2] +=SQR((_cz[dir]-v[cell][2]))*f[cell]*_wts[dir];
@@ -1572,6 +1659,7 @@ class COMETESBGKDiscretizer
 
   void findResidFine(const bool plusFAS)
   {
+    loadValues();
     const int cellcount=_cells.getSelfCount();
     const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
 
@@ -1595,8 +1683,7 @@ class COMETESBGKDiscretizer
     for(int c=0;c<cellcount;c++)
       {
         if (ibType[c] == Mesh::IBTYPE_FLUID){
-          for(int dir=0;dir<_numDir;dir++)
-            fVal[dir]=(*_fArrays[dir])[c];
+          getCellValues(c,fVal);
           if(_BCArray[c]==0)
             {
               Bvec.zero();
@@ -1706,6 +1793,7 @@ class COMETESBGKDiscretizer
 
   void findResid(const bool plusFAS)
   {
+    loadValues();
     const int cellcount=_cells.getSelfCount();
     const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[_cells]);
 
@@ -1727,8 +1815,7 @@ class COMETESBGKDiscretizer
     for(int c=0;c<cellcount;c++)
     {
       if (ibType[c] == Mesh::IBTYPE_FLUID){
-        for(int dir=0;dir<_numDir;dir++)
-	  fVal[dir]=(*_fArrays[dir])[c];
+        getCellValues(c,fVal);
 	if(_BCArray[c]==0)
 	{
 	    Bvec.zero();
@@ -1902,7 +1989,7 @@ class COMETESBGKDiscretizer
   {
     for(int dir=0;dir<_numDir;dir++)
     {
-	const TArray& f = *_fArrays[dir];
+	const DirectionView f = fDirection(dir);
 	o[dir]=f[c];
     }
     const VectorT3Array& v = _velocity;
@@ -1927,7 +2014,7 @@ class COMETESBGKDiscretizer
     for(int dir=0;dir<_numDir;dir++)
       {
         limitCoeff1[dir]=T(1.e20);
-        const TArray& f = *_fArrays[dir];
+        const DirectionView f = fDirection(dir);
         min1[dir]=f[cell];
         max1[dir]=f[cell];
       }
@@ -1948,7 +2035,7 @@ class COMETESBGKDiscretizer
 
         for(int dir=0;dir<_numDir;dir++)
           {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             Grads[dir].accumulate(Gcoeff,f[cell2]-f[cell]);
             if(min1[dir]>f[cell2])min1[dir]=f[cell2];
             if(max1[dir]<f[cell2])max1[dir]=f[cell2];
@@ -1962,7 +2049,7 @@ class COMETESBGKDiscretizer
         SuperbeeLimiter lf;
         for(int dir=0;dir<_numDir;dir++)
           {
-            const TArray& f = *_fArrays[dir];
+            const DirectionView f = fDirection(dir);
             GradType& grad=Grads[dir];
 
             VectorT3 fVec=faceCoords[face]-cellCoords[cell];
@@ -1990,7 +2077,7 @@ class COMETESBGKDiscretizer
           {
             for(int dir=0;dir<_numDir;dir++)
               {
-                TArray& f = *_fArrays[dir];
+                const DirectionView f = fDirection(dir);
                 const T c_dot_en = _cx[dir]*en[0]+_cy[dir]*en[1]+_cz[dir]*en[2];
                 GradType& grad=Grads[dir];
                 if(c_dot_en>T_Scalar(0))
@@ -2058,12 +2145,17 @@ class COMETESBGKDiscretizer
   TArray& _collisionFrequency;
   VectorT10Array& _coeffg;
 
-  TArray** _fArrays;
   TArray** _fN1Arrays;
   TArray** _fN2Arrays;
   TArray** _fEqESArrays;
   TArray** _fResArrays;
   TArray** _fasArrays;
+
+  // the cell-major block of _dsfPtr while it is in use, see loadValues
+  const bool _cellMajor;
+  vector<T*> _fDirections;
+  T* _fBlock;
+  int _fBlockStride;
   
 };
 
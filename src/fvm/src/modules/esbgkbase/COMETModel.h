@@ -24,6 +24,7 @@
 
 #include "Quadrature.h"
 #include "DistFunctFields.h"
+#include "KineticKernels.h"
 
 #include "MacroFields.h"
 #include "FlowFields.h"
@@ -119,6 +120,7 @@ class COMETModel : public Model
     _level(level),
     _geomFields(geomFields),
     _quadrature(quad),
+    _kernels(quad),
     _macroFields(macroFields),
     _dsfPtr(_meshes,_quadrature,"dsf_"),
     _dsfPtr1(_meshes,_quadrature,"dsf1_"),
@@ -1159,80 +1161,26 @@ class COMETModel : public Model
 	TArray& pressure = dynamic_cast<TArray&>(_macroFields.pressure[cells]);
 	const int N123 = _quadrature.getDirCount(); 
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-	const TArray& wts= dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);
-	
 	VectorT6Array& stress = dynamic_cast<VectorT6Array&>(_macroFields.Stress[cells]);
 	
-	//initialize density,velocity,temperature to zero    
-	for(int c=0; c<nCells;c++)
-	  {
-	    density[c]=0.0;
-	    v[c][0]=0.0;
-	    v[c][1]=0.0;
-	    v[c][2]=0.0;
-	    temperature[c]=0.0;   
-	    stress[c][0]=0.0;stress[c][1]=0.0;stress[c][2]=0.0;
-	    stress[c][3]=0.0;stress[c][4]=0.0;stress[c][5]=0.0;
-
-	  }	
-
-
-	for(int j=0;j<N123;j++){
-	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);
-	  
-	  //fprintf(pFile,"%d %12.6f %E %E %E %E \n",j,dcxyz[j],cx[j],cy[j],f[80],density[80]+dcxyz[j]*f[80]);
-	  
-	  for(int c=0; c<nCells;c++){
-	    density[c] = density[c]+wts[j]*f[c];
-	    v[c][0]= v[c][0]+(cx[j]*f[c])*wts[j];
-	    v[c][1]= v[c][1]+(cy[j]*f[c])*wts[j];
-	    v[c][2]= v[c][2]+(cz[j]*f[c])*wts[j];
-	    temperature[c]= temperature[c]+(pow(cx[j],2.0)+pow(cy[j],2.0)
-					   +pow(cz[j],2.0))*f[c]*wts[j];
-	   
-	  }
-	  
-	}
-	
+	vector<const TArray*> fs(N123);
+	for(int j=0;j<N123;j++)
+	  fs[j] = &dynamic_cast<const TArray&>((*_dsfPtr.dsf[j])[cells]);
 
-
-	for(int c=0; c<nCells;c++){
-	  v[c][0]=v[c][0]/density[c];
-	  v[c][1]=v[c][1]/density[c];
-	  v[c][2]=v[c][2]/density[c];
-	  temperature[c]=temperature[c]-(pow(v[c][0],2.0)
-					 +pow(v[c][1],2.0)
-					 +pow(v[c][2],2.0))*density[c];
-	  temperature[c]=temperature[c]/(1.5*density[c]);  
-	  pressure[c]=density[c]*temperature[c];
-	}
-	
-	//Find Pxx,Pyy,Pzz,Pxy,Pyz,Pzx, etc in field	
-	
-	for(int j=0;j<N123;j++){	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);	  
-	  for(int c=0; c<nCells;c++){
-	    stress[c][0] +=pow((cx[j]-v[c][0]),2.0)*f[c]*wts[j];
-	    stress[c][1] +=pow((cy[j]-v[c][1]),2.0)*f[c]*wts[j];
-	    stress[c][2] +=pow((cz[j]-v[c][2]),2.0)*f[c]*wts[j];
-	    stress[c][3] +=(cx[j]-v[c][0])*(cy[j]-v[c][1])*f[c]*wts[j];
-	    stress[c][4] +=(cy[j]-v[c][1])*(cz[j]-v[c][2])*f[c]*wts[j];
-	    stress[c][5] +=(cz[j]-v[c][2])*(cx[j]-v[c][0])*f[c]*wts[j];
-	    
-	  }}
-	
+	//density,velocity,temperature,pressure and Pxx,Pyy,Pzz,Pxy,Pyz,Pzx
+	//in one pass over the directions
+	_kernels.computeMoments(fs,nCells,density,v,temperature,pressure,stress);
 	
       }// end of loop over nmeshes
     //fclose(pFile);
   }
 
-  void ComputeCOMETMacroparameters() 
+  /**
+   * The moments of the cells of blockCells, if given, are taken from
+   * the cell-major block of _dsfPtr, which the caller knows to be the
+   * same as the direction arrays, i.e. just after a sweep on them.
+   */
+  void ComputeCOMETMacroparameters(const StorageSite* blockCells=0) 
   {  
     //FILE * pFile;
     //pFile = fopen("distfun_mf.txt","w");
@@ -1247,69 +1195,25 @@ class COMETModel : public Model
 
         TArray& density = dynamic_cast<TArray&>(_macroFields.density[cells]);
         TArray& temperature = dynamic_cast<TArray&>(_macroFields.temperature[cells]);
-        const VectorT3Array& v = dynamic_cast<const VectorT3Array&>(_macroFields.velocity[cells]);
+        VectorT3Array& v = dynamic_cast<VectorT3Array&>(_macroFields.velocity[cells]);
         TArray& pressure = dynamic_cast<TArray&>(_macroFields.pressure[cells]);
         const int N123 = _quadrature.getDirCount(); 
 
-        const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-        const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-        const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-        const TArray& wts= dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);
-
         VectorT6Array& stress = dynamic_cast<VectorT6Array&>(_macroFields.Stress[cells]);
 
-        //initialize density,velocity,temperature to zero    
-        for(int c=0; c<nCells;c++)
+        //the velocity is kept, the temperature and stress are about it
+        if (&cells == blockCells)
           {
-            density[c]=0.0;
-            temperature[c]=0.0;   
-            stress[c][0]=0.0;stress[c][1]=0.0;stress[c][2]=0.0;
-            stress[c][3]=0.0;stress[c][4]=0.0;stress[c][5]=0.0;
-
-          }
-
-
-        for(int j=0;j<N123;j++){
-          
-          Field& fnd = *_dsfPtr.dsf[j];
-          const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);
-          
-          //fprintf(pFile,"%d %12.6f %E %E %E %E \n",j,dcxyz[j],cx[j],cy[j],f[80],density[80]+dcxyz[j]*f[80]);
-          
-          for(int c=0; c<nCells;c++){
-            density[c] = density[c]+wts[j]*f[c];
-            temperature[c]= temperature[c]+(pow(cx[j],2.0)+pow(cy[j],2.0)
-					    +pow(cz[j],2.0))*f[c]*wts[j];
-           
+            _kernels.computeMoments(_dsfPtr.getBlock(cells),_dsfPtr.getBlockStride(),
+                                    nCells,density,v,temperature,pressure,stress,false);
+            continue;
           }
-          
-        }
 
+        vector<const TArray*> fs(N123);
+        for(int j=0;j<N123;j++)
+          fs[j] = &dynamic_cast<const TArray&>((*_dsfPtr.dsf[j])[cells]);
 
-
-        for(int c=0; c<nCells;c++){
-          temperature[c]=temperature[c]-(pow(v[c][0],2.0)
-                                         +pow(v[c][1],2.0)
-                                         +pow(v[c][2],2.0))*density[c];
-          temperature[c]=temperature[c]/(1.5*density[c]);  
-          pressure[c]=density[c]*temperature[c];
-        }
-
-        //Find Pxx,Pyy,Pzz,Pxy,Pyz,Pzx, etc in field
-
-        for(int j=0;j<N123;j++){          
-          Field& fnd = *_dsfPtr.dsf[j];
-          const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);      
-          for(int c=0; c<nCells;c++){
-            stress[c][0] +=pow((cx[j]-v[c][0]),2.0)*f[c]*wts[j];
-            stress[c][1] +=pow((cy[j]-v[c][1]),2.0)*f[c]*wts[j];
-            stress[c][2] +=pow((cz[j]-v[c][2]),2.0)*f[c]*wts[j];
-            stress[c][3] +=(cx[j]-v[c][0])*(cy[j]-v[c][1])*f[c]*wts[j];
-            stress[c][4] +=(cy[j]-v[c][1])*(cz[j]-v[c][2])*f[c]*wts[j];
-            stress[c][5] +=(cz[j]-v[c][2])*(cx[j]-v[c][0])*f[c]*wts[j];
-            
-          }}
-
+        _kernels.computeMoments(fs,nCells,density,v,temperature,pressure,stress,false);
 
       }// end of loop over nmeshes
     //fclose(pFile);
@@ -1425,53 +1329,17 @@ class COMETModel : public Model
 	
 	const int N123 = _quadrature.getDirCount(); 
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-	const TArray& wts= dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);
-	
 	const double Pr=_options.Prandtl;
 	//cout <<"Prandlt" <<Pr<<endl;
 	
-	//initialize density,velocity,temperature to zero    
-	for(int c=0; c<nCells;c++)
-	  {
-	    Txx[c]=0.0;
-	    Tyy[c]=0.0;
-	    Tzz[c]=0.0;
-	    Txy[c]=0.0;
-	    Tyz[c]=0.0;
-	    Tzx[c]=0.0;
-	  }
+	vector<const TArray*> fs(N123), fgams(N123);
 	for(int j=0;j<N123;j++){
-	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  const TArray& fgam = dynamic_cast<const TArray&>(fndEq[cells]);	  
-	  for(int c=0; c<nCells;c++){
-	    Txx[c]=Txx[c]+pow(cx[j]-v[c][0],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    Tyy[c]=Tyy[c]+pow(cy[j]-v[c][1],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j] ;
-	    Tzz[c]=Tzz[c]+pow(cz[j]-v[c][2],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    //Txy[c]=Txy[c]+(cx[j])*(cy[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    //Tyz[c]=Tyz[c]+(cy[j])*(cz[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];            //Tzx[c]=Tzx[c]+(cz[j])*(cx[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-
- 
-	    Txy[c]=Txy[c]+(cx[j]-v[c][0])*(cy[j]-v[c][1])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    Tyz[c]=Tyz[c]+(cy[j]-v[c][1])*(cz[j]-v[c][2])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j]; 
-	    Tzx[c]=Tzx[c]+(cz[j]-v[c][2])*(cx[j]-v[c][0])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j]; 
-	  }
-	}
-		
-	for(int c=0; c<nCells;c++){
-	  Txx[c]=Txx[c]/density[c];
-	  Tyy[c]=Tyy[c]/density[c];
-	  Tzz[c]=Tzz[c]/density[c];
-	  Txy[c]=Txy[c]/density[c];
-	  Tyz[c]=Tyz[c]/density[c];
-	  Tzx[c]=Tzx[c]/density[c];
+	  fs[j] = &dynamic_cast<const TArray&>((*_dsfPtr.dsf[j])[cells]);
+	  fgams[j] = &dynamic_cast<const TArray&>((*_dsfEqPtr.dsf[j])[cells]);
 	}
 
+	_kernels.computeESBGKMoments(fs,fgams,Pr,nCells,density,v,
+				     Txx,Tyy,Tzz,Txy,Tyz,Tzx);
      }
   }
   
@@ -1629,37 +1497,19 @@ class COMETModel : public Model
 	const VectorT5Array& coeff = dynamic_cast<VectorT5Array&>(_macroFields.coeff[cells]);
 	const VectorT10Array& coeffg = dynamic_cast<VectorT10Array&>(_macroFields.coeffg[cells]);
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 
-	for(int j=0;j< numFields;j++){
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  TArray& fEq = dynamic_cast< TArray&>(fndEq[cells]);
-	  for(int c=0; c<nCells;c++){
-	    fEq[c]=coeff[c][0]*exp(-coeff[c][1]*(pow(cx[j]-v[c][0],2)+pow(cy[j]-v[c][1],2)
-						 +pow(cz[j]-v[c][2],2))+coeff[c][2]*(cx[j]-v[c][0])
-				   +coeff[c][3]*(cy[j]-v[c][1])+coeff[c][4]*(cz[j]-v[c][2]));
-	  } 
-	}
+	vector<TArray*> fEqs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqs[j] = &dynamic_cast<TArray&>((*_dsfEqPtr.dsf[j])[cells]);
+	_kernels.computeMaxwellian(coeff,v,nCells,fEqs);
 	
 	if(_options.fgamma==2){
 	  
-	  for(int j=0;j< numFields;j++){
-	    Field& fndEqES = *_dsfEqPtrES.dsf[j];
-	    TArray& fEqES = dynamic_cast< TArray&>(fndEqES[cells]);
-	    for(int c=0; c<nCells;c++){ 
-	      T Cc1=(cx[j]-v[c][0]);
-	      T Cc2=(cy[j]-v[c][1]);
-	      T Cc3=(cz[j]-v[c][2]);
-	      fEqES[c]=coeffg[c][0]*exp(-coeffg[c][1]*pow(Cc1,2)+coeffg[c][2]*Cc1
-					-coeffg[c][3]*pow(Cc2,2)+coeffg[c][4]*Cc2
-					-coeffg[c][5]*pow(Cc3,2)+coeffg[c][6]*Cc3
-					+coeffg[c][7]*cx[j]*cy[j]+coeffg[c][8]*cy[j]*cz[j]
-					+coeffg[c][9]*cz[j]*cx[j]);
-	    }
-	  }
+	  vector<TArray*> fEqESs(numFields);
+	  for(int j=0;j< numFields;j++)
+	    fEqESs[j] = &dynamic_cast<TArray&>((*_dsfEqPtrES.dsf[j])[cells]);
+	  _kernels.computeESGaussian(coeffg,v,nCells,fEqESs);
 	}
 	
 	
@@ -1672,10 +1522,8 @@ class COMETModel : public Model
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {		
-	//cout << " NewtonsMethod" <<endl;
 	const T tolx=_options["ToleranceX"];
 	const T tolf=_options["ToleranceF"];
-	const int sizeC=5;
 	const Mesh& mesh = *_meshes[n];
 	const StorageSite& cells = mesh.getCells();
 	const int nCells = cells.getCount();
@@ -1686,63 +1534,9 @@ class COMETModel : public Model
     	
 	VectorT5Array& coeff = dynamic_cast<VectorT5Array&>(_macroFields.coeff[cells]);
 	
-	for(int c=0; c<nCells;c++){
-	  
-	  for (int trial=0;trial<ktrial;trial ++){
-	    SquareMatrix<T,sizeC> fjac(0);
-	    SquareMatrix<T,sizeC> fjacinv(0);
-	    VectorT5 fvec;
-	   
-	    
-	    fvec[0]=density[c];
-	    fvec[1]=density[c]*v[c][0];
-	    fvec[2]=density[c]*v[c][1];
-	    fvec[3]=density[c]*v[c][2];
-	    fvec[4]=1.5*density[c]*temperature[c]+density[c]*(pow(v[c][0],2)+pow(v[c][1],2)+pow(v[c][2],2.0));
-	    
-	  
-	    setJacobianBGK(fjac,fvec,coeff[c],v[c],c);
-	    
-	    //solve using GE or inverse
-	    T errf=0.;
-	    for (int row=0;row<sizeC;row++){errf+=fabs(fvec[row]);}
-	    
-	    if(errf <= tolf)
-	      break;
-	    VectorT5 pvec;
-	    for (int row=0;row<sizeC;row++){pvec[row]=-fvec[row];}//rhs
-	  
-
-	    //solve Ax=b for x 
-	    //p=GE_elim(fjac,p,3);
-	    VectorT5 xvec;
-	    fjacinv=inverseGauss(fjac,sizeC);
-	    
-	   
-	    
-	    for (int row=0;row<sizeC;row++){ 
-	      xvec[row]=0.0;
-	      for (int col=0;col<sizeC;col++){
-		xvec[row]+=fjacinv(row,col)*pvec[col];}
-	    }
-	    //check for convergence, update
-	    
-	    T errx=0.;
-	    for (int row=0;row<sizeC;row++){
-	      errx +=fabs(xvec[row]);
-	      coeff[c][row]+= xvec[row];
-	    }
-	    
-	  
-	    if(errx <= tolx)
-	      break;
-	    
-	  }
-	  
-	  
-	}
+	_kernels.solveMaxwellianCoefficients(density,temperature,v,nCells,
+					     ktrial,tolx,tolf,coeff);
       }
-    
   }
   
   void EquilibriumDistributionBGK()
@@ -1772,9 +1566,6 @@ class COMETModel : public Model
 	}
 	*/
 	const VectorT3Array& v = dynamic_cast<const VectorT3Array&>(_macroFields.velocity[cells]);
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 	
 	//call Newtons Method
@@ -1782,70 +1573,21 @@ class COMETModel : public Model
 	NewtonsMethodBGK(ktrial);
 
 	//calculate perturbed maxwellian for BGK
-	for(int j=0;j< numFields;j++){
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  TArray& fEq = dynamic_cast< TArray&>(fndEq[cells]);
-	  for(int c=0; c<nCells;c++){
-	    fEq[c]=coeff[c][0]*exp(-coeff[c][1]*(pow(cx[j]-v[c][0],2)+pow(cy[j]-v[c][1],2)
-	    +pow(cz[j]-v[c][2],2))+coeff[c][2]*(cx[j]-v[c][0])
-	      			    +coeff[c][3]*(cy[j]-v[c][1])+coeff[c][4]*(cz[j]-v[c][2]));
-	  } 
-	  
-	}
+	vector<TArray*> fEqs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqs[j] = &dynamic_cast<TArray&>((*_dsfEqPtr.dsf[j])[cells]);
+	_kernels.computeMaxwellian(coeff,v,nCells,fEqs);
       }
   }
   
   
-  void setJacobianBGK(SquareMatrix<T,5>& fjac, VectorT5& fvec, const VectorT5& xn,const VectorT3& v,const int c)
-  { 
-    
-   
-    const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-    const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-    const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-    const TArray& wts = dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);	
-    
-    const TArray2D& malphaBGK = dynamic_cast<const TArray2D&>(*_quadrature.malphaBGKPtr);	
-    const int numFields= _quadrature.getDirCount(); 
-    VectorT5 mexp;
-    
-    for(int j=0;j< numFields;j++){   
-      T Cconst=pow(cx[j]-v[0],2.0)+pow(cy[j]-v[1],2.0)+pow(cz[j]-v[2],2.0);
-      T Econst=xn[0]*exp(-xn[1]*Cconst+xn[2]*(cx[j]-v[0])+xn[3]*(cy[j]-v[1])+xn[4]*(cz[j]-v[2]))*wts[j];
-      
-      for (int row=0;row<5;row++){
-	fvec[row]+= -Econst*malphaBGK(j,row); //smm
-	
-	//fvec[row]=tvec[row]+fvec[row];               //mma  
-      }
-     
-      mexp[0]=-Econst/xn[0];
-      mexp[1]=Econst*Cconst;
-      mexp[2]=-Econst*(cx[j]-v[0]);
-      mexp[3]=-Econst*(cy[j]-v[1]);
-      mexp[4]=-Econst*(cz[j]-v[2]);
-      for (int row=0;row<5;row++){
-	for (int col=0;col<5;col++){
-	  fjac(row,col)+=malphaBGK(j,row)*mexp[col];  //new
-	}
-      }
-      
-      
-    }
-    
-    
-  
-  }
-  
   void NewtonsMethodESBGK(const int ktrial)
   {
-    // cout<< "Inside Newtons Method" <<endl;
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {
 	const T tolx=_options["ToleranceX"];
 	const T tolf=_options["ToleranceF"];
-	const int sizeC=10;
 	const Mesh& mesh = *_meshes[n];
 	const StorageSite& cells = mesh.getCells();
 	const int nCells = cells.getCount();
@@ -1863,93 +1605,11 @@ class COMETModel : public Model
     	
 	VectorT10Array& coeffg = dynamic_cast<VectorT10Array&>(_macroFields.coeffg[cells]);
 	
-	for(int c=0; c<nCells;c++){
-	  // {cout <<"NM:ES" <<c <<endl;}
-	  for (int trial=0;trial<ktrial;trial ++){
-	    SquareMatrix<T,sizeC> fjac(0);
-	    SquareMatrix<T,sizeC> fjacinv(0);
-	    Vector<T,sizeC> fvec;
-	    // if (c==_options.printCellNumber){cout <<"trial" <<trial <<endl;}
-	    
-	    fvec[0]=density[c];
-	    fvec[1]=density[c]*v[c][0];
-	    fvec[2]=density[c]*v[c][1];
-	    fvec[3]=density[c]*v[c][2];
-	    fvec[4]=density[c]*(pow(v[c][0],2)+Txx[c]); 
-	    fvec[5]=density[c]*(pow(v[c][1],2)+Tyy[c]);
-	    fvec[6]=density[c]*(pow(v[c][2],2)+Tzz[c]);
-	    fvec[7]=density[c]*(v[c][0]*v[c][1]+Txy[c]);
-	    fvec[8]=density[c]*(v[c][1]*v[c][2]+Tyz[c]);
-	    fvec[9]=density[c]*(v[c][2]*v[c][0]+Tzx[c]);
-	    
-	    //calculate Jacobian
-	    setJacobianESBGK(fjac,fvec,coeffg[c],v[c],c);
-	    
-	    
-	    //solve using GaussElimination
-	    T errf=0.; //and Jacobian matrix in fjac.
-	    for (int row=0;row<sizeC;row++){errf+=fabs(fvec[row]);}
-	    if(errf <= tolf)
-	      break;
-	    Vector<T,sizeC> pvec;
-	    for (int row=0;row<sizeC;row++){pvec[row]=-fvec[row];}
-	    
-	    
-	    //solve Ax=b for x 
-	    //p=GE_elim(fjac,p,3);
-	    Vector<T,sizeC> xvec; 
-	    fjacinv=inverseGauss(fjac,sizeC);
-	    for (int row=0;row<sizeC;row++){ 
-	      xvec[row]=0.0;
-	      for (int col=0;col<sizeC;col++){
-		xvec[row]+=fjacinv(row,col)*pvec[col];
-	      
-	      }
-	    }
-	    /*
-	    if (c==_options.printCellNumber){
-	      cout << " cg0 "<<coeffg[c][0]<<" cg1 "<<coeffg[c][1]<<"  cg2 "<<coeffg[c][2] << endl;
-	      cout <<" cg3 " <<coeffg[c][3]<< " cg4 "<<coeffg[c][4]<<" cg5 "<<coeffg[c][5]<<"  cg6 "<<coeffg[c][6] << endl;
-	      cout <<" cg7 " <<coeffg[c][7]<< " cg8 "<<coeffg[c][8]<<" cg9 "<<coeffg[c][9]<<endl;
-	    
-	          
-	    //cout << " fvec-ESBGK " << fvec[4] <<fvec[5]<<fvec[6]<<fvec[7]<<fvec[8]<<fvec[9] <<endl;
-	    FILE * pFile;
-	    pFile = fopen("fvecfjac.dat","wa");  
-	    //fprintf(pFile,"%s %d \n","trial",trial);
-	    for (int mat_col=0;mat_col<sizeC;mat_col++){fprintf(pFile,"%12.4E",fvec[mat_col]);} 
-	    fprintf(pFile,"\n");
-	    for (int mat_row=0;mat_row<sizeC;mat_row++){
-	      for (int mat_col=0;mat_col<sizeC;mat_col++){
-		  fprintf(pFile,"%12.4E",fjac(mat_row,mat_col));}
-	      fprintf(pFile,"\n");} 
-	    // fprintf(pFile,"done \n");
-	    //inverse
-	    for (int mat_row=0;mat_row<sizeC;mat_row++){
-	      for (int mat_col=0;mat_col<sizeC;mat_col++){
-		fprintf(pFile,"%12.4E",fjacinv(mat_row,mat_col));}
-	      fprintf(pFile,"\n");} 
-	    //solution
-	    for (int mat_col=0;mat_col<sizeC;mat_col++){
-	      fprintf(pFile,"%12.4E",pvec[mat_col]);} 
-	      }	
-	    */
-	    
-	    //check for convergence, update
-	    T errx=0.;//%Check root convergence.
-	    for (int row=0;row<sizeC;row++){
-	      errx +=fabs(xvec[row]);
-	      coeffg[c][row]+= xvec[row];
-	    }
-	    //if (c==_options.printCellNumber){cout <<"errx "<<errx<<endl;}
-	    if(errx <= tolx)
-	      break;
-	    
-	  }
-	  
-	}
+	_kernels.solveESGaussianCoefficients(density,v,Txx,Tyy,Tzz,Txy,Tyz,Tzx,
+					     nCells,ktrial,tolx,tolf,coeffg);
       }
   }
+
   void EquilibriumDistributionESBGK()
   {
     ComputeMacroparametersESBGK();
@@ -1980,82 +1640,20 @@ class COMETModel : public Model
 	}
 	*/
 	const VectorT3Array& v = dynamic_cast<const VectorT3Array&>(_macroFields.velocity[cells]);
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 	
 	NewtonsMethodESBGK(ktrial);
 	
-	for(int j=0;j< numFields;j++){
-	  Field& fndEqES = *_dsfEqPtrES.dsf[j];
-	  TArray& fEqES = dynamic_cast< TArray&>(fndEqES[cells]);
-	  for(int c=0; c<nCells;c++){ 
-	    T Cc1=(cx[j]-v[c][0]);
-	    T Cc2=(cy[j]-v[c][1]);
-	    T Cc3=(cz[j]-v[c][2]);
-	    fEqES[c]=coeffg[c][0]*exp(-coeffg[c][1]*pow(Cc1,2)+coeffg[c][2]*Cc1
-				      -coeffg[c][3]*pow(Cc2,2)+coeffg[c][4]*Cc2
-				      -coeffg[c][5]*pow(Cc3,2)+coeffg[c][6]*Cc3
-				    +coeffg[c][7]*cx[j]*cy[j]+coeffg[c][8]*cy[j]*cz[j]
-				    +coeffg[c][9]*cz[j]*cx[j]);
-	  }
-	  
-	}
+	vector<TArray*> fEqESs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqESs[j] = &dynamic_cast<TArray&>((*_dsfEqPtrES.dsf[j])[cells]);
+	_kernels.computeESGaussian(coeffg,v,nCells,fEqESs);
       }
   }
   
-  void setJacobianESBGK(SquareMatrix<T,10>& fjac, VectorT10& fvec, const VectorT10& xn,const VectorT3& v,const int c)
-  {
-    const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-    const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-    const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-    const TArray& wts = dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);	
-    
-    const TArray2D& malphaESBGK = dynamic_cast<const TArray2D&>(*_quadrature.malphaESBGKPtr);	
-    const int numFields= _quadrature.getDirCount(); 
-    VectorT10 mexp;
-    
-    for(int j=0;j< numFields;j++){   
-      T Cc1=cx[j]-v[0];
-      T Cc2=cy[j]-v[1];
-      T Cc3=cz[j]-v[2];
-      T Econst=xn[0]*exp(-xn[1]*pow(Cc1,2)+xn[2]*Cc1-xn[3]*pow(Cc2,2)+ xn[4]*Cc2
-			 -xn[5]*pow(Cc3,2)+xn[6]*Cc3
-			 +xn[7]*cx[j]*cy[j]+xn[8]*cy[j]*cz[j]+xn[9]*cz[j]*cx[j])*wts[j];     
-      
-      for (int row=0;row<10;row++){
-	fvec[row]+= -Econst*malphaESBGK(j,row); //smm
-      }
-      
-      mexp[0]=-Econst/xn[0];
-      mexp[1]=Econst*pow(Cc1,2);
-      mexp[2]=-Econst*Cc1;
-      mexp[3]=Econst*pow(Cc2,2);
-      mexp[4]=-Econst*Cc2; 
-      mexp[5]=Econst*pow(Cc3,2);
-      mexp[6]=-Econst*Cc3;
-      
-      mexp[7]=-Econst*cx[j]*cy[j];
-      mexp[8]=-Econst*cy[j]*cz[j];
-      mexp[9]=-Econst*cz[j]*cx[j];
-   
-      for (int row=0;row<10;row++){
-	for (int col=0;col<10;col++){
-	  fjac(row,col)+=malphaESBGK(j,row)*mexp[col];  //new
-	}
-      }
-      
-      
-      
-      
-    }
-    
-        
-  }
-
   void initializeMaxwellian()
   {
+    _dsfPtr.invalidateBlocks();
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {
@@ -2173,6 +1771,7 @@ class COMETModel : public Model
 
   void weightedMaxwellian(double weight1,double uvel1,double vvel1,double wvel1,double uvel2,double vvel2,double wvel2,double temp1,double temp2)
   {
+    _dsfPtr.invalidateBlocks();
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {
@@ -2213,6 +1812,7 @@ class COMETModel : public Model
   }
   void weightedMaxwellian(double weight1,double uvel1,double uvel2,double temp1,double temp2)
   {
+    _dsfPtr.invalidateBlocks();
     const double vvel1=0.0;
     const double wvel1=0.0;
     const double vvel2=0.0;
@@ -4627,6 +4227,7 @@ map<string,shared_ptr<ArrayBase> >&
   
  void correctMassDeficit()
  {
+ _dsfPtr.invalidateBlocks();
 
  const int numMeshes = _meshes.size();
  T netFlux(0.0);
@@ -4748,6 +4349,7 @@ map<string,shared_ptr<ArrayBase> >&
 
  void correctMassDeficit2(double n1,double n2)
  {
+ _dsfPtr.invalidateBlocks();
 
  const int numMeshes = _meshes.size();
  T netFlux(0.0);
@@ -4918,6 +4520,15 @@ map<string,shared_ptr<ArrayBase> >&
       smooth(num);
   }
 
+  int getSweepThreadCount() const
+  {
+#ifdef _OPENMP
+    return max(1, _options.sweepThreads);
+#else
+    return 1;
+#endif
+  }
+
   void doSweeps(const int sweeps, const int num, const StorageSite& solidFaces)
   {
     for(int sweepNo=0;sweepNo<sweeps;sweepNo++)
@@ -4928,6 +4539,7 @@ map<string,shared_ptr<ArrayBase> >&
   {
     const int numDir=_quadrature.getDirCount();
     const int numMeshes=_meshes.size();
+    const int nThreads=getSweepThreadCount();
     for(int msh=0;msh<numMeshes;msh++)
     {
         const Mesh& mesh=*_meshes[msh];
@@ -4939,13 +4551,14 @@ map<string,shared_ptr<ArrayBase> >&
                                        _options["timeStep"],_options.timeDiscretizationOrder,
                                        _options.transient,_options.underRelaxation,_options["rho_init"], 
                                        _options["T_init"],_options["molecularWeight"],_options.conOrder,
-                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray);
+                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray,
+                                       _options.cellMajorSweeps);
 
         CDisc.setfgFinder();
 
         MakeParallel();
   
-        CDisc.COMETSolve(1,_level); //forward
+        CDisc.COMETSolve(1,_level,nThreads); //forward
 
         MakeParallel();
 
@@ -4960,7 +4573,7 @@ map<string,shared_ptr<ArrayBase> >&
         ConservationofMFSolid(solidFaces);
         computeIBFaceDsf(solidFaces,_options.method,_options.relaxDistribution);
 	          
-        CDisc.COMETSolve(-1,_level); //reverse
+        CDisc.COMETSolve(-1,_level,nThreads); //reverse
         if((num==1)||(num==0&&_level==0))
 	  {
             MakeParallel();
@@ -4982,6 +4595,7 @@ map<string,shared_ptr<ArrayBase> >&
   {
     const int numDir=_quadrature.getDirCount();
     const int numMeshes=_meshes.size();
+    const int nThreads=getSweepThreadCount();
     for(int msh=0;msh<numMeshes;msh++)
       {
         const Mesh& mesh=*_meshes[msh];
@@ -4994,7 +4608,8 @@ map<string,shared_ptr<ArrayBase> >&
                                        _options["timeStep"],_options.timeDiscretizationOrder,
                                        _options.transient,_options.underRelaxation,_options["rho_init"], 
                                        _options["T_init"],_options["molecularWeight"],_options.conOrder,
-                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray);
+                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray,
+                                       _options.cellMajorSweeps);
 
         CDisc.setfgFinder();
 
@@ -5002,11 +4617,11 @@ map<string,shared_ptr<ArrayBase> >&
         MakeParallel();
 
         if(_level==0)
-          CDisc.COMETSolveFine(1,_level); //forward
+          CDisc.COMETSolveFine(1,_level,nThreads); //forward
         else
-          CDisc.COMETSolve(1,_level); //forward
+          CDisc.COMETSolve(1,_level,nThreads); //forward
         //callCOMETBoundaryConditions();
-        ComputeCOMETMacroparameters();
+        ComputeCOMETMacroparameters(_options.cellMajorSweeps ? &mesh.getCells() : 0);
         ComputeCollisionfrequency();
         //update equilibrium distribution function 0-maxwellian, 1-BGK,2-ESBGK
         if (_options.fgamma==0){initializeMaxwellianEq();}
@@ -5018,13 +4633,13 @@ map<string,shared_ptr<ArrayBase> >&
           
 
         if(_level==0)
-          CDisc.COMETSolveFine(-1,_level); //reverse
+          CDisc.COMETSolveFine(-1,_level,nThreads); //reverse
         else
-          CDisc.COMETSolve(-1,_level); //forward
+          CDisc.COMETSolve(-1,_level,nThreads); //forward
         if((num==1)||(num==0&&_level==0))
 	  {
             //callCOMETBoundaryConditions();
-            ComputeCOMETMacroparameters();
+            ComputeCOMETMacroparameters(_options.cellMajorSweeps ? &mesh.getCells() : 0);
             ComputeCollisionfrequency();
             //update equilibrium distribution function 0-maxwellian, 1-BGK,2-ESBGK
             if (_options.fgamma==0){initializeMaxwellianEq();}
@@ -5052,7 +4667,8 @@ map<string,shared_ptr<ArrayBase> >&
                                        _options["timeStep"],_options.timeDiscretizationOrder,
                                        _options.transient,_options.underRelaxation,_options["rho_init"], 
                                        _options["T_init"],_options["molecularWeight"], _options.conOrder,
-                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray);
+                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray,
+                                       _options.cellMajorSweeps);
 
         CDisc.setfgFinder();
         const int numDir=_quadrature.getDirCount();
@@ -5091,7 +4707,8 @@ map<string,shared_ptr<ArrayBase> >&
                                        _options["timeStep"],_options.timeDiscretizationOrder,
                                        _options.transient,_options.underRelaxation,_options["rho_init"],
                                        _options["T_init"],_options["molecularWeight"],_options.conOrder,
-                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray);
+                                       _bcMap,_faceReflectionArrayMap,BCArray,BCfArray,ZCArray,
+                                       _options.cellMajorSweeps);
 
         CDisc.setfgFinder();
 	const int numDir=_quadrature.getDirCount();
@@ -5203,6 +4820,7 @@ map<string,shared_ptr<ArrayBase> >&
 
   void injectResid()
   {
+    _coarserLevel->getdsf().invalidateBlocks();
     const int numMeshes = _meshes.size();
 
     for (int n=0; n<numMeshes; n++)
@@ -5335,6 +4953,7 @@ map<string,shared_ptr<ArrayBase> >&
 
   void correctSolution()
   {
+    _dsfPtr.invalidateBlocks();
     const int numMeshes = _meshes.size();
     
     for (int n=0; n<numMeshes; n++)
@@ -5387,6 +5006,8 @@ map<string,shared_ptr<ArrayBase> >&
 
   void advance(const int iters)
   {
+    // the distribution function may have been set since the last call
+    _dsfPtr.invalidateBlocks();
     callCOMETBoundaryConditions();
     _residual=updateResid(false);
     _initialResidual=_residual;
@@ -5433,6 +5054,8 @@ map<string,shared_ptr<ArrayBase> >&
 
   T advance(const int iters,const StorageSite& solidFaces)
   {
+    // the distribution function may have been set since the last call
+    _dsfPtr.invalidateBlocks();
     callCOMETBoundaryConditions();
     _residual=updateResid(false,solidFaces);
     _initialResidual=_residual;
@@ -5654,6 +5277,7 @@ map<string,shared_ptr<ArrayBase> >&
   GeomFields& _finestGeomFields;
   const MeshList& _finestMeshes;
   Quadrature<T>& _quadrature;
+  const KineticKernels<T> _kernels;
   const int _ibm;
  
   MacroFields& _macroFields;
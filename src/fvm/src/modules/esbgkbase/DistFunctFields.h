@@ -8,6 +8,7 @@
 #include "Mesh.h"
 #include "Quadrature.h"
 #include <stdio.h>
+#include <set>
 #include "Vector.h"
 
 #include "Field.h"
@@ -15,6 +16,7 @@
 #include "FlowFields.h"
 
 #include "FlowBC.h"
+#include "CRMatrixKernels.h"
 
 #include <math.h>
 
@@ -246,11 +248,167 @@ class DistFunctFields
   const Field& getField(int indx) const {
        return *dsf[indx];
   }
-  
-  
+
+  /**
+   * The values of one direction in a cell-major block, indexed by cell
+   * like the direction's array.
+   */
+  class DirectionView
+  {
+  public:
+    DirectionView(T* data, const int stride) :
+      _data(data),
+      _stride(stride)
+    {}
+
+    T& operator[](const int c) const {return _data[c*_stride];}
+
+  private:
+    T* _data;
+    int _stride;
+  };
+
+  /**
+   * A cell-major copy of all the directions on a set of cells, for
+   * solvers that go through the directions of one cell at a time. It is
+   * only created for the sites it is asked for and needs as much memory
+   * again as the direction arrays on them, so COMETModel only uses it
+   * with cellMajorSweeps, for distribution functions too large for the
+   * caches. The
+   * value of direction j in cell c is at c*getBlockStride()+j. The
+   * arrays of dsf remain the values seen by everything else, so the
+   * block is filled from them with gatherBlock before it is used and
+   * copied back with scatterBlock after it has been changed.
+   *
+   * Between sweeps only the ghost cells of the arrays change, through
+   * boundary conditions and syncs, so once a block has been gathered or
+   * scattered gatherBlock only copies the ghost cells again. Whatever
+   * changes the arrays in the cells of the site itself has to call
+   * invalidateBlocks, after which the next gatherBlock copies all of
+   * them.
+   */
+  TArray& gatherBlock(const StorageSite& cells)
+  {
+    const int nCells = cells.getCountLevel1();
+    const int stride = getBlockStride();
+    shared_ptr<TArray>& block = _blocks[&cells];
+    if (!block || block->getLength() != nCells*stride)
+    {
+        block = shared_ptr<TArray>(new TArray(nCells*stride));
+        block->zero();
+        _currentBlocks.erase(&cells);
+    }
+
+    const int first =
+      _currentBlocks.count(&cells) > 0 ? cells.getSelfCount() : 0;
+    copyBlock(cells,*block,first,true);
+    _currentBlocks.insert(&cells);
+    return *block;
+  }
+
+  void scatterBlock(const StorageSite& cells)
+  {
+    TArray& block = getBlock(cells);
+    if (block.getLength() != cells.getCountLevel1()*getBlockStride())
+      throw CException("DistFunctFields::scatterBlock: block does not match site");
+
+    copyBlock(cells,block,0,false);
+    _currentBlocks.insert(&cells);
+  }
+
+  // the arrays have been changed in the cells of their sites, not only
+  // in the ghost cells
+  void invalidateBlocks()
+  {
+    _currentBlocks.clear();
+  }
+
+  bool hasBlock(const StorageSite& cells) const
+  {
+    return _blocks.find(&cells) != _blocks.end();
+  }
+
+  TArray& getBlock(const StorageSite& cells)
+  {
+    typename BlockMap::const_iterator pos = _blocks.find(&cells);
+    if (pos == _blocks.end())
+      throw CException("DistFunctFields::getBlock: no block for site");
+    return *pos->second;
+  }
+
+  const TArray& getBlock(const StorageSite& cells) const
+  {
+    typename BlockMap::const_iterator pos = _blocks.find(&cells);
+    if (pos == _blocks.end())
+      throw CException("DistFunctFields::getBlock: no block for site");
+    return *pos->second;
+  }
+
+  DirectionView getBlockDirection(const StorageSite& cells, const int j)
+  {
+    return DirectionView(&getBlock(cells)[j],getBlockStride());
+  }
+
+  // the rows of the cells are padded to a multiple of four values so
+  // that every cell starts with the same alignment
+  int getBlockStride() const
+  {
+    return ((int(dsf.size()) + 3) / 4) * 4;
+  }
+
  private:
+  typedef map<const StorageSite*, shared_ptr<TArray> > BlockMap;
+
+  // cells copied together between the block and the direction arrays
+  enum { blockTileSize = 16 };
+
+  // copies the cells from first on between the block and the arrays
+  void copyBlock(const StorageSite& cells, TArray& block, const int first,
+                 const bool toBlock)
+  {
+    const int nCells = cells.getCountLevel1();
+    const int stride = getBlockStride();
+    const vector<T*> fs = getDirectionData(cells);
+    const int numFields = int(dsf.size());
+    T* b = &block[0];
+    const int nTiles = (nCells - first + blockTileSize - 1)/blockTileSize;
+#pragma omp parallel for schedule(static) if (nCells - first > CRMATRIX_MIN_THREADED_ROWS)
+    for(int tile=0; tile<nTiles; tile++)
+    {
+        const int cBegin = first + tile*blockTileSize;
+        const int cEnd = std::min(cBegin + int(blockTileSize), nCells);
+        for(int j=0; j<numFields; j++)
+        {
+            T* fj = fs[j];
+            if (toBlock)
+              for(int c=cBegin; c<cEnd; c++)
+                b[c*stride+j] = fj[c];
+            else
+              for(int c=cBegin; c<cEnd; c++)
+                fj[c] = b[c*stride+j];
+        }
+    }
+  }
+
+  vector<T*> getDirectionData(const StorageSite& cells)
+  {
+    const int numFields = int(dsf.size());
+    vector<T*> fs(numFields);
+    for(int j=0; j<numFields; j++)
+    {
+        TArray& f = dynamic_cast<TArray&>((*dsf[j])[cells]);
+        if (f.getLength() < cells.getCountLevel1())
+          throw CException("DistFunctFields: direction array shorter than site");
+        fs[j] = &f[0];
+    }
+    return fs;
+  }
+
   const MeshList _meshes;
   const Quadrature<T> _quadrature;
+  BlockMap _blocks;
+  // the sites whose blocks have the values of the arrays in their cells
+  set<const StorageSite*> _currentBlocks;
   //KineticModelOptions<T> _options;
 };
  
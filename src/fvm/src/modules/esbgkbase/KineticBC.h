@@ -94,6 +94,7 @@ struct KineticModelOptions : public FloatVarDict<T>
     this->timeDiscretizationOrder=1;
     this->CentralDifference=false;
     this->KineticLinearSolver = 0;
+    this->directionThreads = 1;
    
     this-> printCellNumber=0;
     this->defineVar("printDirectionNumber",545);
@@ -132,6 +133,23 @@ struct KineticModelOptions : public FloatVarDict<T>
   bool CentralDifference;
 
   LinearSolver *KineticLinearSolver;
+
+  /**
+   * number of directions solved at the same time, each by its own
+   * thread and linear solver. The first thread uses KineticLinearSolver,
+   * the others the solvers added by addDirectionLinearSolver or else an
+   * AMG with the same tolerances. Values above one need a build with
+   * OpenMP and, in parallel builds, a single process with
+   * MPI::THREAD_MULTIPLE, otherwise the solve throws. The partitioners
+   * and mpi4py ask for THREAD_MULTIPLE when they initialize MPI
+   */
+  int directionThreads;
+
+  void addDirectionLinearSolver(LinearSolver* ls)
+  {
+    this->directionLinearSolvers.push_back(ls);
+  }
+
   int printCellNumber;
   int fgamma;
   int Knq_direction;
@@ -151,6 +169,26 @@ struct KineticModelOptions : public FloatVarDict<T>
     }
     return *this->KineticLinearSolver ;
   }
+
+  LinearSolver& getDirectionLinearSolver(const int thread)
+  {
+    if (thread == 0)
+      return getKineticLinearSolver();
+
+    while (int(this->directionLinearSolvers.size()) < thread)
+    {
+        const LinearSolver& first = getKineticLinearSolver();
+        LinearSolver* ls(new AMG());
+        ls->relativeTolerance = first.relativeTolerance;
+        ls->absoluteTolerance = first.absoluteTolerance;
+        ls->nMaxIterations = first.nMaxIterations;
+        ls->verbosity = first.verbosity;
+        this->directionLinearSolvers.push_back(ls);
+    }
+    return *this->directionLinearSolvers[thread-1];
+  }
+
+  vector<LinearSolver*> directionLinearSolvers;
 #endif
 
 };
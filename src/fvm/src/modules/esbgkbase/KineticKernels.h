@@ -0,0 +1,648 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _KINETICKERNELS_H_
+#define _KINETICKERNELS_H_
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "Array.h"
+#include "Vector.h"
+#include "Quadrature.h"
+
+template<class T>
+/**
+ * Kernels for the moments of the distribution function and the
+ * equilibrium distributions, shared by KineticModel and COMETModel.
+ *
+ * The products of the discrete velocities are computed once from the
+ * quadrature. The cells are processed in small tiles: for the moments
+ * all directions are summed into per tile accumulators in a single pass
+ * over f, and for the equilibrium distributions the exponent of every
+ * cell in the tile is first written as a polynomial in cx,cy,cz so that
+ * the inner loop over the cells only does multiply-adds and one exp on
+ * contiguous data. The Newton iterations for the coefficients of the
+ * equilibrium distributions likewise work on a tile of cells at a time.
+ */
+
+class KineticKernels
+{
+ public:
+  typedef Array<T> TArray;
+  typedef Vector<T,3> VectorT3;
+  typedef Array<VectorT3> VectorT3Array;
+  typedef Vector<T,5> VectorT5;
+  typedef Array<VectorT5> VectorT5Array;
+  typedef Vector<T,6> VectorT6;
+  typedef Array<VectorT6> VectorT6Array;
+  typedef Vector<T,10> VectorT10;
+  typedef Array<VectorT10> VectorT10Array;
+
+  KineticKernels(const Quadrature<T>& quad) :
+    _nDirections(quad.getDirCount()),
+    _w(_nDirections),
+    _cx(_nDirections),
+    _cy(_nDirections),
+    _cz(_nDirections),
+    _cxx(_nDirections),
+    _cyy(_nDirections),
+    _czz(_nDirections),
+    _cxy(_nDirections),
+    _cyz(_nDirections),
+    _czx(_nDirections)
+  {
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    const TArray& wts = *quad.dcxyzPtr;
+    for(int j=0; j<_nDirections; j++)
+      {
+	_w[j] = wts[j];
+	_cx[j] = cx[j];
+	_cy[j] = cy[j];
+	_cz[j] = cz[j];
+	_cxx[j] = cx[j]*cx[j];
+	_cyy[j] = cy[j]*cy[j];
+	_czz[j] = cz[j]*cz[j];
+	_cxy[j] = cx[j]*cy[j];
+	_cyz[j] = cy[j]*cz[j];
+	_czx[j] = cz[j]*cx[j];
+      }
+  }
+
+  /**
+   * Density, temperature, pressure and stress of the first nCells cells
+   * from the distribution function f (one array per direction). The
+   * velocity is computed as well if updateVelocity is set, otherwise the
+   * given velocity is used for the temperature and the stress.
+   */
+  void computeMoments(const vector<const TArray*>& f, const int nCells,
+		      TArray& density, VectorT3Array& v, TArray& temperature,
+		      TArray& pressure, VectorT6Array& stress,
+		      const bool updateVelocity=true) const
+  {
+    const int nTiles = (nCells + tileSize - 1)/tileSize;
+
+#pragma omp parallel for schedule(static)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*tileSize;
+	const int n = std::min(int(tileSize), nCells - cBegin);
+	T m[10][tileSize];
+	sumMoments(f,0,T(1.0),T(0.0),cBegin,n,m);
+	setMoments(m,cBegin,n,density,v,temperature,pressure,stress,
+		   updateVelocity);
+      }
+  }
+
+  /**
+   * The same from a cell-major block of f, as kept by DistFunctFields,
+   * with the directions of cell c starting at f[c*stride]. The sums of a
+   * cell run over its directions in memory order.
+   */
+  void computeMoments(const TArray& f, const int stride, const int nCells,
+		      TArray& density, VectorT3Array& v, TArray& temperature,
+		      TArray& pressure, VectorT6Array& stress,
+		      const bool updateVelocity=true) const
+  {
+    const int nTiles = (nCells + tileSize - 1)/tileSize;
+
+#pragma omp parallel for schedule(static)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*tileSize;
+	const int n = std::min(int(tileSize), nCells - cBegin);
+	T m[10][tileSize];
+	for(int i=0; i<n; i++)
+	  sumCellMoments(&f[(cBegin+i)*stride],m,i);
+	setMoments(m,cBegin,n,density,v,temperature,pressure,stress,
+		   updateVelocity);
+      }
+  }
+
+  /**
+   * Temperature tensor of the ES-BGK model, the second central moments of
+   * (1-1/Pr) f + 1/Pr fgam divided by the density.
+   */
+  void computeESBGKMoments(const vector<const TArray*>& f,
+			   const vector<const TArray*>& fgam,
+			   const T Pr, const int nCells,
+			   const TArray& density, const VectorT3Array& v,
+			   TArray& Txx, TArray& Tyy, TArray& Tzz,
+			   TArray& Txy, TArray& Tyz, TArray& Tzx) const
+  {
+    const int nTiles = (nCells + tileSize - 1)/tileSize;
+    const T fFactor = 1.0 - 1.0/Pr;
+    const T fgamFactor = 1.0/Pr;
+
+#pragma omp parallel for schedule(static)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*tileSize;
+	const int n = std::min(int(tileSize), nCells - cBegin);
+	T m[10][tileSize];
+	sumMoments(f,&fgam,fFactor,fgamFactor,cBegin,n,m);
+
+	for(int i=0; i<n; i++)
+	  {
+	    const int c = cBegin + i;
+	    VectorT6 t;
+	    centralMoments(m,i,v[c],t);
+	    Txx[c] = t[0]/density[c];
+	    Tyy[c] = t[1]/density[c];
+	    Tzz[c] = t[2]/density[c];
+	    Txy[c] = t[3]/density[c];
+	    Tyz[c] = t[4]/density[c];
+	    Tzx[c] = t[5]/density[c];
+	  }
+      }
+  }
+
+  /**
+   * Maxwellian of the BGK model
+   * fEq = coeff0*exp(-coeff1*|c-v|^2 + coeff2*(cx-vx) + coeff3*(cy-vy) + coeff4*(cz-vz))
+   */
+  void computeMaxwellian(const VectorT5Array& coeff, const VectorT3Array& v,
+			 const int nCells, const vector<TArray*>& fEq) const
+  {
+    const int nTiles = (nCells + tileSize - 1)/tileSize;
+
+#pragma omp parallel for schedule(static)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*tileSize;
+	const int n = std::min(int(tileSize), nCells - cBegin);
+	T p[tileSize], a0[tileSize], a[tileSize];
+	T bx[tileSize], by[tileSize], bz[tileSize];
+
+	for(int i=0; i<n; i++)
+	  {
+	    const VectorT5& cf = coeff[cBegin+i];
+	    const VectorT3& u = v[cBegin+i];
+	    p[i] = cf[0];
+	    a[i] = cf[1];
+	    bx[i] = 2.0*cf[1]*u[0] + cf[2];
+	    by[i] = 2.0*cf[1]*u[1] + cf[3];
+	    bz[i] = 2.0*cf[1]*u[2] + cf[4];
+	    a0[i] = -cf[1]*(u[0]*u[0] + u[1]*u[1] + u[2]*u[2])
+	      - cf[2]*u[0] - cf[3]*u[1] - cf[4]*u[2];
+	  }
+
+	for(int j=0; j<_nDirections; j++)
+	  {
+	    T* fj = &(*fEq[j])[cBegin];
+	    const T cx = _cx[j], cy = _cy[j], cz = _cz[j];
+	    const T c2 = _cxx[j] + _cyy[j] + _czz[j];
+	    for(int i=0; i<n; i++)
+	      fj[i] = p[i]*exp(a0[i] + bx[i]*cx + by[i]*cy + bz[i]*cz - a[i]*c2);
+	  }
+      }
+  }
+
+  /**
+   * ES-Gaussian of the ES-BGK model
+   * fEqES = coeffg0*exp(-coeffg1*(cx-vx)^2 + coeffg2*(cx-vx) - coeffg3*(cy-vy)^2
+   *                     + coeffg4*(cy-vy) - coeffg5*(cz-vz)^2 + coeffg6*(cz-vz)
+   *                     + coeffg7*cx*cy + coeffg8*cy*cz + coeffg9*cz*cx)
+   */
+  void computeESGaussian(const VectorT10Array& coeffg, const VectorT3Array& v,
+			 const int nCells, const vector<TArray*>& fEqES) const
+  {
+    const int nTiles = (nCells + tileSize - 1)/tileSize;
+
+#pragma omp parallel for schedule(static)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*tileSize;
+	const int n = std::min(int(tileSize), nCells - cBegin);
+	T p[tileSize], a0[tileSize], bx[tileSize], by[tileSize], bz[tileSize];
+	T qxx[tileSize], qyy[tileSize], qzz[tileSize];
+	T qxy[tileSize], qyz[tileSize], qzx[tileSize];
+
+	for(int i=0; i<n; i++)
+	  {
+	    const VectorT10& cg = coeffg[cBegin+i];
+	    const VectorT3& u = v[cBegin+i];
+	    p[i] = cg[0];
+	    qxx[i] = -cg[1];
+	    qyy[i] = -cg[3];
+	    qzz[i] = -cg[5];
+	    qxy[i] = cg[7];
+	    qyz[i] = cg[8];
+	    qzx[i] = cg[9];
+	    bx[i] = 2.0*cg[1]*u[0] + cg[2];
+	    by[i] = 2.0*cg[3]*u[1] + cg[4];
+	    bz[i] = 2.0*cg[5]*u[2] + cg[6];
+	    a0[i] = -cg[1]*u[0]*u[0] - cg[2]*u[0]
+	      - cg[3]*u[1]*u[1] - cg[4]*u[1]
+	      - cg[5]*u[2]*u[2] - cg[6]*u[2];
+	  }
+
+	for(int j=0; j<_nDirections; j++)
+	  {
+	    T* fj = &(*fEqES[j])[cBegin];
+	    const T cx = _cx[j], cy = _cy[j], cz = _cz[j];
+	    const T cxx = _cxx[j], cyy = _cyy[j], czz = _czz[j];
+	    const T cxy = _cxy[j], cyz = _cyz[j], czx = _czx[j];
+	    for(int i=0; i<n; i++)
+	      fj[i] = p[i]*exp(a0[i] + bx[i]*cx + by[i]*cy + bz[i]*cz
+			       + qxx[i]*cxx + qyy[i]*cyy + qzz[i]*czz
+			       + qxy[i]*cxy + qyz[i]*cyz + qzx[i]*czx);
+	  }
+      }
+  }
+
+  /**
+   * Newton iterations for the coefficients of the BGK Maxwellian so that
+   * its moments match density, velocity and temperature. The Jacobians
+   * of a tile of cells are summed over the directions together and cells
+   * drop out of the tile once they have converged.
+   */
+  void solveMaxwellianCoefficients(const TArray& density, const TArray& temperature,
+				   const VectorT3Array& v, const int nCells,
+				   const int ktrial, const T tolx, const T tolf,
+				   VectorT5Array& coeff) const
+  {
+    const int nTiles = (nCells + newtonTileSize - 1)/newtonTileSize;
+
+#pragma omp parallel for schedule(dynamic,4)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*newtonTileSize;
+	const int n = std::min(int(newtonTileSize), nCells - cBegin);
+	T target[5][newtonTileSize];
+	for(int i=0; i<n; i++)
+	  {
+	    const int c = cBegin + i;
+	    const VectorT3& u = v[c];
+	    target[0][i] = density[c];
+	    target[1][i] = density[c]*u[0];
+	    target[2][i] = density[c]*u[1];
+	    target[3][i] = density[c]*u[2];
+	    target[4][i] = 1.5*density[c]*temperature[c]
+	      + density[c]*(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+	  }
+	newtonSolve<5>(target,v,cBegin,n,ktrial,tolx,tolf,coeff);
+      }
+  }
+
+  /**
+   * Newton iterations for the coefficients of the ES-Gaussian so that its
+   * moments match density, velocity and the temperature tensor.
+   */
+  void solveESGaussianCoefficients(const TArray& density, const VectorT3Array& v,
+				   const TArray& Txx, const TArray& Tyy, const TArray& Tzz,
+				   const TArray& Txy, const TArray& Tyz, const TArray& Tzx,
+				   const int nCells, const int ktrial,
+				   const T tolx, const T tolf,
+				   VectorT10Array& coeffg) const
+  {
+    const int nTiles = (nCells + newtonTileSize - 1)/newtonTileSize;
+
+#pragma omp parallel for schedule(dynamic,4)
+    for(int tile=0; tile<nTiles; tile++)
+      {
+	const int cBegin = tile*newtonTileSize;
+	const int n = std::min(int(newtonTileSize), nCells - cBegin);
+	T target[10][newtonTileSize];
+	for(int i=0; i<n; i++)
+	  {
+	    const int c = cBegin + i;
+	    const VectorT3& u = v[c];
+	    target[0][i] = density[c];
+	    target[1][i] = density[c]*u[0];
+	    target[2][i] = density[c]*u[1];
+	    target[3][i] = density[c]*u[2];
+	    target[4][i] = density[c]*(u[0]*u[0] + Txx[c]);
+	    target[5][i] = density[c]*(u[1]*u[1] + Tyy[c]);
+	    target[6][i] = density[c]*(u[2]*u[2] + Tzz[c]);
+	    target[7][i] = density[c]*(u[0]*u[1] + Txy[c]);
+	    target[8][i] = density[c]*(u[1]*u[2] + Tyz[c]);
+	    target[9][i] = density[c]*(u[2]*u[0] + Tzx[c]);
+	  }
+	newtonSolve<10>(target,v,cBegin,n,ktrial,tolx,tolf,coeffg);
+      }
+  }
+
+ private:
+  enum { tileSize = 64 };
+  enum { newtonTileSize = 16 };
+
+  /**
+   * Newton iterations for the n cells of a tile starting at cBegin. Each
+   * iteration evaluates the residual target - sum(f*moments) and its
+   * Jacobian for the cells that are still active, solves the N x N
+   * systems and updates the coefficients, with the same convergence
+   * tests as the per cell iterations.
+   */
+  template<int N>
+  void newtonSolve(const T target[N][newtonTileSize], const VectorT3Array& v,
+		   const int cBegin, const int n, const int ktrial,
+		   const T tolx, const T tolf, Array<Vector<T,N> >& coeff) const
+  {
+    int active[newtonTileSize];
+    for(int i=0; i<n; i++)
+      active[i] = i;
+    int nActive = n;
+
+    for(int trial=0; trial<ktrial && nActive>0; trial++)
+      {
+	T xn[N][newtonTileSize], u[3][newtonTileSize];
+	T fvec[N][newtonTileSize], fjac[N*N][newtonTileSize];
+	for(int k=0; k<nActive; k++)
+	  {
+	    const int c = cBegin + active[k];
+	    for(int row=0; row<N; row++)
+	      {
+		xn[row][k] = coeff[c][row];
+		fvec[row][k] = target[row][active[k]];
+	      }
+	    for(int i=0; i<3; i++)
+	      u[i][k] = v[c][i];
+	    for(int e=0; e<N*N; e++)
+	      fjac[e][k] = 0.0;
+	  }
+
+	for(int j=0; j<_nDirections; j++)
+	  {
+	    if (N == 5)
+	      addMaxwellianDirection(j,nActive,xn,u,fvec,fjac);
+	    else
+	      addESGaussianDirection(j,nActive,xn,u,fvec,fjac);
+	  }
+
+	int nStillActive = 0;
+	for(int k=0; k<nActive; k++)
+	  {
+	    T errf = 0.;
+	    for(int row=0; row<N; row++)
+	      errf += fabs(fvec[row][k]);
+	    if (errf <= tolf)
+	      continue;
+
+	    T a[N][N], x[N];
+	    for(int row=0; row<N; row++)
+	      {
+		for(int col=0; col<N; col++)
+		  a[row][col] = fjac[row*N+col][k];
+		x[row] = -fvec[row][k];
+	      }
+	    luSolve<N>(a,x);
+
+	    const int c = cBegin + active[k];
+	    T errx = 0.;
+	    for(int row=0; row<N; row++)
+	      {
+		errx += fabs(x[row]);
+		coeff[c][row] += x[row];
+	      }
+	    if (errx > tolx)
+	      active[nStillActive++] = active[k];
+	  }
+	nActive = nStillActive;
+      }
+  }
+
+  // residual and Jacobian terms of direction j for the BGK Maxwellian
+  void addMaxwellianDirection(const int j, const int n,
+			      const T xn[][newtonTileSize], const T u[][newtonTileSize],
+			      T fvec[][newtonTileSize], T fjac[][newtonTileSize]) const
+  {
+    const T w = _w[j];
+    const T cx = _cx[j], cy = _cy[j], cz = _cz[j];
+    const T m[5] = {1.0, cx, cy, cz, _cxx[j] + _cyy[j] + _czz[j]};
+    for(int k=0; k<n; k++)
+      {
+	const T Cc1 = cx - u[0][k];
+	const T Cc2 = cy - u[1][k];
+	const T Cc3 = cz - u[2][k];
+	const T Cconst = Cc1*Cc1 + Cc2*Cc2 + Cc3*Cc3;
+	const T Econst = xn[0][k]*exp(-xn[1][k]*Cconst + xn[2][k]*Cc1
+				      + xn[3][k]*Cc2 + xn[4][k]*Cc3)*w;
+	const T mexp[5] = {-Econst/xn[0][k], Econst*Cconst,
+			   -Econst*Cc1, -Econst*Cc2, -Econst*Cc3};
+	for(int row=0; row<5; row++)
+	  {
+	    fvec[row][k] -= Econst*m[row];
+	    for(int col=0; col<5; col++)
+	      fjac[row*5+col][k] += m[row]*mexp[col];
+	  }
+      }
+  }
+
+  // residual and Jacobian terms of direction j for the ES-Gaussian
+  void addESGaussianDirection(const int j, const int n,
+			      const T xn[][newtonTileSize], const T u[][newtonTileSize],
+			      T fvec[][newtonTileSize], T fjac[][newtonTileSize]) const
+  {
+    const T w = _w[j];
+    const T cx = _cx[j], cy = _cy[j], cz = _cz[j];
+    const T m[10] = {1.0, cx, cy, cz, _cxx[j], _cyy[j], _czz[j],
+		     _cxy[j], _cyz[j], _czx[j]};
+    for(int k=0; k<n; k++)
+      {
+	const T Cc1 = cx - u[0][k];
+	const T Cc2 = cy - u[1][k];
+	const T Cc3 = cz - u[2][k];
+	const T Econst = xn[0][k]*exp(-xn[1][k]*Cc1*Cc1 + xn[2][k]*Cc1
+				      - xn[3][k]*Cc2*Cc2 + xn[4][k]*Cc2
+				      - xn[5][k]*Cc3*Cc3 + xn[6][k]*Cc3
+				      + xn[7][k]*m[7] + xn[8][k]*m[8]
+				      + xn[9][k]*m[9])*w;
+	const T mexp[10] = {-Econst/xn[0][k],
+			    Econst*Cc1*Cc1, -Econst*Cc1,
+			    Econst*Cc2*Cc2, -Econst*Cc2,
+			    Econst*Cc3*Cc3, -Econst*Cc3,
+			    -Econst*m[7], -Econst*m[8], -Econst*m[9]};
+	for(int row=0; row<10; row++)
+	  {
+	    fvec[row][k] -= Econst*m[row];
+	    for(int col=0; col<10; col++)
+	      fjac[row*10+col][k] += m[row]*mexp[col];
+	  }
+      }
+  }
+
+  /**
+   * Solves a x = b in place with an LU factorization using the same
+   * scaled partial pivoting as inverseGauss.
+   */
+  template<int N>
+  static void luSolve(T a[N][N], T b[N])
+  {
+    T scale[N];
+    for(int i=0; i<N; i++)
+      {
+	scale[i] = 0;
+	for(int j=0; j<N; j++)
+	  if (fabs(a[i][j]) > scale[i])
+	    scale[i] = fabs(a[i][j]);
+      }
+
+    for(int j=0; j<N-1; j++)
+      {
+	int pk = j;
+	T pmax = 0;
+	for(int i=j; i<N; i++)
+	  {
+	    const T p = fabs(a[i][j])/scale[i];
+	    if (p > pmax)
+	      {
+		pmax = p;
+		pk = i;
+	      }
+	  }
+	if (pk != j)
+	  {
+	    for(int col=0; col<N; col++)
+	      std::swap(a[j][col],a[pk][col]);
+	    std::swap(b[j],b[pk]);
+	    std::swap(scale[j],scale[pk]);
+	  }
+	for(int i=j+1; i<N; i++)
+	  {
+	    const T l = a[i][j]/a[j][j];
+	    for(int col=j+1; col<N; col++)
+	      a[i][col] -= l*a[j][col];
+	    b[i] -= l*b[j];
+	  }
+      }
+
+    for(int i=N-1; i>=0; i--)
+      {
+	T sum = b[i];
+	for(int col=i+1; col<N; col++)
+	  sum -= a[i][col]*b[col];
+	b[i] = sum/a[i][i];
+      }
+  }
+
+  /**
+   * Raw moments 1, c, cc of fFactor*f + gFactor*g over the n cells
+   * starting at cBegin: m[0] the zeroth, m[1..3] the first and m[4..9]
+   * the second moments in the order xx,yy,zz,xy,yz,zx.
+   */
+  void sumMoments(const vector<const TArray*>& f,
+		  const vector<const TArray*>* g,
+		  const T fFactor, const T gFactor,
+		  const int cBegin, const int n, T m[10][tileSize]) const
+  {
+    for(int k=0; k<10; k++)
+      for(int i=0; i<n; i++)
+	m[k][i] = 0.0;
+
+    for(int j=0; j<_nDirections; j++)
+      {
+	const T* fj = &(*f[j])[cBegin];
+	const T w = _w[j];
+	T wf[tileSize];
+	if (g)
+	  {
+	    const T* gj = &(*(*g)[j])[cBegin];
+	    for(int i=0; i<n; i++)
+	      wf[i] = w*(fFactor*fj[i] + gFactor*gj[i]);
+	  }
+	else
+	  {
+	    for(int i=0; i<n; i++)
+	      wf[i] = w*fj[i];
+	  }
+
+	const T cx = _cx[j], cy = _cy[j], cz = _cz[j];
+	const T cxx = _cxx[j], cyy = _cyy[j], czz = _czz[j];
+	const T cxy = _cxy[j], cyz = _cyz[j], czx = _czx[j];
+	for(int i=0; i<n; i++)
+	  {
+	    m[0][i] += wf[i];
+	    m[1][i] += cx*wf[i];
+	    m[2][i] += cy*wf[i];
+	    m[3][i] += cz*wf[i];
+	    m[4][i] += cxx*wf[i];
+	    m[5][i] += cyy*wf[i];
+	    m[6][i] += czz*wf[i];
+	    m[7][i] += cxy*wf[i];
+	    m[8][i] += cyz*wf[i];
+	    m[9][i] += czx*wf[i];
+	  }
+      }
+  }
+
+  /**
+   * Raw moments of one cell, as in sumMoments, from its nDirections
+   * contiguous values fc into cell i of the tile.
+   */
+  void sumCellMoments(const T* fc, T m[10][tileSize], const int i) const
+  {
+    T s[10] = {0,0,0,0,0,0,0,0,0,0};
+    for(int j=0; j<_nDirections; j++)
+      {
+	const T wf = _w[j]*fc[j];
+	s[0] += wf;
+	s[1] += _cx[j]*wf;
+	s[2] += _cy[j]*wf;
+	s[3] += _cz[j]*wf;
+	s[4] += _cxx[j]*wf;
+	s[5] += _cyy[j]*wf;
+	s[6] += _czz[j]*wf;
+	s[7] += _cxy[j]*wf;
+	s[8] += _cyz[j]*wf;
+	s[9] += _czx[j]*wf;
+      }
+    for(int k=0; k<10; k++)
+      m[k][i] = s[k];
+  }
+
+  // the macroscopic values of the n cells of a tile from their raw moments
+  static void setMoments(const T m[10][tileSize], const int cBegin, const int n,
+			 TArray& density, VectorT3Array& v, TArray& temperature,
+			 TArray& pressure, VectorT6Array& stress,
+			 const bool updateVelocity)
+  {
+    for(int i=0; i<n; i++)
+      {
+	const int c = cBegin + i;
+	const T rho = m[0][i];
+	if (updateVelocity)
+	  {
+	    v[c][0] = m[1][i]/rho;
+	    v[c][1] = m[2][i]/rho;
+	    v[c][2] = m[3][i]/rho;
+	  }
+	const VectorT3& u = v[c];
+	const T trace = m[4][i] + m[5][i] + m[6][i];
+	density[c] = rho;
+	temperature[c] = (trace - (u[0]*u[0] + u[1]*u[1] + u[2]*u[2])*rho)/(1.5*rho);
+	pressure[c] = rho*temperature[c];
+	centralMoments(m,i,u,stress[c]);
+      }
+  }
+
+  // second moments about u from the raw moments of cell i of the tile
+  static void centralMoments(const T m[10][tileSize], const int i,
+			     const VectorT3& u, VectorT6& s)
+  {
+    const T rho = m[0][i];
+    s[0] = m[4][i] - 2.0*u[0]*m[1][i] + u[0]*u[0]*rho;
+    s[1] = m[5][i] - 2.0*u[1]*m[2][i] + u[1]*u[1]*rho;
+    s[2] = m[6][i] - 2.0*u[2]*m[3][i] + u[2]*u[2]*rho;
+    s[3] = m[7][i] - u[0]*m[2][i] - u[1]*m[1][i] + u[0]*u[1]*rho;
+    s[4] = m[8][i] - u[1]*m[3][i] - u[2]*m[2][i] + u[1]*u[2]*rho;
+    s[5] = m[9][i] - u[2]*m[1][i] - u[0]*m[3][i] + u[2]*u[0]*rho;
+  }
+
+  const int _nDirections;
+  vector<T> _w;
+  vector<T> _cx;
+  vector<T> _cy;
+  vector<T> _cz;
+  vector<T> _cxx;
+  vector<T> _cyy;
+  vector<T> _czz;
+  vector<T> _cxy;
+  vector<T> _cyz;
+  vector<T> _czx;
+};
+
+#endif
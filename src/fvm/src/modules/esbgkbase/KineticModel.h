@@ -9,6 +9,10 @@
 #include <mpi.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <stdio.h>
 #include <map>
 #include <cmath>
@@ -21,6 +25,7 @@
 
 #include "Quadrature.h"
 #include "DistFunctFields.h"
+#include "KineticKernels.h"
 
 #include "MacroFields.h"
 #include "FlowFields.h"
@@ -83,6 +88,7 @@ class KineticModel : public Model
     Model(meshes),
     _geomFields(geomFields),
     _quadrature(quad),
+    _kernels(quad),
     _macroFields(macroFields),
     _dsfPtr(_meshes,_quadrature,"dsf_"),
     _dsfPtr1(_meshes,_quadrature,"dsf1_"),
@@ -487,74 +493,15 @@ class KineticModel : public Model
 	TArray& pressure = dynamic_cast<TArray&>(_macroFields.pressure[cells]);
 	const int N123 = _quadrature.getDirCount(); 
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-	const TArray& wts= dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);
-	
 	VectorT6Array& stress = dynamic_cast<VectorT6Array&>(_macroFields.Stress[cells]);
 	
-	//initialize density,velocity,temperature to zero    
-	for(int c=0; c<nCells;c++)
-	  {
-	    density[c]=0.0;
-	    v[c][0]=0.0;
-	    v[c][1]=0.0;
-	    v[c][2]=0.0;
-	    temperature[c]=0.0;   
-	    stress[c][0]=0.0;stress[c][1]=0.0;stress[c][2]=0.0;
-	    stress[c][3]=0.0;stress[c][4]=0.0;stress[c][5]=0.0;
-
-	  }	
-
-
-	for(int j=0;j<N123;j++){
-	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);
-	  
-	  //fprintf(pFile,"%d %12.6f %E %E %E %E \n",j,dcxyz[j],cx[j],cy[j],f[80],density[80]+dcxyz[j]*f[80]);
-	  
-	  for(int c=0; c<nCells;c++){
-	    density[c] = density[c]+wts[j]*f[c];
-	    v[c][0]= v[c][0]+(cx[j]*f[c])*wts[j];
-	    v[c][1]= v[c][1]+(cy[j]*f[c])*wts[j];
-	    v[c][2]= v[c][2]+(cz[j]*f[c])*wts[j];
-	    temperature[c]= temperature[c]+(pow(cx[j],2.0)+pow(cy[j],2.0)
-					   +pow(cz[j],2.0))*f[c]*wts[j];
-	   
-	  }
-	  
-	}
-	
-
+	vector<const TArray*> fs(N123);
+	for(int j=0;j<N123;j++)
+	  fs[j] = &dynamic_cast<const TArray&>((*_dsfPtr.dsf[j])[cells]);
 
-	for(int c=0; c<nCells;c++){
-	  v[c][0]=v[c][0]/density[c];
-	  v[c][1]=v[c][1]/density[c];
-	  v[c][2]=v[c][2]/density[c];
-	  temperature[c]=temperature[c]-(pow(v[c][0],2.0)
-					 +pow(v[c][1],2.0)
-					 +pow(v[c][2],2.0))*density[c];
-	  temperature[c]=temperature[c]/(1.5*density[c]);  
-	  pressure[c]=density[c]*temperature[c];
-	}
-	
-	//Find Pxx,Pyy,Pzz,Pxy,Pyz,Pzx, etc in field	
-	
-	for(int j=0;j<N123;j++){	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);	  
-	  for(int c=0; c<nCells;c++){
-	    stress[c][0] +=pow((cx[j]-v[c][0]),2.0)*f[c]*wts[j];
-	    stress[c][1] +=pow((cy[j]-v[c][1]),2.0)*f[c]*wts[j];
-	    stress[c][2] +=pow((cz[j]-v[c][2]),2.0)*f[c]*wts[j];
-	    stress[c][3] +=(cx[j]-v[c][0])*(cy[j]-v[c][1])*f[c]*wts[j];
-	    stress[c][4] +=(cy[j]-v[c][1])*(cz[j]-v[c][2])*f[c]*wts[j];
-	    stress[c][5] +=(cz[j]-v[c][2])*(cx[j]-v[c][0])*f[c]*wts[j];
-	    
-	  }}
-	
+	//density,velocity,temperature,pressure and Pxx,Pyy,Pzz,Pxy,Pyz,Pzx
+	//in one pass over the directions
+	_kernels.computeMoments(fs,nCells,density,v,temperature,pressure,stress);
 	
       }// end of loop over nmeshes
     //fclose(pFile);
@@ -584,53 +531,17 @@ class KineticModel : public Model
 	
 	const int N123 = _quadrature.getDirCount(); 
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-	const TArray& wts= dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);
-	
 	const double Pr=_options.Prandtl;
 	//cout <<"Prandlt" <<Pr<<endl;
 	
-	//initialize density,velocity,temperature to zero    
-	for(int c=0; c<nCells;c++)
-	  {
-	    Txx[c]=0.0;
-	    Tyy[c]=0.0;
-	    Tzz[c]=0.0;
-	    Txy[c]=0.0;
-	    Tyz[c]=0.0;
-	    Tzx[c]=0.0;
-	  }
+	vector<const TArray*> fs(N123), fgams(N123);
 	for(int j=0;j<N123;j++){
-	  
-	  Field& fnd = *_dsfPtr.dsf[j];
-	  const TArray& f = dynamic_cast<const TArray&>(fnd[cells]);
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  const TArray& fgam = dynamic_cast<const TArray&>(fndEq[cells]);	  
-	  for(int c=0; c<nCells;c++){
-	    Txx[c]=Txx[c]+pow(cx[j]-v[c][0],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    Tyy[c]=Tyy[c]+pow(cy[j]-v[c][1],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j] ;
-	    Tzz[c]=Tzz[c]+pow(cz[j]-v[c][2],2)*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    //Txy[c]=Txy[c]+(cx[j])*(cy[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    //Tyz[c]=Tyz[c]+(cy[j])*(cz[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];            //Tzx[c]=Tzx[c]+(cz[j])*(cx[j])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-
- 
-	    Txy[c]=Txy[c]+(cx[j]-v[c][0])*(cy[j]-v[c][1])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
-	    Tyz[c]=Tyz[c]+(cy[j]-v[c][1])*(cz[j]-v[c][2])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j]; 
-	    Tzx[c]=Tzx[c]+(cz[j]-v[c][2])*(cx[j]-v[c][0])*((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j]; 
-	  }
-	}
-		
-	for(int c=0; c<nCells;c++){
-	  Txx[c]=Txx[c]/density[c];
-	  Tyy[c]=Tyy[c]/density[c];
-	  Tzz[c]=Tzz[c]/density[c];
-	  Txy[c]=Txy[c]/density[c];
-	  Tyz[c]=Tyz[c]/density[c];
-	  Tzx[c]=Tzx[c]/density[c];
+	  fs[j] = &dynamic_cast<const TArray&>((*_dsfPtr.dsf[j])[cells]);
+	  fgams[j] = &dynamic_cast<const TArray&>((*_dsfEqPtr.dsf[j])[cells]);
 	}
 
+	_kernels.computeESBGKMoments(fs,fgams,Pr,nCells,density,v,
+				     Txx,Tyy,Tzz,Txy,Tyz,Tzx);
      }
   }
   
@@ -788,37 +699,19 @@ class KineticModel : public Model
 	const VectorT5Array& coeff = dynamic_cast<VectorT5Array&>(_macroFields.coeff[cells]);
 	const VectorT10Array& coeffg = dynamic_cast<VectorT10Array&>(_macroFields.coeffg[cells]);
 	
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 
-	for(int j=0;j< numFields;j++){
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  TArray& fEq = dynamic_cast< TArray&>(fndEq[cells]);
-	  for(int c=0; c<nCells;c++){
-	    fEq[c]=coeff[c][0]*exp(-coeff[c][1]*(pow(cx[j]-v[c][0],2)+pow(cy[j]-v[c][1],2)
-						 +pow(cz[j]-v[c][2],2))+coeff[c][2]*(cx[j]-v[c][0])
-				   +coeff[c][3]*(cy[j]-v[c][1])+coeff[c][4]*(cz[j]-v[c][2]));
-	  } 
-	}
+	vector<TArray*> fEqs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqs[j] = &dynamic_cast<TArray&>((*_dsfEqPtr.dsf[j])[cells]);
+	_kernels.computeMaxwellian(coeff,v,nCells,fEqs);
 	
 	if(_options.fgamma==2){
 	  
-	  for(int j=0;j< numFields;j++){
-	    Field& fndEqES = *_dsfEqPtrES.dsf[j];
-	    TArray& fEqES = dynamic_cast< TArray&>(fndEqES[cells]);
-	    for(int c=0; c<nCells;c++){ 
-	      T Cc1=(cx[j]-v[c][0]);
-	      T Cc2=(cy[j]-v[c][1]);
-	      T Cc3=(cz[j]-v[c][2]);
-	      fEqES[c]=coeffg[c][0]*exp(-coeffg[c][1]*pow(Cc1,2)+coeffg[c][2]*Cc1
-					-coeffg[c][3]*pow(Cc2,2)+coeffg[c][4]*Cc2
-					-coeffg[c][5]*pow(Cc3,2)+coeffg[c][6]*Cc3
-					+coeffg[c][7]*cx[j]*cy[j]+coeffg[c][8]*cy[j]*cz[j]
-					+coeffg[c][9]*cz[j]*cx[j]);
-	    }
-	  }
+	  vector<TArray*> fEqESs(numFields);
+	  for(int j=0;j< numFields;j++)
+	    fEqESs[j] = &dynamic_cast<TArray&>((*_dsfEqPtrES.dsf[j])[cells]);
+	  _kernels.computeESGaussian(coeffg,v,nCells,fEqESs);
 	}
 	
 	
@@ -831,10 +724,8 @@ class KineticModel : public Model
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {		
-	//cout << " NewtonsMethod" <<endl;
 	const T tolx=_options["ToleranceX"];
 	const T tolf=_options["ToleranceF"];
-	const int sizeC=5;
 	const Mesh& mesh = *_meshes[n];
 	const StorageSite& cells = mesh.getCells();
 	const int nCells = cells.getCountLevel1();
@@ -845,63 +736,9 @@ class KineticModel : public Model
     	
 	VectorT5Array& coeff = dynamic_cast<VectorT5Array&>(_macroFields.coeff[cells]);
 	
-	for(int c=0; c<nCells;c++){
-	  
-	  for (int trial=0;trial<ktrial;trial ++){
-	    SquareMatrix<T,sizeC> fjac(0);
-	    SquareMatrix<T,sizeC> fjacinv(0);
-	    VectorT5 fvec;
-	   
-	    
-	    fvec[0]=density[c];
-	    fvec[1]=density[c]*v[c][0];
-	    fvec[2]=density[c]*v[c][1];
-	    fvec[3]=density[c]*v[c][2];
-	    fvec[4]=1.5*density[c]*temperature[c]+density[c]*(pow(v[c][0],2)+pow(v[c][1],2)+pow(v[c][2],2.0));
-	    
-	  
-	    setJacobianBGK(fjac,fvec,coeff[c],v[c],c);
-	    
-	    //solve using GE or inverse
-	    T errf=0.;
-	    for (int row=0;row<sizeC;row++){errf+=fabs(fvec[row]);}
-	    
-	    if(errf <= tolf)
-	      break;
-	    VectorT5 pvec;
-	    for (int row=0;row<sizeC;row++){pvec[row]=-fvec[row];}//rhs
-	  
-
-	    //solve Ax=b for x 
-	    //p=GE_elim(fjac,p,3);
-	    VectorT5 xvec;
-	    fjacinv=inverseGauss(fjac,sizeC);
-	    
-	   
-	    
-	    for (int row=0;row<sizeC;row++){ 
-	      xvec[row]=0.0;
-	      for (int col=0;col<sizeC;col++){
-		xvec[row]+=fjacinv(row,col)*pvec[col];}
-	    }
-	    //check for convergence, update
-	    
-	    T errx=0.;
-	    for (int row=0;row<sizeC;row++){
-	      errx +=fabs(xvec[row]);
-	      coeff[c][row]+= xvec[row];
-	    }
-	    
-	  
-	    if(errx <= tolx)
-	      break;
-	    
-	  }
-	  
-	  
-	}
+	_kernels.solveMaxwellianCoefficients(density,temperature,v,nCells,
+					     ktrial,tolx,tolf,coeff);
       }
-    
   }
   
   void EquilibriumDistributionBGK()
@@ -931,9 +768,6 @@ class KineticModel : public Model
 	}
 	*/
 	const VectorT3Array& v = dynamic_cast<const VectorT3Array&>(_macroFields.velocity[cells]);
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 	
 	//call Newtons Method
@@ -941,70 +775,21 @@ class KineticModel : public Model
 	NewtonsMethodBGK(ktrial);
 
 	//calculate perturbed maxwellian for BGK
-	for(int j=0;j< numFields;j++){
-	  Field& fndEq = *_dsfEqPtr.dsf[j];
-	  TArray& fEq = dynamic_cast< TArray&>(fndEq[cells]);
-	  for(int c=0; c<nCells;c++){
-	    fEq[c]=coeff[c][0]*exp(-coeff[c][1]*(pow(cx[j]-v[c][0],2)+pow(cy[j]-v[c][1],2)
-	    +pow(cz[j]-v[c][2],2))+coeff[c][2]*(cx[j]-v[c][0])
-	      			    +coeff[c][3]*(cy[j]-v[c][1])+coeff[c][4]*(cz[j]-v[c][2]));
-	  } 
-	  
-	}
+	vector<TArray*> fEqs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqs[j] = &dynamic_cast<TArray&>((*_dsfEqPtr.dsf[j])[cells]);
+	_kernels.computeMaxwellian(coeff,v,nCells,fEqs);
       }
   }
   
   
-  void setJacobianBGK(SquareMatrix<T,5>& fjac, VectorT5& fvec, const VectorT5& xn,const VectorT3& v,const int c)
-  { 
-    
-   
-    const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-    const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-    const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-    const TArray& wts = dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);	
-    
-    const TArray2D& malphaBGK = dynamic_cast<const TArray2D&>(*_quadrature.malphaBGKPtr);	
-    const int numFields= _quadrature.getDirCount(); 
-    VectorT5 mexp;
-    
-    for(int j=0;j< numFields;j++){   
-      T Cconst=pow(cx[j]-v[0],2.0)+pow(cy[j]-v[1],2.0)+pow(cz[j]-v[2],2.0);
-      T Econst=xn[0]*exp(-xn[1]*Cconst+xn[2]*(cx[j]-v[0])+xn[3]*(cy[j]-v[1])+xn[4]*(cz[j]-v[2]))*wts[j];
-      
-      for (int row=0;row<5;row++){
-	fvec[row]+= -Econst*malphaBGK(j,row); //smm
-	
-	//fvec[row]=tvec[row]+fvec[row];               //mma  
-      }
-     
-      mexp[0]=-Econst/xn[0];
-      mexp[1]=Econst*Cconst;
-      mexp[2]=-Econst*(cx[j]-v[0]);
-      mexp[3]=-Econst*(cy[j]-v[1]);
-      mexp[4]=-Econst*(cz[j]-v[2]);
-      for (int row=0;row<5;row++){
-	for (int col=0;col<5;col++){
-	  fjac(row,col)+=malphaBGK(j,row)*mexp[col];  //new
-	}
-      }
-      
-      
-    }
-    
-    
-  
-  }
-  
   void NewtonsMethodESBGK(const int ktrial)
   {
-    // cout<< "Inside Newtons Method" <<endl;
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
       {
 	const T tolx=_options["ToleranceX"];
 	const T tolf=_options["ToleranceF"];
-	const int sizeC=10;
 	const Mesh& mesh = *_meshes[n];
 	const StorageSite& cells = mesh.getCells();
 	const int nCells = cells.getCountLevel1();
@@ -1022,93 +807,11 @@ class KineticModel : public Model
     	
 	VectorT10Array& coeffg = dynamic_cast<VectorT10Array&>(_macroFields.coeffg[cells]);
 	
-	for(int c=0; c<nCells;c++){
-	  // {cout <<"NM:ES" <<c <<endl;}
-	  for (int trial=0;trial<ktrial;trial ++){
-	    SquareMatrix<T,sizeC> fjac(0);
-	    SquareMatrix<T,sizeC> fjacinv(0);
-	    Vector<T,sizeC> fvec;
-	    // if (c==_options.printCellNumber){cout <<"trial" <<trial <<endl;}
-	    
-	    fvec[0]=density[c];
-	    fvec[1]=density[c]*v[c][0];
-	    fvec[2]=density[c]*v[c][1];
-	    fvec[3]=density[c]*v[c][2];
-	    fvec[4]=density[c]*(pow(v[c][0],2)+Txx[c]); 
-	    fvec[5]=density[c]*(pow(v[c][1],2)+Tyy[c]);
-	    fvec[6]=density[c]*(pow(v[c][2],2)+Tzz[c]);
-	    fvec[7]=density[c]*(v[c][0]*v[c][1]+Txy[c]);
-	    fvec[8]=density[c]*(v[c][1]*v[c][2]+Tyz[c]);
-	    fvec[9]=density[c]*(v[c][2]*v[c][0]+Tzx[c]);
-	    
-	    //calculate Jacobian
-	    setJacobianESBGK(fjac,fvec,coeffg[c],v[c],c);
-	    
-	    
-	    //solve using GaussElimination
-	    T errf=0.; //and Jacobian matrix in fjac.
-	    for (int row=0;row<sizeC;row++){errf+=fabs(fvec[row]);}
-	    if(errf <= tolf)
-	      break;
-	    Vector<T,sizeC> pvec;
-	    for (int row=0;row<sizeC;row++){pvec[row]=-fvec[row];}
-	    
-	    
-	    //solve Ax=b for x 
-	    //p=GE_elim(fjac,p,3);
-	    Vector<T,sizeC> xvec; 
-	    fjacinv=inverseGauss(fjac,sizeC);
-	    for (int row=0;row<sizeC;row++){ 
-	      xvec[row]=0.0;
-	      for (int col=0;col<sizeC;col++){
-		xvec[row]+=fjacinv(row,col)*pvec[col];
-	      
-	      }
-	    }
-	    /*
-	    if (c==_options.printCellNumber){
-	      cout << " cg0 "<<coeffg[c][0]<<" cg1 "<<coeffg[c][1]<<"  cg2 "<<coeffg[c][2] << endl;
-	      cout <<" cg3 " <<coeffg[c][3]<< " cg4 "<<coeffg[c][4]<<" cg5 "<<coeffg[c][5]<<"  cg6 "<<coeffg[c][6] << endl;
-	      cout <<" cg7 " <<coeffg[c][7]<< " cg8 "<<coeffg[c][8]<<" cg9 "<<coeffg[c][9]<<endl;
-	    
-	          
-	    //cout << " fvec-ESBGK " << fvec[4] <<fvec[5]<<fvec[6]<<fvec[7]<<fvec[8]<<fvec[9] <<endl;
-	    FILE * pFile;
-	    pFile = fopen("fvecfjac.dat","wa");  
-	    //fprintf(pFile,"%s %d \n","trial",trial);
-	    for (int mat_col=0;mat_col<sizeC;mat_col++){fprintf(pFile,"%12.4E",fvec[mat_col]);} 
-	    fprintf(pFile,"\n");
-	    for (int mat_row=0;mat_row<sizeC;mat_row++){
-	      for (int mat_col=0;mat_col<sizeC;mat_col++){
-		  fprintf(pFile,"%12.4E",fjac(mat_row,mat_col));}
-	      fprintf(pFile,"\n");} 
-	    // fprintf(pFile,"done \n");
-	    //inverse
-	    for (int mat_row=0;mat_row<sizeC;mat_row++){
-	      for (int mat_col=0;mat_col<sizeC;mat_col++){
-		fprintf(pFile,"%12.4E",fjacinv(mat_row,mat_col));}
-	      fprintf(pFile,"\n");} 
-	    //solution
-	    for (int mat_col=0;mat_col<sizeC;mat_col++){
-	      fprintf(pFile,"%12.4E",pvec[mat_col]);} 
-	      }	
-	    */
-	    
-	    //check for convergence, update
-	    T errx=0.;//%Check root convergence.
-	    for (int row=0;row<sizeC;row++){
-	      errx +=fabs(xvec[row]);
-	      coeffg[c][row]+= xvec[row];
-	    }
-	    //if (c==_options.printCellNumber){cout <<"errx "<<errx<<endl;}
-	    if(errx <= tolx)
-	      break;
-	    
-	  }
-	  
-	}
+	_kernels.solveESGaussianCoefficients(density,v,Txx,Tyy,Tzz,Txy,Tyz,Tzx,
+					     nCells,ktrial,tolx,tolf,coeffg);
       }
   }
+
   void EquilibriumDistributionESBGK()
   {
     ComputeMacroparametersESBGK();
@@ -1139,80 +842,17 @@ class KineticModel : public Model
 	}
 	*/
 	const VectorT3Array& v = dynamic_cast<const VectorT3Array&>(_macroFields.velocity[cells]);
-	const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-	const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-	const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
 	const int numFields= _quadrature.getDirCount(); 
 	
 	NewtonsMethodESBGK(ktrial);
 	
-	for(int j=0;j< numFields;j++){
-	  Field& fndEqES = *_dsfEqPtrES.dsf[j];
-	  TArray& fEqES = dynamic_cast< TArray&>(fndEqES[cells]);
-	  for(int c=0; c<nCells;c++){ 
-	    T Cc1=(cx[j]-v[c][0]);
-	    T Cc2=(cy[j]-v[c][1]);
-	    T Cc3=(cz[j]-v[c][2]);
-	    fEqES[c]=coeffg[c][0]*exp(-coeffg[c][1]*pow(Cc1,2)+coeffg[c][2]*Cc1
-				      -coeffg[c][3]*pow(Cc2,2)+coeffg[c][4]*Cc2
-				      -coeffg[c][5]*pow(Cc3,2)+coeffg[c][6]*Cc3
-				    +coeffg[c][7]*cx[j]*cy[j]+coeffg[c][8]*cy[j]*cz[j]
-				    +coeffg[c][9]*cz[j]*cx[j]);
-	  }
-	  
-	}
+	vector<TArray*> fEqESs(numFields);
+	for(int j=0;j< numFields;j++)
+	  fEqESs[j] = &dynamic_cast<TArray&>((*_dsfEqPtrES.dsf[j])[cells]);
+	_kernels.computeESGaussian(coeffg,v,nCells,fEqESs);
       }
   }
   
-  void setJacobianESBGK(SquareMatrix<T,10>& fjac, VectorT10& fvec, const VectorT10& xn,const VectorT3& v,const int c)
-  {
-    const TArray& cx = dynamic_cast<const TArray&>(*_quadrature.cxPtr);
-    const TArray& cy = dynamic_cast<const TArray&>(*_quadrature.cyPtr);
-    const TArray& cz = dynamic_cast<const TArray&>(*_quadrature.czPtr);
-    const TArray& wts = dynamic_cast<const TArray&>(*_quadrature.dcxyzPtr);	
-    
-    const TArray2D& malphaESBGK = dynamic_cast<const TArray2D&>(*_quadrature.malphaESBGKPtr);	
-    const int numFields= _quadrature.getDirCount(); 
-    VectorT10 mexp;
-    
-    for(int j=0;j< numFields;j++){   
-      T Cc1=cx[j]-v[0];
-      T Cc2=cy[j]-v[1];
-      T Cc3=cz[j]-v[2];
-      T Econst=xn[0]*exp(-xn[1]*pow(Cc1,2)+xn[2]*Cc1-xn[3]*pow(Cc2,2)+ xn[4]*Cc2
-			 -xn[5]*pow(Cc3,2)+xn[6]*Cc3
-			 +xn[7]*cx[j]*cy[j]+xn[8]*cy[j]*cz[j]+xn[9]*cz[j]*cx[j])*wts[j];     
-      
-      for (int row=0;row<10;row++){
-	fvec[row]+= -Econst*malphaESBGK(j,row); //smm
-      }
-      
-      mexp[0]=-Econst/xn[0];
-      mexp[1]=Econst*pow(Cc1,2);
-      mexp[2]=-Econst*Cc1;
-      mexp[3]=Econst*pow(Cc2,2);
-      mexp[4]=-Econst*Cc2; 
-      mexp[5]=Econst*pow(Cc3,2);
-      mexp[6]=-Econst*Cc3;
-      
-      mexp[7]=-Econst*cx[j]*cy[j];
-      mexp[8]=-Econst*cy[j]*cz[j];
-      mexp[9]=-Econst*cz[j]*cx[j];
-   
-      for (int row=0;row<10;row++){
-	for (int col=0;col<10;col++){
-	  fjac(row,col)+=malphaESBGK(j,row)*mexp[col];  //new
-	}
-      }
-      
-      
-      
-      
-    }
-    
-        
-  }
-
   void initializeMaxwellian()
   {
     const int numMeshes = _meshes.size();
@@ -3268,6 +2908,97 @@ void MacroparameterIBCell(const StorageSite& solidFaces) const
   }
 	  
 
+  // builds and solves the linear system of one direction
+  MFRPtr solveDirection(const int direction, LinearSolver& solver)
+  {
+    LinearSystem ls;
+    initKineticModelLinearization(ls, direction);
+    ls.initAssembly();
+    linearizeKineticModel(ls,direction);
+    ls.initSolve();
+    
+    MFRPtr kNorm(solver.solve(ls));
+    
+    ls.postSolve();
+    ls.updateSolution();
+    
+    solver.cleanup();
+    return kNorm;
+  }
+
+  int getDirectionThreadCount() const
+  {
+    const int nThreads = max(1, min(_options.directionThreads,
+                                    _quadrature.getDirCount()));
+    if (nThreads == 1)
+      return 1;
+#ifndef _OPENMP
+    throw CException("KineticModel: directionThreads > 1 needs a build with OpenMP");
+#endif
+#ifdef FVM_PARALLEL
+    // the solvers of different directions would otherwise mix up their
+    // messages to the other processes
+    if (MPI::COMM_WORLD.Get_size() > 1)
+      throw CException("KineticModel: directionThreads > 1 is only "
+                       "supported on a single process");
+    if (MPI::Query_thread() != MPI::THREAD_MULTIPLE)
+      throw CException("KineticModel: directionThreads > 1 needs MPI "
+                       "initialized with MPI::THREAD_MULTIPLE");
+#endif
+    return nThreads;
+  }
+
+  /**
+   * The directions are independent of each other once the equilibrium
+   * distribution is fixed, so they are handed out to nThreads threads
+   * with one linear solver each. The first direction is solved before
+   * the threads start, which sets up what the meshes only create on
+   * first use. The residuals of all directions are added up into the
+   * array of the first one, in the order of the directions so that the
+   * result does not depend on the number of threads.
+   */
+  MFRPtr solveDirections(const int nThreads)
+  {
+    const int N123 = _quadrature.getDirCount();
+    vector<MFRPtr> kNorms(N123);
+
+    kNorms[0] = solveDirection(0, _options.getDirectionLinearSolver(0));
+    for(int t=1; t<nThreads; t++)
+      _options.getDirectionLinearSolver(t);
+
+    string error;
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if (nThreads > 1)
+    for(int direction=1; direction<N123; direction++)
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        try
+        {
+            kNorms[direction] =
+              solveDirection(direction, _options.getDirectionLinearSolver(thread));
+        }
+        catch (std::exception& e)
+        {
+#pragma omp critical
+            error = e.what();
+        }
+    }
+    if (!error.empty())
+      throw CException(error);
+
+    MFRPtr rNorm(kNorms[0]);
+    Field& fn0 = *_dsfPtr.dsf[0];
+    ArrayBase& rArray0 = (*rNorm)[fn0];
+    for(int direction=1; direction<N123; direction++)
+    {
+        Field& fnd = *_dsfPtr.dsf[direction];
+        rArray0 += (*kNorms[direction])[fnd];
+    }
+    return rNorm;
+  }
+
   void callBoundaryConditions()
     
   { 
@@ -3361,7 +3092,6 @@ void MacroparameterIBCell(const StorageSite& solidFaces) const
   {
     for(int n=0; n<niter; n++)  
       {
-	const int N123 =_quadrature.getDirCount();
 	MFRPtr rNorm;
 	//MFRPtr vNorm;
        	//const TArray& cx= dynamic_cast<const TArray&>(*_quadrature.cxPtr);
@@ -3374,41 +3104,7 @@ void MacroparameterIBCell(const StorageSite& solidFaces) const
 	_macroFields.temperature.syncLocal();
 	_macroFields.density .syncLocal();
 	*/
-	for(int direction=0; direction<N123;direction++)
-	  {
-	    LinearSystem ls;
-	    initKineticModelLinearization(ls, direction);
-	    ls.initAssembly();
-	    linearizeKineticModel(ls,direction);
-	    ls.initSolve();
-	    
-	    //const T* kNorm=_options.getKineticLinearSolver().solve(ls);
-	     MFRPtr kNorm(_options.getKineticLinearSolver().solve(ls));
-	    
-	     
-	     if (!rNorm)
-	       rNorm = kNorm;
-	     else
-             {
-                 // find the array for the 0the direction residual and
-                 // add the current residual to it
-                 Field& fn0 = *_dsfPtr.dsf[0];
-                 Field& fnd = *_dsfPtr.dsf[direction];
-                 
-                 ArrayBase& rArray0 = (*rNorm)[fn0];
-                 ArrayBase& rArrayd = (*kNorm)[fnd];//*wts[direction];
-                 rArray0 += rArrayd;//*wts[direction];
-		 
-		 // ArrayBase& vArray0 = (*vNorm)[fn0];
-		 // vArray0 += rArrayd;//*cx[direction]*wts[direction];
-             }
-
-	     ls.postSolve();
-	     ls.updateSolution();
-	    		 
-	     _options.getKineticLinearSolver().cleanup();
-	    
-	  }
+	rNorm = solveDirections(getDirectionThreadCount());
 
 	
 	
@@ -3668,6 +3364,7 @@ void MacroparameterIBCell(const StorageSite& solidFaces) const
  
   const GeomFields& _geomFields;
   const Quadrature<T>& _quadrature;
+  const KineticKernels<T> _kernels;
  
   MacroFields& _macroFields;
   DistFunctFields<T> _dsfPtr;  
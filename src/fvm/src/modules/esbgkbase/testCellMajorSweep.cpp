@@ -0,0 +1,193 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Times a COMET-like sweep on the direction arrays and on the cell-major block.
+//
+// usage: testCellMajorSweep [n] [nDirections per axis] [nSweeps]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <sys/time.h>
+
+using namespace std;
+
+#include "Mesh.h"
+#include "Quadrature.h"
+#include "DistFunctFields.h"
+
+typedef double T;
+typedef Array<T> TArray;
+typedef DistFunctFields<T> TDistFF;
+
+namespace
+{
+  double wallTime()
+  {
+    struct timeval tv;
+    gettimeofday(&tv,0);
+    return tv.tv_sec + 1.0e-6*tv.tv_usec;
+  }
+
+  // the value of direction j in cell c in either layout
+  class DirectionMajor
+  {
+  public:
+    DirectionMajor(const vector<T*>& fs) : _fs(fs) {}
+    T& operator()(const int c, const int j) const {return _fs[j][c];}
+  private:
+    const vector<T*>& _fs;
+  };
+
+  class CellMajor
+  {
+  public:
+    CellMajor(T* block, const int stride) : _block(block), _stride(stride) {}
+    T& operator()(const int c, const int j) const {return _block[c*_stride+j];}
+  private:
+    T* _block;
+    const int _stride;
+  };
+
+  // each direction is relaxed towards the upwind values of the cell's
+  // neighbours, the boundary cells only see their neighbours inside
+  template<class F>
+  void sweep(const F& f, const int n, const Quadrature<T>& quad,
+             TArray& b, TArray& d)
+  {
+    const int numDir = quad.getDirCount();
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    const int offset[6][3] =
+      {{1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}};
+
+    for(int k=0; k<n; k++)
+      for(int j=0; j<n; j++)
+        for(int i=0; i<n; i++)
+        {
+            const int c = (k*n+j)*n+i;
+            for(int dir=0; dir<numDir; dir++)
+            {
+                b[dir] = f(c,dir);
+                d[dir] = 1.0;
+            }
+
+            for(int nf=0; nf<6; nf++)
+            {
+                const int ni = i+offset[nf][0];
+                const int nj = j+offset[nf][1];
+                const int nk = k+offset[nf][2];
+                if (ni < 0 || ni >= n || nj < 0 || nj >= n || nk < 0 || nk >= n)
+                  continue;
+                const int nb = (nk*n+nj)*n+ni;
+                for(int dir=0; dir<numDir; dir++)
+                {
+                    const T flux = cx[dir]*offset[nf][0] + cy[dir]*offset[nf][1]
+                      + cz[dir]*offset[nf][2];
+                    if (flux > 0)
+                      d[dir] += flux;
+                    else
+                      b[dir] -= flux*f(nb,dir);
+                }
+            }
+
+            for(int dir=0; dir<numDir; dir++)
+              f(c,dir) = b[dir]/d[dir];
+        }
+  }
+
+  vector<T*> getDirectionData(TDistFF& dsf, const StorageSite& cells)
+  {
+    const int numDir = int(dsf.dsf.size());
+    vector<T*> fs(numDir);
+    for(int dir=0; dir<numDir; dir++)
+      fs[dir] = &dynamic_cast<TArray&>((*dsf.dsf[dir])[cells])[0];
+    return fs;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 16;
+  const int nq = argc > 2 ? atoi(argv[2]) : 8;
+  const int nSweeps = argc > 3 ? atoi(argv[3]) : 3;
+
+  Mesh mesh(3);
+  StorageSite& cells = mesh.getCells();
+  cells.setCount(n*n*n);
+  MeshList meshes;
+  meshes.push_back(&mesh);
+
+  const Quadrature<T> quad(nq,nq,nq,5.5,1.0);
+  const int numDir = quad.getDirCount();
+  const int nCells = cells.getCount();
+
+  TDistFF dsf(meshes,quad,"f");
+  const vector<T*> fs(getDirectionData(dsf,cells));
+
+  TArray initial(nCells*numDir);
+  for(int dir=0; dir<numDir; dir++)
+    for(int c=0; c<nCells; c++)
+      initial[dir*nCells+c] = fs[dir][c];
+
+  TArray b(numDir);
+  TArray d(numDir);
+
+  double t0 = wallTime();
+  for(int s=0; s<nSweeps; s++)
+    sweep(DirectionMajor(fs),n,quad,b,d);
+  const double tArrays = (wallTime()-t0)/nSweeps;
+
+  TArray result(nCells*numDir);
+  for(int dir=0; dir<numDir; dir++)
+    for(int c=0; c<nCells; c++)
+    {
+        result[dir*nCells+c] = fs[dir][c];
+        fs[dir][c] = initial[dir*nCells+c];
+    }
+
+  double tCopies = 0;
+  t0 = wallTime();
+  for(int s=0; s<nSweeps; s++)
+  {
+      const double tc0 = wallTime();
+      dsf.invalidateBlocks();
+      TArray& block = dsf.gatherBlock(cells);
+      tCopies += wallTime()-tc0;
+
+      sweep(CellMajor(&block[0],dsf.getBlockStride()),n,quad,b,d);
+
+      const double tc1 = wallTime();
+      dsf.scatterBlock(cells);
+      tCopies += wallTime()-tc1;
+  }
+  const double tBlock = (wallTime()-t0)/nSweeps;
+  tCopies /= nSweeps;
+
+  bool ok = true;
+  for(int dir=0; dir<numDir; dir++)
+    for(int c=0; c<nCells; c++)
+      if (fs[dir][c] != result[dir*nCells+c])
+        ok = false;
+
+  cout << nCells << " cells, " << numDir << " directions, "
+       << nCells*numDir*sizeof(T)/1.0e6 << " MB per copy of f" << endl;
+  cout << "direction arrays: " << tArrays << " s per sweep" << endl;
+  cout << "cell-major block: " << tBlock << " s per sweep, of which "
+       << tCopies << " s gathering and scattering" << endl;
+  cout << (ok ? "passed" : "FAILED: the layouts give different values") << endl;
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return ok ? 0 : 1;
+}
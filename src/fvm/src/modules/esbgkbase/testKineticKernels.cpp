@@ -0,0 +1,493 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks KineticKernels against the loops KineticModel used before.
+//
+// usage: testKineticKernels [nCells] [nDirections per axis]
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "Array.h"
+#include "Vector.h"
+#include "MatrixOperation.h"
+#include "Quadrature.h"
+#include "KineticKernels.h"
+
+typedef double T;
+typedef Array<T> TArray;
+typedef Array2D<T> TArray2D;
+typedef Vector<T,3> VectorT3;
+typedef Array<VectorT3> VectorT3Array;
+typedef Vector<T,5> VectorT5;
+typedef Array<VectorT5> VectorT5Array;
+typedef Vector<T,6> VectorT6;
+typedef Array<VectorT6> VectorT6Array;
+typedef Vector<T,10> VectorT10;
+typedef Array<VectorT10> VectorT10Array;
+
+namespace
+{
+  const T pi = 3.14159265358979323846;
+
+  // the reference versions below are the loops of KineticModel before
+  // KineticKernels, with the fields replaced by arrays
+
+  void referenceMoments(const Quadrature<T>& quad, const vector<TArray*>& fA,
+                        const int nCells, TArray& density, VectorT3Array& v,
+                        TArray& temperature, TArray& pressure,
+                        VectorT6Array& stress)
+  {
+    const int N123 = quad.getDirCount();
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    const TArray& wts = *quad.dcxyzPtr;
+
+    for(int c=0; c<nCells; c++)
+    {
+        density[c] = 0.0;
+        v[c] = 0.0;
+        temperature[c] = 0.0;
+        stress[c] = 0.0;
+    }
+
+    for(int j=0; j<N123; j++)
+    {
+        const TArray& f = *fA[j];
+        for(int c=0; c<nCells; c++)
+        {
+            density[c] = density[c]+wts[j]*f[c];
+            v[c][0] = v[c][0]+(cx[j]*f[c])*wts[j];
+            v[c][1] = v[c][1]+(cy[j]*f[c])*wts[j];
+            v[c][2] = v[c][2]+(cz[j]*f[c])*wts[j];
+            temperature[c] = temperature[c]+(pow(cx[j],2.0)+pow(cy[j],2.0)
+                                             +pow(cz[j],2.0))*f[c]*wts[j];
+        }
+    }
+
+    for(int c=0; c<nCells; c++)
+    {
+        v[c][0] = v[c][0]/density[c];
+        v[c][1] = v[c][1]/density[c];
+        v[c][2] = v[c][2]/density[c];
+        temperature[c] = temperature[c]-(pow(v[c][0],2.0)
+                                         +pow(v[c][1],2.0)
+                                         +pow(v[c][2],2.0))*density[c];
+        temperature[c] = temperature[c]/(1.5*density[c]);
+        pressure[c] = density[c]*temperature[c];
+    }
+
+    for(int j=0; j<N123; j++)
+    {
+        const TArray& f = *fA[j];
+        for(int c=0; c<nCells; c++)
+        {
+            stress[c][0] += pow((cx[j]-v[c][0]),2.0)*f[c]*wts[j];
+            stress[c][1] += pow((cy[j]-v[c][1]),2.0)*f[c]*wts[j];
+            stress[c][2] += pow((cz[j]-v[c][2]),2.0)*f[c]*wts[j];
+            stress[c][3] += (cx[j]-v[c][0])*(cy[j]-v[c][1])*f[c]*wts[j];
+            stress[c][4] += (cy[j]-v[c][1])*(cz[j]-v[c][2])*f[c]*wts[j];
+            stress[c][5] += (cz[j]-v[c][2])*(cx[j]-v[c][0])*f[c]*wts[j];
+        }
+    }
+  }
+
+  void referenceESBGKMoments(const Quadrature<T>& quad,
+                             const vector<TArray*>& fA,
+                             const vector<TArray*>& fgamA, const T Pr,
+                             const int nCells, const TArray& density,
+                             const VectorT3Array& v, VectorT6Array& tensor)
+  {
+    const int N123 = quad.getDirCount();
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    const TArray& wts = *quad.dcxyzPtr;
+
+    for(int c=0; c<nCells; c++)
+      tensor[c] = 0.0;
+
+    for(int j=0; j<N123; j++)
+    {
+        const TArray& f = *fA[j];
+        const TArray& fgam = *fgamA[j];
+        for(int c=0; c<nCells; c++)
+        {
+            const T fm = ((1-1/Pr)*f[c]+1/Pr*fgam[c])*wts[j];
+            tensor[c][0] += pow(cx[j]-v[c][0],2)*fm;
+            tensor[c][1] += pow(cy[j]-v[c][1],2)*fm;
+            tensor[c][2] += pow(cz[j]-v[c][2],2)*fm;
+            tensor[c][3] += (cx[j]-v[c][0])*(cy[j]-v[c][1])*fm;
+            tensor[c][4] += (cy[j]-v[c][1])*(cz[j]-v[c][2])*fm;
+            tensor[c][5] += (cz[j]-v[c][2])*(cx[j]-v[c][0])*fm;
+        }
+    }
+
+    for(int c=0; c<nCells; c++)
+      for(int k=0; k<6; k++)
+        tensor[c][k] /= density[c];
+  }
+
+  void referenceMaxwellian(const Quadrature<T>& quad, const VectorT5Array& coeff,
+                           const VectorT3Array& v, const int nCells,
+                           const vector<TArray*>& fEqA)
+  {
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    for(int j=0; j<quad.getDirCount(); j++)
+    {
+        TArray& fEq = *fEqA[j];
+        for(int c=0; c<nCells; c++)
+          fEq[c] = coeff[c][0]*exp(-coeff[c][1]*(pow(cx[j]-v[c][0],2)+pow(cy[j]-v[c][1],2)
+                                                 +pow(cz[j]-v[c][2],2))+coeff[c][2]*(cx[j]-v[c][0])
+                                   +coeff[c][3]*(cy[j]-v[c][1])+coeff[c][4]*(cz[j]-v[c][2]));
+    }
+  }
+
+  void referenceESGaussian(const Quadrature<T>& quad, const VectorT10Array& coeffg,
+                           const VectorT3Array& v, const int nCells,
+                           const vector<TArray*>& fEqESA)
+  {
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    for(int j=0; j<quad.getDirCount(); j++)
+    {
+        TArray& fEqES = *fEqESA[j];
+        for(int c=0; c<nCells; c++)
+        {
+            T Cc1 = (cx[j]-v[c][0]);
+            T Cc2 = (cy[j]-v[c][1]);
+            T Cc3 = (cz[j]-v[c][2]);
+            fEqES[c] = coeffg[c][0]*exp(-coeffg[c][1]*pow(Cc1,2)+coeffg[c][2]*Cc1
+                                        -coeffg[c][3]*pow(Cc2,2)+coeffg[c][4]*Cc2
+                                        -coeffg[c][5]*pow(Cc3,2)+coeffg[c][6]*Cc3
+                                        +coeffg[c][7]*cx[j]*cy[j]+coeffg[c][8]*cy[j]*cz[j]
+                                        +coeffg[c][9]*cz[j]*cx[j]);
+        }
+    }
+  }
+
+  // the Newton iterations one cell at a time with the Jacobians of
+  // setJacobianBGK and setJacobianESBGK
+  template<int N>
+  void referenceNewton(const Quadrature<T>& quad, const Vector<T,N>& target,
+                       const VectorT3& v, const int ktrial, const T tolx,
+                       const T tolf, Vector<T,N>& xn)
+  {
+    const TArray& cx = *quad.cxPtr;
+    const TArray& cy = *quad.cyPtr;
+    const TArray& cz = *quad.czPtr;
+    const TArray& wts = *quad.dcxyzPtr;
+    const TArray2D& malpha = N == 5 ? *quad.malphaBGKPtr : *quad.malphaESBGKPtr;
+
+    for (int trial=0; trial<ktrial; trial++)
+    {
+        SquareMatrix<T,N> fjac(0);
+        SquareMatrix<T,N> fjacinv(0);
+        Vector<T,N> fvec(target);
+        Vector<T,N> mexp;
+
+        for(int j=0; j<quad.getDirCount(); j++)
+        {
+            const T Cc1 = cx[j]-v[0];
+            const T Cc2 = cy[j]-v[1];
+            const T Cc3 = cz[j]-v[2];
+            if (N == 5)
+            {
+                const T Cconst = pow(Cc1,2.0)+pow(Cc2,2.0)+pow(Cc3,2.0);
+                const T Econst = xn[0]*exp(-xn[1]*Cconst+xn[2]*Cc1+xn[3]*Cc2
+                                           +xn[4]*Cc3)*wts[j];
+                mexp[0] = -Econst/xn[0];
+                mexp[1] = Econst*Cconst;
+                mexp[2] = -Econst*Cc1;
+                mexp[3] = -Econst*Cc2;
+                mexp[4] = -Econst*Cc3;
+                for (int row=0; row<N; row++)
+                  fvec[row] += -Econst*malpha(j,row);
+            }
+            else
+            {
+                const T Econst = xn[0]*exp(-xn[1]*pow(Cc1,2)+xn[2]*Cc1
+                                           -xn[3]*pow(Cc2,2)+xn[4]*Cc2
+                                           -xn[5]*pow(Cc3,2)+xn[6]*Cc3
+                                           +xn[7]*cx[j]*cy[j]+xn[8]*cy[j]*cz[j]
+                                           +xn[9]*cz[j]*cx[j])*wts[j];
+                mexp[0] = -Econst/xn[0];
+                mexp[1] = Econst*pow(Cc1,2);
+                mexp[2] = -Econst*Cc1;
+                mexp[3] = Econst*pow(Cc2,2);
+                mexp[4] = -Econst*Cc2;
+                mexp[5] = Econst*pow(Cc3,2);
+                mexp[6] = -Econst*Cc3;
+                mexp[7] = -Econst*cx[j]*cy[j];
+                mexp[8] = -Econst*cy[j]*cz[j];
+                mexp[9] = -Econst*cz[j]*cx[j];
+                for (int row=0; row<N; row++)
+                  fvec[row] += -Econst*malpha(j,row);
+            }
+            for (int row=0; row<N; row++)
+              for (int col=0; col<N; col++)
+                fjac(row,col) += malpha(j,row)*mexp[col];
+        }
+
+        T errf = 0.;
+        for (int row=0; row<N; row++)
+          errf += fabs(fvec[row]);
+        if (errf <= tolf)
+          break;
+
+        fjacinv = inverseGauss(fjac,N);
+
+        T errx = 0.;
+        for (int row=0; row<N; row++)
+        {
+            T x = 0.0;
+            for (int col=0; col<N; col++)
+              x += -fjacinv(row,col)*fvec[col];
+            errx += fabs(x);
+            xn[row] += x;
+        }
+        if (errx <= tolx)
+          break;
+    }
+  }
+
+  vector<TArray*> newFields(const int nDirections, const int nCells)
+  {
+    vector<TArray*> f(nDirections);
+    for(int j=0; j<nDirections; j++)
+      f[j] = new TArray(nCells);
+    return f;
+  }
+
+  void deleteFields(vector<TArray*>& f)
+  {
+    for(size_t j=0; j<f.size(); j++)
+      delete f[j];
+    f.clear();
+  }
+
+  vector<const TArray*> constFields(const vector<TArray*>& f)
+  {
+    return vector<const TArray*>(f.begin(),f.end());
+  }
+
+  // the largest difference relative to the largest value of the
+  // reference, both over all components
+  template<class X>
+  double relDiff(const Array<X>& a, const Array<X>& ref, const int nCells)
+  {
+    const int n = nCells*int(sizeof(X)/sizeof(T));
+    const T* ad = (const T*) a.getData();
+    const T* rd = (const T*) ref.getData();
+    double d = 0, s = 0;
+    for(int i=0; i<n; i++)
+    {
+        d = max(d,fabs(ad[i]-rd[i]));
+        s = max(s,fabs(rd[i]));
+    }
+    return s > 0 ? d/s : d;
+  }
+
+  double relDiff(const vector<TArray*>& a, const vector<TArray*>& ref,
+                 const int nCells)
+  {
+    double d = 0;
+    for(size_t j=0; j<a.size(); j++)
+      d = max(d,relDiff(*a[j],*ref[j],nCells));
+    return d;
+  }
+
+  bool check(const char* name, const double diff, const double tol)
+  {
+    const bool ok = diff <= tol;
+    cout << "  " << name << ": relative difference " << diff
+         << (ok ? "" : "  FAILED") << endl;
+    return ok;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const int nCells = argc > 1 ? atoi(argv[1]) : 203;
+  const int nAxis = argc > 2 ? atoi(argv[2]) : 8;
+
+  const Quadrature<T> quad(nAxis,nAxis,nAxis,5.5,1.0);
+  const int nDirections = quad.getDirCount();
+  const KineticKernels<T> kernels(quad);
+  const TArray& cx = *quad.cxPtr;
+  const TArray& cy = *quad.cyPtr;
+  const TArray& cz = *quad.czPtr;
+
+  cout << nCells << " cells, " << nDirections << " directions" << endl;
+
+  // a Maxwellian of varying density, velocity and temperature with a
+  // perturbation that gives non zero shear stresses
+  TArray rho0(nCells), T0(nCells);
+  VectorT3Array v0(nCells);
+  for(int c=0; c<nCells; c++)
+  {
+      rho0[c] = 1.0 + 0.3*sin(0.1*c);
+      T0[c] = 1.0 + 0.2*cos(0.07*c);
+      v0[c][0] = 0.2*sin(0.05*c);
+      v0[c][1] = 0.1*cos(0.11*c);
+      v0[c][2] = 0.05*sin(0.13*c);
+  }
+
+  vector<TArray*> f = newFields(nDirections,nCells);
+  vector<TArray*> fgam = newFields(nDirections,nCells);
+  for(int j=0; j<nDirections; j++)
+    for(int c=0; c<nCells; c++)
+    {
+        const T c2 = pow(cx[j]-v0[c][0],2) + pow(cy[j]-v0[c][1],2)
+          + pow(cz[j]-v0[c][2],2);
+        const T fm = rho0[c]/pow(pi*T0[c],1.5)*exp(-c2/T0[c]);
+        (*f[j])[c] = fm*(1.0 + 0.1*sin(0.3*j + 0.01*c)*(cx[j]*cy[j]));
+        (*fgam[j])[c] = fm*(1.0 + 0.05*cos(0.2*j)*(cy[j]*cz[j]));
+    }
+
+  bool ok = true;
+
+  cout << "moments" << endl;
+  TArray density(nCells), temperature(nCells), pressure(nCells);
+  TArray densityR(nCells), temperatureR(nCells), pressureR(nCells);
+  VectorT3Array v(nCells), vR(nCells);
+  VectorT6Array stress(nCells), stressR(nCells);
+  kernels.computeMoments(constFields(f),nCells,density,v,temperature,
+                         pressure,stress);
+  referenceMoments(quad,f,nCells,densityR,vR,temperatureR,pressureR,stressR);
+  ok = check("density",relDiff(density,densityR,nCells),1e-13) && ok;
+  ok = check("velocity",relDiff(v,vR,nCells),1e-12) && ok;
+  ok = check("temperature",relDiff(temperature,temperatureR,nCells),1e-12) && ok;
+  ok = check("pressure",relDiff(pressure,pressureR,nCells),1e-12) && ok;
+  ok = check("stress",relDiff(stress,stressR,nCells),1e-12) && ok;
+
+  // the same from a cell-major block with padding after each cell
+  const int stride = nDirections + 3;
+  TArray block(nCells*stride);
+  block.zero();
+  for(int c=0; c<nCells; c++)
+    for(int j=0; j<nDirections; j++)
+      block[c*stride+j] = (*f[j])[c];
+  kernels.computeMoments(block,stride,nCells,density,v,temperature,
+                         pressure,stress);
+  ok = check("block density",relDiff(density,densityR,nCells),1e-13) && ok;
+  ok = check("block velocity",relDiff(v,vR,nCells),1e-12) && ok;
+  ok = check("block temperature",
+             relDiff(temperature,temperatureR,nCells),1e-12) && ok;
+  ok = check("block pressure",relDiff(pressure,pressureR,nCells),1e-12) && ok;
+  ok = check("block stress",relDiff(stress,stressR,nCells),1e-12) && ok;
+
+  const T Pr = 2.0/3.0;
+  TArray Txx(nCells), Tyy(nCells), Tzz(nCells);
+  TArray Txy(nCells), Tyz(nCells), Tzx(nCells);
+  VectorT6Array tensor(nCells), tensorR(nCells);
+  kernels.computeESBGKMoments(constFields(f),constFields(fgam),Pr,nCells,
+                              densityR,vR,Txx,Tyy,Tzz,Txy,Tyz,Tzx);
+  for(int c=0; c<nCells; c++)
+  {
+      tensor[c][0] = Txx[c];
+      tensor[c][1] = Tyy[c];
+      tensor[c][2] = Tzz[c];
+      tensor[c][3] = Txy[c];
+      tensor[c][4] = Tyz[c];
+      tensor[c][5] = Tzx[c];
+  }
+  referenceESBGKMoments(quad,f,fgam,Pr,nCells,densityR,vR,tensorR);
+  ok = check("ES-BGK temperature tensor",relDiff(tensor,tensorR,nCells),1e-12) && ok;
+
+  // coefficients near those of the Maxwellian of the moments, with all
+  // the terms of the exponents present
+  cout << "equilibrium distributions" << endl;
+  VectorT5Array coeff(nCells);
+  VectorT10Array coeffg(nCells);
+  for(int c=0; c<nCells; c++)
+  {
+      coeff[c][0] = densityR[c]/pow(pi*temperatureR[c],1.5);
+      coeff[c][1] = 1/temperatureR[c];
+      coeff[c][2] = 0.02*sin(0.3*c);
+      coeff[c][3] = 0.02*cos(0.2*c);
+      coeff[c][4] = 0.01*sin(0.1*c);
+
+      coeffg[c][0] = coeff[c][0];
+      coeffg[c][1] = coeff[c][1];
+      coeffg[c][2] = coeff[c][2];
+      coeffg[c][3] = 1.01*coeff[c][1];
+      coeffg[c][4] = coeff[c][3];
+      coeffg[c][5] = 0.99*coeff[c][1];
+      coeffg[c][6] = coeff[c][4];
+      coeffg[c][7] = 0.01*sin(0.4*c);
+      coeffg[c][8] = 0.01*cos(0.3*c);
+      coeffg[c][9] = 0.005;
+  }
+
+  vector<TArray*> fEq = newFields(nDirections,nCells);
+  vector<TArray*> fEqR = newFields(nDirections,nCells);
+  kernels.computeMaxwellian(coeff,vR,nCells,fEq);
+  referenceMaxwellian(quad,coeff,vR,nCells,fEqR);
+  ok = check("Maxwellian",relDiff(fEq,fEqR,nCells),1e-12) && ok;
+
+  kernels.computeESGaussian(coeffg,vR,nCells,fEq);
+  referenceESGaussian(quad,coeffg,vR,nCells,fEqR);
+  ok = check("ES-Gaussian",relDiff(fEq,fEqR,nCells),1e-12) && ok;
+
+  cout << "Newton iterations" << endl;
+  const int ktrial = 20;
+  const T tolx = 1e-10;
+  const T tolf = 1e-10;
+
+  VectorT5Array coeffR(nCells);
+  coeffR = coeff;
+  kernels.solveMaxwellianCoefficients(densityR,temperatureR,vR,nCells,
+                                      ktrial,tolx,tolf,coeff);
+  for(int c=0; c<nCells; c++)
+  {
+      const VectorT3& u = vR[c];
+      VectorT5 target;
+      target[0] = densityR[c];
+      target[1] = densityR[c]*u[0];
+      target[2] = densityR[c]*u[1];
+      target[3] = densityR[c]*u[2];
+      target[4] = 1.5*densityR[c]*temperatureR[c]
+        + densityR[c]*(pow(u[0],2)+pow(u[1],2)+pow(u[2],2.0));
+      referenceNewton<5>(quad,target,u,ktrial,tolx,tolf,coeffR[c]);
+  }
+  ok = check("BGK coefficients",relDiff(coeff,coeffR,nCells),1e-10) && ok;
+
+  VectorT10Array coeffgR(nCells);
+  coeffgR = coeffg;
+  kernels.solveESGaussianCoefficients(densityR,vR,Txx,Tyy,Tzz,Txy,Tyz,Tzx,
+                                      nCells,ktrial,tolx,tolf,coeffg);
+  for(int c=0; c<nCells; c++)
+  {
+      const VectorT3& u = vR[c];
+      VectorT10 target;
+      target[0] = densityR[c];
+      target[1] = densityR[c]*u[0];
+      target[2] = densityR[c]*u[1];
+      target[3] = densityR[c]*u[2];
+      target[4] = densityR[c]*(pow(u[0],2)+Txx[c]);
+      target[5] = densityR[c]*(pow(u[1],2)+Tyy[c]);
+      target[6] = densityR[c]*(pow(u[2],2)+Tzz[c]);
+      target[7] = densityR[c]*(u[0]*u[1]+Txy[c]);
+      target[8] = densityR[c]*(u[1]*u[2]+Tyz[c]);
+      target[9] = densityR[c]*(u[2]*u[0]+Tzx[c]);
+      referenceNewton<10>(quad,target,u,ktrial,tolx,tolf,coeffgR[c]);
+  }
+  ok = check("ES-BGK coefficients",relDiff(coeffg,coeffgR,nCells),1e-10) && ok;
+
+  deleteFields(f);
+  deleteFields(fgam);
+  deleteFields(fEq);
+  deleteFields(fEqR);
+
+  cout << (ok ? "passed" : "FAILED") << endl;
+  return ok ? 0 : 1;
+}
@@ -12,6 +12,38 @@
 #include <set>
 int AMG::amg_indx = 0;
 
+namespace
+{
+  // conversions between the double precision vectors of the finest
+  // system and those of its single precision copy
+  
+  void copyToSinglePrecision(const MultiField& x, MultiField& spX)
+  {
+    const MultiField::ArrayIndexList& arrayIndices = spX.getArrayIndices();
+    foreach(MultiField::ArrayIndex k,arrayIndices)
+    {
+        const Array<double>& xk = dynamic_cast<const Array<double>&>(x[k]);
+        Array<float>& spXk = dynamic_cast<Array<float>&>(spX[k]);
+        const int length = xk.getLength();
+        for(int i=0; i<length; i++)
+          spXk[i] = float(xk[i]);
+    }
+  }
+
+  void addFromSinglePrecision(MultiField& x, const MultiField& spX)
+  {
+    const MultiField::ArrayIndexList& arrayIndices = spX.getArrayIndices();
+    foreach(MultiField::ArrayIndex k,arrayIndices)
+    {
+        Array<double>& xk = dynamic_cast<Array<double>&>(x[k]);
+        const Array<float>& spXk = dynamic_cast<const Array<float>&>(spX[k]);
+        const int length = xk.getLength();
+        for(int i=0; i<length; i++)
+          xk[i] += spXk[i];
+    }
+  }
+}
+
 AMG::AMG() :
   maxCoarseLevels(30),
   nPreSweeps(0),
@@ -21,11 +53,28 @@ AMG::AMG() :
   cycleType(V_CYCLE),
   smootherType(GAUSS_SEIDEL),
   scaleCorrections(true),
+  coarseningType(GROUPING),
+  strengthThreshold(-1),
+  prolongationSmoothing(4.0/3.0),
+  reuseCoarseLevels(false),
+  recoarsenInterval(0),
+  recoarsenCycleRatio(0),
+  coarsestLevelDirectSolve(false),
+  directSolveSize(500),
+  mergeRowsPerProcess(0),
+  agglomerationFactor(4),
+  singlePrecision(false),
   _finestLinearSystem(0),
   _mergeLevelSize(0),
   _mergeLevel(-1),
   _isMerge(false),
   _totalIterations(0),
+  _coarseLevelsOutdated(false),
+  _recoarsen(false),
+  _nSolvesSinceCoarsening(0),
+  _nCyclesAfterCoarsening(0),
+  _nCyclesThisSolve(0),
+  _coarsestFactorizationOutdated(false),
 #ifdef FVM_PARALLEL
   _commTarget(MPI::COMM_WORLD),
 #endif
@@ -40,12 +89,25 @@ AMG::~AMG()
   logDtor();
 }
 
+// level 0 is the single precision copy of the finest system when the
+// hierarchy is in single precision
+
+LinearSystem&
+AMG::getLinearSystem(const int level)
+{
+  if (level > 0)
+    return *_coarseLinearSystems[level-1];
+  else if (singlePrecision)
+    return _finestLinearSystem->getSinglePrecision();
+  else
+    return *_finestLinearSystem;
+}
+
 void
 AMG::doSweeps(const int nSweeps, const int level)
 {
 
-  LinearSystem& ls = (level == 0) ?
-    *_finestLinearSystem : *_coarseLinearSystems[level-1];
+  LinearSystem& ls = getLinearSystem(level);
 
   const MultiFieldMatrix& m = ls.getMatrix();
   MultiField& delta = ls.getDelta();
@@ -59,6 +121,21 @@ AMG::doSweeps(const int nSweeps, const int level)
           m.forwardGS(delta,b,r);
           m.reverseGS(delta,b,r);
       }
+      else if (smootherType == MULTICOLOR_GAUSS_SEIDEL)
+      {
+          m.forwardColoredGS(delta,b,r);
+          m.reverseColoredGS(delta,b,r);
+      }
+      else if (smootherType == HYBRID_GAUSS_SEIDEL)
+      {
+          m.forwardBlockGS(delta,b,r);
+          m.reverseBlockGS(delta,b,r);
+      }
+      else if (smootherType == L1_JACOBI)
+      {
+          m.l1Jacobi(delta,b,r);
+          m.l1Jacobi(delta,b,r);
+      }
       else
       {
           m.Jacobi(delta,b,r);
@@ -70,12 +147,19 @@ AMG::doSweeps(const int nSweeps, const int level)
 void
 AMG::cycle( CycleType cycleType, const int level)
 {
+  if (_coarsestSolver && level > 0 && level == (int)_coarseLinearSystems.size())
+  {
+      _coarsestSolver->reuseFactorization = !_coarsestFactorizationOutdated;
+      _coarsestSolver->smooth(*_coarseLinearSystems[level-1]);
+      _coarsestFactorizationOutdated = false;
+      return;
+  }
+
   doSweeps(nPreSweeps,level);
 
   if (level < (int)_coarseLinearSystems.size())
   {
-      LinearSystem& fineLS = (level == 0) ?
-        *_finestLinearSystem : *_coarseLinearSystems[level-1];
+      LinearSystem& fineLS = getLinearSystem(level);
 
 
       LinearSystem& coarseLS = *_coarseLinearSystems[level];
@@ -92,24 +176,42 @@ AMG::cycle( CycleType cycleType, const int level)
                                 coarseLS.getB());
  
       int nextLevel = level+1;
+      bool isNextLevelHere = true;
 #ifdef  FVM_PARALLEL
       if ( nextLevel == _mergeLevel ) 
       {	
           _mergeLS->gatherB();
           nextLevel++;
       }
+
+      // the processes the coarse level was agglomerated away from only
+      // send their part of b and get back their part of the correction
+      LinearSystemAgglomerator *agglomerator = 0;
+      if (_agglomerators.find(nextLevel) != _agglomerators.end())
+      {
+          agglomerator = _agglomerators[nextLevel].get();
+          agglomerator->gatherB();
+          isNextLevelHere = agglomerator->isActive();
+          nextLevel++;
+      }
 #endif
      //if ( level == 4 ) 
      //   cycleType = W_CYCLE;
 
-     cycle(cycleType,nextLevel);
+      if (isNextLevelHere)
+      {
+          cycle(cycleType,nextLevel);
 
-      if (cycleType == W_CYCLE)
-        cycle(W_CYCLE,nextLevel);
-      else if (cycleType == F_CYCLE)
-        cycle(V_CYCLE,nextLevel);
+          if (cycleType == W_CYCLE)
+            cycle(W_CYCLE,nextLevel);
+          else if (cycleType == F_CYCLE)
+            cycle(V_CYCLE,nextLevel);
+      }
 
 #ifdef  FVM_PARALLEL
+      if (agglomerator)
+        agglomerator->scatterDelta();
+
       if ( level+1 == _mergeLevel ) {
           _mergeLS->scatterDelta();
       }
@@ -121,11 +223,20 @@ AMG::cycle( CycleType cycleType, const int level)
           const MultiField& x = coarseLS.getDelta();
           const MultiField& b = coarseLS.getB();
           const MultiFieldMatrix& A = coarseLS.getMatrix();
-          MFRPtr xb =  x.dotWith(b);
+          MFRPtr xb =  x.dotWith(b,false);
+          MFRPtr xTAx = A.quadProduct(x,false);
+
+#ifdef FVM_PARALLEL
+          // over the processes that hold the coarse level
+          MultiFieldReductionSync reduction(getLevelComm(level+1));
+          reduction.add(*xb);
+          reduction.add(*xTAx);
+          reduction.start();
+          reduction.finish();
+#endif
           xb->reduceSum();
 
           MFRPtr mxb = -(*xb);
-          MFRPtr xTAx = A.quadProduct(x);
 
           xTAx->reduceSum();
           
@@ -146,17 +257,158 @@ doSweeps(nPostSweeps,level);
   
 }
 
+/**
+ * one cycle on the single precision hierarchy for the residual of the
+ * finest system, whose correction is then added to the double
+ * precision delta
+ * 
+ */
+
+void
+AMG::singlePrecisionCycle(const bool isResidualCurrent)
+{
+  LinearSystem& spLS = _finestLinearSystem->getSinglePrecision();
+
+  if (!isResidualCurrent)
+    _finestLinearSystem->getMatrix().computeResidual(_finestLinearSystem->getDelta(),
+                                                     _finestLinearSystem->getB(),
+                                                     _finestLinearSystem->getResidual());
+
+  copyToSinglePrecision(_finestLinearSystem->getResidual(),spLS.getB());
+  spLS.getDelta().zero();
+
+  cycle(cycleType,0);
+
+  addFromSinglePrecision(_finestLinearSystem->getDelta(),spLS.getDelta());
+}
+
+// one cycle on the finest level, from solve or as a preconditioner;
+// counted for the recoarsening policy
+
+void
+AMG::finestCycle(const bool isResidualCurrent)
+{
+  if (singlePrecision)
+    singlePrecisionCycle(isResidualCurrent);
+  else
+    cycle(cycleType,0);
+  _nCyclesThisSolve++;
+}
+
+/**
+ * ends the bookkeeping of the current solve, i.e. of a call to solve
+ * or of the smooth calls of a Krylov solver between two cleanups
+ * 
+ */
+
+void
+AMG::countSolve()
+{
+  if (_nCyclesThisSolve == 0)
+    return;
+
+  if (_nSolvesSinceCoarsening == 0)
+    _nCyclesAfterCoarsening = _nCyclesThisSolve;
+  else if (recoarsenCycleRatio > 0 &&
+           _nCyclesThisSolve > recoarsenCycleRatio*_nCyclesAfterCoarsening)
+    _recoarsen = true;
+  _nSolvesSinceCoarsening++;
+  _nCyclesThisSolve = 0;
+}
+
+// the coarsest level can only be solved directly if it isn't
+// distributed over several processes
+
+bool
+AMG::isCoarsestLevelLocal() const
+{
+#ifdef FVM_PARALLEL
+  if (_mergeLevel != -1)
+    return true;
+  if (!_agglomerators.empty())
+  {
+      const LinearSystemAgglomerator& last = *_agglomerators.rbegin()->second;
+      return last.isActive() && last.getComm().Get_size() == 1;
+  }
+  return MPI::COMM_WORLD.Get_size() == 1;
+#else
+  return true;
+#endif
+}
+
+#ifdef FVM_PARALLEL
+
+// the processes that hold the given level, i.e. those that the last
+// agglomeration before it was done onto
+
+const MPI::Intracomm&
+AMG::getLevelComm(const int level) const
+{
+  const MPI::Intracomm* comm = &MPI::COMM_WORLD;
+  typedef map<int, shared_ptr<LinearSystemAgglomerator> > AgglomeratorMap;
+  foreach(const AgglomeratorMap::value_type& pos, _agglomerators)
+    if (pos.first < level)
+      comm = &pos.second->getComm();
+  return *comm;
+}
+
+#endif
+
 void
 AMG::createCoarseLevels( )
 {
 
   _coarseLinearSystems.clear();
+  _coarsestSolver.reset();
+
+  if (singlePrecision &&
+      (coarsestLevelDirectSolve || mergeRowsPerProcess > 0 || _isMerge))
+    throw CException("AMG: singlePrecision can not be combined with "
+                     "coarsestLevelDirectSolve or with merging the coarse levels");
+
+  if (singlePrecision)
+    _finestLinearSystem->createSinglePrecision();
+
+  // the strength based coarsenings and their Galerkin coarse matrices
+  // are only implemented for scalar matrices
+  if (coarseningType != GROUPING)
+  {
+      const MultiField& b = _finestLinearSystem->getB();
+      const MultiField::ArrayIndexList& arrayIndices = b.getArrayIndices();
+      foreach(MultiField::ArrayIndex k,arrayIndices)
+        if (!dynamic_cast<const Array<double>*>(&b[k]))
+          throw CException("AMG: CLASSICAL and SMOOTHED_AGGREGATION coarsening "
+                           "are only available for scalar systems, use GROUPING");
+  }
+
+#ifdef FVM_PARALLEL
+  // undo the merge or agglomerations done for the previous
+  // coarsening, if any
+  _mergeLevel = -1;
+  _mergeLS.reset();
+  _agglomerators.clear();
+  if (!_isCOMMWORLD)
+    flipComm();
+#endif
+
   for(int n=0; n<maxCoarseLevels; n++)
   {
-      LinearSystem& fineLS = (n == 0) ?
-        *_finestLinearSystem : *_coarseLinearSystems[n-1];
-      shared_ptr<LinearSystem>
-        coarseLS(fineLS.createCoarse(coarseGroupSize,weightRatioThreshold));
+      LinearSystem& fineLS = getLinearSystem(n);
+      const double threshold = strengthThreshold >= 0 ? strengthThreshold :
+        (coarseningType == CLASSICAL && !singlePrecision ? 0.25 : 0.08);
+
+      shared_ptr<LinearSystem> coarseLS;
+      if (coarseningType == GROUPING)
+        coarseLS = fineLS.createCoarse(coarseGroupSize,weightRatioThreshold);
+      else if (singlePrecision)
+        coarseLS = fineLS.createCoarse(coarseGroupSize,weightRatioThreshold,
+                                       threshold);
+      else if (coarseningType == CLASSICAL)
+        coarseLS = fineLS.createCoarse(coarseGroupSize,weightRatioThreshold,
+                                       threshold,true);
+      else
+        coarseLS = fineLS.createCoarse(coarseGroupSize,weightRatioThreshold,
+                                       threshold,false,prolongationSmoothing);
 
       coarseLS->isSymmetric = fineLS.isSymmetric;
 
@@ -177,10 +429,39 @@ AMG::createCoarseLevels( )
         cout << " proc_id = " << MPI::COMM_WORLD.Get_rank() << "  Created coarse level " << n << " of size "
              << min_size  << endl;
 
+      const int mergeSize = coarseLS->getMatrix().getMergeSize( _commTarget );
+
+      // move the level onto fewer processes, which carry on coarsening
+      // it among themselves while the others stop here
+      const int nProcs = _commTarget.Get_size();
+      int agglomerate = int(!_isMerge && mergeRowsPerProcess > 0 &&
+                            agglomerationFactor > 1 && nProcs > 1 &&
+                            mergeSize < mergeRowsPerProcess*nProcs &&
+                            LinearSystemAgglomerator::isSupported(*coarseLS));
+      _commTarget.Allreduce(MPI::IN_PLACE, &agglomerate, 1, MPI::INT, MPI::MIN);
+
+      if (agglomerate)
+      {
+          shared_ptr<LinearSystemAgglomerator> agglomerator
+            (new LinearSystemAgglomerator(_commTarget,agglomerationFactor,
+                                          *coarseLS));
+          _agglomerators[n+1] = agglomerator;
+          if (!agglomerator->isActive())
+            break;
+
+          _coarseLinearSystems.push_back(agglomerator->getLS());
+          n++;
+          _commTarget = agglomerator->getComm();
+          _isCOMMWORLD = false;
+          min_size = _coarseLinearSystems.back()->getMatrix().getMinSize( _commTarget );
+      }
+
       if ( min_size <= 3  )
         break;
 
-      if ( coarseLS->getMatrix().getMergeSize( _commTarget ) < _mergeLevelSize &&  _mergeLevel == -1  && _isMerge ){
+      const bool mergeBySize = _isMerge && mergeSize < _mergeLevelSize;
+
+      if ( mergeBySize && _mergeLevel == -1 ){
          _mergeLevel = n+1;
          set<int> group;
          int size = MPI::COMM_WORLD.Get_size();
@@ -194,6 +475,9 @@ AMG::createCoarseLevels( )
           flipComm(); //this change to COMM_WORLD to one-processedGROUP 
       } 
 
+      if ( coarsestLevelDirectSolve && isCoarsestLevelLocal() &&
+           _coarseLinearSystems.back()->getMatrix().getMergeSize( _commTarget ) <= directSolveSize )
+        break;
 #endif 
 
 #ifndef FVM_PARALLEL
@@ -202,29 +486,113 @@ AMG::createCoarseLevels( )
     if ( verbosity > 1 )
         cout << "Created coarse level " << n << " of size " << coarseLS->getMatrix().getSize() << endl;
     _coarseLinearSystems.push_back(coarseLS);
+    if ( coarsestLevelDirectSolve &&
+         coarseLS->getMatrix().getSize() <= directSolveSize )
+       break;
 #endif
 
   }
 
+  if (coarsestLevelDirectSolve && isCoarsestLevelLocal() &&
+      !_coarseLinearSystems.empty())
+  {
+      _coarsestSolver = shared_ptr<DirectSolver>(new DirectSolver());
+      _coarsestFactorizationOutdated = true;
+  }
 
 }
 
+void
+AMG::updateCoarseLevels()
+{
+  if (singlePrecision)
+    _finestLinearSystem->updateSinglePrecision();
+
+  const int nLevels = _coarseLinearSystems.size();
+  for(int n=0; n<nLevels; n++)
+  {
+#ifdef FVM_PARALLEL
+      // the merged level is a gathered copy of the one above it
+      if (n == _mergeLevel)
+      {
+          _mergeLS->gatherMatrix();
+          continue;
+      }
+      if (_agglomerators.find(n) != _agglomerators.end())
+      {
+          _agglomerators[n]->gatherMatrix();
+          continue;
+      }
+#endif
+      LinearSystem& fineLS = getLinearSystem(n);
+      fineLS.updateCoarse();
+  }
+
+#ifdef FVM_PARALLEL
+  // the processes that the last level was agglomerated away from
+  if (_agglomerators.find(nLevels) != _agglomerators.end())
+    _agglomerators[nLevels]->gatherMatrix();
+#endif
+  _coarsestFactorizationOutdated = true;
+}
+
+void
+AMG::initCoarseLevels(LinearSystem& ls)
+{
+  if (_finestLinearSystem == &ls && !_coarseLevelsOutdated)
+    return;
+
+  countSolve();
+
+  /**
+   * the coarse levels from the previous solve can be reused if they
+   * were created for this system, i.e. ls still has the coarsening
+   * (a new system that happens to have the same address won't), and
+   * the recoarsening policy doesn't ask for new ones
+   * 
+   */
+
+  const bool hasCoarse = singlePrecision ?
+    (ls.hasSinglePrecision() && ls.getSinglePrecision().hasCoarse()) :
+    ls.hasCoarse();
+
+  if (_finestLinearSystem == &ls && hasCoarse && !_recoarsen &&
+      (recoarsenInterval <= 0 || _nSolvesSinceCoarsening < recoarsenInterval))
+  {
+      updateCoarseLevels();
+  }
+  else
+  {
+      _finestLinearSystem = &ls;
+      createCoarseLevels();
+      _recoarsen = false;
+      _nSolvesSinceCoarsening = 0;
+      _nCyclesAfterCoarsening = 0;
+      _nCyclesThisSolve = 0;
+  }
+  _coarseLevelsOutdated = false;
+}
+
 void
 AMG::cleanup()
 {
+  countSolve();
+  if (reuseCoarseLevels && _finestLinearSystem)
+  {
+      _coarseLevelsOutdated = true;
+      return;
+  }
   _finestLinearSystem = 0;
   _coarseLinearSystems.clear();
+#ifdef FVM_PARALLEL
+  _agglomerators.clear();
+#endif
 }
 
 MFRPtr
 AMG::solve(LinearSystem & ls)
 {
-    if (_finestLinearSystem != &ls)
-     {
-       _finestLinearSystem = &ls;
-       createCoarseLevels();
-     }
-    _finestLinearSystem = &ls;
+  initCoarseLevels(ls);
 
 
   const MultiFieldMatrix& finestMatrix = _finestLinearSystem->getMatrix();
@@ -250,7 +618,7 @@ AMG::solve(LinearSystem & ls)
   for(int i=1; i<nMaxIterations; i++)
   {
       _totalIterations++;
-      cycle(cycleType,0);
+      finestCycle(true);
       finestMatrix.computeResidual(_finestLinearSystem->getDelta(),
                                    _finestLinearSystem->getB(),
                                    _finestLinearSystem->getResidual());
@@ -277,6 +645,8 @@ AMG::solve(LinearSystem & ls)
   }
 
   _finestLinearSystem->getDelta().sync();
+
+  countSolve();
   
   return rNorm0;
 }
@@ -285,16 +655,8 @@ AMG::solve(LinearSystem & ls)
 void
 AMG::smooth(LinearSystem & ls)
 {
-  if (_finestLinearSystem != &ls)
-  {
-      _finestLinearSystem = &ls;
-      createCoarseLevels( );
-  }
-  _finestLinearSystem = &ls;
-
-  {
-      cycle(cycleType,0);
-  }
+  initCoarseLevels(ls);
+  finestCycle(false);
 }
 
 
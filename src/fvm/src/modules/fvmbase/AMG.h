@@ -12,6 +12,8 @@
 
 #include "MultiFieldReduction.h"
 #include "LinearSystemMerger.h"
+#include "LinearSystemAgglomerator.h"
+#include "DirectSolver.h"
 #include <iostream>
 #include <fstream>
 
@@ -35,10 +37,47 @@ public:
       F_CYCLE
     };
 
+  /**
+   * MULTICOLOR_GAUSS_SEIDEL updates the rows of one colour at a time,
+   * in parallel; HYBRID_GAUSS_SEIDEL does GaussSeidel within one block
+   * of rows per thread and l1 Jacobi across the blocks, so with a single
+   * thread, and on levels too small to be threaded, it is the same as
+   * GAUSS_SEIDEL. The ghost columns are kept
+   * fixed during a sweep by all of them. Both reduce to GAUSS_SEIDEL for
+   * matrices that don't support them.
+   * 
+   */
+
   enum SmootherType
     {
       GAUSS_SEIDEL,
-      JACOBI
+      JACOBI,
+      MULTICOLOR_GAUSS_SEIDEL,
+      HYBRID_GAUSS_SEIDEL,
+      L1_JACOBI
+    };
+  
+  /**
+   * GROUPING is the greedy grouping of up to coarseGroupSize rows
+   * controlled by weightRatioThreshold. The others coarsen along the
+   * strong connections of the matrix, which follows the direction of
+   * anisotropy, and use Galerkin coarse matrices. CLASSICAL splits the
+   * rows into coarse and fine ones as in Ruge-Stueben AMG, the latter
+   * being interpolated from their strong coarse neighbours, with
+   * |a_ij| strong if it is at least strengthThreshold times the
+   * largest coefficient of the row. SMOOTHED_AGGREGATION aggregates
+   * the rows using the criterion |a_ij| >= strengthThreshold *
+   * sqrt(|a_ii a_jj|) and smooths the piecewise constant prolongation
+   * with a damped Jacobi step. Both are only available for scalar
+   * systems.
+   * 
+   */
+
+  enum CoarseningType
+    {
+      GROUPING,
+      CLASSICAL,
+      SMOOTHED_AGGREGATION
     };
   
   AMG();
@@ -79,6 +118,68 @@ public:
   CycleType cycleType;
   SmootherType smootherType;
   bool scaleCorrections;
+
+  CoarseningType coarseningType;
+
+  // a negative value selects the usual one for the coarseningType,
+  // 0.25 for CLASSICAL and 0.08 for SMOOTHED_AGGREGATION
+  double strengthThreshold;
+
+  // the Jacobi damping for SMOOTHED_AGGREGATION is this divided by an
+  // estimate of the spectral radius of D^-1 A
+  double prolongationSmoothing;
+
+  // keep the coarse levels after cleanup and only recompute their
+  // coefficients when the same system is solved again
+  bool reuseCoarseLevels;
+
+  // when reusing, coarsen afresh every so many solves (0 for never).
+  // When AMG preconditions a Krylov solver a solve lasts until the
+  // cleanup of that solver, and each application counts as a cycle
+  int recoarsenInterval;
+
+  // when reusing, coarsen afresh if a solve needed more than this
+  // many times the cycles taken by the first solve after the last
+  // coarsening (0 for never)
+  double recoarsenCycleRatio;
+
+  /**
+   * solve the coarsest level with a DirectSolver instead of sweeps;
+   * its factorization is kept across cycles and only recomputed when
+   * the coarse levels are updated. Coarsening then stops at the first
+   * level with no more than directSolveSize rows. In parallel this is
+   * only done once the levels have been gathered on one process,
+   * otherwise the coarsest level is smoothed as usual.
+   *
+   */
+  bool coarsestLevelDirectSolve;
+  int directSolveSize;
+
+  /**
+   * in parallel, agglomerate the coarse levels onto fewer processes
+   * each time they have fewer than mergeRowsPerProcess rows per process
+   * on average, moving the rows of every agglomerationFactor
+   * consecutive processes to the first of them, until a single process
+   * is left. With 0 the levels are only merged, all at once onto one
+   * process, at the size given to setMergeLevelSize.
+   *
+   */
+  int mergeRowsPerProcess;
+  int agglomerationFactor;
+
+  /**
+   * build and cycle the whole hierarchy, including the smoothing of
+   * the finest level, on a single precision copy of the system. Each
+   * cycle is applied to the double precision residual and its
+   * correction added to the double precision solution, so this is
+   * best used as a preconditioner for one of the Krylov solvers.
+   * Only available for scalar systems; combining it with merging or
+   * the direct solve of the coarsest level throws. CLASSICAL and
+   * SMOOTHED_AGGREGATION then both use the aggregates of the latter
+   * with piecewise constant transfers.
+   *
+   */
+  bool singlePrecision;
 private:
 
   AMG(const AMG&);
@@ -87,10 +188,20 @@ private:
   vector<shared_ptr<LinearSystem> > _coarseLinearSystems;
   shared_ptr<LinearSystemMerger>   _mergeLS;
 
+  void  initCoarseLevels( LinearSystem& ls );
   void  createCoarseLevels( );
+  void  updateCoarseLevels( );
   void  doSweeps( const int nSweeps, const int level );
   void  cycle(  CycleType cycleType, const int level );
+  void  singlePrecisionCycle( const bool isResidualCurrent );
+  void  finestCycle( const bool isResidualCurrent );
+  void  countSolve();
+  LinearSystem& getLinearSystem( const int level );
   void  flipComm();
+  bool  isCoarsestLevelLocal() const;
+#ifdef FVM_PARALLEL
+  const MPI::Intracomm& getLevelComm( const int level ) const;
+#endif
 
   static int amg_indx;
  
@@ -99,8 +210,22 @@ private:
   bool _isMerge;
   int _totalIterations;
 
+  bool _coarseLevelsOutdated;
+  bool _recoarsen;
+  int _nSolvesSinceCoarsening;
+  int _nCyclesAfterCoarsening;
+  int _nCyclesThisSolve;
+
+  shared_ptr<DirectSolver> _coarsestSolver;
+  bool _coarsestFactorizationOutdated;
+
 #ifdef FVM_PARALLEL
   MPI::Intracomm _commTarget;
+
+  // keyed like _mergeLevel by the level that is agglomerated, whose
+  // copy on fewer processes is the next level on those processes; the
+  // others have no levels after it
+  map<int, shared_ptr<LinearSystemAgglomerator> > _agglomerators;
 #endif
 
   streambuf *m_psbuf;
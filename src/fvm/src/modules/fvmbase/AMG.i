@@ -18,7 +18,17 @@ public:
   enum SmootherType
     {
       GAUSS_SEIDEL,
-      JACOBI
+      JACOBI,
+      MULTICOLOR_GAUSS_SEIDEL,
+      HYBRID_GAUSS_SEIDEL,
+      L1_JACOBI
+    };
+
+  enum CoarseningType
+    {
+      GROUPING,
+      CLASSICAL,
+      SMOOTHED_AGGREGATION
     };
 
   int maxCoarseLevels;
@@ -29,6 +39,17 @@ public:
   CycleType cycleType;
   SmootherType smootherType;
   bool scaleCorrections;
+  CoarseningType coarseningType;
+  double strengthThreshold;
+  double prolongationSmoothing;
+  bool reuseCoarseLevels;
+  int recoarsenInterval;
+  double recoarsenCycleRatio;
+  bool coarsestLevelDirectSolve;
+  int directSolveSize;
+  int mergeRowsPerProcess;
+  int agglomerationFactor;
+  bool singlePrecision;
 private:
   AMG(const AMG&);
 };
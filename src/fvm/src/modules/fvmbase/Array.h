@@ -423,6 +423,19 @@ public:
     throw CException("invalid  array for operator-");
   }
 
+  virtual shared_ptr<ArrayBase>
+  sqrt() const
+  {
+    if (_length == 1)
+    {
+        Array* nPtr(new Array(1));
+        (*nPtr)[0] = _data[0];
+        ArrayScalarTraits<T>::sqrt((*nPtr)[0]);
+        return shared_ptr<ArrayBase>(nPtr);
+    }
+    throw CException("invalid  array for sqrt");
+  }
+
 
   virtual void
   inject(IContainer& coarseI, const IContainer& coarseIndexI, const int length) const
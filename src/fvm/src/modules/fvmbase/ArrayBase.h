@@ -53,6 +53,7 @@ public:
 
   virtual shared_ptr<ArrayBase> operator-() const {throw;}
   virtual void limit(const double min, const double max) {throw;}
+  virtual shared_ptr<ArrayBase> sqrt() const {throw;}
   
     virtual ArrayBase& safeDivide(const ArrayBase& a) =0;
   virtual ArrayBase& normalize(const ArrayBase& a) =0;
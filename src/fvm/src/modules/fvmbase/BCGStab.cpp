@@ -60,11 +60,15 @@ BCGStab::solve(LinearSystem & ls)
     cout << 0 << ": " << *rNorm0 << endl;
 #endif
 
+  // the residual norms are summed together with the dot products
+  // needed next, three global sums per iteration instead of six. The
+  // check after the first half step is therefore only done once the
+  // second preconditioner application is complete
+  rho = r->dotWith(*rTilda);
+
   for(int i = 0; i<nMaxIterations; i++)
   { 
       _totalIterations++;
-      rhoPrev = rho;
-      rho = r->dotWith(*rTilda);
 
       rho->reduceSum();
 
@@ -98,12 +102,7 @@ BCGStab::solve(LinearSystem & ls)
       x->msaxpy(*alpha,*pHat);
       r->msaxpy(*alpha,*v);
 
-      MFRPtr rNorm = r->getOneNorm();
-
-      if (*rNorm < absoluteTolerance)
-      {
-          break;
-      }
+      MFRPtr rNorm = r->getOneNorm(false);
 
       shared_ptr<MultiField> sHat = pHat;
       sHat->zero();
@@ -114,8 +113,20 @@ BCGStab::solve(LinearSystem & ls)
 
       matrix.multiply(*t,*sHat);
 
-      MFRPtr tdotr = t->dotWith(*r);
-      MFRPtr tdott = t->dotWith(*t);
+      MFRPtr tdotr = t->dotWith(*r,false);
+      MFRPtr tdott = t->dotWith(*t,false);
+
+      MultiFieldReductionSync midReductions;
+      midReductions.add(*rNorm);
+      midReductions.add(*tdotr);
+      midReductions.add(*tdott);
+      midReductions.start();
+      midReductions.finish();
+
+      if (*rNorm < absoluteTolerance)
+      {
+          break;
+      }
 
       tdotr->reduceSum();
       tdott->reduceSum();
@@ -125,7 +136,15 @@ BCGStab::solve(LinearSystem & ls)
       x->msaxpy(*omega,*sHat);
       r->msaxpy(*omega,*t);
 
-      rNorm = r->getOneNorm();
+      rNorm = r->getOneNorm(false);
+      rhoPrev = rho;
+      rho = r->dotWith(*rTilda,false);
+
+      MultiFieldReductionSync reductions;
+      reductions.add(*rNorm);
+      reductions.add(*rho);
+      reductions.start();
+      reductions.finish();
 
       MFRPtr normRatio(rNorm->normalize(*rNorm0));
 
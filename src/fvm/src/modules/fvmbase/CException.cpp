@@ -45,7 +45,11 @@ CException::CException(const string& what) :
                 
                 char *realName = abi::__cxa_demangle(funcNameMangled.c_str(), 0, 0, &status);
                 
-                std::cout << x << " :  " << realName   << endl;
+                // static functions have no name to demangle
+                if (realName)
+                  std::cout << x << " :  " << realName   << endl;
+                else
+                  std::cout << x << " :  " << s   << endl;
                 free(realName);
             }
             else
@@ -58,6 +58,11 @@ CG::solve(LinearSystem & ls)
 #endif
 
 
+  // the norm of the residual is summed together with rho in the next
+  // iteration, at the cost of one preconditioner application more on
+  // convergence
+  MFRPtr rNorm;
+
   for(int i = 0; i<nMaxIterations; i++)
   {
       z->zero();
@@ -68,7 +73,32 @@ CG::solve(LinearSystem & ls)
 
 
       rhoPrev = rho;
-      rho = r->dotWith(*z);
+      rho = r->dotWith(*z,false);
+
+      MultiFieldReductionSync reductions;
+      reductions.add(*rho);
+      if (rNorm)
+        reductions.add(*rNorm);
+      reductions.start();
+      reductions.finish();
+
+      if (rNorm)
+      {
+          MFRPtr normRatio(rNorm->normalize(*rNorm0));
+
+#ifndef FVM_PARALLEL
+          if (verbosity >0)
+            cout << i << ": " << *rNorm << endl;
+#endif
+
+#ifdef  FVM_PARALLEL
+          if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+            cout << i << ": " << *rNorm << endl;
+#endif
+
+          if (*rNorm < absoluteTolerance || *normRatio < relativeTolerance)
+            break;
+      }
 
       rho->reduceSum();
 
@@ -93,25 +123,7 @@ CG::solve(LinearSystem & ls)
       x->msaxpy(*alpha,*p);
       r->msaxpy(*alpha,*q);
 
-      MFRPtr rNorm = r->getOneNorm();
-
-
-      MFRPtr normRatio(rNorm->normalize(*rNorm0));
-
-#ifndef FVM_PARALLEL
-      if (verbosity >0)
-        cout << i+1 << ": " << *rNorm << endl;
-#endif
-
-#ifdef  FVM_PARALLEL
-  if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
-    cout << i+1 << ": " << *rNorm << endl;
-#endif
-
-      if (*rNorm < absoluteTolerance || *normRatio < relativeTolerance)
-        break;
-
-
+      rNorm = r->getOneNorm(false);
   }
   ls.replaceDelta(x);
   ls.replaceB(bOrig);
@@ -163,6 +163,171 @@ CRConnectivity::getMultiTranspose(const int varSize) const
   return trPtr;
 }
 
+shared_ptr<Array<int> >
+CRConnectivity::getMultiTransposePositions(const CRConnectivity& flatConnectivity,
+                                           const int varSize) const
+{
+  const Array<int>& myRow = *_row;
+  const Array<int>& myCol = *_col;
+
+  const int blockSize = varSize*varSize;
+  shared_ptr<Array<int> > positionsPtr(new Array<int>((_rowDim + myRow[_rowDim])*
+                                                      blockSize));
+  Array<int>& positions = *positionsPtr;
+
+  int np=0;
+  for(int i=0; i<_rowDim; i++)
+  {
+      for(int ndr=0; ndr<varSize; ndr++)
+        for(int ndc=0; ndc<varSize; ndc++)
+        {
+            const int nfr = i*varSize + ndr;
+            const int nfc = i*varSize + ndc;
+            positions[np++] = flatConnectivity.getCoeffPosition(nfc,nfr);
+        }
+      
+      for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+      {
+          const int j = myCol[jp];
+
+          for(int ndr=0; ndr<varSize; ndr++)
+            for(int ndc=0; ndc<varSize; ndc++)
+            {
+                const int nfr = i*varSize + ndr;
+                const int nfc = j*varSize + ndc;
+                positions[np++] = flatConnectivity.getCoeffPosition(nfc,nfr);
+            }
+      }
+  }
+  return positionsPtr;
+}
+
+
+// greedy colouring; each row gets the lowest colour not already taken
+// by another row sharing one of its columns
+
+shared_ptr<CRConnectivity>
+CRConnectivity::getRowColoring(StorageSite& colorSite) const
+{
+  const Array<int>& myRow = *_row;
+  const Array<int>& myCol = *_col;
+
+  shared_ptr<CRConnectivity> trPtr = getTranspose();
+  const CRConnectivity& tr = *trPtr;
+
+  Array<int> rowColor(_rowDim);
+  rowColor = -1;
+
+  // forbidden[c] == i marks colour c as taken by a neighbour of row i
+  vector<int> forbidden;
+  
+  int nColors = 0;
+  for(int i=0; i<_rowDim; i++)
+  {
+      for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+      {
+          const int j = myCol[jp];
+          for(int k=0; k<tr.getCount(j); k++)
+          {
+              const int c = rowColor[tr(j,k)];
+              if (c >= 0)
+                forbidden[c] = i;
+          }
+      }
+
+      int c = 0;
+      while(c < nColors && forbidden[c] == i)
+        c++;
+
+      if (c == nColors)
+      {
+          forbidden.push_back(-1);
+          nColors++;
+      }
+      rowColor[i] = c;
+  }
+
+  colorSite.setCount(nColors);
+  shared_ptr<CRConnectivity> colorsPtr(new CRConnectivity(colorSite,*_rowSite));
+  CRConnectivity& colors = *colorsPtr;
+
+  colors.initCount();
+  for(int i=0; i<_rowDim; i++)
+    colors.addCount(rowColor[i],1);
+  colors.finishCount();
+
+  for(int i=0; i<_rowDim; i++)
+    colors.add(rowColor[i],i);
+  colors.finishAdd();
+
+  return colorsPtr;
+}
+
+// greedy colouring of the graph formed by the rows and columns of a
+// square connectivity; both i->j and j->i entries are checked so that
+// the structure need not be symmetric
+
+shared_ptr<CRConnectivity>
+CRConnectivity::getAdjacencyColoring(StorageSite& colorSite,
+                                     const int nRows) const
+{
+  if (nRows > _rowDim || nRows > _colDim)
+    throw CException("invalid connectivity for adjacency coloring");
+  
+  const Array<int>& myRow = *_row;
+  const Array<int>& myCol = *_col;
+
+  shared_ptr<CRConnectivity> trPtr = getTranspose();
+  const CRConnectivity& tr = *trPtr;
+
+  Array<int> rowColor(nRows);
+  rowColor = -1;
+
+  vector<int> forbidden;
+  
+  int nColors = 0;
+  for(int i=0; i<nRows; i++)
+  {
+      for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+      {
+          const int j = myCol[jp];
+          if (j < nRows && j != i && rowColor[j] >= 0)
+            forbidden[rowColor[j]] = i;
+      }
+      for(int k=0; k<tr.getCount(i); k++)
+      {
+          const int j = tr(i,k);
+          if (j < nRows && j != i && rowColor[j] >= 0)
+            forbidden[rowColor[j]] = i;
+      }
+
+      int c = 0;
+      while(c < nColors && forbidden[c] == i)
+        c++;
+
+      if (c == nColors)
+      {
+          forbidden.push_back(-1);
+          nColors++;
+      }
+      rowColor[i] = c;
+  }
+
+  colorSite.setCount(nColors);
+  shared_ptr<CRConnectivity> colorsPtr(new CRConnectivity(colorSite,*_rowSite));
+  CRConnectivity& colors = *colorsPtr;
+
+  colors.initCount();
+  for(int i=0; i<nRows; i++)
+    colors.addCount(rowColor[i],1);
+  colors.finishCount();
+
+  for(int i=0; i<nRows; i++)
+    colors.add(rowColor[i],i);
+  colors.finishAdd();
+
+  return colorsPtr;
+}
 
 shared_ptr<CRConnectivity>
 CRConnectivity::multiply(const CRConnectivity& b, const bool implicitDiagonal) const
@@ -693,6 +858,32 @@ CRConnectivity::reorder( const Array<int>& indices )
 }
 
 
+void
+CRConnectivity::permuteRows( const Array<int>& oldOfNew )
+{
+  Array<int>& myRow = *_row;
+  Array<int>& myCol = *_col;
+  const int nPermuted = oldOfNew.getLength();
+
+  Array<int> newRow(_rowDim);
+  Array<int> newCol(myCol.getLength());
+
+  int pos = myRow[0];
+  for ( int i = 0; i < _rowDim; i++ )
+  {
+      const int r = ( i < nPermuted ) ? oldOfNew[i] : i;
+      newRow[i] = pos;
+      for ( int j = myRow[r]; j < myRow[r+1]; j++ )
+        newCol[pos++] = myCol[j];
+  }
+
+  for ( int i = 0; i < _rowDim; i++ )
+    myRow[i] = newRow[i];
+  for ( int j = myRow[0]; j < pos; j++ )
+    myCol[j] = newCol[j];
+}
+
+
 void
 CRConnectivity::localize(  const Array<int>& globalToLocal,
                            const StorageSite& newColSite)
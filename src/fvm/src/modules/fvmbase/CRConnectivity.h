@@ -74,6 +74,40 @@ public:
   shared_ptr<CRConnectivity> getTranspose() const;
   shared_ptr<CRConnectivity> getMultiTranspose(const int varSize) const;
 
+  /**
+   * for a flat connectivity created by getMultiTranspose, returns the
+   * position of each flattened coefficient in the order they are
+   * visited when flattening the matrix, i.e. for each row the diagonal
+   * block followed by the off diagonal blocks, each block by rows.
+   * 
+   */
+
+  shared_ptr<Array<int> >
+  getMultiTransposePositions(const CRConnectivity& flatConnectivity,
+                             const int varSize) const;
+
+  /**
+   * groups the rows into colours such that no two rows of the same
+   * colour share a column. The returned connectivity maps each colour
+   * to its rows (in increasing order) and the count of colorSite is
+   * set to the number of colours used.
+   * 
+   */
+
+  shared_ptr<CRConnectivity> getRowColoring(StorageSite& colorSite) const;
+
+  /**
+   * for a square connectivity, groups the first nRows rows into
+   * colours such that no row has a column belonging to another row of
+   * the same colour, i.e. the rows of a colour can be relaxed
+   * independently. Columns beyond nRows are ignored. Returns the
+   * colour to row connectivity like getRowColoring.
+   * 
+   */
+
+  shared_ptr<CRConnectivity> getAdjacencyColoring(StorageSite& colorSite,
+                                                  const int nRows) const;
+
   shared_ptr<CRConnectivity> multiply(const CRConnectivity& b,
                                       const bool implicitDiagonal) const;
   
@@ -85,6 +119,17 @@ public:
   getSubset(const StorageSite& site,const Array<int>& indices) const;
 
   void reorder( const Array<int>& indices );
+
+  /**
+   * puts the rows in the order given by oldOfNew, which holds the
+   * current index of each new row; rows beyond its length stay where
+   * they are. The row and column arrays are overwritten in place so
+   * that connectivities created from this one by createOffset see the
+   * new order.
+   * 
+   */
+
+  void permuteRows( const Array<int>& oldOfNew );
   
   shared_ptr<CRConnectivity>
   getLocalizedSubset(const StorageSite& newRowSite,
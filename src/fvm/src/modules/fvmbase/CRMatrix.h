@@ -9,13 +9,20 @@
 #include <mpi.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "Matrix.h"
 #include "CRConnectivity.h"
+#include "CRMatrixTranspose.h"
 #include "Array.h"
+#include "CRMatrixKernels.h"
 #include "StorageSite.h"
 #include "LinearSystemMerger.h"
 #include "SpikeStorage.h"
 #include "SpikeMatrix.h"
+#include "SyncPlan.h"
 #include <set>
 
 // used to handle cases where OffDiag and Diag are not the same type
@@ -44,11 +51,11 @@ void setFlatCoeffs(Array<double>& flatCoeffs,
 }
                    
 
-void setFlatCoeffs(Array<double>& flatCoeffs,
-                   const CRConnectivity& flatConnectivity,
-                   Array<double>& diag,
-                   Array<double>& offDiag,
-                   const CRConnectivity& connectivity)
+inline void setFlatCoeffs(Array<double>& flatCoeffs,
+                          const CRConnectivity& flatConnectivity,
+                          const Array<double>& diag,
+                          const Array<double>& offDiag,
+                          const CRConnectivity& connectivity)
 {
     const Array<int>& myRow = connectivity.getRow();
     const Array<int>& myCol = connectivity.getCol();
@@ -70,6 +77,365 @@ void setFlatCoeffs(Array<double>& flatCoeffs,
     }
 }
 
+// same as above but using the positions returned by
+// CRConnectivity::getMultiTransposePositions so that the flat matrix
+// can be refilled without searching for each coefficient
+
+template<class T_Diag, class T_OffDiag>
+void setFlatCoeffs(Array<double>& flatCoeffs,
+                   const Array<int>& flatPositions,
+                   const Array<T_Diag>& diag,
+                   const Array<T_OffDiag>& offDiag,
+                   const CRConnectivity& connectivity)
+{
+  throw CException("not implemented");
+}
+
+inline void setFlatCoeffs(Array<double>& flatCoeffs,
+                          const Array<int>& flatPositions,
+                          const Array<double>& diag,
+                          const Array<double>& offDiag,
+                          const CRConnectivity& connectivity)
+{
+    const Array<int>& myRow = connectivity.getRow();
+    const int rowDim = connectivity.getRowDim();
+
+    int np=0;
+    for(int i=0; i<rowDim; i++)
+    {
+        flatCoeffs[flatPositions[np++]] = diag[i];
+        for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+          flatCoeffs[flatPositions[np++]] = offDiag[jp];
+    }
+}
+
+// helper function to set the coefficients of a single precision copy
+// of a matrix, used by AMG to build its hierarchy in single
+// precision. As for setFlatCoeffs only the versions we need are
+// defined, currently that for a scalar matrix.
+
+template<class T_Diag, class T_OffDiag>
+void setSinglePrecisionCoeffs(Array<float>& spDiag,
+                              Array<float>& spOffDiag,
+                              const Array<T_Diag>& diag,
+                              const Array<T_OffDiag>& offDiag)
+{
+  throw CException("not implemented");
+}
+
+inline void setSinglePrecisionCoeffs(Array<float>& spDiag,
+                                     Array<float>& spOffDiag,
+                                     const Array<double>& diag,
+                                     const Array<double>& offDiag)
+{
+  const int nRows = diag.getLength();
+  for(int i=0; i<nRows; i++)
+    spDiag[i] = float(diag[i]);
+
+  const int nCoeffs = offDiag.getLength();
+  for(int i=0; i<nCoeffs; i++)
+    spOffDiag[i] = float(offDiag[i]);
+}
+
+// helper functions for the prolongation based AMG coarsening. The
+// first computes the weights of the smoothed aggregation prolongation
+// P = (I - omega D^-1 A) P0 where P0 is the piecewise constant
+// prolongation defined by coarseIndex and A is filtered to keep only
+// the strong connections (see CRMatrix::createProlongationConnectivity),
+// the others being added to its diagonal D. The second computes the
+// direct interpolation of classical AMG and the third the
+// coefficients of the Galerkin coarse matrix P^T A P. As above only
+// the scalar versions are defined.
+
+template<class T_Diag, class T_OffDiag>
+void setSmoothedProlongation(Array<double>& weights,
+                             const CRConnectivity& prolongation,
+                             const Array<int>& coarseIndex,
+                             const Array<T_Diag>& diag,
+                             const Array<T_OffDiag>& offDiag,
+                             const CRConnectivity& connectivity,
+                             const double strengthThreshold,
+                             const double smoothing)
+{
+  throw CException("setSmoothedProlongation: only available for scalar matrices");
+}
+
+inline void setSmoothedProlongation(Array<double>& weights,
+                                    const CRConnectivity& prolongation,
+                                    const Array<int>& coarseIndex,
+                                    const Array<double>& diag,
+                                    const Array<double>& offDiag,
+                                    const CRConnectivity& connectivity,
+                                    const double strengthThreshold,
+                                    const double smoothing)
+{
+    const Array<int>& myRow = connectivity.getRow();
+    const Array<int>& myCol = connectivity.getCol();
+    const Array<int>& pRow = prolongation.getRow();
+    const Array<int>& pCol = prolongation.getCol();
+    const int nSelfRows = connectivity.getRowSite().getSelfCount();
+    const int nRows = prolongation.getRowDim();
+
+    Array<int> coarsePos(prolongation.getColDim());
+    coarsePos = -1;
+
+    // the filtered matrix keeps the strong connections to aggregates
+    // in the prolongation pattern; the other connections to coarsened
+    // rows, including those of other processes, are added to its
+    // diagonal. Connections to rows that have not been coarsened
+    // (boundaries) are left out as they are in P0.
+    Array<double> filteredDiag(nSelfRows);
+    Array<bool> isStrong(myCol.getLength());
+    filteredDiag.zero();
+    isStrong = false;
+
+    // omega is smoothing divided by the Gershgorin bound for the
+    // spectral radius of D^-1 A
+    double rho = 0;
+
+    for(int i=0; i<nSelfRows; i++)
+    {
+        if (coarseIndex[i] < 0 || diag[i] == 0)
+          continue;
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+          coarsePos[pCol[pp]] = pp;
+
+        double strongSum = 0;
+        filteredDiag[i] = diag[i];
+        for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+        {
+            const int j = myCol[jp];
+            const int jc = coarseIndex[j];
+            if (jc < 0)
+              continue;
+
+            if (j < nSelfRows && coarsePos[jc] >= 0 &&
+                fabs(offDiag[jp]) >= strengthThreshold*sqrt(fabs(diag[i]*diag[j])))
+            {
+                isStrong[jp] = true;
+                strongSum += fabs(offDiag[jp]);
+            }
+            else
+              filteredDiag[i] += offDiag[jp];
+        }
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+          coarsePos[pCol[pp]] = -1;
+
+        if (filteredDiag[i] != 0)
+          rho = max(rho,(fabs(filteredDiag[i]) + strongSum)/fabs(filteredDiag[i]));
+    }
+
+    const double omega = rho > 0 ? smoothing/rho : 0;
+
+    for(int i=0; i<nRows; i++)
+    {
+        const int ic = coarseIndex[i];
+        if (ic < 0)
+          continue;
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+        {
+            coarsePos[pCol[pp]] = pp;
+            weights[pp] = 0;
+        }
+
+        weights[coarsePos[ic]] = 1.0;
+
+        // ghost rows keep the piecewise constant prolongation
+        if (i < nSelfRows && filteredDiag[i] != 0)
+        {
+            const double scale = omega/filteredDiag[i];
+
+            weights[coarsePos[ic]] -= omega;
+            for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+              if (isStrong[jp])
+                weights[coarsePos[coarseIndex[myCol[jp]]]] -= scale*offDiag[jp];
+        }
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+          coarsePos[pCol[pp]] = -1;
+    }
+}
+
+template<class T_Diag, class T_OffDiag>
+void setClassicalProlongation(Array<double>& weights,
+                              const CRConnectivity& prolongation,
+                              const Array<int>& coarseIndex,
+                              const Array<T_Diag>& diag,
+                              const Array<T_OffDiag>& offDiag,
+                              const CRConnectivity& connectivity)
+{
+  throw CException("setClassicalProlongation: only available for scalar matrices");
+}
+
+inline void setClassicalProlongation(Array<double>& weights,
+                                     const CRConnectivity& prolongation,
+                                     const Array<int>& coarseIndex,
+                                     const Array<double>& diag,
+                                     const Array<double>& offDiag,
+                                     const CRConnectivity& connectivity)
+{
+    const Array<int>& myRow = connectivity.getRow();
+    const Array<int>& myCol = connectivity.getCol();
+    const Array<int>& pRow = prolongation.getRow();
+    const Array<int>& pCol = prolongation.getCol();
+    const int nRows = prolongation.getRowDim();
+
+    Array<int> coarsePos(prolongation.getColDim());
+    coarsePos = -1;
+
+    for(int i=0; i<nRows; i++)
+    {
+        // C rows are injected
+        if (coarseIndex[i] >= 0)
+        {
+            for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+              weights[pp] = 1.0;
+            continue;
+        }
+
+        // F rows are interpolated from their strong C neighbours, the
+        // weights being scaled so that the other connections to rows
+        // in the hierarchy are accounted for; those to boundaries and
+        // to the F rows of other processes are left out
+        if (pRow[i] == pRow[i+1])
+          continue;
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+          coarsePos[pCol[pp]] = pp;
+
+        double sum = 0;
+        double interpolatedSum = 0;
+        for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+        {
+            const int j = myCol[jp];
+            const int jc = coarseIndex[j];
+            if (jc >= 0 && coarsePos[jc] >= 0)
+              interpolatedSum += offDiag[jp];
+            if (jc >= 0 || pRow[j] < pRow[j+1])
+              sum += offDiag[jp];
+        }
+
+        const double scale =
+          (interpolatedSum != 0 && diag[i] != 0) ? -sum/(interpolatedSum*diag[i]) : 0;
+
+        for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+        {
+            const int jc = coarseIndex[myCol[jp]];
+            if (jc >= 0 && coarsePos[jc] >= 0)
+              weights[coarsePos[jc]] = scale*offDiag[jp];
+        }
+
+        for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+          coarsePos[pCol[pp]] = -1;
+    }
+}
+
+template<class T_Diag, class T_OffDiag>
+void setGalerkinCoeffs(Array<T_Diag>& coarseDiag,
+                       Array<T_OffDiag>& coarseOffDiag,
+                       const CRConnectivity& coarseConnectivity,
+                       const Array<T_Diag>& diag,
+                       const Array<T_OffDiag>& offDiag,
+                       const CRConnectivity& connectivity,
+                       const CRConnectivity& rowProlongation,
+                       const Array<double>& rowWeights,
+                       const CRConnectivity& colProlongation,
+                       const Array<double>& colWeights)
+{
+  throw CException("setGalerkinCoeffs: only available for scalar matrices");
+}
+
+inline void setGalerkinCoeffs(Array<double>& coarseDiag,
+                              Array<double>& coarseOffDiag,
+                              const CRConnectivity& coarseConnectivity,
+                              const Array<double>& diag,
+                              const Array<double>& offDiag,
+                              const CRConnectivity& connectivity,
+                              const CRConnectivity& rowProlongation,
+                              const Array<double>& rowWeights,
+                              const CRConnectivity& colProlongation,
+                              const Array<double>& colWeights)
+{
+    const Array<int>& myRow = connectivity.getRow();
+    const Array<int>& myCol = connectivity.getCol();
+    const Array<int>& pRow = colProlongation.getRow();
+    const Array<int>& pCol = colProlongation.getCol();
+    const Array<int>& coarseConnRow = coarseConnectivity.getRow();
+    const Array<int>& coarseConnCol = coarseConnectivity.getCol();
+    const int nCoarseRows = coarseConnectivity.getRowDim();
+
+    // the transpose of the row prolongation along with its weights,
+    // giving for each coarse row the fine rows restricted into it
+    const Array<int>& rpRow = rowProlongation.getRow();
+    const Array<int>& rpCol = rowProlongation.getCol();
+    const int nFineRows = rowProlongation.getRowDim();
+
+    Array<int> rRow(nCoarseRows+1);
+    Array<int> rFine(rpCol.getLength());
+    Array<double> rWeights(rpCol.getLength());
+
+    rRow = 0;
+    for(int i=0; i<nFineRows; i++)
+      for(int pp=rpRow[i]; pp<rpRow[i+1]; pp++)
+        rRow[rpCol[pp]+1]++;
+    for(int nc=0; nc<nCoarseRows; nc++)
+      rRow[nc+1] += rRow[nc];
+    for(int i=0; i<nFineRows; i++)
+      for(int pp=rpRow[i]; pp<rpRow[i+1]; pp++)
+      {
+          const int rp = rRow[rpCol[pp]]++;
+          rFine[rp] = i;
+          rWeights[rp] = rowWeights[pp];
+      }
+    for(int nc=nCoarseRows; nc>0; nc--)
+      rRow[nc] = rRow[nc-1];
+    rRow[0] = 0;
+
+    coarseDiag.zero();
+    coarseOffDiag.zero();
+
+    //used to avoid searches when inserting coeffs
+    Array<int> coarseCoeffPos(coarseConnectivity.getColDim());
+
+    for(int nrCoarse=0; nrCoarse<nCoarseRows; nrCoarse++)
+    {
+        for(int nb=coarseConnRow[nrCoarse]; nb<coarseConnRow[nrCoarse+1]; nb++)
+          coarseCoeffPos[coarseConnCol[nb]] = nb;
+
+        for(int rp=rRow[nrCoarse]; rp<rRow[nrCoarse+1]; rp++)
+        {
+            const int i = rFine[rp];
+
+            for(int pp=pRow[i]; pp<pRow[i+1]; pp++)
+            {
+                const int ncCoarse = pCol[pp];
+                const double rAP = rWeights[rp]*diag[i]*colWeights[pp];
+                if (ncCoarse == nrCoarse)
+                  coarseDiag[nrCoarse] += rAP;
+                else
+                  coarseOffDiag[coarseCoeffPos[ncCoarse]] += rAP;
+            }
+
+            for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+            {
+                const int j = myCol[jp];
+                for(int pp=pRow[j]; pp<pRow[j+1]; pp++)
+                {
+                    const int ncCoarse = pCol[pp];
+                    const double rAP = rWeights[rp]*offDiag[jp]*colWeights[pp];
+                    if (ncCoarse == nrCoarse)
+                      coarseDiag[nrCoarse] += rAP;
+                    else
+                      coarseOffDiag[coarseCoeffPos[ncCoarse]] += rAP;
+                }
+            }
+        }
+    }
+}
+
 /**
  * Sparse matrix stored using a compressed row format. The sparsity
  * pattern is provided by a CRConnectivity object that is required at
@@ -90,6 +456,9 @@ public:
 
    //friend class LinearSystemMerger;
 
+  // for copying between matrices of different precisions
+  template<class T_Diag2, class T_OffDiag2, class X2> friend class CRMatrix;
+
   typedef T_Diag Diag;
   typedef T_OffDiag OffDiag;
   typedef Array<Diag> DiagArray;
@@ -103,8 +472,12 @@ public:
   typedef shared_ptr< Array<double> >  ArrayDblePtr;
   typedef  SpikeMatrix< Diag, OffDiag, X> T_SpikeMtrx;
 
+  // the prolongators used by classical and smoothed aggregation AMG
+  typedef CRMatrixTranspose<double,double,double> ProlongationMatrix;
+
   typedef pair<const StorageSite*, const StorageSite*> EntryIndex;
   typedef map<EntryIndex, shared_ptr<ArrayBase> > GhostArrayMap;
+  typedef SyncPlan<EntryIndex> BndryCoeffsSyncPlan;
 
   /**
    * Embedded class used for easy (ie. no search) access to matrix
@@ -203,16 +576,7 @@ public:
     const XArray& x = dynamic_cast<const XArray&>(xB);
     
     const int nRows = _conn.getRowSite().getCount();
-    for(int nr=0; nr<nRows; nr++)
-    {
-        y[nr] = _diag[nr]*x[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            y[nr] += _offDiag[nb]*x[j];
-        }
-
-    }
+    getKernels().multiply(nRows,x,y,false);
   }
 
   /**
@@ -226,16 +590,20 @@ public:
     const XArray& x = dynamic_cast<const XArray&>(xB);
     
     const int nRows = _conn.getRowSite().getCount();
-    for(int nr=0; nr<nRows; nr++)
-    {
-        y[nr] += _diag[nr]*x[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            y[nr] += _offDiag[nb]*x[j];
-        }
-    }
+    getKernels().multiply(nRows,x,y,true);
+  }
+
+  virtual bool hasRowProducts() const {return true;}
 
+  virtual void multiplyAndAddRows(IContainer& yB, const IContainer& xB,
+                                  const Array<int>& rows) const
+  {
+    XArray& y = dynamic_cast<XArray&>(yB);
+    const XArray& x = dynamic_cast<const XArray&>(xB);
+
+    const int nRows = rows.getLength();
+    if (nRows > 0)
+      getKernels().multiply(nRows,x,y,true,&rows[0]);
   }
 
   virtual void transpose()
@@ -306,18 +674,7 @@ public:
     const XArray& b = dynamic_cast<const XArray&>(bB);
     
     const int nRows = _conn.getRowSite().getSelfCount();
-
-    X sum;
-    for(int nr=0; nr<nRows; nr++)
-    {
-        sum = b[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            sum += _offDiag[nb]*x[j];
-        }
-        x[nr] = -sum/_diag[nr];
-    }
+    getKernels().GS(0,nRows,1,x,b);
   }
   
   /**
@@ -331,18 +688,7 @@ public:
     const XArray& b = dynamic_cast<const XArray&>(bB);
     
     const int nRows = _conn.getRowSite().getSelfCount();
-
-    X sum;
-    for(int nr=nRows-1; nr>=0; nr--)
-    {
-        sum = b[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            sum += _offDiag[nb]*x[j];
-        }
-        x[nr] = -sum/_diag[nr];
-    }
+    getKernels().GS(nRows-1,-1,-1,x,b);
   }
 
   /**
@@ -358,19 +704,60 @@ public:
     const XArray& b = dynamic_cast<const XArray&>(bB);
     
     const int nRows = _conn.getRowSite().getSelfCount();
+    getKernels().Jacobi(nRows,xnew,xold,b);
+  }
 
-    X sum;
-    for(int nr=0; nr<nRows; nr++)
-    {
-        sum = b[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            sum += _offDiag[nb]*xold[j];
-        }
-        xnew[nr] = -sum/_diag[nr];
-    }
+  /**
+   * multicolour GaussSeidel updates for this * x  = b. The rows of a
+   * colour don't depend on each other and are updated in parallel
+   * 
+   */
+
+  virtual void forwardColoredGS(IContainer& xB, IContainer& bB, IContainer&) const
+  {
+    coloredGS(dynamic_cast<XArray&>(xB),dynamic_cast<const XArray&>(bB),false);
+  }
+  
+  virtual void reverseColoredGS(IContainer& xB, IContainer& bB, IContainer&) const
+  {
+    coloredGS(dynamic_cast<XArray&>(xB),dynamic_cast<const XArray&>(bB),true);
+  }
+
+  /**
+   * hybrid GaussSeidel updates for this * x  = b. The rows are split
+   * into one block per thread, each doing GaussSeidel on its own
+   * block with the l1 treatment of the couplings to other blocks
+   * 
+   */
+
+  virtual void forwardBlockGS(IContainer& xB, IContainer& bB, IContainer&) const
+  {
+    blockGS(dynamic_cast<XArray&>(xB),dynamic_cast<const XArray&>(bB),false);
+  }
+
+  virtual void reverseBlockGS(IContainer& xB, IContainer& bB, IContainer&) const
+  {
+    blockGS(dynamic_cast<XArray&>(xB),dynamic_cast<const XArray&>(bB),true);
+  }
+
+  /**
+   * l1 Jacobi update for this * x  = b
+   * 
+   */
 
+  virtual void l1Jacobi(IContainer& xnewB, const IContainer& xoldB,
+                        const IContainer& bB) const
+  {
+    XArray& xnew = dynamic_cast<XArray&>(xnewB);
+    const XArray& xold = dynamic_cast<const XArray&>(xoldB);
+    const XArray& b = dynamic_cast<const XArray&>(bB);
+    
+    const int nRows = _conn.getRowSite().getSelfCount();
+    const Kernels kernels(getKernels());
+
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+      kernels.relaxRowL1(nr,nr,nr+1,nRows,xnew,xold,b);
   }
 
   virtual void iluSolve(IContainer& xB, const IContainer& bB, const IContainer&) const
@@ -412,17 +799,7 @@ public:
     XArray& r = dynamic_cast<XArray&>(rB);
     
     const int nRows = _conn.getRowSite().getSelfCount();
-
-    for(int nr=0; nr<nRows; nr++)
-    {
-
-        r[nr] = b[nr] + _diag[nr]*x[nr];
-        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
-        {
-            const int j = _col[nb];
-            r[nr] += _offDiag[nb]*x[j];
-        }
-    }
+    getKernels().computeResidual(nRows,x,b,r);
   }
 
   /**
@@ -685,78 +1062,365 @@ public:
     }
 
 
-    coarseCR->finishAdd();
- 
-    return coarseCR;
+    coarseCR->finishAdd();
+ 
+    return coarseCR;
+  }
+
+  /**
+   * create the coarse matrix given the coarsening and the coarse
+   * level connectivity.
+   * 
+   */
+
+  shared_ptr<Matrix>
+  createCoarseMatrix(const IContainer& gCoarseIndex,
+                     const CRConnectivity& coarseToFine,
+                     const CRConnectivity& coarseConnectivity)
+  {
+    shared_ptr<CRMatrix> coarseMatrix(new CRMatrix(coarseConnectivity));
+    updateCoarseMatrix(gCoarseIndex,coarseToFine,*coarseMatrix);
+    return coarseMatrix;
+  }
+
+  /**
+   * recompute the coefficients of a coarse matrix previously created
+   * by createCoarseMatrix from the current values of this matrix,
+   * keeping the coarsening and the coarse connectivity.
+   * 
+   */
+
+  virtual void
+  updateCoarseMatrix(const IContainer& gCoarseIndex,
+                     const CRConnectivity& coarseToFine,
+                     Matrix& gCoarseMatrix)
+  {
+    const Array<int>&  coarseIndex = dynamic_cast<const Array<int>& >(gCoarseIndex);
+    CRMatrix& coarseMatrix = dynamic_cast<CRMatrix&>(gCoarseMatrix);
+    const CRConnectivity& coarseConnectivity = coarseMatrix.getConnectivity();
+    const int nCoarseRows = coarseConnectivity.getRowDim();
+
+    Array<Diag>& coarseDiag = coarseMatrix.getDiag();
+    Array<OffDiag>& coarseOffDiag = coarseMatrix.getOffDiag();
+
+    const Array<int>& coarseConnRow = coarseConnectivity.getRow();
+    const Array<int>& coarseConnCol = coarseConnectivity.getCol();
+
+    coarseDiag.zero();
+    coarseOffDiag.zero();
+
+    //used to avoid searches when inserting coeffs, kept for the next
+    //update since that is done on every solve with reused coarse levels
+    if (!_coarseCoeffPos || _coarseCoeffPos->getLength() != nCoarseRows)
+      _coarseCoeffPos = IntArrayPtr(new Array<int>(nCoarseRows));
+    Array<int>& coarseCoeffPos = *_coarseCoeffPos;
+
+
+    for(int nrCoarse=0; nrCoarse<nCoarseRows; nrCoarse++)
+    {
+        // for easy indexing when inserting coefficients set col
+        // positions into the coarse connectivity
+        for(int nb=coarseConnRow[nrCoarse]; nb<coarseConnRow[nrCoarse+1]; nb++)
+          coarseCoeffPos[coarseConnCol[nb]] = nb;
+
+        // loop over the fine rows that make up this coarse row
+        const int nFine = coarseToFine.getCount(nrCoarse);
+        for(int nfr=0; nfr<nFine; nfr++)
+        {
+            const int nrFine = coarseToFine(nrCoarse,nfr);
+
+            coarseDiag[nrCoarse] += _diag[nrFine];
+            
+            for (int nb = _row[nrFine]; nb<_row[nrFine+1]; nb++)
+            {
+                const int nc = _col[nb];
+                const int ncCoarse = coarseIndex[nc];
+
+                if (ncCoarse<0) continue;
+                
+                if (nrCoarse!=ncCoarse)
+                {
+                    const int pos = coarseCoeffPos[ncCoarse];
+                    coarseOffDiag[pos] += _offDiag[nb];
+                }
+                else
+                {
+                    coarseDiag[nrCoarse] += _offDiag[nb];
+                }
+            }
+        }
+    }
+  }
+
+  /**
+   * Alternatives to createCoarsening based on the strong connections
+   * of the matrix. With classical the connection from i to j is strong
+   * if |a_ij| is at least strengthThreshold times the largest off
+   * diagonal coefficient of row i, otherwise if |a_ij| >=
+   * strengthThreshold*sqrt(|a_ii a_jj|).
+   *
+   * Without classical the rows are aggregated as in smoothed
+   * aggregation AMG. Rows whose strong neighbours are all ungrouped
+   * are first made into aggregates together with them, the remaining
+   * rows then join the aggregate they are most strongly connected to
+   * and whatever is still left is grouped with its ungrouped strong
+   * neighbours.
+   *
+   * With classical the rows are split into coarse (C) and fine (F)
+   * rows as in Ruge-Stueben AMG. The row that the most unassigned
+   * rows strongly depend on becomes a C row and these become F rows,
+   * which makes the other rows they depend on more likely to be
+   * chosen next. F rows left without a strong C neighbour are then
+   * changed to C rows. Only the C rows get a coarse index, the F rows
+   * being interpolated from their strong C neighbours by the
+   * prolongator.
+   */
+
+  virtual int createStrengthCoarsening(IContainer& gCoarseIndex,
+                                       const double strengthThreshold,
+                                       const bool classical)
+  {
+    Array<int>&  coarseIndex = dynamic_cast<Array<int>& >(gCoarseIndex);
+
+    const int nRows = _conn.getRowSite().getSelfCount();
+
+    coarseIndex = -1;
+
+    Array<bool> isStrong(_col.getLength());
+    markStrongConnections(isStrong,strengthThreshold,classical);
+
+    if (classical)
+      return createClassicalSplitting(coarseIndex,isStrong);
+
+    int nCoarseRows=0;
+
+    // rows with all their strong neighbours still ungrouped
+    for(int nr=0; nr<nRows; nr++)
+      if (coarseIndex[nr] == -1 && !_isBoundary[nr])
+      {
+          bool isFree = true;
+          for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+            if (isStrong[nb] && coarseIndex[_col[nb]] != -1)
+            {
+                isFree = false;
+                break;
+            }
+
+          if (isFree)
+          {
+              coarseIndex[nr] = nCoarseRows;
+              for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+                if (isStrong[nb])
+                  coarseIndex[_col[nb]] = nCoarseRows;
+              nCoarseRows++;
+          }
+      }
+
+    // rows next to the aggregates created above join the one they
+    // are most strongly connected to
+    Array<int> firstPassIndex(nRows);
+    for(int nr=0; nr<nRows; nr++)
+      firstPassIndex[nr] = coarseIndex[nr];
+
+    for(int nr=0; nr<nRows; nr++)
+      if (coarseIndex[nr] == -1 && !_isBoundary[nr])
+      {
+          double maxCoeffMeasure = 0;
+          for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+          {
+              const int nc = _col[nb];
+              if (isStrong[nb] && firstPassIndex[nc] != -1)
+              {
+                  const double coeffMeasure =
+                    fabs(NumTypeTraits<OffDiag>::doubleMeasure(_offDiag[nb]));
+                  if (coeffMeasure > maxCoeffMeasure)
+                  {
+                      maxCoeffMeasure = coeffMeasure;
+                      coarseIndex[nr] = firstPassIndex[nc];
+                  }
+              }
+          }
+      }
+
+    // and the rest are grouped with their ungrouped strong neighbours
+    for(int nr=0; nr<nRows; nr++)
+      if (coarseIndex[nr] == -1 && !_isBoundary[nr])
+      {
+          coarseIndex[nr] = nCoarseRows;
+          for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+            if (isStrong[nb] && coarseIndex[_col[nb]] == -1)
+              coarseIndex[_col[nb]] = nCoarseRows;
+          nCoarseRows++;
+      }
+
+    return nCoarseRows;
+  }
+
+  /**
+   * Create the connectivity of the prolongation from the coarse site
+   * to the row site of this matrix for the coarsening computed by
+   * createStrengthCoarsening. Without classical each self row gets
+   * its own aggregate and those of the self neighbours it is strongly
+   * connected to. With classical the C rows only get their own coarse
+   * row and the F rows those of their strong C neighbours. Ghost rows
+   * only get their own coarse row, if any.
+   *
+   */
+
+  virtual shared_ptr<CRConnectivity>
+  createProlongationConnectivity(const IContainer& gCoarseIndex,
+                                 const StorageSite& coarseSite,
+                                 const double strengthThreshold,
+                                 const bool classical) const
+  {
+    const Array<int>&  coarseIndex = dynamic_cast<const Array<int>& >(gCoarseIndex);
+
+    const StorageSite& fineSite = _conn.getRowSite();
+    const int nFineRows = fineSite.getCountLevel1();
+
+    shared_ptr<CRConnectivity> prolongation(new CRConnectivity(fineSite,coarseSite));
+
+    Array<bool> isStrong(_col.getLength());
+    markStrongConnections(isStrong,strengthThreshold,classical);
+
+    Array<bool> coarseCounted(coarseSite.getCountLevel1());
+    coarseCounted = false;
+
+    Array<int> columns(coarseSite.getCountLevel1());
+
+    prolongation->initCount();
+
+    for(int nr=0; nr<nFineRows; nr++)
+    {
+        const int nCols = getProlongationColumns(nr,coarseIndex,isStrong,classical,
+                                                 coarseCounted,columns);
+        prolongation->addCount(nr,nCols);
+    }
+
+    prolongation->finishCount();
+
+    for(int nr=0; nr<nFineRows; nr++)
+    {
+        const int nCols = getProlongationColumns(nr,coarseIndex,isStrong,classical,
+                                                 coarseCounted,columns);
+        for(int n=0; n<nCols; n++)
+          prolongation->add(nr,columns[n]);
+    }
+
+    prolongation->finishAdd();
+
+    return prolongation;
   }
 
   /**
-   * create the coarse matrix given the coarsening and the coarse
-   * level connectivity.
-   * 
+   * set the weights of a prolongator created on the connectivity
+   * returned by createProlongationConnectivity from the current
+   * coefficients. With classical these are the direct interpolation
+   * weights, otherwise those of one damped Jacobi step with the
+   * filtered matrix applied to the piecewise constant prolongation,
+   * i.e. P = (I - omega D^-1 A) P0, with omega = smoothing/rho(D^-1 A).
+   *
    */
 
-  shared_ptr<Matrix>
-  createCoarseMatrix(const IContainer& gCoarseIndex,
-                     const CRConnectivity& coarseToFine,
-                     const CRConnectivity& coarseConnectivity)
+  virtual void
+  updateProlongator(Matrix& gProlongator,
+                    const IContainer& gCoarseIndex,
+                    const double strengthThreshold,
+                    const bool classical,
+                    const double smoothing) const
   {
     const Array<int>&  coarseIndex = dynamic_cast<const Array<int>& >(gCoarseIndex);
-    const int nCoarseRows = coarseConnectivity.getRowDim();
+    ProlongationMatrix& prolongator = dynamic_cast<ProlongationMatrix&>(gProlongator);
+
+    if (classical)
+      setClassicalProlongation(prolongator.getCoeff(),
+                               prolongator.getConnectivity(),
+                               coarseIndex, _diag, _offDiag, _conn);
+    else
+      setSmoothedProlongation(prolongator.getCoeff(),
+                              prolongator.getConnectivity(),
+                              coarseIndex, _diag, _offDiag, _conn,
+                              strengthThreshold, smoothing);
+  }
 
-    shared_ptr<CRMatrix> coarseMatrix(new CRMatrix(coarseConnectivity));
+  /**
+   * Create the connectivity for the Galerkin coarse matrix
+   * transpose(rowProlongator) * this * colProlongator
+   *
+   */
 
-    Array<Diag>& coarseDiag = coarseMatrix->getDiag();
-    Array<OffDiag>& coarseOffDiag = coarseMatrix->getOffDiag();
+  virtual shared_ptr<CRConnectivity>
+  createGalerkinConnectivity(const Matrix& rowProlongator,
+                             const Matrix& colProlongator,
+                             const StorageSite& coarseRowSite,
+                             const StorageSite& coarseColSite) const
+  {
+    const CRConnectivity& rowProlongation = rowProlongator.getConnectivity();
+    const CRConnectivity& colProlongation = colProlongator.getConnectivity();
 
-    const Array<int>& coarseConnRow = coarseConnectivity.getRow();
-    const Array<int>& coarseConnCol = coarseConnectivity.getCol();
+    shared_ptr<CRConnectivity> restriction(rowProlongation.getTranspose());
 
-    coarseDiag.zero();
-    coarseOffDiag.zero();
+    const int nCoarseRows = coarseRowSite.getCountLevel1();
 
-    //used to avoid searches when inserting coeffs
-    Array<int> coarseCoeffPos(nCoarseRows);
+    shared_ptr<CRConnectivity> coarseCR(new CRConnectivity(coarseRowSite,coarseColSite));
 
+    Array<bool> coarseCounted(coarseColSite.getCountLevel1());
+    coarseCounted = false;
+
+    Array<int> columns(coarseColSite.getCountLevel1());
+
+    coarseCR->initCount();
 
     for(int nrCoarse=0; nrCoarse<nCoarseRows; nrCoarse++)
     {
-        // for easy indexing when inserting coefficients set col
-        // positions into the coarse connectivity
-        for(int nb=coarseConnRow[nrCoarse]; nb<coarseConnRow[nrCoarse+1]; nb++)
-          coarseCoeffPos[coarseConnCol[nb]] = nb;
-
-        // loop over the fine rows that make up this coarse row
-        const int nFine = coarseToFine.getCount(nrCoarse);
-        for(int nfr=0; nfr<nFine; nfr++)
-        {
-            const int nrFine = coarseToFine(nrCoarse,nfr);
+        const int nCols = getGalerkinColumns(nrCoarse,*restriction,colProlongation,
+                                             coarseCounted,columns);
+        coarseCR->addCount(nrCoarse,nCols);
+    }
 
-            coarseDiag[nrCoarse] += _diag[nrFine];
-            
-            for (int nb = _row[nrFine]; nb<_row[nrFine+1]; nb++)
-            {
-                const int nc = _col[nb];
-                const int ncCoarse = coarseIndex[nc];
+    coarseCR->finishCount();
 
-                if (ncCoarse<0) continue;
-                
-                if (nrCoarse!=ncCoarse)
-                {
-                    const int pos = coarseCoeffPos[ncCoarse];
-                    coarseOffDiag[pos] += _offDiag[nb];
-                }
-                else 
-                {
-                    coarseDiag[nrCoarse] += _offDiag[nb];
-                }
-            }
-        }
+    for(int nrCoarse=0; nrCoarse<nCoarseRows; nrCoarse++)
+    {
+        const int nCols = getGalerkinColumns(nrCoarse,*restriction,colProlongation,
+                                             coarseCounted,columns);
+        for(int n=0; n<nCols; n++)
+          coarseCR->add(nrCoarse,columns[n]);
     }
 
+    coarseCR->finishAdd();
+
+    return coarseCR;
+  }
+
+  virtual shared_ptr<Matrix>
+  createGalerkinMatrix(const Matrix& rowProlongator,
+                       const Matrix& colProlongator,
+                       const CRConnectivity& coarseConnectivity) const
+  {
+    shared_ptr<CRMatrix> coarseMatrix(new CRMatrix(coarseConnectivity));
+    updateGalerkinMatrix(rowProlongator,colProlongator,*coarseMatrix);
     return coarseMatrix;
   }
 
+  virtual void
+  updateGalerkinMatrix(const Matrix& rowProlongator,
+                       const Matrix& colProlongator,
+                       Matrix& gCoarseMatrix) const
+  {
+    const ProlongationMatrix& rowP =
+      dynamic_cast<const ProlongationMatrix&>(rowProlongator);
+    const ProlongationMatrix& colP =
+      dynamic_cast<const ProlongationMatrix&>(colProlongator);
+    CRMatrix& coarseMatrix = dynamic_cast<CRMatrix&>(gCoarseMatrix);
+
+    setGalerkinCoeffs(coarseMatrix._diag, coarseMatrix._offDiag,
+                      coarseMatrix.getConnectivity(),
+                      _diag, _offDiag, _conn,
+                      rowP.getConnectivity(), rowP.getCoeff(),
+                      colP.getConnectivity(), colP.getCoeff());
+  }
+
 #ifdef FVM_PARALLEL
 
 shared_ptr<Matrix>
@@ -829,6 +1493,14 @@ createMergeMatrix( const LinearSystemMerger& mergeLS )
 
 }
 
+virtual shared_ptr<Matrix>
+createAgglomeratedMatrix(const CRConnectivity& conn) const
+{
+  shared_ptr<CRMatrix> m(new CRMatrix(conn));
+  m->initAssembly();
+  return m;
+}
+
 #endif
   
   virtual const CRConnectivity& getConnectivity() const {return _conn;}
@@ -1090,27 +1762,422 @@ createMergeMatrix( const LinearSystemMerger& mergeLS )
     setFlatCoeffs(fm.getOffDiag(), fm.getConnectivity(),
                   getDiag(), getOffDiag(), getConnectivity());
   }
+
+  virtual void setFlatMatrix(Matrix& fmg, const Array<int>& flatPositions) const
+  {
+    CRMatrix<double,double,double>& fm = dynamic_cast<CRMatrix<double,double,double>& >(fmg);
+    setFlatCoeffs(fm.getOffDiag(), flatPositions,
+                  getDiag(), getOffDiag(), getConnectivity());
+  }
+
+  virtual shared_ptr<Matrix> createSinglePrecisionMatrix() const
+  {
+    shared_ptr<CRMatrix<float,float,float> >
+      spMatrix(new CRMatrix<float,float,float>(_conn));
+    updateSinglePrecisionMatrix(*spMatrix);
+    return spMatrix;
+  }
+
+  virtual void updateSinglePrecisionMatrix(Matrix& spMatrixG) const
+  {
+    CRMatrix<float,float,float>& spMatrix =
+      dynamic_cast<CRMatrix<float,float,float>& >(spMatrixG);
+    setSinglePrecisionCoeffs(spMatrix._diag, spMatrix._offDiag, _diag, _offDiag);
+    spMatrix._isBoundary = _isBoundary;
+  }
   
 private:
 
+  // the symmetric strength criterion of smoothed aggregation for the
+  // coefficient at position nb of row nr
+  bool isStrongConnection(const int nr, const int nb,
+                          const double strengthThreshold) const
+  {
+    const double coeffMeasure =
+      fabs(NumTypeTraits<OffDiag>::doubleMeasure(_offDiag[nb]));
+    const double diagMeasure0 =
+      fabs(NumTypeTraits<Diag>::doubleMeasure(_diag[nr]));
+    const double diagMeasure1 =
+      fabs(NumTypeTraits<Diag>::doubleMeasure(_diag[_col[nb]]));
+    return coeffMeasure > 0 &&
+      coeffMeasure >= strengthThreshold*sqrt(diagMeasure0*diagMeasure1);
+  }
+
+  // marks the strong connections between the non boundary self rows
+  // using the criteria of createStrengthCoarsening
+  void markStrongConnections(Array<bool>& isStrong,
+                             const double strengthThreshold,
+                             const bool classical) const
+  {
+    const int nRows = _conn.getRowSite().getSelfCount();
+
+    isStrong = false;
+
+    for(int nr=0; nr<nRows; nr++)
+      if (!_isBoundary[nr])
+      {
+          double maxCoeffMeasure = 0;
+          if (classical)
+            for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+            {
+                const int nc = _col[nb];
+                if (nc < nRows && !_isBoundary[nc])
+                  maxCoeffMeasure =
+                    max(maxCoeffMeasure,
+                        fabs(NumTypeTraits<OffDiag>::doubleMeasure(_offDiag[nb])));
+            }
+
+          for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+          {
+              const int nc = _col[nb];
+              if (nc < nRows && !_isBoundary[nc])
+              {
+                  const double coeffMeasure =
+                    fabs(NumTypeTraits<OffDiag>::doubleMeasure(_offDiag[nb]));
+
+                  if (classical)
+                    isStrong[nb] = coeffMeasure > 0 &&
+                      coeffMeasure >= strengthThreshold*maxCoeffMeasure;
+                  else
+                    isStrong[nb] = isStrongConnection(nr,nb,strengthThreshold);
+              }
+          }
+      }
+  }
+
+  // the C/F splitting of createStrengthCoarsening with classical
+  int createClassicalSplitting(Array<int>& coarseIndex,
+                               const Array<bool>& isStrong) const
+  {
+    const int nRows = _conn.getRowSite().getSelfCount();
+
+    enum {UNASSIGNED, C_ROW, F_ROW, BOUNDARY_ROW};
+
+    // the rows strongly depending on each row, i.e. the transpose of
+    // the strong connections
+    Array<int> dependRow(nRows+1);
+    Array<int> dependCol(_col.getLength());
+
+    dependRow = 0;
+    for(int nr=0; nr<nRows; nr++)
+      for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+        if (isStrong[nb])
+          dependRow[_col[nb]+1]++;
+    for(int nr=0; nr<nRows; nr++)
+      dependRow[nr+1] += dependRow[nr];
+    for(int nr=0; nr<nRows; nr++)
+      for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+        if (isStrong[nb])
+          dependCol[dependRow[_col[nb]]++] = nr;
+    for(int nr=nRows; nr>0; nr--)
+      dependRow[nr] = dependRow[nr-1];
+    dependRow[0] = 0;
+
+    // the unassigned rows ordered by the number of rows depending on
+    // them, increased each time one of these becomes an F row
+    Array<int> rowType(nRows);
+    Array<int> measure(nRows);
+    set<pair<int,int> > candidates;
+
+    for(int nr=0; nr<nRows; nr++)
+    {
+        rowType[nr] = _isBoundary[nr] ? BOUNDARY_ROW : UNASSIGNED;
+        measure[nr] = dependRow[nr+1] - dependRow[nr];
+        if (rowType[nr] == UNASSIGNED)
+          candidates.insert(make_pair(measure[nr],nr));
+    }
+
+    while(!candidates.empty())
+    {
+        const int nr = candidates.rbegin()->second;
+        candidates.erase(make_pair(measure[nr],nr));
+        rowType[nr] = C_ROW;
+
+        for(int d=dependRow[nr]; d<dependRow[nr+1]; d++)
+        {
+            const int nf = dependCol[d];
+            if (rowType[nf] != UNASSIGNED)
+              continue;
+
+            candidates.erase(make_pair(measure[nf],nf));
+            rowType[nf] = F_ROW;
+
+            for(int nb=_row[nf]; nb<_row[nf+1]; nb++)
+            {
+                const int nc = _col[nb];
+                if (isStrong[nb] && rowType[nc] == UNASSIGNED)
+                {
+                    candidates.erase(make_pair(measure[nc],nc));
+                    candidates.insert(make_pair(++measure[nc],nc));
+                }
+            }
+        }
+
+        for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int nc = _col[nb];
+            if (isStrong[nb] && rowType[nc] == UNASSIGNED)
+            {
+                candidates.erase(make_pair(measure[nc],nc));
+                candidates.insert(make_pair(--measure[nc],nc));
+            }
+        }
+    }
+
+    // F rows that can't be interpolated
+    for(int nr=0; nr<nRows; nr++)
+      if (rowType[nr] == F_ROW)
+      {
+          bool hasCoarseNeighbour = false;
+          for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+            if (isStrong[nb] && rowType[_col[nb]] == C_ROW)
+            {
+                hasCoarseNeighbour = true;
+                break;
+            }
+          if (!hasCoarseNeighbour)
+            rowType[nr] = C_ROW;
+      }
+
+    int nCoarseRows=0;
+    for(int nr=0; nr<nRows; nr++)
+      if (rowType[nr] == C_ROW)
+        coarseIndex[nr] = nCoarseRows++;
+
+    return nCoarseRows;
+  }
+
+  // collects the columns of row nr of the prolongation created by
+  // createProlongationConnectivity. coarseCounted must be all false
+  // and is left that way.
+  int getProlongationColumns(const int nr,
+                             const Array<int>& coarseIndex,
+                             const Array<bool>& isStrong,
+                             const bool classical,
+                             Array<bool>& coarseCounted,
+                             Array<int>& columns) const
+  {
+    const int nSelfRows = _conn.getRowSite().getSelfCount();
+    const int nrCoarse = coarseIndex[nr];
+
+    int nCols = 0;
+    if (nrCoarse >= 0)
+    {
+        columns[nCols++] = nrCoarse;
+        if (classical || nr >= nSelfRows)
+          return nCols;
+        coarseCounted[nrCoarse] = true;
+    }
+    else if (!classical || nr >= nSelfRows || _isBoundary[nr])
+      return nCols;
+
+    for(int nb=_row[nr]; nb<_row[nr+1]; nb++)
+      if (isStrong[nb])
+      {
+          const int ncCoarse = coarseIndex[_col[nb]];
+          if (ncCoarse >= 0 && !coarseCounted[ncCoarse])
+          {
+              coarseCounted[ncCoarse] = true;
+              columns[nCols++] = ncCoarse;
+          }
+      }
+
+    for(int n=0; n<nCols; n++)
+      coarseCounted[columns[n]] = false;
+
+    return nCols;
+  }
+
+  // collects the columns of row nrCoarse of the Galerkin coarse
+  // matrix, excluding the diagonal, from the fine rows restricted
+  // into it. coarseCounted must be all false and is left that way.
+  int getGalerkinColumns(const int nrCoarse,
+                         const CRConnectivity& restriction,
+                         const CRConnectivity& colProlongation,
+                         Array<bool>& coarseCounted,
+                         Array<int>& columns) const
+  {
+    const Array<int>& rRow = restriction.getRow();
+    const Array<int>& rCol = restriction.getCol();
+    const Array<int>& pRow = colProlongation.getRow();
+    const Array<int>& pCol = colProlongation.getCol();
+
+    int nCols = 0;
+    for(int rp=rRow[nrCoarse]; rp<rRow[nrCoarse+1]; rp++)
+    {
+        const int nrFine = rCol[rp];
+
+        // the prolongation rows of the fine row itself and of its
+        // neighbours
+        for(int nb=_row[nrFine]-1; nb<_row[nrFine+1]; nb++)
+        {
+            const int nc = (nb < _row[nrFine]) ? nrFine : _col[nb];
+            for(int pp=pRow[nc]; pp<pRow[nc+1]; pp++)
+            {
+                const int ncCoarse = pCol[pp];
+                if (ncCoarse != nrCoarse && !coarseCounted[ncCoarse])
+                {
+                    coarseCounted[ncCoarse] = true;
+                    columns[nCols++] = ncCoarse;
+                }
+            }
+        }
+    }
+
+    for(int n=0; n<nCols; n++)
+      coarseCounted[columns[n]] = false;
+
+    return nCols;
+  }
+
+  typedef CRMatrixKernels<Diag,OffDiag,X> Kernels;
+
+  Kernels getKernels() const
+  {
+    return Kernels(_row,_col,_diag,_offDiag);
+  }
+
+  void coloredGS(XArray& x, const XArray& b, const bool reverse) const
+  {
+    if (!_rowColors)
+    {
+        _colorSite = shared_ptr<StorageSite>(new StorageSite(0));
+        _rowColors = _conn.getAdjacencyColoring(*_colorSite,
+                                                _conn.getRowSite().getSelfCount());
+    }
+
+    const CRConnectivity& colors = *_rowColors;
+    const Kernels kernels(getKernels());
+    const int nColors = colors.getRowDim();
+    for(int n=0; n<nColors; n++)
+    {
+        const int c = reverse ? nColors-1-n : n;
+        const int nColorRows = colors.getCount(c);
+#pragma omp parallel for if (nColorRows > CRMATRIX_MIN_THREADED_ROWS)
+        for(int i=0; i<nColorRows; i++)
+          kernels.relaxRow(colors(c,i),x,b);
+    }
+  }
+
+  void blockGS(XArray& x, const XArray& b, const bool reverse) const
+  {
+    const int nRows = _conn.getRowSite().getSelfCount();
+
+    // values at the start of the sweep, used for the couplings to
+    // other blocks
+    if (!_xOld || _xOld->getLength() != x.getLength())
+      _xOld = shared_ptr<XArray>(new XArray(x.getLength()));
+    XArray& xOld = *_xOld;
+    xOld.copyPartial(x,0,x.getLength());
+
+    // one block per thread, or a plain Gauss-Seidel sweep on levels too
+    // small to be threaded
+    int nBlocks = 1;
+#ifdef _OPENMP
+    if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+      nBlocks = omp_get_max_threads();
+#endif
+
+    const Kernels kernels(getKernels());
+
+#pragma omp parallel for if (nBlocks > 1)
+    for(int n=0; n<nBlocks; n++)
+    {
+        const int nBegin = int((long(nRows)*n)/nBlocks);
+        const int nEnd = int((long(nRows)*(n+1))/nBlocks);
+        if (reverse)
+          for(int nr=nEnd-1; nr>=nBegin; nr--)
+            kernels.relaxRowL1(nr,nBegin,nEnd,nRows,x,xOld,b);
+        else
+          for(int nr=nBegin; nr<nEnd; nr++)
+            kernels.relaxRowL1(nr,nBegin,nEnd,nRows,x,xOld,b);
+    }
+  }
+
+    // the boundary rows are those of the boundary ghost cells and don't
+    // change between linearizations, so the counts and indices are only
+    // exchanged the first time and when the rows or their connectivity
+    // differ from those recorded with the plan. Otherwise the
+    // coefficients and b go to each neighbour in one message of a
+    // persistent plan.
     void syncBndryCoeffs( const Array<X>& b )
     {
-       //create recvCounts buffer
-       createScatterGatherCountsBuffer();
-       //syn counts
-       syncCounts();
-       //create recvindices buffer
-       createScatterGatherIndicesBuffer();
-       //sync indices 
-       syncIndices();
-       //create crmtrx buffer
+       if ( _bndryCoeffsSyncPlan && !isBndryCoeffsStructureCurrent() ){
+          _bndryCoeffsSyncPlan.reset();
+          _sendValuesCRMtrx.clear();
+          _recvValuesCRMtrx.clear();
+          _sendValuesB.clear();
+          _recvValuesB.clear();
+       }
+       if ( !_bndryCoeffsSyncPlan ){
+          recordBndryCoeffsStructure();
+          //create recvCounts buffer
+          createScatterGatherCountsBuffer();
+          //syn counts
+          syncCounts();
+          //create recvindices buffer
+          createScatterGatherIndicesBuffer();
+          //sync indices 
+          syncIndices();
+       }
+       //fill crmtrx buffer
        createScatterGatherValuesCRMtrxBuffer();
-       //sync values crmtrx
-       syncValuesCRMtrx();
-       //create b buffer
+       //fill b buffer
        createScatterGatherValuesBBuffer(b);
-       //sync values b
-       syncValuesB();
+       //sync values crmtrx and b
+       syncValues();
+    }
+
+    // the plan and the buffers are kept for as long as the boundary rows
+    // sent to the neighbours and their columns are the ones recorded
+    // here, in the order of the send buffers. A change has to be made on
+    // all the processes sharing the rows, as repartitioning does.
+    void recordBndryCoeffsStructure()
+    {
+       _bndryCoeffsStructure.clear();
+       const StorageSite& site = _conn.getRowSite();
+       const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
+       foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
+          const Array<int>& scatterArray = *mpos.second;
+          _bndryCoeffsStructure.push_back( scatterArray.getLength() );
+          for( int i = 0; i < scatterArray.getLength(); i++ ){
+             const int ii = scatterArray[i];
+             if ( _isBoundary[ii] ){
+                _bndryCoeffsStructure.push_back( ii );
+                _bndryCoeffsStructure.push_back( _conn.getCount(ii) );
+                for ( int j = 0; j < _conn.getCount(ii); j++ )
+                   _bndryCoeffsStructure.push_back( _conn(ii,j) );
+             }
+          }
+       }
+    }
+
+    bool isBndryCoeffsStructureCurrent() const
+    {
+       const int size = int(_bndryCoeffsStructure.size());
+       int indx = 0;
+       const StorageSite& site = _conn.getRowSite();
+       const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
+       foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
+          const Array<int>& scatterArray = *mpos.second;
+          if ( indx == size || _bndryCoeffsStructure[indx++] != scatterArray.getLength() )
+             return false;
+          for( int i = 0; i < scatterArray.getLength(); i++ ){
+             const int ii = scatterArray[i];
+             if ( _isBoundary[ii] ){
+                const int count = _conn.getCount(ii);
+                if ( indx + 2 + count > size ||
+                     _bndryCoeffsStructure[indx] != ii ||
+                     _bndryCoeffsStructure[indx+1] != count )
+                   return false;
+                indx += 2;
+                for ( int j = 0; j < count; j++ )
+                   if ( _bndryCoeffsStructure[indx++] != _conn(ii,j) )
+                      return false;
+             }
+          }
+       }
+       return indx == size;
     }
 
     //fill countArray (both mesh and partition) and only gatherArray for mesh
@@ -1345,7 +2412,8 @@ private:
               sendSize += send_counts[i];
            }
            //allocate array
-           _sendValuesCRMtrx[e]  = shared_ptr< Array<OffDiag> > ( new Array<OffDiag> (sendSize) );
+           if ( !_sendValuesCRMtrx[e] )
+              _sendValuesCRMtrx[e]  = shared_ptr< Array<OffDiag> > ( new Array<OffDiag> (sendSize) );
            //fill send array
            Array<OffDiag>& valueArray = dynamic_cast< Array<OffDiag>& > ( *_sendValuesCRMtrx[e]  );
            int indx = 0;
@@ -1373,7 +2441,8 @@ private:
              recvSize += recvCounts[i];
            }
           //allocate array
-          _recvValuesCRMtrx[e] = shared_ptr< Array<OffDiag> > ( new Array<OffDiag> (recvSize) );
+          if ( !_recvValuesCRMtrx[e] )
+             _recvValuesCRMtrx[e] = shared_ptr< Array<OffDiag> > ( new Array<OffDiag> (recvSize) );
           //mesh interface can be done know
           if ( oSite.getGatherProcID() == - 1) {
              *_recvValuesCRMtrx[e] = *_sendValuesCRMtrx[e];
@@ -1382,54 +2451,6 @@ private:
 
     }
 
-    //sending values
-    void syncValuesCRMtrx()
-    {
-       #ifdef FVM_PARALLEL
-          //SENDING
-          const int  request_size = get_request_size();
-          MPI::Request   request_send[ request_size ];
-          MPI::Request   request_recv[ request_size ];
-          int indxSend = 0;
-          int indxRecv = 0;
-          const StorageSite&    site      = _conn.getRowSite();
-          const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-          foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-             const StorageSite&  oSite = *mpos.first;
-             EntryIndex e(&site,&oSite);
-             //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             ArrayBase& sendArray = *_sendValuesCRMtrx[e];
-             //loop over surround indices and itself
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                    MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-          }
-          //RECIEVING
-          //getting values from other meshes to fill g
-          const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-          foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-             const StorageSite&  oSite = *mpos.first;
-             //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&oSite,&site);
-             ArrayBase& recvArray = *_recvValuesCRMtrx[e];
-             int from_where       = oSite.getGatherProcID();
-             if ( from_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_recv[indxRecv++] =  
-                      MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-             }
-          }
-
-          int count  = get_request_size();
-          MPI::Request::Waitall( count, request_recv );
-          MPI::Request::Waitall( count, request_send );
-#endif
-
-    }
-
     //fill scatterArray (both mesh and partition) and only gatherArray for mesh
     void    createScatterGatherValuesBBuffer(const XArray& B)
     {
@@ -1445,7 +2466,8 @@ private:
            const Array<int>& send_counts = dynamic_cast< const Array<int>& > (*_sendCounts[e]);
            int sendSize = send_counts.getLength();
            //allocate array
-           _sendValuesB[e]  = shared_ptr< Array<X> > ( new Array<X> (sendSize) );
+           if ( !_sendValuesB[e] )
+              _sendValuesB[e]  = shared_ptr< Array<X> > ( new Array<X> (sendSize) );
            //fill send array
            XArray& bArray = dynamic_cast< Array<X>& > ( *_sendValuesB[e]  );
            int indx = 0;
@@ -1465,7 +2487,8 @@ private:
           const Array<int>& recvCounts  =  dynamic_cast< const Array<int>& > (*_recvCounts[e]);
           int recvSize = recvCounts.getLength();
           //allocate array
-          _recvValuesB[e] = shared_ptr< Array<X> > ( new Array<X> (recvSize) );
+          if ( !_recvValuesB[e] )
+             _recvValuesB[e] = shared_ptr< Array<X> > ( new Array<X> (recvSize) );
           //mesh interface can be done know
           if ( oSite.getGatherProcID() == - 1) {
              *_recvValuesB[e] = *_sendValuesB[e];
@@ -1474,52 +2497,40 @@ private:
 
     }
 
-    //sending values
-    void syncValuesB()
+    //sending values of crmtrx and b
+    void syncValues()
     {
-       #ifdef FVM_PARALLEL
-          //SENDING
-          const int  request_size = get_request_size();
-          MPI::Request   request_send[ request_size ];
-          MPI::Request   request_recv[ request_size ];
-          int indxSend = 0;
-          int indxRecv = 0;
-          const StorageSite&    site      = _conn.getRowSite();
-          const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-          foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-             const StorageSite&  oSite = *mpos.first;
-             EntryIndex e(&site,&oSite);
-             //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             ArrayBase& sendArray = *_sendValuesB[e];
-             //loop over surround indices and itself
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                    MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-          }
-          //RECIEVING
-          //getting values from other meshes to fill g
-          const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-          foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-             const StorageSite&  oSite = *mpos.first;
-             //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&oSite,&site);
-             ArrayBase& recvArray = *_recvValuesB[e];
-             int from_where       = oSite.getGatherProcID();
-             if ( from_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_recv[indxRecv++] =  
-                      MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-             }
-          }
-
-          int count  = get_request_size();
-          MPI::Request::Waitall( count, request_recv );
-          MPI::Request::Waitall( count, request_send );
+#ifdef FVM_PARALLEL
+       if ( !_bndryCoeffsSyncPlan )
+          createBndryCoeffsSyncPlan();
+       _bndryCoeffsSyncPlan->start();
+       _bndryCoeffsSyncPlan->finish();
 #endif
+    }
 
+    //both buffers for a neighbour are added with the same tag so that they
+    //are sent as one message
+    void createBndryCoeffsSyncPlan()
+    {
+       shared_ptr<BndryCoeffsSyncPlan> plan( new BndryCoeffsSyncPlan() );
+       const StorageSite& site = _conn.getRowSite();
+       const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
+       foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
+          const StorageSite&  oSite = *mpos.first;
+          EntryIndex e(&site,&oSite);
+          const int to_where = oSite.getGatherProcID();
+          plan->addSend( e, *mpos.second, *_sendValuesCRMtrx[e], to_where, oSite.getTag() );
+          plan->addSend( e, *mpos.second, *_sendValuesB[e], to_where, oSite.getTag() );
+       }
+       const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
+       foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
+          const StorageSite&  oSite = *mpos.first;
+          EntryIndex e(&oSite,&site);
+          const int from_where = oSite.getGatherProcID();
+          plan->addRecv( e, *mpos.second, *_recvValuesCRMtrx[e], from_where, oSite.getTag() );
+          plan->addRecv( e, *mpos.second, *_recvValuesB[e], from_where, oSite.getTag() );
+       }
+       _bndryCoeffsSyncPlan = plan;
     }
 
     int  get_request_size()
@@ -1736,6 +2747,16 @@ private:
   mutable DiagArrayPtr _iluCoeffsPtr;
   
   mutable shared_ptr<T_SpikeMtrx>  _spikeMtrx;
+
+  // colouring of the rows for the multicolour GaussSeidel
+  mutable shared_ptr<StorageSite> _colorSite;
+  mutable shared_ptr<CRConnectivity> _rowColors;
+
+  // copy of x used by the hybrid GaussSeidel
+  mutable shared_ptr<XArray> _xOld;
+
+  // work array of updateCoarseMatrix
+  IntArrayPtr _coarseCoeffPos;
   
   GhostArrayMap   _sendCounts;
   GhostArrayMap   _recvCounts;
@@ -1746,6 +2767,8 @@ private:
   GhostArrayMap   _sendValuesB;
   GhostArrayMap   _recvValuesB;  
   map<int,int>    _ghostCellBoundayMap;
+  shared_ptr<BndryCoeffsSyncPlan> _bndryCoeffsSyncPlan;
+  vector<int>     _bndryCoeffsStructure;
 
  
 };
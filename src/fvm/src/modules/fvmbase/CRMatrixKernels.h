@@ -0,0 +1,680 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _CRMATRIXKERNELS_H_
+#define _CRMATRIXKERNELS_H_
+
+#include "Array.h"
+#include "Vector.h"
+#include "SquareTensor.h"
+#include "DiagonalTensor.h"
+
+/**
+ * Row loops used by CRMatrix for products, residuals and relaxation
+ * sweeps. The arrays are those of the matrix, i.e. the compressed row
+ * structure and the separately stored diagonal and off diagonal
+ * coefficients.
+ *
+ * CRMatrixGenericKernels works for any coefficient types using their
+ * arithmetic operators. CRMatrixKernels defaults to it and is
+ * specialized below for the scalar matrices and the three component
+ * block matrices used by the flow and structure models. The
+ * specializations accumulate each row in local variables and expand
+ * the block arithmetic so that no temporaries are created inside the
+ * loops; they do the same operations in the same order as the
+ * generic versions.
+ *
+ * The products, residuals and Jacobi sweeps compute each row
+ * independently and share the rows among the OpenMP threads of the
+ * process when there are enough of them.
+ *
+ */
+
+// fewer rows than this are not worth starting threads for, as on the
+// coarse AMG levels
+#define CRMATRIX_MIN_THREADED_ROWS 1000
+
+template<class Diag, class OffDiag, class X>
+class CRMatrixGenericKernels
+{
+public:
+  CRMatrixGenericKernels(const Array<int>& row, const Array<int>& col,
+                         const Array<Diag>& diag,
+                         const Array<OffDiag>& offDiag) :
+    _row(row),
+    _col(col),
+    _diag(diag),
+    _offDiag(offDiag)
+  {}
+
+  // y = A x, or y += A x if add is true. With rows only the nRows
+  // rows listed there are computed
+  void multiply(const int nRows, const Array<X>& x, Array<X>& y,
+                const bool add, const int *rows=0) const
+  {
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int n=0; n<nRows; n++)
+    {
+        const int nr = rows ? rows[n] : n;
+        if (add)
+          y[nr] += _diag[nr]*x[nr];
+        else
+          y[nr] = _diag[nr]*x[nr];
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            y[nr] += _offDiag[nb]*x[j];
+        }
+    }
+  }
+
+  // r = b + A x
+  void computeResidual(const int nRows, const Array<X>& x,
+                       const Array<X>& b, Array<X>& r) const
+  {
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        r[nr] = b[nr] + _diag[nr]*x[nr];
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            r[nr] += _offDiag[nb]*x[j];
+        }
+    }
+  }
+
+  // Gauss-Seidel sweep over rows nBegin, nBegin+step, ... up to but
+  // not including nEnd
+  void GS(const int nBegin, const int nEnd, const int step,
+          Array<X>& x, const Array<X>& b) const
+  {
+    X sum;
+    for(int nr=nBegin; nr!=nEnd; nr+=step)
+    {
+        sum = b[nr];
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            sum += _offDiag[nb]*x[j];
+        }
+        x[nr] = -sum/_diag[nr];
+    }
+  }
+
+  void Jacobi(const int nRows, Array<X>& xnew, const Array<X>& xold,
+              const Array<X>& b) const
+  {
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        X sum = b[nr];
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            sum += _offDiag[nb]*xold[j];
+        }
+        xnew[nr] = -sum/_diag[nr];
+    }
+  }
+
+  // Gauss-Seidel update of a single row
+  void relaxRow(const int nr, Array<X>& x, const Array<X>& b) const
+  {
+    X sum = b[nr];
+    for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+    {
+        const int j = _col[nb];
+        sum += _offDiag[nb]*x[j];
+    }
+    x[nr] = -sum/_diag[nr];
+  }
+
+  /**
+   * update of a single row for the l1 smoothers. Columns in
+   * [nBegin,nEnd) contribute their current values from x, all others
+   * their values from xOld. For the other owned rows, i.e. columns
+   * below nRows, the magnitude of the coefficient is also added to the
+   * diagonal; the ghost columns are boundary values as in relaxRow. A
+   * row with no couplings to other owned blocks gets the plain
+   * Gauss-Seidel update, so a single block is a GaussSeidel sweep.
+   *
+   * The generic version scales the diagonal instead of shifting it
+   * so that the sign of its components need not be known.
+   * 
+   */
+  
+  void relaxRowL1(const int nr, const int nBegin, const int nEnd, const int nRows,
+                  Array<X>& x, const Array<X>& xOld, const Array<X>& b) const
+  {
+    typedef typename NumTypeTraits<Diag>::T_Scalar T_Scalar;
+    
+    X sum = b[nr];
+    double l1 = 0;
+    for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+    {
+        const int j = _col[nb];
+        if (j >= nBegin && j < nEnd)
+          sum += _offDiag[nb]*x[j];
+        else
+        {
+            sum += _offDiag[nb]*xOld[j];
+            if (j < nRows)
+              l1 += NumTypeTraits<OffDiag>::doubleMeasure(_offDiag[nb]);
+        }
+    }
+
+    if (l1 == 0)
+    {
+        x[nr] = -sum/_diag[nr];
+        return;
+    }
+
+    Diag diagL1(_diag[nr]);
+    diagL1 *= T_Scalar(1.0 + l1/NumTypeTraits<Diag>::doubleMeasure(_diag[nr]));
+    sum += _diag[nr]*xOld[nr];
+    x[nr] = xOld[nr] - sum/diagL1;
+  }
+
+protected:
+  const Array<int>& _row;
+  const Array<int>& _col;
+  const Array<Diag>& _diag;
+  const Array<OffDiag>& _offDiag;
+};
+
+template<class Diag, class OffDiag, class X>
+class CRMatrixKernels : public CRMatrixGenericKernels<Diag,OffDiag,X>
+{
+public:
+  CRMatrixKernels(const Array<int>& row, const Array<int>& col,
+                  const Array<Diag>& diag, const Array<OffDiag>& offDiag) :
+    CRMatrixGenericKernels<Diag,OffDiag,X>(row,col,diag,offDiag)
+  {}
+};
+
+/**
+ * scalar coefficients. The Gauss-Seidel sweeps are left to the generic
+ * version: each row waits for the value of the one before it, and the
+ * loop compiles to the same code either way.
+ *
+ */
+
+template<>
+class CRMatrixKernels<double,double,double> :
+  public CRMatrixGenericKernels<double,double,double>
+{
+public:
+  CRMatrixKernels(const Array<int>& row, const Array<int>& col,
+                  const Array<double>& diag, const Array<double>& offDiag) :
+    CRMatrixGenericKernels<double,double,double>(row,col,diag,offDiag),
+    _rowData(&row[0]),
+    _colData(&col[0]),
+    _diagData(&diag[0]),
+    _offDiagData(&offDiag[0])
+  {}
+
+  void multiply(const int nRows, const Array<double>& xA, Array<double>& yA,
+                const bool add, const int *rows=0) const
+  {
+    const double *x = &xA[0];
+    double *y = &yA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int n=0; n<nRows; n++)
+    {
+        const int nr = rows ? rows[n] : n;
+        double sum = add ? y[nr] + _diagData[nr]*x[nr] : _diagData[nr]*x[nr];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          sum += _offDiagData[nb]*x[_colData[nb]];
+        y[nr] = sum;
+    }
+  }
+
+  void computeResidual(const int nRows, const Array<double>& xA,
+                       const Array<double>& bA, Array<double>& rA) const
+  {
+    const double *x = &xA[0];
+    const double *b = &bA[0];
+    double *r = &rA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        double sum = b[nr] + _diagData[nr]*x[nr];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          sum += _offDiagData[nb]*x[_colData[nb]];
+        r[nr] = sum;
+    }
+  }
+
+  void Jacobi(const int nRows, Array<double>& xnewA,
+              const Array<double>& xoldA, const Array<double>& bA) const
+  {
+    double *xnew = &xnewA[0];
+    const double *xold = &xoldA[0];
+    const double *b = &bA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        double sum = b[nr];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          sum += _offDiagData[nb]*xold[_colData[nb]];
+        xnew[nr] = -sum/_diagData[nr];
+    }
+  }
+
+private:
+  const int *_rowData;
+  const int *_colData;
+  const double *_diagData;
+  const double *_offDiagData;
+};
+
+/**
+ * 3x3 blocks, used by the structure model. The diagonal block is
+ * inverted inline for the relaxation sweeps using the same formula
+ * as inverse() in SquareTensor.h.
+ *
+ */
+
+template<>
+class CRMatrixKernels<SquareTensor<double,3>,SquareTensor<double,3>,Vector<double,3> > :
+  public CRMatrixGenericKernels<SquareTensor<double,3>,SquareTensor<double,3>,
+                                Vector<double,3> >
+{
+public:
+  typedef SquareTensor<double,3> Block;
+  typedef Vector<double,3> VectorT3;
+
+  CRMatrixKernels(const Array<int>& row, const Array<int>& col,
+                  const Array<Block>& diag, const Array<Block>& offDiag) :
+    CRMatrixGenericKernels<Block,Block,VectorT3>(row,col,diag,offDiag),
+    _rowData(&row[0]),
+    _colData(&col[0]),
+    _diagData(&diag[0]),
+    _offDiagData(&offDiag[0])
+  {}
+
+  void multiply(const int nRows, const Array<VectorT3>& xA, Array<VectorT3>& yA,
+                const bool add, const int *rows=0) const
+  {
+    const VectorT3 *x = &xA[0];
+    VectorT3 *y = &yA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int n=0; n<nRows; n++)
+    {
+        const int nr = rows ? rows[n] : n;
+        double s0, s1, s2;
+        addProduct(_diagData[nr],x[nr],s0,s1,s2,false);
+        if (add)
+        {
+            s0 = y[nr][0] + s0;
+            s1 = y[nr][1] + s1;
+            s2 = y[nr][2] + s2;
+        }
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          addProduct(_offDiagData[nb],x[_colData[nb]],s0,s1,s2,true);
+        y[nr][0] = s0;
+        y[nr][1] = s1;
+        y[nr][2] = s2;
+    }
+  }
+
+  void computeResidual(const int nRows, const Array<VectorT3>& xA,
+                       const Array<VectorT3>& bA, Array<VectorT3>& rA) const
+  {
+    const VectorT3 *x = &xA[0];
+    const VectorT3 *b = &bA[0];
+    VectorT3 *r = &rA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        double s0, s1, s2;
+        addProduct(_diagData[nr],x[nr],s0,s1,s2,false);
+        s0 = b[nr][0] + s0;
+        s1 = b[nr][1] + s1;
+        s2 = b[nr][2] + s2;
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          addProduct(_offDiagData[nb],x[_colData[nb]],s0,s1,s2,true);
+        r[nr][0] = s0;
+        r[nr][1] = s1;
+        r[nr][2] = s2;
+    }
+  }
+
+  void GS(const int nBegin, const int nEnd, const int step,
+          Array<VectorT3>& xA, const Array<VectorT3>& bA) const
+  {
+    VectorT3 *x = &xA[0];
+    const VectorT3 *b = &bA[0];
+    for(int nr=nBegin; nr!=nEnd; nr+=step)
+      relax(nr,x,b);
+  }
+
+  void relaxRow(const int nr, Array<VectorT3>& x, const Array<VectorT3>& b) const
+  {
+    relax(nr,&x[0],&b[0]);
+  }
+
+  // the l1 terms are added to each row of the diagonal block
+  void relaxRowL1(const int nr, const int nBegin, const int nEnd, const int nRows,
+                  Array<VectorT3>& x, const Array<VectorT3>& xOld,
+                  const Array<VectorT3>& b) const
+  {
+    double s0 = b[nr][0];
+    double s1 = b[nr][1];
+    double s2 = b[nr][2];
+    double l0 = 0, l1 = 0, l2 = 0;
+    const int nbEnd = _rowData[nr+1];
+    for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+    {
+        const int j = _colData[nb];
+        const Block& a = _offDiagData[nb];
+        if (j >= nBegin && j < nEnd)
+          addProduct(a,x[j],s0,s1,s2,true);
+        else
+        {
+            addProduct(a,xOld[j],s0,s1,s2,true);
+            if (j >= nRows)
+              continue;
+            l0 += fabs(a(0,0)) + fabs(a(0,1)) + fabs(a(0,2));
+            l1 += fabs(a(1,0)) + fabs(a(1,1)) + fabs(a(1,2));
+            l2 += fabs(a(2,0)) + fabs(a(2,1)) + fabs(a(2,2));
+        }
+    }
+
+    if (l0 == 0 && l1 == 0 && l2 == 0)
+    {
+        solveDiag(_diagData[nr],-s0,-s1,-s2,x[nr]);
+        return;
+    }
+
+    const Block& d = _diagData[nr];
+    addProduct(d,xOld[nr],s0,s1,s2,true);
+    Block dL1(d);
+    dL1(0,0) += d(0,0) < 0 ? -l0 : l0;
+    dL1(1,1) += d(1,1) < 0 ? -l1 : l1;
+    dL1(2,2) += d(2,2) < 0 ? -l2 : l2;
+    VectorT3 dx;
+    solveDiag(dL1,s0,s1,s2,dx);
+    x[nr] = xOld[nr] - dx;
+  }
+
+  void Jacobi(const int nRows, Array<VectorT3>& xnewA,
+              const Array<VectorT3>& xoldA, const Array<VectorT3>& bA) const
+  {
+    VectorT3 *xnew = &xnewA[0];
+    const VectorT3 *xold = &xoldA[0];
+    const VectorT3 *b = &bA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        double s0 = b[nr][0];
+        double s1 = b[nr][1];
+        double s2 = b[nr][2];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+          addProduct(_offDiagData[nb],xold[_colData[nb]],s0,s1,s2,true);
+        solveDiag(_diagData[nr],-s0,-s1,-s2,xnew[nr]);
+    }
+  }
+
+private:
+  void relax(const int nr, VectorT3 *x, const VectorT3 *b) const
+  {
+    double s0 = b[nr][0];
+    double s1 = b[nr][1];
+    double s2 = b[nr][2];
+    const int nbEnd = _rowData[nr+1];
+    for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+      addProduct(_offDiagData[nb],x[_colData[nb]],s0,s1,s2,true);
+    solveDiag(_diagData[nr],-s0,-s1,-s2,x[nr]);
+  }
+
+  // s += a*v, or s = a*v if add is false
+  static void addProduct(const Block& a, const VectorT3& v,
+                         double& s0, double& s1, double& s2, const bool add)
+  {
+    const double p0 = a(0,0)*v[0] + a(0,1)*v[1] + a(0,2)*v[2];
+    const double p1 = a(1,0)*v[0] + a(1,1)*v[1] + a(1,2)*v[2];
+    const double p2 = a(2,0)*v[0] + a(2,1)*v[1] + a(2,2)*v[2];
+    if (add)
+    {
+        s0 += p0;
+        s1 += p1;
+        s2 += p2;
+    }
+    else
+    {
+        s0 = p0;
+        s1 = p1;
+        s2 = p2;
+    }
+  }
+
+  // x = inverse(a)*(r0,r1,r2)
+  static void solveDiag(const Block& a, const double r0, const double r1,
+                        const double r2, VectorT3& x)
+  {
+    const double det = a(0,0)*(a(1,1)*a(2,2)-a(1,2)*a(2,1))
+      -a(0,1)*(a(1,0)*a(2,2) - a(1,2)*a(2,0))
+      +a(0,2)*(a(1,0)*a(2,1) - a(1,1)*a(2,0));
+
+    const double i00 =  (a(1,1)*a(2,2) - a(1,2)*a(2,1)) / det;
+    const double i01 =  (a(0,2)*a(2,1) - a(0,1)*a(2,2)) / det;
+    const double i02 =  (a(0,1)*a(1,2) - a(0,2)*a(1,1)) / det;
+    const double i10 =  (a(1,2)*a(2,0) - a(1,0)*a(2,2)) / det;
+    const double i11 =  (a(0,0)*a(2,2) - a(0,2)*a(2,0)) / det;
+    const double i12 =  (a(0,2)*a(1,0) - a(0,0)*a(1,2)) / det;
+    const double i20 =  (a(1,0)*a(2,1) - a(1,1)*a(2,0)) / det;
+    const double i21 =  (a(0,1)*a(2,0) - a(0,0)*a(2,1)) / det;
+    const double i22 =  (a(0,0)*a(1,1) - a(0,1)*a(1,0)) / det;
+
+    x[0] = i00*r0 + i01*r1 + i02*r2;
+    x[1] = i10*r0 + i11*r1 + i12*r2;
+    x[2] = i20*r0 + i21*r1 + i22*r2;
+  }
+
+  const int *_rowData;
+  const int *_colData;
+  const Block *_diagData;
+  const Block *_offDiagData;
+};
+
+/**
+ * diagonal 3x3 diagonal blocks with scalar off diagonal coefficients,
+ * used by the momentum equations of the flow model
+ *
+ */
+
+template<>
+class CRMatrixKernels<DiagonalTensor<double,3>,double,Vector<double,3> > :
+  public CRMatrixGenericKernels<DiagonalTensor<double,3>,double,Vector<double,3> >
+{
+public:
+  typedef DiagonalTensor<double,3> DiagBlock;
+  typedef Vector<double,3> VectorT3;
+
+  CRMatrixKernels(const Array<int>& row, const Array<int>& col,
+                  const Array<DiagBlock>& diag, const Array<double>& offDiag) :
+    CRMatrixGenericKernels<DiagBlock,double,VectorT3>(row,col,diag,offDiag),
+    _rowData(&row[0]),
+    _colData(&col[0]),
+    _diagData(&diag[0]),
+    _offDiagData(&offDiag[0])
+  {}
+
+  void multiply(const int nRows, const Array<VectorT3>& xA, Array<VectorT3>& yA,
+                const bool add, const int *rows=0) const
+  {
+    const VectorT3 *x = &xA[0];
+    VectorT3 *y = &yA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int n=0; n<nRows; n++)
+    {
+        const int nr = rows ? rows[n] : n;
+        const DiagBlock& d = _diagData[nr];
+        double s0 = d[0]*x[nr][0];
+        double s1 = d[1]*x[nr][1];
+        double s2 = d[2]*x[nr][2];
+        if (add)
+        {
+            s0 = y[nr][0] + s0;
+            s1 = y[nr][1] + s1;
+            s2 = y[nr][2] + s2;
+        }
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+        {
+            const double a = _offDiagData[nb];
+            const VectorT3& xj = x[_colData[nb]];
+            s0 += a*xj[0];
+            s1 += a*xj[1];
+            s2 += a*xj[2];
+        }
+        y[nr][0] = s0;
+        y[nr][1] = s1;
+        y[nr][2] = s2;
+    }
+  }
+
+  void computeResidual(const int nRows, const Array<VectorT3>& xA,
+                       const Array<VectorT3>& bA, Array<VectorT3>& rA) const
+  {
+    const VectorT3 *x = &xA[0];
+    const VectorT3 *b = &bA[0];
+    VectorT3 *r = &rA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        const DiagBlock& d = _diagData[nr];
+        double s0 = b[nr][0] + d[0]*x[nr][0];
+        double s1 = b[nr][1] + d[1]*x[nr][1];
+        double s2 = b[nr][2] + d[2]*x[nr][2];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+        {
+            const double a = _offDiagData[nb];
+            const VectorT3& xj = x[_colData[nb]];
+            s0 += a*xj[0];
+            s1 += a*xj[1];
+            s2 += a*xj[2];
+        }
+        r[nr][0] = s0;
+        r[nr][1] = s1;
+        r[nr][2] = s2;
+    }
+  }
+
+  void GS(const int nBegin, const int nEnd, const int step,
+          Array<VectorT3>& xA, const Array<VectorT3>& bA) const
+  {
+    VectorT3 *x = &xA[0];
+    const VectorT3 *b = &bA[0];
+    for(int nr=nBegin; nr!=nEnd; nr+=step)
+      relax(nr,x,b);
+  }
+
+  void relaxRow(const int nr, Array<VectorT3>& x, const Array<VectorT3>& b) const
+  {
+    relax(nr,&x[0],&b[0]);
+  }
+
+  void relaxRowL1(const int nr, const int nBegin, const int nEnd, const int nRows,
+                  Array<VectorT3>& x, const Array<VectorT3>& xOld,
+                  const Array<VectorT3>& b) const
+  {
+    double s0 = b[nr][0];
+    double s1 = b[nr][1];
+    double s2 = b[nr][2];
+    double l1 = 0;
+    const int nbEnd = _rowData[nr+1];
+    for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+    {
+        const int j = _colData[nb];
+        const double a = _offDiagData[nb];
+        const bool inBlock = (j >= nBegin && j < nEnd);
+        const VectorT3& xj = inBlock ? x[j] : xOld[j];
+        s0 += a*xj[0];
+        s1 += a*xj[1];
+        s2 += a*xj[2];
+        if (!inBlock && j < nRows)
+          l1 += fabs(a);
+    }
+
+    const DiagBlock& d = _diagData[nr];
+    if (l1 == 0)
+    {
+        x[nr][0] = -s0/d[0];
+        x[nr][1] = -s1/d[1];
+        x[nr][2] = -s2/d[2];
+        return;
+    }
+    
+    const VectorT3& xr = xOld[nr];
+    x[nr][0] = xr[0] - (s0 + d[0]*xr[0])/(d[0] < 0 ? d[0]-l1 : d[0]+l1);
+    x[nr][1] = xr[1] - (s1 + d[1]*xr[1])/(d[1] < 0 ? d[1]-l1 : d[1]+l1);
+    x[nr][2] = xr[2] - (s2 + d[2]*xr[2])/(d[2] < 0 ? d[2]-l1 : d[2]+l1);
+  }
+
+  void Jacobi(const int nRows, Array<VectorT3>& xnewA,
+              const Array<VectorT3>& xoldA, const Array<VectorT3>& bA) const
+  {
+    VectorT3 *xnew = &xnewA[0];
+    const VectorT3 *xold = &xoldA[0];
+    const VectorT3 *b = &bA[0];
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
+    for(int nr=0; nr<nRows; nr++)
+    {
+        double s0 = b[nr][0];
+        double s1 = b[nr][1];
+        double s2 = b[nr][2];
+        const int nbEnd = _rowData[nr+1];
+        for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+        {
+            const double a = _offDiagData[nb];
+            const VectorT3& xj = xold[_colData[nb]];
+            s0 += a*xj[0];
+            s1 += a*xj[1];
+            s2 += a*xj[2];
+        }
+        const DiagBlock& d = _diagData[nr];
+        xnew[nr][0] = -s0/d[0];
+        xnew[nr][1] = -s1/d[1];
+        xnew[nr][2] = -s2/d[2];
+    }
+  }
+
+private:
+  void relax(const int nr, VectorT3 *x, const VectorT3 *b) const
+  {
+    double s0 = b[nr][0];
+    double s1 = b[nr][1];
+    double s2 = b[nr][2];
+    const int nbEnd = _rowData[nr+1];
+    for (int nb = _rowData[nr]; nb<nbEnd; nb++)
+    {
+        const double a = _offDiagData[nb];
+        const VectorT3& xj = x[_colData[nb]];
+        s0 += a*xj[0];
+        s1 += a*xj[1];
+        s2 += a*xj[2];
+    }
+    const DiagBlock& d = _diagData[nr];
+    x[nr][0] = -s0/d[0];
+    x[nr][1] = -s1/d[1];
+    x[nr][2] = -s2/d[2];
+  }
+
+  const int *_rowData;
+  const int *_colData;
+  const DiagBlock *_diagData;
+  const double *_offDiagData;
+};
+
+#endif
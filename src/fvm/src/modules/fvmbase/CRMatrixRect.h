@@ -289,15 +289,30 @@ public:
                      const CRConnectivity& coarseToFine,
                      const CRConnectivity& coarseConnectivity)
   {
-    const Array<int>&  coarseIndex =
-      dynamic_cast<const Array<int>& >(gCoarseIndex);
-    
-    const int nCoarseRows = coarseConnectivity.getRowDim();
-
     shared_ptr<CRMatrixRect> coarseMatrix(new CRMatrixRect(coarseConnectivity));
+    updateCoarseMatrix(gCoarseIndex,coarseToFine,*coarseMatrix);
+    return coarseMatrix;
+  }
 
-    Array<Diag>& coarseDiag = coarseMatrix->getDiag();
-    Array<OffDiag>& coarseOffDiag = coarseMatrix->getOffDiag();
+  /**
+   * recompute the coefficients of a coarse matrix previously created
+   * by createCoarseMatrix from the current values of this matrix,
+   * keeping the coarsening and the coarse connectivity.
+   * 
+   */
+
+  virtual void
+  updateCoarseMatrix(const IContainer& gCoarseIndex,
+                     const CRConnectivity& coarseToFine,
+                     Matrix& gCoarseMatrix)
+  {
+    const Array<int>&  coarseIndex = dynamic_cast<const Array<int>& >(gCoarseIndex);
+    CRMatrixRect& coarseMatrix = dynamic_cast<CRMatrixRect&>(gCoarseMatrix);
+    const CRConnectivity& coarseConnectivity = coarseMatrix.getConnectivity();
+    const int nCoarseRows = coarseConnectivity.getRowDim();
+
+    Array<Diag>& coarseDiag = coarseMatrix.getDiag();
+    Array<OffDiag>& coarseOffDiag = coarseMatrix.getOffDiag();
 
     const Array<int>& coarseConnRow = coarseConnectivity.getRow();
     const Array<int>& coarseConnCol = coarseConnectivity.getCol();
@@ -343,8 +358,6 @@ public:
             }
         }
     }
-
-    return coarseMatrix;
   }
   
   PairWiseAssembler& getPairWiseAssembler(const CRConnectivity& pairs)
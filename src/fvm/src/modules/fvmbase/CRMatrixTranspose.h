@@ -117,7 +117,45 @@ public:
     }
   }
 
-  
+  /**
+   * y += this * x and y += transpose(this) * x using only the first
+   * nRows rows of the connectivity. These are used when the matrix
+   * stores the prolongation from a coarse to a fine site in smoothed
+   * aggregation AMG, with nRows the self count of the fine site.
+   *
+   */
+
+  void multiplyAndAdd(IContainer& yB, const IContainer& xB, const int nRows) const
+  {
+    BArray& y = dynamic_cast<BArray&>(yB);
+    const XArray& x = dynamic_cast<const XArray&>(xB);
+
+    for(int nr=0; nr<nRows; nr++)
+    {
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            y[nr] += _coeff[nb]*x[j];
+        }
+    }
+  }
+
+  void multiplyTransposeAndAdd(IContainer& yB, const IContainer& xB,
+                               const int nRows) const
+  {
+    XArray& y = dynamic_cast<XArray&>(yB);
+    const BArray& x = dynamic_cast<const BArray&>(xB);
+
+    for(int nr=0; nr<nRows; nr++)
+    {
+        for (int nb = _row[nr]; nb<_row[nr+1]; nb++)
+        {
+            const int j = _col[nb];
+            y[j] += _coeff[nb]*x[nr];
+        }
+    }
+  }
+
   const CRConnectivity& getConnectivity() const {return _conn;}
 
   Array<Coeff>& getCoeff() {return _coeff;}
@@ -84,14 +84,24 @@ public:
     const IntArray& ibType = dynamic_cast<const IntArray&>(_geomFields.ibType[cells]);
     
     const int nFaces = faces.getCount();
+
+    // faces of one colour share no cells and can be done concurrently
+    const CRConnectivity* faceColors = getFaceColors(mesh,faces);
+    const int nColors = faceColors ? faceColors->getRowDim() : 1;
+
     if (_geomFields.gridFlux.hasArray(faces))
     {
         shared_ptr<TArray> gridFluxPtr(new TArray(nFaces));
 	TArray& gridFlux = *gridFluxPtr;
         gridFlux = dynamic_cast<const TArray&>(_geomFields.gridFlux[faces]);
 
-	for(int f=0; f<nFaces; f++)
+	for(int nc=0; nc<nColors; nc++)
 	{
+	const int nColorFaces = faceColors ? faceColors->getCount(nc) : nFaces;
+#pragma omp parallel for if (faceColors)
+	for(int nf=0; nf<nColorFaces; nf++)
+	{
+	    const int f = faceColors ? (*faceColors)(nc,nf) : nf;
             const int c0 = faceCells(f,0);
 	    const int c1 = faceCells(f,1);
 	    const T_Scalar faceCFlux = convectingFlux[f] - gridFlux[f];
@@ -113,12 +123,18 @@ public:
 	    rCell[c0] -= varFlux;
 	    rCell[c1] += varFlux;
 	}
+	}
     }
     else
     {
       if (_useCentralDifference){
-	for(int f=0; f<nFaces; f++)
+	for(int nc=0; nc<nColors; nc++)
+	{
+	const int nColorFaces = faceColors ? faceColors->getCount(nc) : nFaces;
+#pragma omp parallel for if (faceColors)
+	for(int nf=0; nf<nColorFaces; nf++)
           {
+              const int f = faceColors ? (*faceColors)(nc,nf) : nf;
               const int c0 = faceCells(f,0);
               const int c1 = faceCells(f,1);
               const T_Scalar faceCFlux = convectingFlux[f];
@@ -161,10 +177,16 @@ public:
                   }
               }
           }
+	}
        }
        else
-          for(int f=0; f<nFaces; f++)
+          for(int nc=0; nc<nColors; nc++)
           {
+          const int nColorFaces = faceColors ? faceColors->getCount(nc) : nFaces;
+#pragma omp parallel for if (faceColors)
+          for(int nf=0; nf<nColorFaces; nf++)
+          {
+              const int f = faceColors ? (*faceColors)(nc,nf) : nf;
               const int c0 = faceCells(f,0);
               const int c1 = faceCells(f,1);
               const T_Scalar faceCFlux = convectingFlux[f];
@@ -189,9 +211,11 @@ public:
               //cout << "convflux" << varFlux << endl;
 
           }
+          }
     }
 
     const int nCells = cells.getSelfCount();
+#pragma omp parallel for if (_threadedAssembly)
     for(int c=0;c<nCells;c++)
     {
         const T_Scalar cImb = continuityResidual[c];
@@ -123,8 +123,20 @@ public:
     const int nCoarseRows = coarseToFine.getRowDim();
 
     shared_ptr<DiagonalMatrix> coarseMatrix(new DiagonalMatrix(nCoarseRows));
+    updateCoarseMatrix(gCoarseIndex,coarseToFine,*coarseMatrix);
+    return coarseMatrix;
+  }
 
-    Array<Diag>& coarseDiag = coarseMatrix->_diag;
+  virtual void
+  updateCoarseMatrix(const IContainer& gCoarseIndex,
+                     const CRConnectivity& coarseToFine,
+                     Matrix& gCoarseMatrix)
+  {
+    const int nCoarseRows = coarseToFine.getRowDim();
+
+    DiagonalMatrix& coarseMatrix = dynamic_cast<DiagonalMatrix&>(gCoarseMatrix);
+
+    Array<Diag>& coarseDiag = coarseMatrix._diag;
     coarseDiag.zero();
 
     for(int nrCoarse=0; nrCoarse<nCoarseRows; nrCoarse++)
@@ -139,8 +151,6 @@ public:
             
         }
     }
-
-    return coarseMatrix;
   }
 
   virtual void initAssembly()
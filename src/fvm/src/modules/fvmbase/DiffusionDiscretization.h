@@ -109,8 +109,15 @@ public:
 	    
 	    //cout << "doing dielectric interface " << endl;
 
-	    for(int f=0; f<nFaces; f++)
+	    const CRConnectivity* faceColors = getFaceColors(mesh,faces);
+	    const int nColors = faceColors ? faceColors->getRowDim() : 1;
+	    for(int nc=0; nc<nColors; nc++)
+	    {
+	    const int nColorFaces = faceColors ? faceColors->getCount(nc) : nFaces;
+#pragma omp parallel for if (faceColors)
+	    for(int nf=0; nf<nColorFaces; nf++)
 	      {
+		const int f = faceColors ? (*faceColors)(nc,nf) : nf;
 		const int c0 = faceCells(f,0);
 		const int c1 = faceCells(f,1);
 
@@ -148,6 +155,7 @@ public:
 		cout << "diffCoeff  " << diffCoeff << endl;
 		*/
 	      }
+	    }
 	  }
 
 	else
@@ -162,8 +170,15 @@ public:
 	    const VectorT3Array& faceCentroid =
 	      dynamic_cast<const VectorT3Array&>(_geomFields.coordinate[faces]);
 	    CCAssembler& assembler = matrix.getPairWiseAssembler(faceCells);
-	    for(int f=0; f<nFaces; f++)
+	    const CRConnectivity* faceColors = getFaceColors(mesh,faces);
+	    const int nColors = faceColors ? faceColors->getRowDim() : 1;
+	    for(int nc=0; nc<nColors; nc++)
+	    {
+	    const int nColorFaces = faceColors ? faceColors->getCount(nc) : nFaces;
+#pragma omp parallel for if (faceColors)
+	    for(int nf=0; nf<nColorFaces; nf++)
 	      {
+		const int f = faceColors ? (*faceColors)(nc,nf) : nf;
 		const int c0 = faceCells(f,0);
 		const int c1 = faceCells(f,1);
 
@@ -226,6 +241,7 @@ public:
 */
 	
 	      }
+	    }
 
 	  }
       }
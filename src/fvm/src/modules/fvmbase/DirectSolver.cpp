@@ -4,27 +4,90 @@
 
 
 #include <umfpack.h>
+#include <string.h>
 
 #include "DirectSolver.h"
 #include "CRMatrix.h"
 
-DirectSolver::DirectSolver()
+typedef CRMatrix<double,double,double>  FlatMatrix;
+
+DirectSolver::DirectSolver() :
+  reuseFactorization(false),
+  _blockSize(0),
+  _symbolic(0),
+  _numeric(0)
 {}
 
 DirectSolver::~DirectSolver()
-{}
+{
+  freeFactorization();
+}
 
+// the factorization is kept across solves, see reset() for discarding it
 void
 DirectSolver::cleanup()
 {}
 
+void
+DirectSolver::reset()
+{
+  freeFactorization();
+  _factoredCoeffs.reset();
+  _flatMatrix.reset();
+  _flatPositions.reset();
+  _flatConn.reset();
+  _origRow.reset();
+  _origCol.reset();
+  _blockSize = 0;
+}
 
-MFRPtr
-DirectSolver::solve(LinearSystem & ls)
+void
+DirectSolver::freeFactorization()
+{
+  if (_numeric)
+    umfpack_di_free_numeric(&_numeric);
+  if (_symbolic)
+    umfpack_di_free_symbolic(&_symbolic);
+  _numeric = 0;
+  _symbolic = 0;
+}
+
+bool
+DirectSolver::isSamePattern(const CRConnectivity& origConn,
+                            const int blockSize) const
+{
+  if (!_flatConn || blockSize != _blockSize)
+    return false;
+
+  const Array<int>& row = origConn.getRow();
+  const Array<int>& col = origConn.getCol();
+
+  return (row.getDataSize() == _origRow->getDataSize() &&
+          col.getDataSize() == _origCol->getDataSize() &&
+          memcmp(row.getData(),_origRow->getData(),row.getDataSize()) == 0 &&
+          memcmp(col.getData(),_origCol->getData(),col.getDataSize()) == 0);
+}
+
+void
+DirectSolver::setupPattern(const CRConnectivity& origConn, const int blockSize)
 {
+  reset();
+
+  _blockSize = blockSize;
+
+  // keep our own copies of the pattern since the connectivity object
+  // may be replaced by another one at the same address
+  _origRow = dynamic_pointer_cast<Array<int> >(origConn.getRow().newCopy());
+  _origCol = dynamic_pointer_cast<Array<int> >(origConn.getCol().newCopy());
+
+  _flatConn = origConn.getMultiTranspose(blockSize);
+  _flatPositions = origConn.getMultiTransposePositions(*_flatConn,blockSize);
+  _flatMatrix = shared_ptr<Matrix>(new FlatMatrix(*_flatConn));
+}
 
-  typedef CRMatrix<double,double,double>  FlatMatrix;
-  
+void
+DirectSolver::directSolve(LinearSystem & ls)
+{
   const MultiFieldMatrix& mfMatrix = ls.getMatrix();
   const MultiField& bField = ls.getB();
   MultiField& deltaField = ls.getDelta();
@@ -38,68 +101,111 @@ DirectSolver::solve(LinearSystem & ls)
   const CRConnectivity& origConn = origMatrix.getConnectivity();
 
   const ArrayBase& origB = bField[rowIndex];
-  const int blockSize = origB.getDataSize()/(sizeof(double)*origB.getLength());
-
-  shared_ptr<CRConnectivity> flatConnPtr = origConn.getMultiTranspose(blockSize);
+  // nothing to do on processes that don't hold any part of a gathered
+  // coarse level
+  if (origB.getLength() == 0)
+    return;
 
-  FlatMatrix flatMatrix(*flatConnPtr);
+  const int blockSize = origB.getDataSize()/(sizeof(double)*origB.getLength());
 
-  origMatrix.setFlatMatrix(flatMatrix);
+  if (!isSamePattern(origConn,blockSize))
+    setupPattern(origConn,blockSize);
 
+  FlatMatrix& flatMatrix = dynamic_cast<FlatMatrix&>(*_flatMatrix);
   Array<double>& flatCoeffs = flatMatrix.getOffDiag();
-  const Array<int>& flatRow = flatConnPtr->getRow();
-  const Array<int>& flatCol = flatConnPtr->getCol();
+
+  if (!(_numeric && reuseFactorization))
+  {
+      origMatrix.setFlatMatrix(flatMatrix,*_flatPositions);
+
+      if (_numeric &&
+          memcmp(flatCoeffs.getData(),_factoredCoeffs->getData(),
+                 flatCoeffs.getDataSize()) != 0)
+      {
+          umfpack_di_free_numeric(&_numeric);
+          _numeric = 0;
+      }
+  }
+
+  const Array<int>& flatRow = _flatConn->getRow();
+  const Array<int>& flatCol = _flatConn->getCol();
   const ArrayBase& flatB = origB;
-  
-  ArrayBase& flatDelta = deltaField[rowIndex];
-  
-  const int nFlatEqs = flatConnPtr->getRowDim();
-    
-  // original system is in delta form
 
-  mfMatrix.computeResidual(deltaField,bField,ls.getResidual());
+  ArrayBase& flatDelta = deltaField[rowIndex];
 
-  MFRPtr rNorm0(ls.getResidual().getOneNorm());
+  const int nFlatEqs = _flatConn->getRowDim();
 
-  if (verbosity >0)
-    cout << 0 << ": " << *rNorm0 << endl;
-  
-  
   double *null = (double *) NULL ;
-  
-  void *Symbolic, *Numeric ;
-  (void) umfpack_di_symbolic (nFlatEqs, nFlatEqs,
-                              (int*)flatRow.getData(),
-                              (int*)flatCol.getData(),
-                              (double*) flatCoeffs.getData(),
-                              &Symbolic, null, null) ;
-  (void) umfpack_di_numeric ( (int*)flatRow.getData(),
-                              (int*)flatCol.getData(),
-                              (double*) flatCoeffs.getData(),
-                              
-                              Symbolic, &Numeric, null, null) ;
-  umfpack_di_free_symbolic (&Symbolic) ;
+
+  if (!_symbolic)
+  {
+      const int status =
+        umfpack_di_symbolic (nFlatEqs, nFlatEqs,
+                             (int*)flatRow.getData(),
+                             (int*)flatCol.getData(),
+                             (double*) flatCoeffs.getData(),
+                             &_symbolic, null, null) ;
+      if (status < 0)
+      {
+          _symbolic = 0;
+          throw CException("umfpack symbolic analysis failed");
+      }
+  }
+
+  if (!_numeric)
+  {
+      const int status =
+        umfpack_di_numeric ( (int*)flatRow.getData(),
+                             (int*)flatCol.getData(),
+                             (double*) flatCoeffs.getData(),
+                             _symbolic, &_numeric, null, null) ;
+      if (status < 0)
+      {
+          _numeric = 0;
+          throw CException("umfpack numeric factorization failed");
+      }
+      _factoredCoeffs = dynamic_pointer_cast<Array<double> >(flatCoeffs.newCopy());
+  }
+
   (void) umfpack_di_solve (UMFPACK_A,
                            (int*)flatRow.getData(),
                            (int*)flatCol.getData(),
                            (double*) flatCoeffs.getData(),
                            (double*) flatDelta.getData(),
                            (double*) flatB.getData(),
-                           Numeric, null, null) ;
-   umfpack_di_free_numeric (&Numeric) ;
-
-   // umfpack solves ax=b, we want ax+b=0;
-   double *flatDeltaData = (double*) flatDelta.getData();
-   for(int n=0; n<nFlatEqs; n++)
-     flatDeltaData[n] *= -1.0;
-   
+                           _numeric, null, null) ;
+
+  // umfpack solves ax=b, we want ax+b=0;
+  double *flatDeltaData = (double*) flatDelta.getData();
+  for(int n=0; n<nFlatEqs; n++)
+    flatDeltaData[n] *= -1.0;
+}
+
+MFRPtr
+DirectSolver::solve(LinearSystem & ls)
+{
+  const MultiFieldMatrix& mfMatrix = ls.getMatrix();
+  const MultiField& bField = ls.getB();
+  MultiField& deltaField = ls.getDelta();
+
+  // original system is in delta form
+
+  mfMatrix.computeResidual(deltaField,bField,ls.getResidual());
+
+  MFRPtr rNorm0(ls.getResidual().getOneNorm());
+
+  if (verbosity >0)
+    cout << 0 << ": " << *rNorm0 << endl;
+
+  directSolve(ls);
+
   mfMatrix.computeResidual(deltaField,bField,ls.getResidual());
 
   MFRPtr rNormN(ls.getResidual().getOneNorm());
 
   if (verbosity >0)
     cout <<  "Final : " << *rNormN << endl;
-  
+
 
   return rNorm0;
 }
@@ -107,5 +213,5 @@ DirectSolver::solve(LinearSystem & ls)
 void
 DirectSolver::smooth(LinearSystem& ls)
 {
-  throw CException("cannot use DirectSolver as preconditioner");
+  directSolve(ls);
 }
@@ -16,27 +16,55 @@ using namespace std;
 
 /**
  * Solve a linear system using UMFPack
- * 
+ *
+ * The flattened sparsity pattern, the positions of the coefficients
+ * in it and the symbolic analysis are kept across solves and only
+ * recomputed when the connectivity of the matrix changes. The numeric
+ * factorization is reused when the flattened coefficients are the
+ * same as the ones last factored, or without checking them at all if
+ * reuseFactorization is set (for systems whose matrix is known to
+ * stay the same, e.g. linear problems with constant properties).
+ *
+ * smooth() does the same direct solve so that this can be used for
+ * the coarsest level of AMG.
  */
 
 class DirectSolver : public LinearSolver
 {
 public:
 
-  
+
   DirectSolver();
   virtual ~DirectSolver();
 
   virtual void cleanup();
-  
+
   virtual MFRPtr solve(LinearSystem & ls);
   virtual void smooth(LinearSystem & ls);
 
+  // discards all the cached data, including the factorization
+  void reset();
+
+  bool reuseFactorization;
 
 private:
 
   DirectSolver(const DirectSolver&);
 
+  void directSolve(LinearSystem& ls);
+  void setupPattern(const CRConnectivity& origConn, const int blockSize);
+  bool isSamePattern(const CRConnectivity& origConn, const int blockSize) const;
+  void freeFactorization();
+
+  int _blockSize;
+  shared_ptr<Array<int> > _origRow;
+  shared_ptr<Array<int> > _origCol;
+  shared_ptr<CRConnectivity> _flatConn;
+  shared_ptr<Array<int> > _flatPositions;
+  shared_ptr<Matrix> _flatMatrix;
+  shared_ptr<Array<double> > _factoredCoeffs;
+  void *_symbolic;
+  void *_numeric;
 };
 
 #endif
@@ -3,5 +3,8 @@ class DirectSolver : public LinearSolver
 public:
 
   DirectSolver();
+  void reset();
+
+  bool reuseFactorization;
 };
 
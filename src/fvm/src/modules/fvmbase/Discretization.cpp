@@ -4,11 +4,21 @@
 
 
 #include "Discretization.h"
+#include "CRConnectivity.h"
 
 Discretization::Discretization(const MeshList& meshes):
-  _meshes(meshes)
+  _meshes(meshes),
+  _threadedAssembly(false)
  {}
 
 
 Discretization::~Discretization()
 {}
+
+const CRConnectivity*
+Discretization::getFaceColors(const Mesh& mesh, const StorageSite& faces) const
+{
+  if (_threadedAssembly)
+    return &mesh.getFaceColors(faces);
+  return 0;
+}
@@ -11,6 +11,7 @@
 class MultiFieldMatrix;
 class MultiField;
 class Model;
+class CRConnectivity;
 
 class Discretization
 {
@@ -23,9 +24,24 @@ public:
   virtual void discretize(const Mesh& mesh, MultiFieldMatrix& matrix,
                           MultiField& x, MultiField& r) = 0;
 
+  // when set, discretizations that support it run their face loops
+  // one colour at a time with the faces of each colour shared among
+  // threads (see Mesh::getFaceColors)
+  void setThreadedAssembly(const bool threadedAssembly)
+  {_threadedAssembly = threadedAssembly;}
+
+  bool isThreadedAssembly() const {return _threadedAssembly;}
+  
   DEFINE_TYPENAME("Discretization");
 protected:
+
+  // returns the face colouring to use for the loop over the given
+  // faces or null if the faces are to be visited serially in order
+  const CRConnectivity* getFaceColors(const Mesh& mesh,
+                                      const StorageSite& faces) const;
+  
   const MeshList& _meshes;
+  bool _threadedAssembly;
 };
 
 typedef vector<shared_ptr<Discretization> > DiscrList;
@@ -112,8 +112,13 @@ struct ElectricModelOptions : public FloatVarDict<T>
     this->diffusion_enable = false;
     this->trapbandtunneling_enable = false;
     this->printNormalizedResiduals = true;
+    this->persistentLinearSystem = false;
   }
   bool printNormalizedResiduals;
+  // keeps the linear systems across iterations; unlike the thermal,
+  // species and flow models the discretizations are still created on
+  // every iteration, since they copy many of the options and constants
+  bool persistentLinearSystem;
 
   double electrostaticsTolerance;
   double chargetransportTolerance;
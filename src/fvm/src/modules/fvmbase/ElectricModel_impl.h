@@ -307,6 +307,8 @@ public:
     _initialElectroStaticsNorm = MFRPtr();
     if (_options.chargetransport_enable)
       _initialChargeTransportNorm = MFRPtr();
+    _electroStaticsLinearSystem = shared_ptr<LinearSystem>();
+    _chargeTransportLinearSystem = shared_ptr<LinearSystem>();
   }
   
 
@@ -376,9 +378,15 @@ public:
 
   MFRPtr solveElectroStatics()
   {
-    LinearSystem ls;
-        
-    initElectroStaticsLinearization(ls);
+    shared_ptr<LinearSystem> lsPtr(_electroStaticsLinearSystem);
+    if (!lsPtr || !_options.persistentLinearSystem)
+    {
+        lsPtr = shared_ptr<LinearSystem>(new LinearSystem());
+        initElectroStaticsLinearization(*lsPtr);
+        if (_options.persistentLinearSystem)
+          _electroStaticsLinearSystem = lsPtr;
+    }
+    LinearSystem& ls = *lsPtr;
     
     ls.initAssembly();
    
@@ -411,9 +419,15 @@ public:
 
   MFRPtr solveChargeTransport()
   {
-    LinearSystem ls;
-        
-    initChargeTransportLinearization(ls);
+    shared_ptr<LinearSystem> lsPtr(_chargeTransportLinearSystem);
+    if (!lsPtr || !_options.persistentLinearSystem)
+    {
+        lsPtr = shared_ptr<LinearSystem>(new LinearSystem());
+        initChargeTransportLinearization(*lsPtr);
+        if (_options.persistentLinearSystem)
+          _chargeTransportLinearSystem = lsPtr;
+    }
+    LinearSystem& ls = *lsPtr;
 
     ls.initAssembly();
 
@@ -1481,6 +1495,9 @@ private:
   MFRPtr _initialElectroStaticsNorm;
   MFRPtr _initialChargeTransportNorm;
   int _niters;
+
+  shared_ptr<LinearSystem> _electroStaticsLinearSystem;
+  shared_ptr<LinearSystem> _chargeTransportLinearSystem;
   T _avgCharge;
   T _tunnelCurrentIn;
   T _tunnelCurrentOut;
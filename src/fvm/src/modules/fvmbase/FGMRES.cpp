@@ -0,0 +1,230 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifdef  FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+
+#include "FGMRES.h"
+
+namespace
+{
+  // two norm of x as a global reduction
+  MFRPtr twoNorm(const MultiField& x)
+  {
+    MFRPtr xx = x.dotWith(x);
+    xx->reduceSum();
+    return xx->sqrt();
+  }
+
+  // (a,b) <- (c*a + s*b, -s*a + c*b)
+  void applyRotation(MultiFieldReduction& c, MultiFieldReduction& s,
+                     MFRPtr& a, MFRPtr& b)
+  {
+    MFRPtr aNew = c*(*a);
+    *aNew += *(s*(*b));
+    MFRPtr bNew = c*(*b);
+    *bNew += *(-*(s*(*a)));
+    a = aNew;
+    b = bNew;
+  }
+
+  // the rotation that zeros b when applied to (a,b)
+  void createRotation(const MFRPtr& a, const MFRPtr& b,
+                      MFRPtr& c, MFRPtr& s)
+  {
+    MFRPtr r2 = (*a)*(*a);
+    *r2 += *((*b)*(*b));
+    MFRPtr r = r2->sqrt();
+    c = (*a)/(*r);
+    s = (*b)/(*r);
+  }
+}
+
+FGMRES::FGMRES() :
+  preconditioner(0),
+  restartLength(30),
+  _totalIterations(0)
+{}
+
+FGMRES::~FGMRES()
+{
+}
+
+void
+FGMRES::cleanup()
+{
+  preconditioner->cleanup();
+}
+
+MFRPtr
+FGMRES::solve(LinearSystem & ls)
+{
+  const MultiFieldMatrix& matrix = ls.getMatrix();
+
+  // original system is in delta form
+  shared_ptr<MultiField> x(ls.getDeltaPtr());
+  shared_ptr<MultiField> bOrig(ls.getBPtr());
+
+  matrix.computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+
+  MFRPtr rNorm0(ls.getResidual().getOneNorm());
+
+#ifndef  FVM_PARALLEL
+  if (verbosity >0)
+    cout << 0 << ": " << *rNorm0 << endl;
+#endif
+
+#ifdef  FVM_PARALLEL
+  if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+    cout << 0 << ": " << *rNorm0 << endl;
+#endif
+
+  if (*rNorm0 < absoluteTolerance)
+    return rNorm0;
+
+  const int m = restartLength;
+
+  /**
+   * since the residual is b + A x, the Arnoldi process is done with A
+   * directly and the correction is obtained by subtracting Z*y, where
+   * y solves the least squares problem for r = |r| v_0
+   *
+   */
+
+  vector<shared_ptr<MultiField> > v(m+1);
+  vector<shared_ptr<MultiField> > z(m);
+  vector<vector<MFRPtr> > h(m+1,vector<MFRPtr>(m));
+  vector<MFRPtr> c(m), s(m), g(m+1);
+
+  shared_ptr<MultiField> r(dynamic_pointer_cast<MultiField>(ls.getResidual().newCopy()));
+  MFRPtr rTwoNorm0;
+
+  int nIterations = 0;
+  bool converged = false;
+  while(!converged && nIterations < nMaxIterations)
+  {
+      MFRPtr beta = twoNorm(*r);
+      if (!rTwoNorm0)
+        rTwoNorm0 = beta;
+
+      v[0] = r;
+      *v[0] /= *beta;
+      g[0] = beta;
+
+      int k = 0;
+      while(k < m && nIterations < nMaxIterations)
+      {
+          nIterations++;
+          _totalIterations++;
+
+          if (!z[k])
+            z[k] = dynamic_pointer_cast<MultiField>(x->newClone());
+          z[k]->zero();
+          ls.replaceDelta(z[k]);
+          ls.replaceB(v[k]);
+
+          preconditioner->smooth(ls);
+
+          shared_ptr<MultiField> w(dynamic_pointer_cast<MultiField>(x->newClone()));
+          matrix.multiply(*w,*z[k]);
+
+          // modified Gram-Schmidt
+          for(int i=0; i<=k; i++)
+          {
+              h[i][k] = w->dotWith(*v[i]);
+              h[i][k]->reduceSum();
+              w->msaxpy(*h[i][k],*v[i]);
+          }
+          h[k+1][k] = twoNorm(*w);
+          v[k+1] = w;
+          *v[k+1] /= *h[k+1][k];
+
+          for(int i=0; i<k; i++)
+            applyRotation(*c[i],*s[i],h[i][k],h[i+1][k]);
+
+          createRotation(h[k][k],h[k+1][k],c[k],s[k]);
+          applyRotation(*c[k],*s[k],h[k][k],h[k+1][k]);
+          g[k+1] = -*((*s[k])*(*g[k]));
+          g[k] = (*c[k])*(*g[k]);
+
+          k++;
+
+          MFRPtr rNorm = ((*g[k])*(*g[k]))->sqrt();
+          MFRPtr normRatio(rNorm->normalize(*rTwoNorm0));
+
+#ifndef FVM_PARALLEL
+          if (verbosity >0)
+            cout << nIterations << ": " << *rNorm << endl;
+#endif
+
+#ifdef  FVM_PARALLEL
+          if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+            cout << nIterations << ": " << *rNorm << endl;
+#endif
+
+          if (*rNorm < absoluteTolerance || *normRatio < relativeTolerance)
+          {
+              converged = true;
+              break;
+          }
+      }
+
+      // back substitution for the upper triangular system H y = g
+      vector<MFRPtr> y(k);
+      for(int i=k-1; i>=0; i--)
+      {
+          MFRPtr sum = g[i];
+          for(int j=i+1; j<k; j++)
+            *sum += *(-*((*h[i][j])*(*y[j])));
+          y[i] = (*sum)/(*h[i][i]);
+      }
+
+      for(int i=0; i<k; i++)
+        x->msaxpy(*y[i],*z[i]);
+
+#ifdef FVM_PARALLEL
+      x->sync();
+#endif
+
+      ls.replaceDelta(x);
+      ls.replaceB(bOrig);
+
+      // the residual for the next restart, always recomputed to avoid
+      // drift in the estimate
+      r = dynamic_pointer_cast<MultiField>(x->newClone());
+      matrix.computeResidual(*x,*bOrig,*r);
+
+      if (!converged)
+      {
+          MFRPtr rNorm = r->getOneNorm();
+          MFRPtr normRatio(rNorm->normalize(*rNorm0));
+          if (*rNorm < absoluteTolerance || *normRatio < relativeTolerance)
+            converged = true;
+      }
+  }
+
+  matrix.computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+  MFRPtr rNormn(ls.getResidual().getOneNorm());
+
+#ifndef FVM_PARALLEL
+  if (verbosity >0)
+    cout << "n" << ": " << *rNormn << endl;
+#endif
+
+
+#ifdef  FVM_PARALLEL
+  if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+    cout << "n" << ": " << *rNormn << endl;
+#endif
+
+  return rNorm0;
+}
+
+void
+FGMRES::smooth(LinearSystem& ls)
+{
+  throw CException("cannot use FGMRES as preconditioner");
+}
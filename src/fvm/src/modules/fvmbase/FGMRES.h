@@ -0,0 +1,51 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _FGMRES_H_
+#define _FGMRES_H_
+
+#include <vector>
+#include "LinearSystem.h"
+#include "MultiFieldReduction.h"
+#include "LinearSolver.h"
+
+using namespace std;
+
+/**
+ * Solve a linear system using the flexible generalized minimal
+ * residual method, restarted every restartLength iterations. The
+ * preconditioner is applied through its smooth() and may change from
+ * one iteration to the next, so AMG cycles can be used.
+ *
+ * The convergence checks within a restart cycle use the two norm
+ * estimate from the least squares problem; the one norm of the actual
+ * residual is checked at each restart.
+ *
+ */
+
+class FGMRES : public LinearSolver
+{
+public:
+
+  FGMRES();
+  virtual ~FGMRES();
+  virtual MFRPtr solve(LinearSystem & ls);
+
+  virtual void cleanup();
+  virtual void smooth(LinearSystem& ls);
+
+  int getTotalIterations() const { return _totalIterations;}
+
+  DEFINE_TYPENAME("FGMRES");
+
+  LinearSolver *preconditioner;
+  int restartLength;
+private:
+
+  FGMRES(const FGMRES&);
+
+  int _totalIterations;
+};
+
+#endif
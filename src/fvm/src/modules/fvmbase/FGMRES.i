@@ -0,0 +1,10 @@
+class FGMRES : public LinearSolver
+{
+public:
+
+  FGMRES();
+  int getTotalIterations() const;
+  LinearSolver *preconditioner;
+  int restartLength;
+};
+
@@ -22,7 +22,9 @@ using namespace std;
 Field::Field(const string& name):
   IContainer(),
   _name(name),
-  _arrays()
+  _arrays(),
+  _syncInProgress(false),
+  _syncPlanFieldCount(0)
 {
   logCtor();
 }  
@@ -108,6 +110,9 @@ Field::clear()
   _childSitesMap.clear();
   _ghostArrays.clear();
   _ghostArraysLevel1.clear();
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
+  _syncPlanArrays.clear();
 }
 
 ArrayBase& 
@@ -192,689 +197,196 @@ Field::copyFrom(const IContainer& oc)
 
 
 void
-Field::createSyncGatherArrays(const StorageSite& site)
+Field::addToSyncPlan(FieldSyncPlan& plan, GhostArrayMap& ghostArrays,
+                     const StorageSite& site,
+                     const StorageSite::ScatterMap& scatterMap,
+                     const StorageSite::GatherMap& gatherMap,
+                     const ArrayBase& thisArray, const int numDir)
 {
-  ArrayBase& thisArray = operator[](site);
+  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
+  {
+      const StorageSite& oSite = *mpos.first;
+      const Array<int>& fromIndices = *(mpos.second);
+      const int length = fromIndices.getLength()*numDir;
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(&site, &oSite)];
+      if (!ghostArray || ghostArray->getLength() != length)
+        ghostArray = thisArray.newSizedClone(length);
 
-  const StorageSite::GatherMap& gatherMap = site.getGatherMap();
+      plan.addSend(&site, fromIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
+  }
 
   foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
   {
       const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&oSite, &site);
       const Array<int>& toIndices = *(mpos.second);
-      if (_ghostArrays.find(e) == _ghostArrays.end())
-      {
-          _ghostArrays[e] = thisArray.newSizedClone(toIndices.getLength());
-      }	
+      const int length = toIndices.getLength()*numDir;
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(&oSite, &site)];
+      if (!ghostArray || ghostArray->getLength() != length)
+        ghostArray = thisArray.newSizedClone(length);
+
+      plan.addRecv(&site, toIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
   }
 }
 
 void
-Field::createSyncGatherArraysLevel1(const StorageSite& site)
+Field::createSyncPlans(const int numDir)
 {
-  ArrayBase& thisArray = operator[](site);
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
+  _syncPlanArrays.clear();
 
-  const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
+  shared_ptr<FieldSyncPlan> plan(new FieldSyncPlan());
+  shared_ptr<FieldSyncPlan> planLevel1(new FieldSyncPlan());
 
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
+  foreach(ArrayMap::value_type& pos, _arrays)
   {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&oSite, &site);
-      const Array<int>& toIndices = *(mpos.second);
-      if (_ghostArraysLevel1.find(e) == _ghostArraysLevel1.end())
-      {
-          _ghostArraysLevel1[e] = thisArray.newSizedClone(toIndices.getLength());
-      }	
-  }
-}
-
+      const StorageSite& site = *pos.first;
+      const ArrayBase& thisArray = *pos.second;
 
-void
-Field::syncScatter(const StorageSite& site)
-{
-  const ArrayBase& thisArray = operator[](site);
-      	
-  const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-  
-  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&site, &oSite);	
-      const Array<int>& fromIndices = *(mpos.second);
-      if (_ghostArrays.find(e) == _ghostArrays.end()){
-        _ghostArrays[e] = thisArray.newSizedClone( fromIndices.getLength() );
-      }
+      addToSyncPlan(*plan, _ghostArrays, site,
+                    site.getScatterMap(), site.getGatherMap(),
+                    thisArray, numDir);
 
-      ArrayBase& ghostArray = *_ghostArrays[e];	
-      thisArray.scatter(ghostArray,fromIndices);
+      // only arrays that include the second layer of ghosts
+      if (thisArray.getLength() == site.getCountLevel1())
+        addToSyncPlan(*planLevel1, _ghostArraysLevel1, site,
+                      site.getScatterMapLevel1(), site.getGatherMapLevel1(),
+                      thisArray, numDir);
 
+      _syncPlanArrays.push_back(make_pair(&site, thisArray.getLength()));
   }
-}
 
+  _syncPlan = plan;
+  _syncPlanLevel1 = planLevel1;
+  _syncPlanFieldCount = numDir;
+}
 
-void
-Field::syncScatterLevel1(const StorageSite& site)
+bool
+Field::hasCurrentSyncPlans(const int numDir) const
 {
-  const ArrayBase& thisArray = operator[](site);
-      	
-  const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-  
-  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&site, &oSite);	
-      const Array<int>& fromIndices = *(mpos.second);
-      if (_ghostArraysLevel1.find(e) == _ghostArraysLevel1.end()){
-        _ghostArraysLevel1[e] = thisArray.newSizedClone( fromIndices.getLength() );
-      }
-
-      ArrayBase& ghostArray = *_ghostArraysLevel1[e];	
-      thisArray.scatter(ghostArray,fromIndices);
+  if (!_syncPlan || numDir != _syncPlanFieldCount ||
+      _syncPlanArrays.size() != _arrays.size())
+    return false;
 
+  int n=0;
+  foreach(const ArrayMap::value_type& pos, _arrays)
+  {
+      const pair<const StorageSite*, int>& planned = _syncPlanArrays[n++];
+      if (planned.first != pos.first ||
+          planned.second != pos.second->getLength())
+        return false;
   }
+  return true;
 }
 
-
+// the buffers hold the values of all the fields one after the other
 void
-Field::syncGather(const StorageSite& site)
+Field::syncScatter(const FieldSyncPlan& plan, Field* const* fields,
+                   const int numFields)
 {
-  ArrayBase& thisArray = operator[](site);
-      
-  const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-  
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
+  foreach(const FieldSyncPlan::Buffer& b, plan.getSendBuffers())
   {
-      const StorageSite& oSite = *mpos.first;
-      const Array<int>& toIndices = *(mpos.second);
-      EntryIndex e(&oSite, &site);
-
-      if (_ghostArrays.find(e) == _ghostArrays.end())
+      const int chunkSize = b.indices->getLength();
+      for(int dir=0; dir<numFields; dir++)
       {
-         ostringstream e;
-         e << "Field::syncScatter: ghost array not found for"
-           << &oSite << endl;
-         throw CException(e.str());
+          const ArrayBase& thisArray = (*fields[dir])[*b.key];
+          thisArray.scatter(*b.data, *b.indices, chunkSize*dir);
       }
-
-      const ArrayBase& ghostArray = *_ghostArrays[e];
-      thisArray.gather(ghostArray,toIndices);
   }
 }
 
-
 void
-Field::syncGatherLevel1(const StorageSite& site)
+Field::syncGather(const FieldSyncPlan& plan, Field* const* fields,
+                  const int numFields)
 {
-  ArrayBase& thisArray = operator[](site);
-      
-  const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-  
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
+  foreach(const FieldSyncPlan::Buffer& b, plan.getRecvBuffers())
   {
-      const StorageSite& oSite = *mpos.first;
-      const Array<int>& toIndices = *(mpos.second);
-      EntryIndex e(&oSite, &site);
-
-      if (_ghostArraysLevel1.find(e) == _ghostArraysLevel1.end())
+      const int chunkSize = b.indices->getLength();
+      for(int dir=0; dir<numFields; dir++)
       {
-         ostringstream e;
-         e << "Field::syncScatter: ghost array not found for"
-           << &oSite << endl;
-         throw CException(e.str());
+          ArrayBase& thisArray = (*fields[dir])[*b.key];
+          thisArray.gather(*b.data, *b.indices, chunkSize*dir);
       }
-
-      const ArrayBase& ghostArray = *_ghostArraysLevel1[e];
-      thisArray.gather(ghostArray,toIndices);
   }
 }
 
-
 void
 Field::syncLocal()
-{  
-   // scatter first (prepare ship packages)
-   foreach(ArrayMap::value_type& pos, _arrays)
-      syncScatter(*pos.first);
-
-   foreach(ArrayMap::value_type& pos, _arrays)
-      createSyncGatherArrays(*pos.first);
-
-#ifdef FVM_PARALLEL
-   //SENDING
-   MPI::Request   request_send[ get_request_size() ];
-   MPI::Request   request_recv[ get_request_size() ];
-   int indxSend = 0;
-   int indxRecv = 0;
-   foreach(ArrayMap::value_type& pos, _arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&site,&oSite);
-             ArrayBase& sendArray = *_ghostArrays[e];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                     MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-      }
-      //RECIEVING
-      //getting values from other meshes to fill g
-      const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-      foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-         const StorageSite&  oSite = *mpos.first;
-         //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-         EntryIndex e(&oSite,&site);
-         ArrayBase& recvArray = *_ghostArrays[e];
-         int from_where       = oSite.getGatherProcID();
-         if ( from_where != -1 ){
-             int mpi_tag = oSite.getTag();
-             request_recv[indxRecv++] =  
-                    MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-         }
-      }
-   }
-
-   int count  = get_request_size();
-   MPI::Request::Waitall( count, request_recv );
-   MPI::Request::Waitall( count, request_send );
-#endif
-
-  // gather 
-  foreach(ArrayMap::value_type& pos, _arrays)
-    syncGather(*pos.first);
-
-
-   //sycnLocal1
-   syncLocalLevel1();
-
-}
-
-int
-Field::get_request_size()
 {
-   int indx =  0;
-   foreach(ArrayMap::value_type& pos, _arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-          if ( oSite.getGatherProcID() != -1 )
-             indx++;
-      }
-   }
-   return indx;
-
+  startSync();
+  finishSync();
 }
 
-
-
 void
-Field::syncLocalLevel1()
-{  
-
-   // scatter first (prepare ship packages)
-   foreach(ArrayMap::value_type& pos, _arrays){
-      if ( pos.second->getLength() == pos.first->getCountLevel1() )
-         syncScatterLevel1(*pos.first);
-  }
-
-   foreach(ArrayMap::value_type& pos, _arrays){
-      if ( pos.second->getLength() == pos.first->getCountLevel1() )
-         createSyncGatherArraysLevel1(*pos.first);
-   }
-
-#ifdef FVM_PARALLEL
-   //SENDING
-   int countScatter   = get_request_size_scatter_level1();
-   int countGather    = get_request_size_gather_level1();
-   MPI::Request   request_send[ countScatter ];
-   MPI::Request   request_recv[ countGather  ];
-   int indxSend = 0;
-   int indxRecv = 0;
-   foreach(ArrayMap::value_type& pos, _arrays){
-      const StorageSite& site = *pos.first;
-      if ( pos.second->getLength() == pos.first->getCountLevel1() ){
-         const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-         foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-             const StorageSite&  oSite = *mpos.first;
-             //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&site,&oSite);
-             ArrayBase& sendArray = *_ghostArraysLevel1[e];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                     MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-         }
-         //RECIEVING
-         //getting values from other meshes to fill g
-         const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-         foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-            const StorageSite&  oSite = *mpos.first;
-            //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-            EntryIndex e(&oSite,&site);
-            ArrayBase& recvArray = *_ghostArraysLevel1[e];
-            int from_where       = oSite.getGatherProcID();
-            if ( from_where != -1 ){
-               int mpi_tag = oSite.getTag();
-               request_recv[indxRecv++] =  
-                   MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-            }
-         }
-
-      }
-   }
-
-   MPI::Request::Waitall( countGather, request_recv );
-   MPI::Request::Waitall( countScatter, request_send );
-#endif
-
-   // gather 
-   foreach(ArrayMap::value_type& pos, _arrays){
-      if ( pos.second->getLength() == pos.first->getCountLevel1() )
-        syncGatherLevel1(*pos.first);
-   }
-}
-
-int
-Field::get_request_size_scatter_level1()
+Field::startSync()
 {
-   int indx =  0;
-   foreach(ArrayMap::value_type& pos, _arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-      if ( pos.second->getLength() == pos.first->getCountLevel1() ){
-         foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-            const StorageSite&  oSite = *mpos.first;
-            //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-            if ( oSite.getGatherProcID() != -1 )
-               indx++;
-         }
-      }
-    }
-   return indx;
+  if (_syncInProgress)
+    throw CException("Field::startSync: " + _name + " is already being synced");
 
-}
+  if (!hasCurrentSyncPlans(1))
+    createSyncPlans(1);
 
-int
-Field::get_request_size_gather_level1()
-{
-   int indx =  0;
-   foreach(ArrayMap::value_type& pos, _arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-      if ( pos.second->getLength() == pos.first->getCountLevel1() ){
-         foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-            const StorageSite&  oSite = *mpos.first;
-            //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-            if ( oSite.getGatherProcID() != -1 )
-               indx++;
-         }
-      }
-   }
-   return indx;
+  _syncInProgress = true;
 
+  Field* self = this;
+  syncScatter(*_syncPlan, &self, 1);
+  _syncPlan->start();
 }
 
-
-//only for one field need to be communicated
 void
-Field::createSyncGatherArraysVectorFields(const StorageSite& site, Field& field, const size_t numDir)
+Field::finishSync()
 {
-  ArrayBase& thisArray = field[site];
-  GhostArrayMap& ghostArrays = field.getGhostArrayMap();
+  if (!_syncInProgress)
+    throw CException("Field::finishSync: " + _name + " is not being synced");
+  _syncInProgress = false;
 
-  const StorageSite::GatherMap& gatherMap = site.getGatherMap();
+  _syncPlan->finish();
 
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&oSite, &site);
-      const Array<int>& toIndices = *(mpos.second);
-      if (ghostArrays.find(e) == ghostArrays.end())
-      {
-          ghostArrays[e] = thisArray.newSizedClone(toIndices.getLength() * numDir);
-      }	
-  }
-}
-
-void
-Field::createSyncGatherArraysVectorFieldsLevel1(const StorageSite& site, Field& field, const size_t numDir)
-{
-  ArrayBase& thisArray = field[site];
-  GhostArrayMap& ghostArrays = field.getGhostArrayMapLevel1();
+  Field* self = this;
+  syncGather(*_syncPlan, &self, 1);
 
-  const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&oSite, &site);
-      const Array<int>& toIndices = *(mpos.second);
-      if (ghostArrays.find(e) == ghostArrays.end())
-      {
-          ghostArrays[e] = thisArray.newSizedClone(toIndices.getLength() * numDir);
-      }	
-  }
+  syncLocalLevel1();
 }
 
-
 void
-Field::syncScatterVectorFields(const StorageSite& site, std::vector<Field*> & dsf)
+Field::syncLocalLevel1()
 {
-   
-  const size_t numDir = dsf.size();
-  Field& field0 = *dsf[0];
-  ArrayBase& thisArray0 = field0[site];
-  GhostArrayMap& ghostArrays = field0.getGhostArrayMap();
-      
-  const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-  
-  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&site, &oSite);	
-      const Array<int>& fromIndices = *(mpos.second);
-      if (ghostArrays.find(e) == ghostArrays.end()){
-        ghostArrays[e] = thisArray0.newSizedClone( fromIndices.getLength() * numDir );
-      }
-
-      const int chunkSize = fromIndices.getLength();	 
-      ArrayBase& ghostArray = *ghostArrays[e];	
-      for (size_t dir=0; dir < numDir; dir++){
-	Field& field = *dsf[dir];
-	const ArrayBase& thisArray = field[site];
-	const int offset = chunkSize * dir;
-        thisArray.scatter(ghostArray,fromIndices, offset);
-      } 
-  }
+  Field* self = this;
+  syncScatter(*_syncPlanLevel1, &self, 1);
+  _syncPlanLevel1->start();
+  _syncPlanLevel1->finish();
+  syncGather(*_syncPlanLevel1, &self, 1);
 }
 
 void
-Field::syncScatterVectorFieldsLevel1(const StorageSite& site, std::vector<Field*> & dsf)
+Field::syncLocalVectorFields(std::vector<Field*>& dsf)
 {
-   
-  const size_t numDir = dsf.size();
   Field& field0 = *dsf[0];
-  ArrayBase& thisArray0 = field0[site];
-  GhostArrayMap& ghostArrays = field0.getGhostArrayMapLevel1();
-      
-  const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-  
-  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      EntryIndex e(&site, &oSite);	
-      const Array<int>& fromIndices = *(mpos.second);
-      if (ghostArrays.find(e) == ghostArrays.end()){
-        ghostArrays[e] = thisArray0.newSizedClone( fromIndices.getLength() * numDir );
-      }
-
-      const int chunkSize = fromIndices.getLength();	 
-      ArrayBase& ghostArray = *ghostArrays[e];	
-      for (size_t dir=0; dir < numDir; dir++){
-	Field& field = *dsf[dir];
-	const ArrayBase& thisArray = field[site];
-	const int offset = chunkSize * dir;
-        thisArray.scatter(ghostArray,fromIndices, offset);
-      } 
-  }
-}
-
+  const int numDir = int(dsf.size());
 
+  if (!field0.hasCurrentSyncPlans(numDir))
+    field0.createSyncPlans(numDir);
 
-void
-Field::syncGatherVectorFields(const StorageSite& site,  std::vector<Field*>& dsf)
-{
-  
-  const size_t  numDir = dsf.size();
-  Field& field0 = *dsf[0];
-  GhostArrayMap& ghostArrays = field0.getGhostArrayMap();
-     
-  const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-  
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      const Array<int>& toIndices = *(mpos.second);
-      EntryIndex e(&oSite, &site);
-
-      if (ghostArrays.find(e) == ghostArrays.end())
-      {
-         ostringstream e;
-         e << "Field::syncScatter: ghost array not found for"
-           << &oSite << endl;
-         throw CException(e.str());
-      }
+  FieldSyncPlan& plan = *field0._syncPlan;
+  syncScatter(plan, &dsf[0], numDir);
+  plan.start();
+  plan.finish();
+  syncGather(plan, &dsf[0], numDir);
 
-      const ArrayBase& ghostArray = *ghostArrays[e];
-      const int chunkSize = toIndices.getLength();
-      for (size_t dir = 0; dir < numDir; dir++){
-	 Field& field = *dsf[dir];
-	 ArrayBase& thisArray = field[site];
-	 const size_t offset = dir * chunkSize;
-	 thisArray.gather(ghostArray,toIndices, offset);
-     }
-  }
+  syncLocalVectorFieldsLevel1(dsf);
 }
 
 void
-Field::syncGatherVectorFieldsLevel1(const StorageSite& site,  std::vector<Field*>& dsf)
+Field::syncLocalVectorFieldsLevel1(std::vector<Field*>& dsf)
 {
-  
-  const size_t  numDir = dsf.size();
   Field& field0 = *dsf[0];
-  GhostArrayMap& ghostArrays = field0.getGhostArrayMapLevel1();
-     
-  const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-  
-  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-  {
-      const StorageSite& oSite = *mpos.first;
-      const Array<int>& toIndices = *(mpos.second);
-      EntryIndex e(&oSite, &site);
-
-      if (ghostArrays.find(e) == ghostArrays.end())
-      {
-         ostringstream e;
-         e << "Field::syncScatter: ghost array not found for"
-           << &oSite << endl;
-         throw CException(e.str());
-      }
-
-      const ArrayBase& ghostArray = *ghostArrays[e];
-      const int chunkSize = toIndices.getLength();
-      for (size_t dir = 0; dir < numDir; dir++){
-	 Field& field = *dsf[dir];
-	 ArrayBase& thisArray = field[site];
-	 const size_t offset = dir * chunkSize;
-	 thisArray.gather(ghostArray,toIndices, offset);
-     }
-  }
-}
-void 
-Field::syncLocalVectorFields(std::vector<Field*> & dsf)
-{
-       // scatter first (prepare ship packages)
-   Field& field0 = *dsf[0];
-   ArrayMap& arrays = field0.getArrayMap();
-   foreach(ArrayMap::value_type& pos, arrays)
-      Field::syncScatterVectorFields(*pos.first, dsf);
-
-   const size_t numDir = dsf.size();
-   foreach(ArrayMap::value_type& pos, arrays)
-      Field::createSyncGatherArraysVectorFields(*pos.first, field0, numDir );
-   
-   GhostArrayMap& ghostArrays = field0.getGhostArrayMap();
-   
-#ifdef FVM_PARALLEL
-   //SENDING
-   MPI::Request   request_send[ Field::get_request_size(field0) ];
-   MPI::Request   request_recv[ Field::get_request_size(field0) ];
-   int indxSend = 0;
-   int indxRecv = 0;
-   foreach(ArrayMap::value_type& pos, arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&site,&oSite);
-             ArrayBase& sendArray = *ghostArrays[e];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                     MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-      }
-      //RECIEVING
-      //getting values from other meshes to fill g
-      const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-      foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-         const StorageSite&  oSite = *mpos.first;
-         //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-         EntryIndex e(&oSite,&site);
-         ArrayBase& recvArray = *ghostArrays[e];
-         int from_where       = oSite.getGatherProcID();
-         if ( from_where != -1 ){
-             int mpi_tag = oSite.getTag();
-             request_recv[indxRecv++] =  
-                    MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-         }
-      }
-   }
-
-   int count  = Field::get_request_size(field0);
-   MPI::Request::Waitall( count, request_recv );
-   MPI::Request::Waitall( count, request_send );
-#endif
-
-  // gather 
-  foreach(ArrayMap::value_type& pos, arrays)
-    Field::syncGatherVectorFields(*pos.first, dsf);
-
-
-   //sycnLocal1
-   
-  Field::syncLocalVectorFieldsLevel1(dsf);
-} 
- 
-void 
-Field::syncLocalVectorFieldsLevel1(std::vector<Field*> & dsf)
-{
-   // scatter first (prepare ship packages)
-   Field& field0 = *dsf[0];
-   ArrayMap& arrays = field0.getArrayMap();
-   foreach(ArrayMap::value_type& pos, arrays){ 
-      if ( pos.second->getLength() == pos.first->getCountLevel1() )
-          Field::syncScatterVectorFieldsLevel1(*pos.first, dsf);
-   }
-   
-   const size_t numDir = dsf.size();
-   foreach(ArrayMap::value_type& pos, arrays){
-      if ( pos.second->getLength() == pos.first->getCountLevel1() )   
-         Field::createSyncGatherArraysVectorFieldsLevel1(*pos.first, field0, numDir );
-   }
-     
-   GhostArrayMap& ghostArrays = field0.getGhostArrayMapLevel1();
-   
-#ifdef FVM_PARALLEL
-   //SENDING
-   MPI::Request   request_send[ Field::get_request_size_level1(field0) ];
-   MPI::Request   request_recv[ Field::get_request_size_level1(field0) ];
-   int indxSend = 0;
-   int indxRecv = 0;
-   foreach(ArrayMap::value_type& pos, arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-             EntryIndex e(&site,&oSite);
-             ArrayBase& sendArray = *ghostArrays[e];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[indxSend++] =  
-                     MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-      }
-      //RECIEVING
-      //getting values from other meshes to fill g
-      const StorageSite::GatherMap& gatherMap = site.getGatherMapLevel1();
-      foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-         const StorageSite&  oSite = *mpos.first;
-         //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-         EntryIndex e(&oSite,&site);
-         ArrayBase& recvArray = *ghostArrays[e];
-         int from_where       = oSite.getGatherProcID();
-         if ( from_where != -1 ){
-             int mpi_tag = oSite.getTag();
-             request_recv[indxRecv++] =  
-                    MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-         }
-      }
-   }
-
-   int count  = Field::get_request_size_level1(field0);
-   MPI::Request::Waitall( count, request_recv );
-   MPI::Request::Waitall( count, request_send );
-#endif
-
-  // gather 
-  foreach(ArrayMap::value_type& pos, arrays){
-     if ( pos.second->getLength() == pos.first->getCountLevel1() )
-         Field::syncGatherVectorFieldsLevel1(*pos.first, dsf);
-  }	 
-
-
-  
-}  
-
-
-int
-Field::get_request_size(Field& field)
-{
-   ArrayMap& arrays = field.getArrayMap();
-   int indx =  0;
-   foreach(ArrayMap::value_type& pos, arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-          if ( oSite.getGatherProcID() != -1 )
-             indx++;
-      }
-   }
-   return indx;
-
-}
-
-
-int
-Field::get_request_size_level1(Field& field)
-{
-   ArrayMap& arrays = field.getArrayMap();
-   int indx =  0;
-   foreach(ArrayMap::value_type& pos, arrays){
-      const StorageSite& site = *pos.first;
-      const StorageSite::ScatterMap& scatterMap = site.getScatterMapLevel1();
-      foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-          const StorageSite&  oSite = *mpos.first;
-          //checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-          if ( oSite.getGatherProcID() != -1 )
-             indx++;
-      }
-   }
-   return indx;
+  const int numDir = int(dsf.size());
 
+  FieldSyncPlan& plan = *field0._syncPlanLevel1;
+  syncScatter(plan, &dsf[0], numDir);
+  plan.start();
+  plan.finish();
+  syncGather(plan, &dsf[0], numDir);
 }
-
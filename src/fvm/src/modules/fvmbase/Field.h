@@ -8,7 +8,7 @@
 #include "IContainer.h"
 #include "StorageSite.h"
 #include "ArrayBase.h"
-
+#include "SyncPlan.h"
 
 
 class Field : public IContainer
@@ -18,6 +18,7 @@ public:
   typedef map<const StorageSite*, vector<const StorageSite*>* > ChildSitesMap;
   typedef pair<const StorageSite*, const StorageSite*> EntryIndex;
   typedef map<EntryIndex, shared_ptr<ArrayBase> > GhostArrayMap;
+  typedef SyncPlan<const StorageSite*> FieldSyncPlan;
 
   Field(const string& name);
   
@@ -44,6 +45,14 @@ public:
   bool hasArray(const StorageSite& s) const;
   
   void syncLocal();
+
+  // the two halves of syncLocal. startSync posts the exchange of the
+  // values sent to other processes and finishSync completes it and
+  // fills in the ghosts, so anything not involving those can be
+  // computed in between. The second layer of ghosts is exchanged by
+  // finishSync after the first one.
+  void startSync();
+  void finishSync();
   
   ArrayMap& getArrayMap() { return _arrays;}
     
@@ -61,25 +70,22 @@ public:
 private:
 
   Field(const Field&);
-  void  createSyncGatherArrays(const StorageSite& site);
-  void  syncScatter(const StorageSite& site);
-  void  syncGather(const StorageSite& site);
-  void  createSyncGatherArraysLevel1(const StorageSite& site);
-  void  syncScatterLevel1(const StorageSite& site);
-  void  syncGatherLevel1(const StorageSite& site);
-  int  get_request_size();
-  int  get_request_size_scatter_level1();
-  int  get_request_size_gather_level1();
-  
-  static void   createSyncGatherArraysVectorFields(const StorageSite& site, Field& field, const size_t numDir);
-  static void   syncScatterVectorFields(const StorageSite& site, std::vector<Field*> & dsf);
-  static void   syncGatherVectorFields(const StorageSite& site,  std::vector<Field*>& dsf);
-  static void   createSyncGatherArraysVectorFieldsLevel1(const StorageSite& site, Field& field, const size_t numDir);
-  static void   syncScatterVectorFieldsLevel1(const StorageSite& site, std::vector<Field*> & dsf);
-  static void   syncGatherVectorFieldsLevel1(const StorageSite& site,  std::vector<Field*>& dsf);
 
-  static int    get_request_size(Field& field); 
-  static int    get_request_size_level1(Field& field);
+  // the exchange of the ghost values is set up once for the current
+  // arrays and reused until they change. numDir is the number of
+  // fields exchanged together by syncLocalVectorFields
+  void createSyncPlans(const int numDir);
+  bool hasCurrentSyncPlans(const int numDir) const;
+
+  static void addToSyncPlan(FieldSyncPlan& plan, GhostArrayMap& ghostArrays,
+                            const StorageSite& site,
+                            const StorageSite::ScatterMap& scatterMap,
+                            const StorageSite::GatherMap& gatherMap,
+                            const ArrayBase& thisArray, const int numDir);
+  static void syncScatter(const FieldSyncPlan& plan, Field* const* fields,
+                          const int numFields);
+  static void syncGather(const FieldSyncPlan& plan, Field* const* fields,
+                         const int numFields);
 
   void syncLocalLevel1();
   static void syncLocalVectorFieldsLevel1(std::vector<Field*>& dsf);
@@ -94,6 +100,12 @@ private:
   
   ChildSitesMap _childSitesMap;
 
+  bool _syncInProgress;
+  shared_ptr<FieldSyncPlan> _syncPlan;
+  shared_ptr<FieldSyncPlan> _syncPlanLevel1;
+  vector<pair<const StorageSite*, int> > _syncPlanArrays;
+  int _syncPlanFieldCount;
+
   ArrayBase& _create(const StorageSite& site);
   
 };
@@ -14,6 +14,8 @@ public:
 
 
   void syncLocal();
+  void startSync();
+  void finishSync();
 
   const string getName() const;
 
@@ -0,0 +1,190 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#include "FieldGroup.h"
+#include "Array.h"
+
+FieldGroup::FieldGroup() :
+  _fields(),
+  _syncInProgress(false)
+{}
+
+FieldGroup::FieldGroup(const vector<Field*>& fields) :
+  _fields(fields),
+  _syncInProgress(false)
+{}
+
+FieldGroup::~FieldGroup()
+{}
+
+void
+FieldGroup::addField(Field& field)
+{
+  if (_syncInProgress)
+    throw CException("FieldGroup::addField: group is being synced");
+  _fields.push_back(&field);
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
+}
+
+void
+FieldGroup::addToSyncPlan(GroupSyncPlan& plan, GhostArrayMap& ghostArrays,
+                          const ArrayIndex& aIndex,
+                          const StorageSite::ScatterMap& scatterMap,
+                          const StorageSite::GatherMap& gatherMap,
+                          const ArrayBase& thisArray)
+{
+  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
+  {
+      const StorageSite& oSite = *mpos.first;
+      const Array<int>& fromIndices = *(mpos.second);
+      const ArrayIndex oIndex(aIndex.first, &oSite);
+
+      // arrays are stored with (Sender,receiver) as the key
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(aIndex, oIndex)];
+      if (!ghostArray || ghostArray->getLength() != fromIndices.getLength())
+        ghostArray = thisArray.newSizedClone(fromIndices.getLength());
+
+      plan.addSend(aIndex, fromIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
+  }
+
+  foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
+  {
+      const StorageSite& oSite = *mpos.first;
+      const Array<int>& toIndices = *(mpos.second);
+      const ArrayIndex oIndex(aIndex.first, &oSite);
+
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(oIndex, aIndex)];
+      if (!ghostArray || ghostArray->getLength() != toIndices.getLength())
+        ghostArray = thisArray.newSizedClone(toIndices.getLength());
+
+      plan.addRecv(aIndex, toIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
+  }
+}
+
+void
+FieldGroup::createSyncPlans()
+{
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
+  _syncPlanArrays.clear();
+
+  shared_ptr<GroupSyncPlan> plan(new GroupSyncPlan());
+  shared_ptr<GroupSyncPlan> planLevel1(new GroupSyncPlan());
+
+  // the buffers are added field by field so that the messages to each
+  // process hold them in the same order on both sides
+  for(int n=0; n<int(_fields.size()); n++)
+  {
+      foreach(Field::ArrayMap::value_type& pos, _fields[n]->getArrayMap())
+      {
+          const StorageSite& site = *pos.first;
+          const ArrayBase& thisArray = *pos.second;
+          const ArrayIndex aIndex(n, &site);
+
+          addToSyncPlan(*plan, _ghostArrays, aIndex,
+                        site.getScatterMap(), site.getGatherMap(),
+                        thisArray);
+
+          if (thisArray.getLength() == site.getCountLevel1())
+            addToSyncPlan(*planLevel1, _ghostArraysLevel1, aIndex,
+                          site.getScatterMapLevel1(),
+                          site.getGatherMapLevel1(),
+                          thisArray);
+
+          _syncPlanArrays.push_back(make_pair(aIndex, thisArray.getLength()));
+      }
+  }
+
+  _syncPlan = plan;
+  _syncPlanLevel1 = planLevel1;
+}
+
+bool
+FieldGroup::hasCurrentSyncPlans() const
+{
+  if (!_syncPlan)
+    return false;
+
+  size_t nArrays = 0;
+  for(int n=0; n<int(_fields.size()); n++)
+  {
+      foreach(const Field::ArrayMap::value_type& pos, _fields[n]->getArrayMap())
+      {
+          if (nArrays == _syncPlanArrays.size())
+            return false;
+          const pair<ArrayIndex, int>& planned = _syncPlanArrays[nArrays++];
+          if (planned.first != ArrayIndex(n, pos.first) ||
+              planned.second != pos.second->getLength())
+            return false;
+      }
+  }
+  return nArrays == _syncPlanArrays.size();
+}
+
+void
+FieldGroup::syncScatter(const GroupSyncPlan& plan)
+{
+  foreach(const GroupSyncPlan::Buffer& b, plan.getSendBuffers())
+  {
+      const ArrayBase& thisArray = (*_fields[b.key.first])[*b.key.second];
+      thisArray.scatter(*b.data, *b.indices);
+  }
+}
+
+void
+FieldGroup::syncGather(const GroupSyncPlan& plan)
+{
+  foreach(const GroupSyncPlan::Buffer& b, plan.getRecvBuffers())
+  {
+      ArrayBase& thisArray = (*_fields[b.key.first])[*b.key.second];
+      thisArray.gather(*b.data, *b.indices);
+  }
+}
+
+void
+FieldGroup::syncLocal()
+{
+  startSync();
+  finishSync();
+}
+
+void
+FieldGroup::startSync()
+{
+  if (_syncInProgress)
+    throw CException("FieldGroup::startSync: group is already being synced");
+
+  if (!hasCurrentSyncPlans())
+    createSyncPlans();
+
+  _syncInProgress = true;
+
+  syncScatter(*_syncPlan);
+  _syncPlan->start();
+}
+
+void
+FieldGroup::finishSync()
+{
+  if (!_syncInProgress)
+    throw CException("FieldGroup::finishSync: group is not being synced");
+  _syncInProgress = false;
+
+  _syncPlan->finish();
+  syncGather(*_syncPlan);
+
+  syncLocalLevel1();
+}
+
+void
+FieldGroup::syncLocalLevel1()
+{
+  syncScatter(*_syncPlanLevel1);
+  _syncPlanLevel1->start();
+  _syncPlanLevel1->finish();
+  syncGather(*_syncPlanLevel1);
+}
@@ -0,0 +1,68 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _FIELDGROUP_H_
+#define _FIELDGROUP_H_
+
+#include "Field.h"
+#include "SyncPlan.h"
+
+/**
+ * A set of fields whose ghosts are exchanged together. The values of
+ * all the fields going to a neighbouring process are sent as one
+ * message instead of one per field, which matters when a model syncs
+ * many fields in a row. The fields must be added in the same order on
+ * all processes and must outlive the group.
+ *
+ */
+
+class FieldGroup
+{
+public:
+  typedef pair<int, const StorageSite*> ArrayIndex;
+  typedef pair<ArrayIndex, ArrayIndex> EntryIndex;
+  typedef map<EntryIndex, shared_ptr<ArrayBase> > GhostArrayMap;
+  typedef SyncPlan<ArrayIndex> GroupSyncPlan;
+
+  FieldGroup();
+  FieldGroup(const vector<Field*>& fields);
+
+  virtual ~FieldGroup();
+
+  DEFINE_TYPENAME("FieldGroup");
+
+  void addField(Field& field);
+  int getFieldCount() const {return int(_fields.size());}
+
+  void syncLocal();
+
+  // see Field::startSync
+  void startSync();
+  void finishSync();
+
+private:
+  FieldGroup(const FieldGroup&);
+
+  void createSyncPlans();
+  bool hasCurrentSyncPlans() const;
+  void addToSyncPlan(GroupSyncPlan& plan, GhostArrayMap& ghostArrays,
+                     const ArrayIndex& aIndex,
+                     const StorageSite::ScatterMap& scatterMap,
+                     const StorageSite::GatherMap& gatherMap,
+                     const ArrayBase& thisArray);
+  void syncScatter(const GroupSyncPlan& plan);
+  void syncGather(const GroupSyncPlan& plan);
+  void syncLocalLevel1();
+
+  vector<Field*> _fields;
+  GhostArrayMap _ghostArrays;
+  GhostArrayMap _ghostArraysLevel1;
+
+  bool _syncInProgress;
+  shared_ptr<GroupSyncPlan> _syncPlan;
+  shared_ptr<GroupSyncPlan> _syncPlanLevel1;
+  vector<pair<ArrayIndex, int> > _syncPlanArrays;
+};
+
+#endif
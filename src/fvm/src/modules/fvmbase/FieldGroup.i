@@ -0,0 +1,16 @@
+%{
+#include "FieldGroup.h"
+  %}
+
+class FieldGroup
+{
+public:
+  FieldGroup();
+
+  void addField(Field& field);
+  int getFieldCount() const;
+
+  void syncLocal();
+  void startSync();
+  void finishSync();
+};
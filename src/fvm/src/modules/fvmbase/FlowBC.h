@@ -66,6 +66,8 @@ struct FlowModelOptions : public FloatVarDict<T>
     this->vk = 0.4187;
     this->emp = 9.793;
     this-> cmu = 0.09;
+    this->threadedAssembly = false;
+    this->persistentLinearSystem = false;
    
 
   }
@@ -84,6 +86,11 @@ struct FlowModelOptions : public FloatVarDict<T>
   double vk;
   double emp;
   bool incompressible;
+  // only the momentum equations are assembled through the Linearizer;
+  // the continuity and pressure correction face loops sum the boundary
+  // fluxes and mark Dirichlet cells as they go, so they stay serial
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 #ifndef SWIG
   LinearSolver& getMomentumLinearSolver()
   {
@@ -37,6 +37,8 @@ struct FlowModelOptions : public FloatVarDict<T>
   double vk;
   double emp;
   bool turbulent;
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 }; 
 
 //%template(Vector3) Vector<ATYPE_STR,3>;
@@ -92,7 +92,13 @@ public:
                            _flowFields.pressureGradient,_geomFields),
     _initialMomentumNorm(),
     _initialContinuityNorm(),
-    _niters(0)
+    _niters(0),
+    _momentumDiscretizations(),
+    _momentumRelaxation(),
+    _discretizedTransient(false),
+    _discretizedTimeStep(0),
+    _discretizedTurbulent(false),
+    _discretizedMomentumURF(0)
   {
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
@@ -339,6 +345,10 @@ public:
     _niters  =0;
     _initialMomentumNorm = MFRPtr();
     _initialContinuityNorm = MFRPtr();
+    _momentumLinearSystem = shared_ptr<LinearSystem>();
+    _continuityLinearSystem = shared_ptr<LinearSystem>();
+    _momentumDiscretizations.clear();
+    _momentumRelaxation.clear();
   }
   
   FlowBCMap& getBCMap() {return _bcMap;}
@@ -573,11 +583,11 @@ public:
     }
   }
 
-  void linearizeMomentum(LinearSystem& ls)
+  void createMomentumDiscretizations()
   {
-    _velocityGradientModel.compute();
-    
-    DiscrList discretizations;
+    DiscrList& discretizations = _momentumDiscretizations;
+    discretizations.clear();
+
     shared_ptr<Discretization>
       dd(new DiffusionDiscretization<VectorT3,DiagTensorT3,T>
          (_meshes,_geomFields,
@@ -623,9 +633,41 @@ public:
              (_meshes,_geomFields,_flowFields.velocity));
       
     discretizations.push_back(ibm);
-    Linearizer linearizer;
 
-    linearizer.linearize(discretizations,_meshes,ls.getMatrix(),
+    _momentumRelaxation.clear();
+    shared_ptr<Discretization>
+      ud(new Underrelaxer<VectorT3,DiagTensorT3,T>
+         (_meshes,_flowFields.velocity,
+          _options["momentumURF"]));
+    _momentumRelaxation.push_back(ud);
+
+    _discretizedTransient = _options.transient;
+    _discretizedTimeStep = _options["timeStep"];
+    _discretizedTurbulent = _options.turbulent;
+    _discretizedMomentumURF = _options["momentumURF"];
+  }
+
+  // kept with a persistent linear system as in ThermalModel
+  bool momentumDiscretizationsAreCurrent() const
+  {
+    return _options.persistentLinearSystem &&
+      !_momentumDiscretizations.empty() &&
+      _discretizedTransient == _options.transient &&
+      _discretizedTimeStep == _options["timeStep"] &&
+      _discretizedTurbulent == _options.turbulent &&
+      _discretizedMomentumURF == _options["momentumURF"];
+  }
+
+  void linearizeMomentum(LinearSystem& ls)
+  {
+    _velocityGradientModel.compute();
+
+    if (!momentumDiscretizationsAreCurrent())
+      createMomentumDiscretizations();
+
+    Linearizer linearizer(_options.threadedAssembly);
+
+    linearizer.linearize(_momentumDiscretizations,_meshes,ls.getMatrix(),
                          ls.getX(), ls.getB());
 
     const int numMeshes = _meshes.size();
@@ -713,15 +755,7 @@ public:
         }
 
     }
-    DiscrList discretizations2;
-    shared_ptr<Discretization>
-      ud(new Underrelaxer<VectorT3,DiagTensorT3,T>
-         (_meshes,_flowFields.velocity,
-          _options["momentumURF"]));
-
-    discretizations2.push_back(ud);
-
-    linearizer.linearize(discretizations2,_meshes,ls.getMatrix(),
+    linearizer.linearize(_momentumRelaxation,_meshes,ls.getMatrix(),
                          ls.getX(), ls.getB());
 
   }
@@ -729,9 +763,18 @@ public:
 
   MFRPtr solveMomentum()
   {
-    LinearSystem ls;
+    // the momentum and continuity systems are kept across iterations
+    // when they are persistent, see ThermalModel::advance
+    shared_ptr<LinearSystem> lsPtr(_momentumLinearSystem);
+    if (!lsPtr || !_options.persistentLinearSystem)
+    {
+        lsPtr = shared_ptr<LinearSystem>(new LinearSystem());
+        initMomentumLinearization(*lsPtr);
+        if (_options.persistentLinearSystem)
+          _momentumLinearSystem = lsPtr;
+    }
+    LinearSystem& ls = *lsPtr;
 
-    initMomentumLinearization(ls);
     ls.initAssembly();
     linearizeMomentum(ls);
     ls.initSolve();
@@ -1393,9 +1436,14 @@ public:
 
   shared_ptr<LinearSystem> discretizeContinuity()
   {
-    shared_ptr<LinearSystem> ls(new LinearSystem());
-
-    initContinuityLinearization(*ls);
+    shared_ptr<LinearSystem> ls(_continuityLinearSystem);
+    if (!ls || !_options.persistentLinearSystem)
+    {
+        ls = shared_ptr<LinearSystem>(new LinearSystem());
+        initContinuityLinearization(*ls);
+        if (_options.persistentLinearSystem)
+          _continuityLinearSystem = ls;
+    }
         
     ls->initAssembly();
     
@@ -2137,6 +2185,16 @@ private:
   shared_ptr<Field> _previousVelocity;
   shared_ptr<Field> _momApField;
 
+  shared_ptr<LinearSystem> _momentumLinearSystem;
+  shared_ptr<LinearSystem> _continuityLinearSystem;
+
+  DiscrList _momentumDiscretizations;
+  DiscrList _momentumRelaxation;
+  bool _discretizedTransient;
+  T _discretizedTimeStep;
+  bool _discretizedTurbulent;
+  T _discretizedMomentumURF;
+
   bool _useReferencePressure;
   int  _globalRefCellID;
   int  _globalRefProcID;
@@ -16,6 +16,7 @@
 #include "Array.h"
 #include "StorageSite.h"
 #include "Gradient.h"
+#include "CRMatrixKernels.h"
 
 class GradientMatrixBase
 {
@@ -56,13 +57,19 @@ public:
   shared_ptr<Array<Gradient<X> > >
   getGradient(const Array<X>& x) const
   {
-    typedef Gradient<X> GradType;
-    typedef Array<GradType> GradArray;
+    shared_ptr<Array<Gradient<X> > >
+      gradXPtr(new Array<Gradient<X> >(x.getLength()));
+    getGradient(*gradXPtr,x);
+    return gradXPtr;
+  }
 
-    shared_ptr<GradArray> gradXPtr(new GradArray(x.getLength()));
-    GradArray& gradX = *gradXPtr;
-    
+  // the same into an existing array, which only has its self rows set
+  template<class X>
+  void
+  getGradient(Array<Gradient<X> >& gradX, const Array<X>& x) const
+  {
     const int nRows = getConnectivity().getRowSite().getSelfCount();
+#pragma omp parallel for if (nRows > CRMATRIX_MIN_THREADED_ROWS)
     for(int nr=0; nr<nRows; nr++)
     {
         gradX[nr].zero();
@@ -72,7 +79,6 @@ public:
             gradX[nr].accumulate(_coeffs[nb],x[j]-x[nr]);
         }
     }
-    return gradXPtr;
   }
   
   template<class X>
@@ -92,9 +98,9 @@ public:
     }
   }
 
-  template<class X>
+  template<class X, class XArray>
     X
-    computeR(const Gradient<X>& g, const Array<X>& x, const Coord dist, int i, int j) const
+    computeR(const Gradient<X>& g, const XArray& x, const Coord dist, int i, int j) const
     {//Darwish and Moukalled, Int. J. H. M. T., 46 (2003) 599-611
 
       X den=x[j]-x[i];
@@ -485,9 +485,19 @@ public:
         GradMatrixType& gradMatrix = getGradientMatrix(mesh,_geomFields);
 	
         const XArray& var = dynamic_cast<const XArray&>(_varField[cells]);
-        shared_ptr<GradArray> gradPtr = gradMatrix.getGradient(var);
 
-        _gradientField.addArray(cells,gradPtr);
+        // overwrite the array of the previous call so that the
+        // iterations of a model do not allocate one per mesh
+        shared_ptr<GradArray> gradPtr;
+        if (_gradientField.hasArray(cells))
+          gradPtr = dynamic_pointer_cast<GradArray>(_gradientField.getArrayPtr(cells));
+        if (gradPtr && gradPtr->getLength() == var.getLength())
+          gradMatrix.getGradient(*gradPtr,var);
+        else
+        {
+            gradPtr = gradMatrix.getGradient(var);
+            _gradientField.addArray(cells,gradPtr);
+        }
 
         // fix values in cells adjacent to IB Faces
 
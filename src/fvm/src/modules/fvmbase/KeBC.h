@@ -54,10 +54,15 @@ struct KeModelOptions : public FloatVarDict<T>
     this-> sigmak =1.0;
     this-> sigmae =1.3;
     this->printNormalizedResiduals = true;
+    this->persistentLinearSystem = false;
 
  }     
 
   bool printNormalizedResiduals ;
+  // keeps the linear systems across iterations; unlike the thermal,
+  // species and flow models the discretizations, a handful of small
+  // objects per equation, are still created on every iteration
+  bool persistentLinearSystem;
   bool transient;
   int timeDiscretizationOrder;
   double relativeTolerance;
@@ -35,6 +35,7 @@ struct KeModelOptions : public FloatVarDict<T>
   double sigmae;
   bool useCentralDifference;
   bool printNormalizedResiduals;
+  bool persistentLinearSystem;
 
 };
 
@@ -267,6 +267,8 @@ public:
     _niters  =0;
     _initialNormk = MFRPtr();
     _initialNorm = MFRPtr();
+    _energyLinearSystem = shared_ptr<LinearSystem>();
+    _dissipationLinearSystem = shared_ptr<LinearSystem>();
 
   }
   
@@ -878,8 +880,15 @@ public:
     { 
  
      {
-        LinearSystem lsk;
-        initLinearizationk(lsk);
+        shared_ptr<LinearSystem> lskPtr(_energyLinearSystem);
+        if (!lskPtr || !_options.persistentLinearSystem)
+        {
+            lskPtr = shared_ptr<LinearSystem>(new LinearSystem());
+            initLinearizationk(*lskPtr);
+            if (_options.persistentLinearSystem)
+              _energyLinearSystem = lskPtr;
+        }
+        LinearSystem& lsk = *lskPtr;
         
         lsk.initAssembly();
 
@@ -914,8 +923,15 @@ public:
       }
 
       { 
-        LinearSystem lse;
-        initLinearization(lse);
+        shared_ptr<LinearSystem> lsePtr(_dissipationLinearSystem);
+        if (!lsePtr || !_options.persistentLinearSystem)
+        {
+            lsePtr = shared_ptr<LinearSystem>(new LinearSystem());
+            initLinearization(*lsePtr);
+            if (_options.persistentLinearSystem)
+              _dissipationLinearSystem = lsePtr;
+        }
+        LinearSystem& lse = *lsePtr;
 
         lse.initAssembly();
 
@@ -984,6 +1000,8 @@ private:
   MFRPtr _initialNormk; 
   MFRPtr _initialNorm;
   int _niters;
+  shared_ptr<LinearSystem> _energyLinearSystem;
+  shared_ptr<LinearSystem> _dissipationLinearSystem;
 };
 
 template<class T>
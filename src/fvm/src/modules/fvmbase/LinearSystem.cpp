@@ -16,7 +16,7 @@ LinearSystem::LinearSystem() :
   _b(),
   _delta(),
   _residual(),
-  _coarseIndex(),
+  _coarseIndex(new MultiField()),
   _coarseningField(0)
 {}
 
@@ -32,15 +32,21 @@ void
 LinearSystem::initAssembly()
 {
   _matrix.initAssembly();
-  _b = dynamic_pointer_cast<MultiField>(_x->newClone());
+
+  // a system that is being reused only needs its values reset, the
+  // arrays of b have already been allocated to match x
+  if (!_b || _b->getLength() != _x->getLength())
+    _b = dynamic_pointer_cast<MultiField>(_x->newClone());
   _b->zero();
 }
 
 void
 LinearSystem::initSolve()
 {
-  _delta = dynamic_pointer_cast<MultiField>(_x->newClone());
-  _residual = dynamic_pointer_cast<MultiField>(_x->newClone());
+  if (!_delta || _delta->getLength() != _x->getLength())
+    _delta = dynamic_pointer_cast<MultiField>(_x->newClone());
+  if (!_residual || _residual->getLength() != _x->getLength())
+    _residual = dynamic_pointer_cast<MultiField>(_x->newClone());
   _delta->zero();
   _residual->zero();
 
@@ -64,10 +70,17 @@ LinearSystem::initSolve()
 }
 
 shared_ptr<LinearSystem>
-LinearSystem::createCoarse(const int groupSize, const double weightRatioThreshold)
+LinearSystem::createCoarse(const int groupSize, const double weightRatioThreshold,
+                           const double strengthThreshold,
+                           const bool classical,
+                           const double prolongationSmoothing)
 {
 
   shared_ptr<LinearSystem> coarseLS(new LinearSystem());
+
+  // discard any coarsening left over from a previous solve of this system
+  _coarseIndex = shared_ptr<MultiField>(new MultiField());
+  _matrix.clearCoarsening();
   /**
    * we create only one entry in coarseIndex for each
    * StorageSite even if the site is present in multiple fine
@@ -93,7 +106,7 @@ LinearSystem::createCoarse(const int groupSize, const double weightRatioThreshol
               sitesCoarsenedWithField[site] = fieldIndex;
               const ArrayBase& bi = (*_b)[ai];
               shared_ptr<Array<int> > cIndex(new Array<int>(bi.getLength()));
-              _coarseIndex.addArray(ai,cIndex);
+              _coarseIndex->addArray(ai,cIndex);
 
           }
       }
@@ -108,12 +121,16 @@ LinearSystem::createCoarse(const int groupSize, const double weightRatioThreshol
    * 
    */
 
-  _matrix.createCoarsening(_coarseIndex,groupSize,weightRatioThreshold);
+  if (strengthThreshold >= 0)
+    _matrix.createStrengthCoarsening(*_coarseIndex,strengthThreshold,
+                                     classical);
+  else
+    _matrix.createCoarsening(*_coarseIndex,groupSize,weightRatioThreshold);
 
-  _coarseIndex.sync();
+  _coarseIndex->sync();
 
 
-_matrix.syncGhostCoarsening(_coarseIndex);
+_matrix.syncGhostCoarsening(*_coarseIndex);
 
 
   // we can now create the coarse sites for each fine site
@@ -183,7 +200,7 @@ _matrix.syncGhostCoarsening(_coarseIndex);
   }
 
   // create the connectivities for the coarse matrices
-  _matrix.createCoarseToFineMapping(_coarseIndex);
+  _matrix.createCoarseToFineMapping(*_coarseIndex);
 
   /**
    *  now we have the coarse indices, sizes, sites, mappers and *
@@ -201,7 +218,7 @@ _matrix.syncGhostCoarsening(_coarseIndex);
       {
           const Field* fieldIndexUsedForCoarsening = sitesCoarsenedWithField[site];
           MultiField::ArrayIndex indexCoarsened(fieldIndexUsedForCoarsening,site);
-          _coarseIndex.addArray(k, _coarseIndex.getArrayPtr(indexCoarsened));
+          _coarseIndex->addArray(k, _coarseIndex->getArrayPtr(indexCoarsened));
           _matrix._coarseSizes[k] = _matrix._coarseSizes[indexCoarsened];
           _matrix._coarseGhostSizes[k] = _matrix._coarseGhostSizes[indexCoarsened];
           _matrix._coarseSites[k] = _matrix._coarseSites[indexCoarsened];
@@ -209,8 +226,12 @@ _matrix.syncGhostCoarsening(_coarseIndex);
       }
   }
 
-  _matrix.createCoarseConnectivity(_coarseIndex);
-  _matrix.createCoarseMatrices(_coarseIndex);
+  if (classical || prolongationSmoothing > 0)
+    _matrix.createProlongators(*_coarseIndex,strengthThreshold,classical,
+                               prolongationSmoothing);
+
+  _matrix.createCoarseConnectivity(*_coarseIndex);
+  _matrix.createCoarseMatrices(*_coarseIndex);
   foreach(MultiField::ArrayIndex fineRowIndex,arrayIndices)
   {
       MultiField::ArrayIndex coarseRowIndex (fineRowIndex.first,
@@ -247,6 +268,63 @@ _matrix.syncGhostCoarsening(_coarseIndex);
   return coarseLS;
 }
 
+void
+LinearSystem::updateCoarse()
+{
+  _matrix.updateCoarseMatrices(*_coarseIndex);
+}
+
+void
+LinearSystem::createSinglePrecision()
+{
+  shared_ptr<LinearSystem> spLS(new LinearSystem());
+
+  spLS->isSymmetric = isSymmetric;
+  spLS->_coarseningField = _coarseningField;
+  spLS->_b = shared_ptr<MultiField>(new MultiField());
+
+  const MultiField::ArrayIndexList& arrayIndices = _b->getArrayIndices();
+  foreach(MultiField::ArrayIndex k,arrayIndices)
+  {
+      const ArrayBase& bk = (*_b)[k];
+      if (!dynamic_cast<const Array<double>*>(&bk))
+        throw CException("single precision copy is only available for scalar systems");
+      spLS->_b->addArray(k, shared_ptr<ArrayBase>(new Array<float>(bk.getLength())));
+  }
+
+  spLS->_b->zero();
+  spLS->_delta = dynamic_pointer_cast<MultiField>(spLS->_b->newClone());
+  spLS->_delta->zero();
+  spLS->_residual = dynamic_pointer_cast<MultiField>(spLS->_b->newClone());
+  spLS->_residual->zero();
+
+  foreach(MultiField::ArrayIndex rowIndex,arrayIndices)
+  {
+      foreach(MultiField::ArrayIndex colIndex,arrayIndices)
+      {
+          if (_matrix.hasMatrix(rowIndex,colIndex))
+          {
+              MultiFieldMatrix::EntryIndex e(rowIndex,colIndex);
+              spLS->_matrix._matrices[e] =
+                _matrix.getMatrix(rowIndex,colIndex).createSinglePrecisionMatrix();
+          }
+      }
+  }
+
+  _singlePrecision = spLS;
+}
+
+void
+LinearSystem::updateSinglePrecision()
+{
+  foreach(MultiFieldMatrix::MatrixMap::value_type& pos,
+          _singlePrecision->_matrix._matrices)
+  {
+      const MultiFieldMatrix::EntryIndex& e = pos.first;
+      _matrix.getMatrix(e.first,e.second).updateSinglePrecisionMatrix(*pos.second);
+  }
+}
+
 void LinearSystem::postSolve()
 {
   _matrix.solveBoundary(*_delta,*_b,*_residual);
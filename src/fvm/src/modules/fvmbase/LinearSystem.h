@@ -26,8 +26,42 @@ public:
 
   void updateSolution();
 
+  /**
+   * with a non negative strengthThreshold the rows are coarsened along
+   * their strong connections instead of being grouped groupSize at a
+   * time (see CRMatrix::createStrengthCoarsening). When classical, or
+   * with a positive prolongationSmoothing, the residuals and
+   * corrections are transferred with the corresponding prolongators
+   * and the coarse matrices are the Galerkin products.
+   * 
+   */
   shared_ptr<LinearSystem>
-  createCoarse(const int groupSize, const double weightRatioThreshold);
+  createCoarse(const int groupSize, const double weightRatioThreshold,
+               const double strengthThreshold=-1,
+               const bool classical=false,
+               const double prolongationSmoothing=0);
+
+  // recompute the coefficients of the coarse matrices created by the
+  // last createCoarse call from the current values of the matrix
+  void updateCoarse();
+
+  bool hasCoarse() const {return _coarseIndex->getLength() > 0;}
+
+  /**
+   * creates a copy of this system with the matrices and vectors in
+   * single precision, replacing any previous one. This is used by AMG
+   * to build and cycle its hierarchy in single precision and is only
+   * available for scalar systems.
+   * 
+   */
+  void createSinglePrecision();
+
+  // recompute the coefficients of the single precision copy from the
+  // current values of the matrix
+  void updateSinglePrecision();
+
+  bool hasSinglePrecision() const {return _singlePrecision;}
+  LinearSystem& getSinglePrecision() {return *_singlePrecision;}
 
   MultiField& getX() {return *_x;}
   MultiField& getB() {return *_b;}
@@ -36,7 +70,7 @@ public:
   
   MultiFieldMatrix& getMatrix() {return _matrix;}
 
-  MultiField& getCoarseIndex() {return _coarseIndex;}
+  MultiField& getCoarseIndex() {return *_coarseIndex;}
 
   shared_ptr<MultiField> getDeltaPtr() {return _delta;}
   shared_ptr<MultiField> getBPtr() {return _b;}
@@ -55,11 +89,12 @@ private:
   shared_ptr<MultiField> _b;
   shared_ptr<MultiField> _delta;
   shared_ptr<MultiField> _residual;
-  MultiField _coarseIndex;
+  shared_ptr<MultiField> _coarseIndex;
   const Field* _coarseningField;
   shared_ptr<MultiField> _xAux;
   shared_ptr<MultiField> _bAux;
   shared_ptr<MultiField> _deltaAux;
   shared_ptr<MultiField> _residualAux;
+  shared_ptr<LinearSystem> _singlePrecision;
 };
 #endif
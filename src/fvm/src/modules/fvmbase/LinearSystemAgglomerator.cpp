@@ -0,0 +1,358 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifdef FVM_PARALLEL
+
+#include <algorithm>
+#include <cstring>
+#include "LinearSystemAgglomerator.h"
+#include "CRConnectivity.h"
+
+using namespace std;
+
+LinearSystemAgglomerator::LinearSystemAgglomerator(const MPI::Intracomm& comm,
+                                                   const int factor,
+                                                   LinearSystem& ls) :
+  _ls(ls),
+  _index(ls.getB().getArrayIndex(0)),
+  _groupComm(),
+  _comm(),
+  _isActive(false),
+  _rank(MPI::COMM_WORLD.Get_rank()),
+  _diagEntrySize(0),
+  _offDiagEntrySize(0)
+{
+  createGroups(comm,factor);
+
+  const StorageSite& site = *_index.second;
+  const int nSelf = site.getSelfCount();
+  const Matrix& m = _ls.getMatrix().getMatrix(_index,_index);
+  const CRConnectivity& conn = m.getConnectivity();
+  const Array<int>& row = conn.getRow();
+  const Array<int>& col = conn.getCol();
+
+  // where the self rows go: after those of the members before this
+  // one, on the first process of the group
+  const int groupSize = _groupComm.Get_size();
+  _selfCounts.resize(groupSize);
+  _groupComm.Allgather(&nSelf, 1, MPI::INT, &_selfCounts[0], 1, MPI::INT);
+  int offset = 0;
+  for(int i=0; i<_groupComm.Get_rank(); i++)
+    offset += _selfCounts[i];
+  int target = _rank;
+  _groupComm.Bcast(&target, 1, MPI::INT, 0);
+
+  // and so where the ghost rows are, as told by their owners. The
+  // ghosts that aren't received, e.g. boundary rows, stay at -1
+  shared_ptr<Array<int> > procs(new Array<int>(site.getCount()));
+  shared_ptr<Array<int> > rows(new Array<int>(site.getCount()));
+  *procs = -1;
+  *rows = -1;
+  for(int i=0; i<nSelf; i++)
+  {
+      (*procs)[i] = target;
+      (*rows)[i] = offset + i;
+  }
+  MultiField procsField;
+  MultiField rowsField;
+  procsField.addArray(_index,procs);
+  rowsField.addArray(_index,rows);
+  procsField.sync();
+  rowsField.sync();
+
+  vector<int> rowCounts(nSelf,0);
+  vector<int> cols;
+  for(int i=0; i<nSelf; i++)
+    for(int nb=row[i]; nb<row[i+1]; nb++)
+    {
+        const int j = col[nb];
+        if ((*procs)[j] >= 0)
+        {
+            _keptOffDiag.push_back(nb);
+            cols.push_back((*procs)[j]);
+            cols.push_back((*rows)[j]);
+            rowCounts[i]++;
+        }
+    }
+
+  // the sizes of the entries, from the processes that have any
+  const int rowDim = conn.getRowDim();
+  const int colLength = col.getLength();
+  const ArrayBase& b = _ls.getB()[_index];
+  int entrySizes[3] = {rowDim > 0 ? m.getDiagDataSize()/rowDim : 0,
+                       colLength > 0 ? m.getOffDiagDataSize()/colLength : 0,
+                       b.getLength() > 0 ? b.getDataSize()/b.getLength() : 0};
+  _groupComm.Allreduce(MPI::IN_PLACE, entrySizes, 3, MPI::INT, MPI::MAX);
+  _diagEntrySize = entrySizes[0];
+  _offDiagEntrySize = entrySizes[1];
+  const int xEntrySize = entrySizes[2];
+  _offDiagBuffer.resize(_keptOffDiag.size()*_offDiagEntrySize);
+
+  int nKept = int(_keptOffDiag.size());
+  vector<int> keptCounts(groupSize);
+  _groupComm.Gather(&nKept, 1, MPI::INT, &keptCounts[0], 1, MPI::INT, 0);
+
+  // the counts and displacements of everything gathered later, only
+  // used on the first process of the group
+  _selfBytes.resize(groupSize,0);
+  _selfDispls.resize(groupSize,0);
+  _diagBytes.resize(groupSize,0);
+  _diagDispls.resize(groupSize,0);
+  _offDiagBytes.resize(groupSize,0);
+  _offDiagDispls.resize(groupSize,0);
+  if (_isActive)
+  {
+      for(int i=0; i<groupSize; i++)
+      {
+          _selfBytes[i] = _selfCounts[i]*xEntrySize;
+          _diagBytes[i] = _selfCounts[i]*_diagEntrySize;
+          _offDiagBytes[i] = keptCounts[i]*_offDiagEntrySize;
+          _selfDispls[i] = i == 0 ? 0 : _selfDispls[i-1] + _selfBytes[i-1];
+          _diagDispls[i] = i == 0 ? 0 : _diagDispls[i-1] + _diagBytes[i-1];
+          _offDiagDispls[i] = i == 0 ? 0 : _offDiagDispls[i-1] + _offDiagBytes[i-1];
+      }
+  }
+
+  // the rows of the group, with their columns as (process, row) pairs
+  int nRows = 0;
+  vector<int> rowDispls(groupSize);
+  vector<int> colCounts(groupSize);
+  vector<int> colDispls(groupSize);
+  for(int i=0; i<groupSize; i++)
+  {
+      rowDispls[i] = nRows;
+      nRows += _selfCounts[i];
+      colCounts[i] = 2*keptCounts[i];
+      colDispls[i] = i == 0 ? 0 : colDispls[i-1] + colCounts[i-1];
+  }
+
+  vector<int> groupRowCounts(_isActive ? nRows : 0);
+  vector<int> groupCols(_isActive ? colDispls[groupSize-1] + colCounts[groupSize-1] : 0);
+  _groupComm.Gatherv(nSelf > 0 ? &rowCounts[0] : 0, nSelf, MPI::INT,
+                     groupRowCounts.empty() ? 0 : &groupRowCounts[0],
+                     &_selfCounts[0], &rowDispls[0], MPI::INT, 0);
+  _groupComm.Gatherv(cols.empty() ? 0 : &cols[0], int(cols.size()), MPI::INT,
+                     groupCols.empty() ? 0 : &groupCols[0],
+                     &colCounts[0], &colDispls[0], MPI::INT, 0);
+
+  if (_isActive)
+  {
+      vector<RowID> groupColIDs(groupCols.size()/2);
+      for(size_t i=0; i<groupColIDs.size(); i++)
+        groupColIDs[i] = RowID(groupCols[2*i],groupCols[2*i+1]);
+      createSite(groupRowCounts,groupColIDs);
+  }
+
+  gatherMatrix();
+}
+
+LinearSystemAgglomerator::~LinearSystemAgglomerator()
+{
+  if (!MPI::Is_finalized())
+  {
+      _groupComm.Free();
+      if (_isActive)
+        _comm.Free();
+  }
+}
+
+bool
+LinearSystemAgglomerator::isSupported(LinearSystem& ls)
+{
+  const MultiField& b = ls.getB();
+  return b.getLength() == 1 &&
+    ls.getMatrix().hasMatrix(b.getArrayIndex(0),b.getArrayIndex(0));
+}
+
+void
+LinearSystemAgglomerator::createGroups(const MPI::Intracomm& comm,
+                                       const int factor)
+{
+  const int rank = comm.Get_rank();
+  _groupComm = comm.Split(rank/factor, rank);
+  _isActive = _groupComm.Get_rank() == 0;
+  _comm = comm.Split(_isActive ? 0 : MPI::UNDEFINED, rank);
+}
+
+void
+LinearSystemAgglomerator::createSite(const vector<int>& rowCounts,
+                                     const vector<RowID>& cols)
+{
+  const int nSelf = int(rowCounts.size());
+
+  vector<RowID> ghosts;
+  foreach(const RowID& c, cols)
+    if (c.first != _rank)
+      ghosts.push_back(c);
+  sort(ghosts.begin(),ghosts.end());
+  ghosts.erase(unique(ghosts.begin(),ghosts.end()),ghosts.end());
+
+  _site = shared_ptr<StorageSite>(new StorageSite(nSelf,int(ghosts.size())));
+
+  createMaps(ghosts);
+
+  // the columns are added in the order of the gathered off diagonals
+  _conn = shared_ptr<CRConnectivity>(new CRConnectivity(*_site,*_site));
+  _conn->initCount();
+  for(int i=0; i<nSelf; i++)
+    _conn->addCount(i,rowCounts[i]);
+  _conn->finishCount();
+  int nc = 0;
+  for(int i=0; i<nSelf; i++)
+    for(int n=0; n<rowCounts[i]; n++, nc++)
+    {
+        const RowID& c = cols[nc];
+        if (c.first == _rank)
+          _conn->add(i,c.second);
+        else
+          _conn->add(i,nSelf + int(lower_bound(ghosts.begin(),ghosts.end(),c)
+                                   - ghosts.begin()));
+    }
+  _conn->finishAdd();
+
+  const Matrix& m = _ls.getMatrix().getMatrix(_index,_index);
+  _matrix = m.createAgglomeratedMatrix(*_conn);
+
+  MultiField::ArrayIndex index(_index.first,_site.get());
+  shared_ptr<MultiField> b(new MultiField());
+  b->addArray(index,_ls.getB()[_index].newSizedClone(_site->getCount()));
+  b->zero();
+
+  _agglomeratedLS = shared_ptr<LinearSystem>(new LinearSystem());
+  _agglomeratedLS->isSymmetric = _ls.isSymmetric;
+  _agglomeratedLS->replaceB(b);
+  _agglomeratedLS->replaceDelta(dynamic_pointer_cast<MultiField>(b->newClone()));
+  _agglomeratedLS->getDelta().zero();
+  _agglomeratedLS->replaceResidual(dynamic_pointer_cast<MultiField>(b->newClone()));
+  _agglomeratedLS->getResidual().zero();
+  _agglomeratedLS->getMatrix().addMatrix(index,index,_matrix);
+}
+
+/**
+ * the ghosts are sorted by process and row, so those of each process
+ * are received in the order of its rows. Every process sends the
+ * others the rows it needs from them, which become their scatter
+ * maps. A neighbour is given both maps even if one of them is empty,
+ * as the coarsening of the agglomerated system expects.
+ *
+ */
+
+void
+LinearSystemAgglomerator::createMaps(const vector<RowID>& ghosts)
+{
+  const int nProcs = _comm.Get_size();
+  const int nSelf = _site->getSelfCount();
+
+  vector<int> ranks(nProcs);
+  _comm.Allgather(&_rank, 1, MPI::INT, &ranks[0], 1, MPI::INT);
+  map<int,int> commRanks;
+  for(int p=0; p<nProcs; p++)
+    commRanks[ranks[p]] = p;
+
+  // the positions of the ghosts of each process, in their order
+  vector<vector<int> > ghostPositions(nProcs);
+  for(int g=0; g<int(ghosts.size()); g++)
+    ghostPositions[commRanks[ghosts[g].first]].push_back(g);
+
+  vector<int> sendCounts(nProcs);
+  vector<int> sendDispls(nProcs,0);
+  vector<int> sendRows;
+  for(int p=0; p<nProcs; p++)
+  {
+      sendCounts[p] = int(ghostPositions[p].size());
+      sendDispls[p] = int(sendRows.size());
+      foreach(const int g, ghostPositions[p])
+        sendRows.push_back(ghosts[g].second);
+  }
+
+  vector<int> recvCounts(nProcs);
+  _comm.Alltoall(&sendCounts[0], 1, MPI::INT, &recvCounts[0], 1, MPI::INT);
+  vector<int> recvDispls(nProcs,0);
+  for(int p=1; p<nProcs; p++)
+    recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+  vector<int> recvRows(recvDispls[nProcs-1] + recvCounts[nProcs-1]);
+  _comm.Alltoallv(sendRows.empty() ? 0 : &sendRows[0], &sendCounts[0],
+                  &sendDispls[0], MPI::INT,
+                  recvRows.empty() ? 0 : &recvRows[0], &recvCounts[0],
+                  &recvDispls[0], MPI::INT);
+
+  for(int p=0; p<nProcs; p++)
+  {
+      if (sendCounts[p] == 0 && recvCounts[p] == 0)
+        continue;
+
+      const int proc = ranks[p];
+      shared_ptr<StorageSite> ghostSite(new StorageSite(-1));
+      ghostSite->setGatherProcID(proc);
+      ghostSite->setScatterProcID(_rank);
+      ghostSite->setTag((std::max(_rank,proc) << 16) | std::min(_rank,proc));
+      _ghostSites[proc] = ghostSite;
+
+      shared_ptr<Array<int> > toIndices(new Array<int>(sendCounts[p]));
+      for(int i=0; i<sendCounts[p]; i++)
+        (*toIndices)[i] = nSelf + ghostPositions[p][i];
+      _site->getGatherMap()[ghostSite.get()] = toIndices;
+
+      shared_ptr<Array<int> > fromIndices(new Array<int>(recvCounts[p]));
+      for(int i=0; i<recvCounts[p]; i++)
+        (*fromIndices)[i] = recvRows[recvDispls[p]+i];
+      _site->getScatterMap()[ghostSite.get()] = fromIndices;
+  }
+}
+
+void
+LinearSystemAgglomerator::gatherMatrix()
+{
+  const Matrix& m = _ls.getMatrix().getMatrix(_index,_index);
+  const int nSelf = _index.second->getSelfCount();
+
+  const char *offDiag = static_cast<const char*>(m.getOffDiagData());
+  const int nKept = int(_keptOffDiag.size());
+  for(int i=0; i<nKept; i++)
+    memcpy(&_offDiagBuffer[i*_offDiagEntrySize],
+           offDiag + _keptOffDiag[i]*_offDiagEntrySize, _offDiagEntrySize);
+
+  _groupComm.Gatherv(m.getDiagData(), nSelf*_diagEntrySize, MPI::BYTE,
+                     _isActive ? _matrix->getDiagData() : 0,
+                     &_diagBytes[0], &_diagDispls[0], MPI::BYTE, 0);
+  _groupComm.Gatherv(_offDiagBuffer.empty() ? 0 : &_offDiagBuffer[0],
+                     int(_offDiagBuffer.size()), MPI::BYTE,
+                     _isActive ? _matrix->getOffDiagData() : 0,
+                     &_offDiagBytes[0], &_offDiagDispls[0], MPI::BYTE, 0);
+}
+
+void
+LinearSystemAgglomerator::gatherB()
+{
+  const ArrayBase& b = _ls.getB()[_index];
+  const int nSelf = _index.second->getSelfCount();
+  const int bytes = b.getLength() > 0 ? nSelf*(b.getDataSize()/b.getLength()) : 0;
+
+  void *agglomeratedB = 0;
+  if (_isActive)
+  {
+      _agglomeratedLS->getDelta().zero();
+      agglomeratedB = _agglomeratedLS->getB()[_agglomeratedLS->getB().getArrayIndex(0)].getData();
+  }
+
+  _groupComm.Gatherv(b.getData(), bytes, MPI::BYTE, agglomeratedB,
+                     &_selfBytes[0], &_selfDispls[0], MPI::BYTE, 0);
+}
+
+void
+LinearSystemAgglomerator::scatterDelta()
+{
+  ArrayBase& delta = _ls.getDelta()[_index];
+  const int nSelf = _index.second->getSelfCount();
+  const int bytes = delta.getLength() > 0 ? nSelf*(delta.getDataSize()/delta.getLength()) : 0;
+
+  const void *agglomeratedDelta = 0;
+  if (_isActive)
+    agglomeratedDelta = _agglomeratedLS->getDelta()[_agglomeratedLS->getDelta().getArrayIndex(0)].getData();
+
+  _groupComm.Scatterv(agglomeratedDelta, &_selfBytes[0], &_selfDispls[0],
+                      MPI::BYTE, delta.getData(), bytes, MPI::BYTE, 0);
+}
+
+#endif
@@ -0,0 +1,98 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _LINEARSYSTEMAGGLOMERATOR_H_
+#define _LINEARSYSTEMAGGLOMERATOR_H_
+#ifdef FVM_PARALLEL
+
+#include <mpi.h>
+#include "LinearSystem.h"
+#include <map>
+#include <vector>
+
+/**
+ * Moves a linear system distributed over the processes of comm onto
+ * fewer of them. The processes are taken in groups of factor
+ * consecutive ranks of comm and the rows of each group are moved to
+ * its first process. Unlike LinearSystemMerger the groups keep their
+ * interfaces with each other: the agglomerated system has ghost rows
+ * for the rows of the other groups that it is coupled to, and scatter
+ * and gather maps for exchanging them, so it can be smoothed and
+ * coarsened further on the processes that hold it.
+ *
+ * The agglomerated system has its own delta, b and residual. gatherB
+ * moves b there from the system on comm and scatterDelta moves the
+ * solution back; the residual is computed where the rows are. Only
+ * systems with a single array per process and a CRMatrix for it are
+ * supported, see isSupported, which must hold on all the processes.
+ *
+ * All the processes of comm construct the agglomerator and take part
+ * in gatherMatrix, gatherB and scatterDelta. Only those for which
+ * isActive is true hold a part of the agglomerated system, and getComm
+ * is the communicator of those processes (MPI::COMM_NULL elsewhere).
+ *
+ */
+
+class LinearSystemAgglomerator
+{
+public:
+
+  LinearSystemAgglomerator(const MPI::Intracomm& comm, const int factor,
+                           LinearSystem& ls);
+  ~LinearSystemAgglomerator();
+
+  static bool isSupported(LinearSystem& ls);
+
+  // copy the coefficients of the matrix of ls to the agglomerated system
+  void gatherMatrix();
+  void gatherB();
+  void scatterDelta();
+
+  bool isActive() const {return _isActive;}
+  const MPI::Intracomm& getComm() const {return _comm;}
+  shared_ptr<LinearSystem> getLS() {return _agglomeratedLS;}
+
+private:
+  LinearSystemAgglomerator(const LinearSystemAgglomerator&);
+
+  typedef pair<int,int> RowID; // (process, row) in the agglomerated system
+
+  void createGroups(const MPI::Intracomm& comm, const int factor);
+  void createSite(const vector<int>& rowCounts, const vector<RowID>& cols);
+  void createMaps(const vector<RowID>& ghosts);
+
+  LinearSystem& _ls;
+  MultiField::ArrayIndex _index;
+
+  MPI::Intracomm _groupComm;
+  MPI::Intracomm _comm;
+  bool _isActive;
+  int _rank;
+
+  // the self row counts of the members of the group and, on its first
+  // process, the sizes in bytes of their rows and kept off diagonals
+  vector<int> _selfCounts;
+  vector<int> _selfBytes;
+  vector<int> _selfDispls;
+  vector<int> _diagBytes;
+  vector<int> _diagDispls;
+  vector<int> _offDiagBytes;
+  vector<int> _offDiagDispls;
+
+  // the off diagonal entries of ls that are kept, i.e. not coupled to
+  // a boundary row, in their order
+  vector<int> _keptOffDiag;
+  vector<char> _offDiagBuffer;
+  int _diagEntrySize;
+  int _offDiagEntrySize;
+
+  shared_ptr<StorageSite> _site;
+  map<int, shared_ptr<StorageSite> > _ghostSites;
+  shared_ptr<CRConnectivity> _conn;
+  shared_ptr<Matrix> _matrix;
+  shared_ptr<LinearSystem> _agglomeratedLS;
+};
+
+#endif
+#endif
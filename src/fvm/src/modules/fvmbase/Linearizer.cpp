@@ -10,7 +10,8 @@
 #include "Discretization.h"
 //#include <omp.h>
 
-Linearizer::Linearizer()
+Linearizer::Linearizer(const bool threadedAssembly) :
+  _threadedAssembly(threadedAssembly)
 {}
 
 void
@@ -20,8 +21,13 @@ Linearizer::linearize(DiscrList& discretizations,
 {
   const int nMeshes = meshes.size();
   const int nDiscretizations = discretizations.size();
+
+  for(int nd=0; nd<nDiscretizations; nd++)
+    discretizations[nd]->setThreadedAssembly(_threadedAssembly);
   
-  //#pragma omp parallel for
+  // meshes are visited serially since the discretizations share
+  // lazily built per mesh data; the parallelism is within each
+  // discretization's face and cell loops
   for(int n=0; n<nMeshes; n++)
   {
       const Mesh& mesh = *meshes[n];
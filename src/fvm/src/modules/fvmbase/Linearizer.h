@@ -16,11 +16,17 @@ class MultiField;
 class Linearizer
 {
 public:
-  Linearizer();
+
+  // with threadedAssembly the discretizations are asked to run their
+  // face loops on coloured face sets so that they can be shared among
+  // threads (see Discretization::setThreadedAssembly)
+  Linearizer(const bool threadedAssembly=false);
 
   virtual void linearize(DiscrList& discretizations,
                          const MeshList& meshes, MultiFieldMatrix& matrix,
                          MultiField& x, MultiField& b);
+private:
+  const bool _threadedAssembly;
 };
 
 #endif
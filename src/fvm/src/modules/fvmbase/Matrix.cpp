@@ -36,6 +36,78 @@ Matrix::createCoarseMatrix(const IContainer& coarseIndex,
   throw CException("createCoarseMatrix not implemented");
 }
 
+void
+Matrix::updateCoarseMatrix(const IContainer& coarseIndex,
+                           const CRConnectivity& coarseToFine,
+                           Matrix& coarseMatrix)
+{
+  throw CException("updateCoarseMatrix not implemented");
+}
+
+int
+Matrix::createStrengthCoarsening(IContainer& coarseIndex,
+                                 const double strengthThreshold,
+                                 const bool classical)
+{
+  throw CException("createStrengthCoarsening not implemented");
+}
+
+shared_ptr<CRConnectivity>
+Matrix::createProlongationConnectivity(const IContainer& coarseIndex,
+                                       const StorageSite& coarseSite,
+                                       const double strengthThreshold,
+                                       const bool classical) const
+{
+  throw CException("createProlongationConnectivity not implemented");
+}
+
+void
+Matrix::updateProlongator(Matrix& prolongator,
+                          const IContainer& coarseIndex,
+                          const double strengthThreshold,
+                          const bool classical,
+                          const double smoothing) const
+{
+  throw CException("updateProlongator not implemented");
+}
+
+shared_ptr<CRConnectivity>
+Matrix::createGalerkinConnectivity(const Matrix& rowProlongator,
+                                   const Matrix& colProlongator,
+                                   const StorageSite& coarseRowSite,
+                                   const StorageSite& coarseColSite) const
+{
+  throw CException("createGalerkinConnectivity not implemented");
+}
+
+shared_ptr<Matrix>
+Matrix::createGalerkinMatrix(const Matrix& rowProlongator,
+                             const Matrix& colProlongator,
+                             const CRConnectivity& coarseConnectivity) const
+{
+  throw CException("createGalerkinMatrix not implemented");
+}
+
+void
+Matrix::updateGalerkinMatrix(const Matrix& rowProlongator,
+                             const Matrix& colProlongator,
+                             Matrix& coarseMatrix) const
+{
+  throw CException("updateGalerkinMatrix not implemented");
+}
+
+shared_ptr<Matrix>
+Matrix::createSinglePrecisionMatrix() const
+{
+  throw CException("createSinglePrecisionMatrix not implemented");
+}
+
+void
+Matrix::updateSinglePrecisionMatrix(Matrix& spMatrix) const
+{
+  throw CException("updateSinglePrecisionMatrix not implemented");
+}
+
 void
 Matrix::multiply(IContainer& yB, const IContainer& xB) const
 {
@@ -48,6 +120,13 @@ Matrix::multiplyAndAdd(IContainer& yB, const IContainer& xB) const
   throw CException("multiplyAndAdd not implemented");
 }
 
+void
+Matrix::multiplyAndAddRows(IContainer& yB, const IContainer& xB,
+                           const Array<int>& rows) const
+{
+  throw CException("multiplyAndAddRows not implemented");
+}
+
 void Matrix::forwardGS(IContainer& xB, IContainer& bB,
                        IContainer& residual) const
 {
@@ -66,6 +145,36 @@ void Matrix::Jacobi(IContainer&, const IContainer&,
   throw CException("Jacobi not implemented");
 }
 
+void Matrix::forwardColoredGS(IContainer& xB, IContainer& bB,
+                              IContainer& residual) const
+{
+  forwardGS(xB,bB,residual);
+}
+
+void Matrix::reverseColoredGS(IContainer& xB, IContainer& bB,
+                              IContainer& residual) const
+{
+  reverseGS(xB,bB,residual);
+}
+
+void Matrix::forwardBlockGS(IContainer& xB, IContainer& bB,
+                            IContainer& residual) const
+{
+  forwardGS(xB,bB,residual);
+}
+
+void Matrix::reverseBlockGS(IContainer& xB, IContainer& bB,
+                            IContainer& residual) const
+{
+  reverseGS(xB,bB,residual);
+}
+
+void Matrix::l1Jacobi(IContainer& xnew, const IContainer& xold,
+                      const IContainer& b) const
+{
+  Jacobi(xnew,xold,b);
+}
+
 void Matrix::iluSolve(IContainer&, const IContainer&,
                        const IContainer&) const
 {
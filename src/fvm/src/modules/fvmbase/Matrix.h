@@ -13,6 +13,7 @@ class CRConnectivity;
 class LinearSystemMerger;
 class SpikeStorage;
 class ArrayBase;
+template<class T> class Array;
 class Matrix
 {
 public:
@@ -25,6 +26,13 @@ public:
   
   virtual void multiply(IContainer& yB, const IContainer& xB) const;
   virtual void multiplyAndAdd(IContainer& yB, const IContainer& xB) const;
+
+  // y += this * x for the listed rows only, which lets the rows sent
+  // to other processes be computed first and the rest while they are
+  // in transit. Only available when hasRowProducts is true.
+  virtual bool hasRowProducts() const {return false;}
+  virtual void multiplyAndAddRows(IContainer& yB, const IContainer& xB,
+                                  const Array<int>& rows) const;
   virtual shared_ptr<ArrayBase>  quadProduct(const IContainer& xB) const {throw;}
   
   virtual void forwardGS(IContainer& xB, IContainer& bB,
@@ -33,6 +41,19 @@ public:
                          IContainer& residual) const;
   virtual void Jacobi(IContainer& xnew, const IContainer& xold,
                          const IContainer& b) const;
+
+  // threaded variants of the smoothers above; the defaults fall back
+  // to the sequential versions
+  virtual void forwardColoredGS(IContainer& xB, IContainer& bB,
+                                IContainer& residual) const;
+  virtual void reverseColoredGS(IContainer& xB, IContainer& bB,
+                                IContainer& residual) const;
+  virtual void forwardBlockGS(IContainer& xB, IContainer& bB,
+                              IContainer& residual) const;
+  virtual void reverseBlockGS(IContainer& xB, IContainer& bB,
+                              IContainer& residual) const;
+  virtual void l1Jacobi(IContainer& xnew, const IContainer& xold,
+                        const IContainer& b) const;
   virtual void iluSolve(IContainer& xB, const IContainer& bB,
                         const IContainer& residual) const;
   virtual void spikeSolve(IContainer& xB, const IContainer& bB,
@@ -55,10 +76,20 @@ public:
   virtual int   getDiagDataSize() const {throw;}
   virtual int   getOffDiagDataSize() const {throw;}
   virtual shared_ptr<Matrix> createMergeMatrix( const LinearSystemMerger& mergeLS ) { throw;}
+  // an empty matrix of the same type for the given connectivity, used
+  // by LinearSystemAgglomerator, which copies the coefficients bytewise
+  virtual shared_ptr<Matrix> createAgglomeratedMatrix(const CRConnectivity& conn) const { throw;}
 
   virtual void setFlatMatrix(Matrix& fmg) const {throw;}
+  virtual void setFlatMatrix(Matrix& fmg,
+                             const Array<int>& flatPositions) const {throw;}
 
   virtual void transpose() {throw;}
+
+  // a copy of this matrix with the coefficients in single precision
+  // and its update from the current values of this matrix
+  virtual shared_ptr<Matrix> createSinglePrecisionMatrix() const;
+  virtual void updateSinglePrecisionMatrix(Matrix& spMatrix) const;
   
   virtual shared_ptr<CRConnectivity>
   createCoarseConnectivity(const IContainer& coarseIndex,
@@ -69,6 +100,47 @@ public:
   createCoarseMatrix(const IContainer& coarseIndex,
                      const CRConnectivity& coarseToFine,
                      const CRConnectivity& coarseConnectivity);
+  virtual void
+  updateCoarseMatrix(const IContainer& coarseIndex,
+                     const CRConnectivity& coarseToFine,
+                     Matrix& coarseMatrix);
+
+  /**
+   * used by the alternative coarsening options of AMG: the splitting
+   * or aggregation of the rows along the strong connections of the
+   * matrix, the prolongation for it and the Galerkin coarse matrix
+   * P^T A P. The prolongators are CRMatrixTranspose objects mapping
+   * the coarse site to the fine one.
+   *
+   */
+
+  virtual int createStrengthCoarsening(IContainer& coarseIndex,
+                                       const double strengthThreshold,
+                                       const bool classical);
+  virtual shared_ptr<CRConnectivity>
+  createProlongationConnectivity(const IContainer& coarseIndex,
+                                 const StorageSite& coarseSite,
+                                 const double strengthThreshold,
+                                 const bool classical) const;
+  virtual void
+  updateProlongator(Matrix& prolongator,
+                    const IContainer& coarseIndex,
+                    const double strengthThreshold,
+                    const bool classical,
+                    const double smoothing) const;
+  virtual shared_ptr<CRConnectivity>
+  createGalerkinConnectivity(const Matrix& rowProlongator,
+                             const Matrix& colProlongator,
+                             const StorageSite& coarseRowSite,
+                             const StorageSite& coarseColSite) const;
+  virtual shared_ptr<Matrix>
+  createGalerkinMatrix(const Matrix& rowProlongator,
+                       const Matrix& colProlongator,
+                       const CRConnectivity& coarseConnectivity) const;
+  virtual void
+  updateGalerkinMatrix(const Matrix& rowProlongator,
+                       const Matrix& colProlongator,
+                       Matrix& coarseMatrix) const;
 
   virtual bool isInvertible() {return false;} 
   
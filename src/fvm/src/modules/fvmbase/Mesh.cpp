@@ -3,6 +3,8 @@
 // See LICENSE file for terms.
 
 #include <set>
+#include <algorithm>
+#include <boost/cstdint.hpp>
 #include "Mesh.h"
 #include "StorageSite.h"
 #include "CRConnectivity.h"
@@ -398,6 +400,54 @@ Mesh::getFaceCells(const StorageSite& faces) const
   return *thisFaceCells;
 }
 
+const CRConnectivity&
+Mesh::getFaceColors(const StorageSite& faces) const
+{
+  map<const StorageSite*, shared_ptr<StorageSite> >::const_iterator pos =
+    _faceColorSites.find(&faces);
+  if (pos != _faceColorSites.end())
+    return getConnectivity(*pos->second,faces);
+
+  shared_ptr<StorageSite> colorSite(new StorageSite(0));
+  shared_ptr<CRConnectivity> faceColors =
+    getFaceCells(faces).getRowColoring(*colorSite);
+
+  SSPair key(colorSite.get(),&faces);
+  _faceColorSites[&faces] = colorSite;
+  _connectivityMap[key] = faceColors;
+  return *faceColors;
+}
+
+const CRConnectivity&
+Mesh::getCellColoring(const int distance) const
+{
+  if (distance != 1 && distance != 2)
+    throw CException("Mesh::getCellColoring: distance must be 1 or 2");
+
+  map<int, shared_ptr<StorageSite> >::const_iterator pos =
+    _cellColorSites.find(distance);
+  if (pos != _cellColorSites.end())
+    return getConnectivity(*pos->second,_cells);
+
+  // ghost cells are left out of the colouring; the product is used
+  // rather than getCellCells2 since the latter renumbers the face cells
+  // of partitioned meshes
+  const CRConnectivity& cellCells = getCellCells();
+  shared_ptr<CRConnectivity> adjacencyPtr;
+  if (distance == 2)
+    adjacencyPtr = cellCells.multiply(cellCells,false);
+  const CRConnectivity& adjacency = adjacencyPtr ? *adjacencyPtr : cellCells;
+
+  shared_ptr<StorageSite> colorSite(new StorageSite(0));
+  shared_ptr<CRConnectivity> cellColors =
+    adjacency.getAdjacencyColoring(*colorSite,_cells.getSelfCount());
+
+  SSPair key(colorSite.get(),&_cells);
+  _cellColorSites[distance] = colorSite;
+  _connectivityMap[key] = cellColors;
+  return *cellColors;
+}
+
 const CRConnectivity&
 Mesh::getFaceNodes(const StorageSite& faces) const
 {
@@ -682,6 +732,473 @@ Mesh::uniqueFaceCells()
      }
 }
 
+// breadth first search from seed over the interior cells that have not
+// been numbered yet; cells holds the cells found, level by level, and
+// lastLevelStart the position of the last level in it
+static int
+findCellLevels(const CRConnectivity& cellCells, const int selfCount,
+               const vector<bool>& numbered, vector<int>& mark,
+               const int stamp, const int seed,
+               vector<int>& cells, int& lastLevelStart)
+{
+  cells.clear();
+  cells.push_back(seed);
+  mark[seed] = stamp;
+
+  int nLevels = 0;
+  int levelStart = 0;
+  while (levelStart < int(cells.size()))
+  {
+      const int levelEnd = int(cells.size());
+      lastLevelStart = levelStart;
+      nLevels++;
+      for(int i=levelStart; i<levelEnd; i++)
+      {
+          const int c = cells[i];
+          for(int j=0; j<cellCells.getCount(c); j++)
+          {
+              const int nb = cellCells(c,j);
+              if (nb < selfCount && !numbered[nb] && mark[nb] != stamp)
+              {
+                  mark[nb] = stamp;
+                  cells.push_back(nb);
+              }
+          }
+      }
+      levelStart = levelEnd;
+  }
+  return nLevels;
+}
+
+// the position along a Hilbert curve of the point with the given
+// coordinates of nBits bits each, using the transform described by
+// Skilling, "Programming the Hilbert curve" (2004)
+static boost::uint64_t
+getHilbertIndex(unsigned int x[], const int nDim, const int nBits)
+{
+  const unsigned int m = 1u << (nBits-1);
+
+  for(unsigned int q=m; q>1; q>>=1)
+  {
+      const unsigned int p = q-1;
+      for(int i=0; i<nDim; i++)
+      {
+          if (x[i] & q)
+            x[0] ^= p;
+          else
+          {
+              const unsigned int t = (x[0] ^ x[i]) & p;
+              x[0] ^= t;
+              x[i] ^= t;
+          }
+      }
+  }
+
+  for(int i=1; i<nDim; i++)
+    x[i] ^= x[i-1];
+  unsigned int t = 0;
+  for(unsigned int q=m; q>1; q>>=1)
+    if (x[nDim-1] & q)
+      t ^= q-1;
+  for(int i=0; i<nDim; i++)
+    x[i] ^= t;
+
+  // interleave the bits of the coordinates
+  boost::uint64_t index = 0;
+  for(int b=nBits-1; b>=0; b--)
+    for(int i=0; i<nDim; i++)
+      index = (index << 1) | ((x[i] >> b) & 1u);
+  return index;
+}
+
+// puts the first entries of the array in the given order, the others
+// stay where they are
+static void
+permuteArray(ArrayBase& a, const Array<int>& oldOfNew)
+{
+  const int n = oldOfNew.getLength();
+  if (a.getLength() < n)
+    throw CException("Mesh::reorder: array is shorter than its site");
+  shared_ptr<ArrayBase> permuted = a.newSizedClone(n);
+  a.scatter(*permuted, oldOfNew);
+  a.copyPartial(*permuted, 0, n);
+}
+
+static shared_ptr<Array<int> >
+getInverseOrder(const Array<int>& oldOfNew, const int length)
+{
+  shared_ptr<Array<int> > newOfOldPtr(new Array<int>(length));
+  Array<int>& newOfOld = *newOfOldPtr;
+  for(int i=0; i<length; i++)
+    newOfOld[i] = i;
+  for(int i=0; i<oldOfNew.getLength(); i++)
+    newOfOld[oldOfNew[i]] = i;
+  return newOfOldPtr;
+}
+
+static int
+renumberIndex(const int i, const Array<int>& newOfOld)
+{
+  return (i >= 0 && i < newOfOld.getLength()) ? newOfOld[i] : i;
+}
+
+// renumbers the indices held in the scatter, gather and common maps of
+// the site, each array only once even if it is in more than one map
+static void
+renumberSiteMaps(StorageSite& site, const Array<int>& newOfOld)
+{
+  set<Array<int>*> arrays;
+  foreach(StorageSite::ScatterMap::value_type& pos, site.getScatterMap())
+    arrays.insert(pos.second.get());
+  foreach(StorageSite::GatherMap::value_type& pos, site.getGatherMap())
+    arrays.insert(pos.second.get());
+  foreach(StorageSite::ScatterMap::value_type& pos, site.getScatterMapLevel1())
+    arrays.insert(pos.second.get());
+  foreach(StorageSite::GatherMap::value_type& pos, site.getGatherMapLevel1())
+    arrays.insert(pos.second.get());
+  foreach(StorageSite::CommonMap::value_type& pos, site.getCommonMap())
+    arrays.insert(pos.second.get());
+
+  foreach(Array<int>* indicesPtr, arrays)
+  {
+      Array<int>& indices = *indicesPtr;
+      for(int i=0; i<indices.getLength(); i++)
+        indices[i] = renumberIndex(indices[i],newOfOld);
+  }
+  site.clearInterfaceIndices();
+}
+
+shared_ptr<Array<int> >
+Mesh::createRCMCellOrder() const
+{
+  const int selfCount = _cells.getSelfCount();
+  const CRConnectivity& cellCells = getCellCells();
+
+  // degrees in the graph of the interior cells
+  vector<int> degree(selfCount,0);
+  vector<pair<int,int> > byDegree(selfCount);
+  for(int c=0; c<selfCount; c++)
+  {
+      for(int j=0; j<cellCells.getCount(c); j++)
+        if (cellCells(c,j) < selfCount)
+          degree[c]++;
+      byDegree[c] = make_pair(degree[c],c);
+  }
+  sort(byDegree.begin(),byDegree.end());
+
+  vector<bool> numbered(selfCount,false);
+  vector<int> mark(selfCount,0);
+  vector<int> order;
+  vector<int> cells;
+  vector<pair<int,int> > neighbours;
+  order.reserve(selfCount);
+  int stamp = 0;
+
+  // each connected set of cells is numbered starting from a pseudo
+  // peripheral cell, found as suggested by George and Liu
+  for(int n=0; n<selfCount; n++)
+  {
+      int seed = byDegree[n].second;
+      if (numbered[seed])
+        continue;
+
+      int lastLevelStart = 0;
+      int nLevels = findCellLevels(cellCells,selfCount,numbered,mark,++stamp,
+                                   seed,cells,lastLevelStart);
+      for(;;)
+      {
+          int next = cells[lastLevelStart];
+          for(int i=lastLevelStart+1; i<int(cells.size()); i++)
+            if (degree[cells[i]] < degree[next])
+              next = cells[i];
+
+          const int nNextLevels =
+            findCellLevels(cellCells,selfCount,numbered,mark,++stamp,
+                           next,cells,lastLevelStart);
+          if (nNextLevels <= nLevels)
+            break;
+          seed = next;
+          nLevels = nNextLevels;
+      }
+
+      // Cuthill-McKee, the neighbours of each cell being numbered in
+      // the order of increasing degree
+      size_t i = order.size();
+      order.push_back(seed);
+      numbered[seed] = true;
+      for(; i<order.size(); i++)
+      {
+          const int c = order[i];
+          neighbours.clear();
+          for(int j=0; j<cellCells.getCount(c); j++)
+          {
+              const int nb = cellCells(c,j);
+              if (nb < selfCount && !numbered[nb])
+              {
+                  numbered[nb] = true;
+                  neighbours.push_back(make_pair(degree[nb],nb));
+              }
+          }
+          sort(neighbours.begin(),neighbours.end());
+          for(size_t k=0; k<neighbours.size(); k++)
+            order.push_back(neighbours[k].second);
+      }
+  }
+
+  shared_ptr<Array<int> > cellOrderPtr(new Array<int>(selfCount));
+  Array<int>& cellOrder = *cellOrderPtr;
+  for(int c=0; c<selfCount; c++)
+    cellOrder[c] = order[selfCount-1-c];
+  return cellOrderPtr;
+}
+
+shared_ptr<Array<int> >
+Mesh::createHilbertCellOrder() const
+{
+  const int selfCount = _cells.getSelfCount();
+  const int nFaces = _faces.getCount();
+  const CRConnectivity& faceCells = getAllFaceCells();
+  const CRConnectivity& faceNodes = getAllFaceNodes();
+  const Array<VecD3>& coords = *_coordinates;
+
+  // the average of the face centres is close enough to the centroid
+  // for ordering the cells
+  Array<VecD3> xc(selfCount);
+  Array<int> nCellFaces(selfCount);
+  xc.zero();
+  nCellFaces = 0;
+  for(int f=0; f<nFaces; f++)
+  {
+      VecD3 xf(VecD3::getZero());
+      const int nFaceNodes = faceNodes.getCount(f);
+      for(int j=0; j<nFaceNodes; j++)
+        xf += coords[faceNodes(f,j)];
+      xf /= double(nFaceNodes);
+
+      for(int j=0; j<faceCells.getCount(f); j++)
+      {
+          const int c = faceCells(f,j);
+          if (c < selfCount)
+          {
+              xc[c] += xf;
+              nCellFaces[c]++;
+          }
+      }
+  }
+
+  VecD3 xmin(VecD3::getZero());
+  VecD3 xmax(VecD3::getZero());
+  for(int c=0; c<selfCount; c++)
+  {
+      if (nCellFaces[c] > 0)
+        xc[c] /= double(nCellFaces[c]);
+      for(int d=0; d<3; d++)
+      {
+          if (c == 0 || xc[c][d] < xmin[d])
+            xmin[d] = xc[c][d];
+          if (c == 0 || xc[c][d] > xmax[d])
+            xmax[d] = xc[c][d];
+      }
+  }
+
+  const int nDim = (_dimension == 2) ? 2 : 3;
+  const int nBits = 21;
+  const double maxCoord = double((1u << nBits) - 1);
+
+  vector<pair<boost::uint64_t,int> > keys(selfCount);
+  for(int c=0; c<selfCount; c++)
+  {
+      unsigned int x[3];
+      for(int d=0; d<nDim; d++)
+      {
+          const double extent = xmax[d] - xmin[d];
+          x[d] = (extent > 0) ?
+            (unsigned int) ((xc[c][d] - xmin[d])/extent*maxCoord) : 0;
+      }
+      keys[c] = make_pair(getHilbertIndex(x,nDim,nBits),c);
+  }
+  sort(keys.begin(),keys.end());
+
+  shared_ptr<Array<int> > cellOrderPtr(new Array<int>(selfCount));
+  Array<int>& cellOrder = *cellOrderPtr;
+  for(int c=0; c<selfCount; c++)
+    cellOrder[c] = keys[c].second;
+  return cellOrderPtr;
+}
+
+void
+Mesh::reorder(const CellOrdering ordering)
+{
+  if (_repeatNodes || _ibFaceList)
+    throw CException("Mesh::reorder: must be called before the mesh is coupled");
+
+  // connectivities to sites of other objects (particles, ib faces
+  // etc.) can't be renumbered here
+  set<const StorageSite*> ownSites;
+  ownSites.insert(&_cells);
+  ownSites.insert(&_faces);
+  ownSites.insert(&_nodes);
+  foreach(const FaceGroupPtr fgPtr, _faceGroups)
+    ownSites.insert(&fgPtr->site);
+  for(map<const StorageSite*, shared_ptr<StorageSite> >::const_iterator pos =
+        _faceColorSites.begin(); pos != _faceColorSites.end(); ++pos)
+    ownSites.insert(pos->second.get());
+  for(map<int, shared_ptr<StorageSite> >::const_iterator pos =
+        _cellColorSites.begin(); pos != _cellColorSites.end(); ++pos)
+    ownSites.insert(pos->second.get());
+  foreach(const ConnectivityMap::value_type& pos, _connectivityMap)
+  {
+      if (!ownSites.count(pos.first.first) || !ownSites.count(pos.first.second))
+        throw CException("Mesh::reorder: mesh has connectivities to other sites");
+  }
+
+  const int nCells = _cells.getCountLevel1();
+  const int nFaces = _faces.getCount();
+  const int nNodes = _nodes.getCount();
+  const StorageSite& interiorFaces = _interiorFaceGroup->site;
+  const int faceOffset = interiorFaces.getOffset();
+  const int nInteriorFaces = interiorFaces.getCount();
+
+  CRConnectivity& faceCells = getAllFaceCells();
+  CRConnectivity& faceNodes = const_cast<CRConnectivity&>(getAllFaceNodes());
+
+  shared_ptr<Array<int> > cellOrder = (ordering == CELL_ORDER_HILBERT) ?
+    createHilbertCellOrder() : createRCMCellOrder();
+  shared_ptr<Array<int> > newCellsPtr = getInverseOrder(*cellOrder,nCells);
+  const Array<int>& newCells = *newCellsPtr;
+  faceCells.reorder(newCells);
+
+  // interior faces, sorted by their lower numbered and then by their
+  // other cell
+  vector<pair<pair<int,int>,int> > faceKeys(nInteriorFaces);
+  for(int i=0; i<nInteriorFaces; i++)
+  {
+      const int f = faceOffset + i;
+      const int c0 = faceCells(f,0);
+      const int c1 = faceCells(f,1);
+      faceKeys[i] = make_pair(make_pair(min(c0,c1),max(c0,c1)),f);
+  }
+  sort(faceKeys.begin(),faceKeys.end());
+
+  shared_ptr<Array<int> > faceOrder(new Array<int>(faceOffset+nInteriorFaces));
+  for(int f=0; f<faceOffset; f++)
+    (*faceOrder)[f] = f;
+  for(int i=0; i<nInteriorFaces; i++)
+    (*faceOrder)[faceOffset+i] = faceKeys[i].second;
+  faceCells.permuteRows(*faceOrder);
+  faceNodes.permuteRows(*faceOrder);
+  shared_ptr<Array<int> > newFacesPtr = getInverseOrder(*faceOrder,nFaces);
+  const Array<int>& newFaces = *newFacesPtr;
+
+  // nodes, in the order the faces use them
+  shared_ptr<Array<int> > nodeOrder(new Array<int>(nNodes));
+  shared_ptr<Array<int> > newNodesPtr(new Array<int>(nNodes));
+  Array<int>& newNodes = *newNodesPtr;
+  newNodes = -1;
+  int nNumbered = 0;
+  const Array<int>& faceNodeRow = faceNodes.getRow();
+  const Array<int>& faceNodeCol = faceNodes.getCol();
+  for(int j=faceNodeRow[0]; j<faceNodeRow[nFaces]; j++)
+  {
+      const int n = faceNodeCol[j];
+      if (newNodes[n] == -1)
+      {
+          newNodes[n] = nNumbered;
+          (*nodeOrder)[nNumbered++] = n;
+      }
+  }
+  for(int n=0; n<nNodes; n++)
+    if (newNodes[n] == -1)
+    {
+        newNodes[n] = nNumbered;
+        (*nodeOrder)[nNumbered++] = n;
+    }
+  faceNodes.reorder(newNodes);
+  if (_coordinates)
+    permuteArray(*_coordinates,*nodeOrder);
+
+  renumberSiteMaps(_cells,newCells);
+  renumberSiteMaps(_faces,newFaces);
+  renumberSiteMaps(_nodes,newNodes);
+
+  // data kept for the partitioning and the coupling
+  if (_localToGlobal)
+    permuteArray(*_localToGlobal,*cellOrder);
+  foreach(mapInt::value_type& pos, _globalToLocal)
+    pos.second = renumberIndex(pos.second,newCells);
+
+  multiMap cellCellsGlobal;
+  foreach(const multiMap::value_type& pos, _cellCellsGlobal)
+    cellCellsGlobal.insert(make_pair(renumberIndex(pos.first,newCells),
+                                     pos.second));
+  _cellCellsGlobal.swap(cellCellsGlobal);
+
+  if (_cellColor)
+    permuteArray(*_cellColor,*cellOrder);
+  if (_cellColorOther)
+    permuteArray(*_cellColorOther,*cellOrder);
+
+  if (_localToGlobalNodes)
+    permuteArray(*_localToGlobalNodes,*nodeOrder);
+  foreach(mapInt::value_type& pos, _globalToLocalNodes)
+    pos.second = renumberIndex(pos.second,newNodes);
+
+  set<int> boundaryNodesSet;
+  foreach(const int n, _boundaryNodesSet)
+    boundaryNodesSet.insert(renumberIndex(n,newNodes));
+  _boundaryNodesSet.swap(boundaryNodesSet);
+  _boundaryNodeGlobalToLocalPtr.reset();
+
+  mapInt commonFacesMap;
+  foreach(const mapInt::value_type& pos, _commonFacesMap)
+    commonFacesMap[renumberIndex(pos.first,newFaces)] = pos.second;
+  _commonFacesMap.swap(commonFacesMap);
+  foreach(mapInt::value_type& pos, _commonFacesMapOther)
+    pos.second = renumberIndex(pos.second,newFaces);
+
+  // the connectivities computed on demand are recreated when needed
+  const SSPair faceCellsKey(&_faces,&_cells);
+  const SSPair faceNodesKey(&_faces,&_nodes);
+  shared_ptr<CRConnectivity> faceCellsPtr = _connectivityMap[faceCellsKey];
+  shared_ptr<CRConnectivity> faceNodesPtr = _connectivityMap[faceNodesKey];
+  _connectivityMap.clear();
+  _connectivityMap[faceCellsKey] = faceCellsPtr;
+  _connectivityMap[faceNodesKey] = faceNodesPtr;
+  _faceColorSites.clear();
+  _cellColorSites.clear();
+  _cellCells2.reset();
+  _faceCells2.reset();
+  if (_cellCellsGhostExt)
+    createCellCellsGhostExt();
+
+  _cellOrder = cellOrder;
+  _faceOrder = faceOrder;
+  _nodeOrder = nodeOrder;
+}
+
+void
+Mesh::reorderField(Field& field) const
+{
+  const Field::ArrayMap& arrays = field.getArrayMap();
+  foreach(const Field::ArrayMap::value_type& pos, arrays)
+  {
+      const StorageSite* site = pos.first;
+      ArrayBase& a = *pos.second;
+      if (site == &_cells && _cellOrder)
+        permuteArray(a,*_cellOrder);
+      else if (site == &_faces && _faceOrder)
+        permuteArray(a,*_faceOrder);
+      else if (site == &_nodes && _nodeOrder)
+        permuteArray(a,*_nodeOrder);
+      // the interior face group starts at the first face; its array
+      // only needs to be reordered if it isn't part of one for all the
+      // faces
+      else if (site == &_interiorFaceGroup->site && _faceOrder &&
+               arrays.find(&_faces) == arrays.end())
+        permuteArray(a,*_faceOrder);
+  }
+}
+
 const Array<int>&
 Mesh::getIBFaceList() const
 {
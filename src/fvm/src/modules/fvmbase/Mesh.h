@@ -87,6 +87,20 @@ public:
       IBTYPE_REALBOUNDARY=-4,
       IBTYPE_UNKNOWN=-5
     };
+
+  /**
+   * orderings of the cells used by reorder. CELL_ORDER_RCM is the
+   * reverse Cuthill-McKee ordering of the cell adjacency graph,
+   * CELL_ORDER_HILBERT follows a Hilbert curve through the cell
+   * centroids.
+   * 
+   */
+
+  enum CellOrdering
+    {
+      CELL_ORDER_RCM,
+      CELL_ORDER_HILBERT
+    };
   
   Mesh(const int dimension);
   Mesh(const int dimension, const Array<VecD3>&  faceNodesCoord ); 
@@ -176,6 +190,15 @@ public:
   const CRConnectivity& getCellCells2() const;
   const CRConnectivity& getFaceCells2() const;
 
+  // colouring of the faces of the given site such that faces of the
+  // same colour do not share a cell, computed on demand
+  const CRConnectivity& getFaceColors(const StorageSite& site) const;
+
+  // colouring of the owned cells such that cells of the same colour are
+  // more than the given distance (1 or 2) apart in the cell to cell
+  // connectivity, computed on demand
+  const CRConnectivity& getCellColoring(const int distance) const;
+
   CRConnectivity& getAllFaceCells();
   
   const FaceGroup& getInteriorFaceGroup() const {return *_interiorFaceGroup;}
@@ -310,6 +333,25 @@ public:
   bool COMETfindCommonFaces(StorageSite& faces, StorageSite& otherFaces,
 			    const GeomFields& geomFields);
   
+  /**
+   * renumbers the mesh for locality: the interior cells are put in the
+   * given order, the interior faces are sorted by their lower numbered
+   * cell and the nodes are numbered in the order the faces first use
+   * them. Ghost cells and the faces of the boundary and interface
+   * groups keep their positions. The connectivities, the scatter,
+   * gather and common maps and the local to global maps are updated
+   * and the connectivities computed on demand are recreated.
+   * 
+   * It is meant to be called once the mesh has been read or
+   * partitioned and before the metrics are computed; arrays that
+   * fields already have on the mesh can be renumbered with
+   * reorderField.
+   * 
+   */
+
+  void reorder(const CellOrdering ordering);
+  void reorderField(Field& field) const;
+
   Mesh* extractBoundaryMesh();
   Mesh* extrude(int nz, double zmax, bool boundaryOnly=false);
 
@@ -405,6 +447,12 @@ protected:
   mutable shared_ptr<CRConnectivity> _cellCells2;
   mutable shared_ptr<CRConnectivity> _faceCells2;
 
+  // row sites (one row per colour) for the face colourings
+  mutable map<const StorageSite*, shared_ptr<StorageSite> > _faceColorSites;
+
+  // row sites for the cell colourings, by distance
+  mutable map<int, shared_ptr<StorageSite> > _cellColorSites;
+
   bool _isShell;
   bool _isDoubleShell;
   bool _isConnectedShell;
@@ -422,6 +470,11 @@ protected:
 
   PeriodicFacePairs _periodicFacePairs;
 
+  // the old index of each renumbered cell, face and node after reorder
+  shared_ptr<Array<int> > _cellOrder;
+  shared_ptr<Array<int> > _faceOrder;
+  shared_ptr<Array<int> > _nodeOrder;
+
 private:
   void createRowColSiteCRConn();
   void countCRConn();
@@ -429,6 +482,9 @@ private:
   int  getNumBounCells();
   int  get_request_size();
 
+  shared_ptr<Array<int> > createRCMCellOrder() const;
+  shared_ptr<Array<int> > createHilbertCellOrder() const;
+
       
   
   
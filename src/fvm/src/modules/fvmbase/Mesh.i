@@ -1,5 +1,6 @@
 %{
 #include "Mesh.h"
+#include "MeshSlice.h"
   %}
 
 //%include "Vector.i"
@@ -83,6 +84,12 @@ public:
       IBTYPE_REALBOUNDARY,
       IBTYPE_UNKNOWN
     };
+
+  enum CellOrdering
+    {
+      CELL_ORDER_RCM,
+      CELL_ORDER_HILBERT
+    };
 %extend{
   Mesh(const int dimension, const ArrayBase&  faceNodesCoord ) 
   {
@@ -160,6 +167,9 @@ public:
   void findCommonFaces(StorageSite& faces, StorageSite& otherFaces,
                        const GeomFields& geomFields);
   
+  void reorder(const CellOrdering ordering);
+  void reorderField(Field& field) const;
+
   Mesh* extractBoundaryMesh();
   Mesh* extrude(int nz, double zmax, bool boundaryOnly=false);
 
@@ -250,6 +260,14 @@ private:
 
 typedef std::vector<Mesh*> MeshList;
 
+struct MeshSlice
+{
+  int dimension;
+  int cellCount;
+  int nodeOffset;
+  int getFaceCount() const;
+};
+
 
 %template(MeshList) std::vector<Mesh*>;
 %template(MapInt)  std::map<int,int>;
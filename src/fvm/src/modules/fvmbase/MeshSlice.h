@@ -0,0 +1,67 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _MESHSLICE_H_
+#define _MESHSLICE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Vector.h"
+
+using namespace std;
+
+/**
+ * The part of a mesh that one process reads, so that a mesh can be
+ * partitioned without any process holding all of it. A slice has some
+ * of the faces of the mesh and a contiguous range of its nodes, with
+ * the cells and nodes of the faces in the global numbering of the
+ * whole mesh. Every face and every node of the mesh is in exactly one
+ * slice, and the node ranges of the processes follow each other in
+ * the order of their ranks.
+ *
+ * faceCells has two cells per face. The first cell of a boundary face
+ * is the one inside and the second is -1; the nodes of every face are
+ * ordered so that its normal points from the first cell to the second.
+ * faceGroups has the id of the face group (e.g. the Fluent zone) of
+ * every face and groupTypes the type of every group, which is the same
+ * on all the processes.
+ *
+ */
+
+struct MeshSlice
+{
+  typedef Vector<double,3> VecD3;
+
+  MeshSlice() :
+    dimension(0),
+    cellCount(0),
+    faceCells(),
+    faceNodesRow(1,0),
+    faceNodesCol(),
+    faceGroups(),
+    nodeOffset(0),
+    coords(),
+    groupTypes()
+  {}
+
+  int getFaceCount() const {return int(faceGroups.size());}
+
+  int dimension;
+  // the number of cells of the whole mesh
+  int cellCount;
+
+  vector<int> faceCells;
+  vector<int> faceNodesRow;
+  vector<int> faceNodesCol;
+  vector<int> faceGroups;
+
+  // the global id of the first node of coords
+  int nodeOffset;
+  vector<VecD3> coords;
+
+  map<int,string> groupTypes;
+};
+
+#endif
@@ -19,7 +19,8 @@ MultiField::MultiField():
   _length(0),
   _arrays(),
   _arrayIndices(),
-  _arrayMap()
+  _arrayMap(),
+  _syncInProgress(false)
 {
   logCtor();
 }
@@ -213,7 +214,7 @@ MultiField::operator*=(const MultiFieldReduction& alphaMF)
 }
 
 shared_ptr<MultiFieldReduction>
-MultiField::getOneNorm() const
+MultiField::getOneNorm(const bool sync) const
 {
   shared_ptr<MultiField> c(new MultiField());
   for(int i=0; i<_length; i++)
@@ -223,12 +224,12 @@ MultiField::getOneNorm() const
       c->addArray(_arrayIndices[i],
                   myArray.getOneNorm(thisSite.getSelfCount()));
   }
-  shared_ptr<MultiFieldReduction> r(c->reduceSum());
+  shared_ptr<MultiFieldReduction> r(c->reduceSum(sync));
   return r;
 }
 
 shared_ptr<MultiFieldReduction>
-MultiField::dotWith(const MultiField& ofield) const
+MultiField::dotWith(const MultiField& ofield, const bool sync) const
 {
   shared_ptr<MultiField> dotpField(new MultiField());
 
@@ -241,12 +242,12 @@ MultiField::dotWith(const MultiField& ofield) const
                           myArray.dotWith(otherArray, thisSite.getSelfCount()));
   }
 
-  shared_ptr<MultiFieldReduction> r(dotpField->reduceSum());
+  shared_ptr<MultiFieldReduction> r(dotpField->reduceSum(sync));
   return r;
 }
 
 shared_ptr<MultiFieldReduction>
-MultiField::reduceSum() const
+MultiField::reduceSum(const bool sync) const
 {
   shared_ptr<MultiFieldReduction> sum(new MultiFieldReduction());
   
@@ -261,7 +262,8 @@ MultiField::reduceSum() const
   }
 
 #ifdef FVM_PARALLEL 
-  sum->sync(); //global reduction operation for residual check;
+  if (sync)
+    sum->sync(); //global reduction operation for residual check;
 #endif
   return sum;
 }
@@ -273,6 +275,8 @@ MultiField::addArray(const MultiField::ArrayIndex& i, shared_ptr<ArrayBase> a)
   _arrays.push_back(a);
   _arrayIndices.push_back(i);
   ++_length;
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
 }
 
 
@@ -296,6 +300,8 @@ MultiField::removeArray(const ArrayIndex& aIndex)
         pos->second = currentValue-1;
   }
   _length = _arrays.size();
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
 }
 
 
@@ -355,328 +361,150 @@ MultiField::syncScatter(const ArrayIndex& i)
 
 
 void
-MultiField::syncScatterLevel1(const ArrayIndex& i)
-{
-
-  const  ArrayBase& thisArray  = *_arrays[_arrayMap[i]];
-  const  StorageSite& thisSite = *i.second;
-  if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-     const StorageSite::ScatterMap& scatterMap = thisSite.getScatterMapLevel1();
-
-     foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-     {
-        const StorageSite& oSite = *mpos.first;
-
-        ArrayIndex oIndex(i.first,&oSite);
-        // arrays are stored with (Sender,receiver) as the key
-        EntryIndex eIndex(i,oIndex);
-        const Array<int>& fromIndices = *(mpos.second);
-        if (_ghostArraysLevel1.find(eIndex) == _ghostArraysLevel1.end()){
-          _ghostArraysLevel1[eIndex] = thisArray.newSizedClone(fromIndices.getLength());
-        }
-
-        ArrayBase& ghostArray = *_ghostArraysLevel1[eIndex];
-        thisArray.scatter(ghostArray,fromIndices);
-     }
-  }
-
-}
-
-void
-MultiField::createSyncGatherArrays(const ArrayIndex& i)
+MultiField::syncGather(const ArrayIndex& i)
 {
 
   ArrayBase& thisArray = *_arrays[_arrayMap[i]];
   const StorageSite& thisSite = *i.second;
 
   const StorageSite::GatherMap& gatherMap = thisSite.getGatherMap();
-
+ 
   foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
   {
       const StorageSite& oSite = *mpos.first;
-
       ArrayIndex oIndex(i.first,&oSite);
+
+      const Array<int>& toIndices = *(mpos.second);
       EntryIndex eIndex(oIndex,i);
 
-     const Array<int>& toIndices = *(mpos.second);
-      if (_ghostArrays.find(eIndex) == _ghostArrays.end()){
-         _ghostArrays[eIndex]  = thisArray.newSizedClone(toIndices.getLength());
+      if (_ghostArrays.find(eIndex) != _ghostArrays.end()){	
+          const ArrayBase& ghostArray = *_ghostArrays[eIndex];
+          thisArray.gather(ghostArray,toIndices);
       }
   }
 
 }
 
 void
-MultiField::createSyncGatherArraysLevel1(const ArrayIndex& i)
+MultiField::addToSyncPlan(MultiFieldSyncPlan& plan, GhostArrayMap& ghostArrays,
+                          const int pos,
+                          const StorageSite::ScatterMap& scatterMap,
+                          const StorageSite::GatherMap& gatherMap)
 {
+  const ArrayIndex& i = _arrayIndices[pos];
+  const ArrayBase& thisArray = *_arrays[pos];
 
-  ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-  const StorageSite& thisSite = *i.second;
-  
-  if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-     const StorageSite::GatherMap& gatherMap = thisSite.getGatherMapLevel1();
-
-     foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-     {
-        const StorageSite& oSite = *mpos.first;
+  foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
+  {
+      const StorageSite& oSite = *mpos.first;
+      ArrayIndex oIndex(i.first,&oSite);
+      const Array<int>& fromIndices = *(mpos.second);
 
-        ArrayIndex oIndex(i.first,&oSite);
-        EntryIndex eIndex(oIndex,i);
+      // arrays are stored with (Sender,receiver) as the key
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(i,oIndex)];
+      if (!ghostArray || ghostArray->getLength() != fromIndices.getLength())
+        ghostArray = thisArray.newSizedClone(fromIndices.getLength());
 
-        const Array<int>& toIndices = *(mpos.second);
-        if (_ghostArraysLevel1.find(eIndex) == _ghostArraysLevel1.end()){
-          _ghostArraysLevel1[eIndex]  = thisArray.newSizedClone(toIndices.getLength());
-        }
-     }
+      plan.addSend(pos, fromIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
   }
 
-}
-
-void
-MultiField::syncGather(const ArrayIndex& i)
-{
-
-  ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-  const StorageSite& thisSite = *i.second;
-
-  const StorageSite::GatherMap& gatherMap = thisSite.getGatherMap();
- 
   foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
   {
       const StorageSite& oSite = *mpos.first;
       ArrayIndex oIndex(i.first,&oSite);
-
       const Array<int>& toIndices = *(mpos.second);
-      EntryIndex eIndex(oIndex,i);
 
-      if (_ghostArrays.find(eIndex) != _ghostArrays.end()){	
-          const ArrayBase& ghostArray = *_ghostArrays[eIndex];
-          thisArray.gather(ghostArray,toIndices);
-      }
-  }
+      shared_ptr<ArrayBase>& ghostArray = ghostArrays[EntryIndex(oIndex,i)];
+      if (!ghostArray || ghostArray->getLength() != toIndices.getLength())
+        ghostArray = thisArray.newSizedClone(toIndices.getLength());
 
+      plan.addRecv(pos, toIndices, *ghostArray,
+                   oSite.getGatherProcID(), oSite.getTag());
+  }
 }
 
 void
-MultiField::syncGatherLevel1(const ArrayIndex& i)
+MultiField::createSyncPlans()
 {
+  _syncPlan.reset();
+  _syncPlanLevel1.reset();
 
-  ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-  const StorageSite& thisSite = *i.second;
+  shared_ptr<MultiFieldSyncPlan> plan(new MultiFieldSyncPlan());
+  shared_ptr<MultiFieldSyncPlan> planLevel1(new MultiFieldSyncPlan());
 
-  if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-     const StorageSite::GatherMap& gatherMap = thisSite.getGatherMapLevel1();
- 
-     foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-     {
-        const StorageSite& oSite = *mpos.first;
-        ArrayIndex oIndex(i.first,&oSite);
-
-        const Array<int>& toIndices = *(mpos.second);
-        EntryIndex eIndex(oIndex,i);
-
-        if (_ghostArraysLevel1.find(eIndex) != _ghostArraysLevel1.end()){	
-           const ArrayBase& ghostArray = *_ghostArraysLevel1[eIndex];
-           thisArray.gather(ghostArray,toIndices);
-        }  
-     }
+  for(int pos=0; pos<_length; pos++)
+  {
+      const StorageSite& thisSite = *_arrayIndices[pos].second;
+
+      addToSyncPlan(*plan, _ghostArrays, pos,
+                    thisSite.getScatterMap(), thisSite.getGatherMap());
+
+      if (_arrays[pos]->getLength() == thisSite.getCountLevel1())
+        addToSyncPlan(*planLevel1, _ghostArraysLevel1, pos,
+                      thisSite.getScatterMapLevel1(),
+                      thisSite.getGatherMapLevel1());
   }
 
+  _syncPlan = plan;
+  _syncPlanLevel1 = planLevel1;
+}
+
+void
+MultiField::syncScatter(const MultiFieldSyncPlan& plan)
+{
+  foreach(const MultiFieldSyncPlan::Buffer& b, plan.getSendBuffers())
+    _arrays[b.key]->scatter(*b.data, *b.indices);
 }
 
+void
+MultiField::syncGather(const MultiFieldSyncPlan& plan)
+{
+  foreach(const MultiFieldSyncPlan::Buffer& b, plan.getRecvBuffers())
+    _arrays[b.key]->gather(*b.data, *b.indices);
+}
 
 void
 MultiField::sync()
 {
-  foreach(ArrayIndex i, _arrayIndices)
-    syncScatter(i);
-
-  foreach(ArrayIndex i, _arrayIndices)
-        createSyncGatherArrays(i);
+  startSync();
+  finishSync();
+}
 
-#ifdef FVM_PARALLEL
-  //this communication is based on assumption that MPI communication will be only done inside the same field
-  //SENDING
-   MPI::Request   request_send[ get_request_size() ];
-   MPI::Request   request_recv[ get_request_size() ];
-   int sendIndx = 0;
-   int recvIndx = 0;
-   foreach ( ArrayIndex i, _arrayIndices ){
-       const  StorageSite& thisSite = *i.second;
-       const StorageSite::ScatterMap& scatterMap = thisSite.getScatterMap();
-       foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-           const StorageSite& oSite = *mpos.first;
-           ArrayIndex oIndex(i.first,&oSite);
-          // arrays are stored with (Sender,receiver) as the key
-             EntryIndex eIndex(i,oIndex);
-             ArrayBase& sendArray = *_ghostArrays[eIndex];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[sendIndx++] =  
-                       MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-       }
+void
+MultiField::startSync()
+{
+  if (_syncInProgress)
+    throw CException("MultiField::startSync: already being synced");
 
-  
-     //RECIEVING
-      const StorageSite::GatherMap& gatherMap = thisSite.getGatherMap();
-      foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-           const StorageSite& oSite = *mpos.first;
-           ArrayIndex oIndex(i.first,&oSite);
-             EntryIndex eIndex(oIndex,i);
-             ArrayBase& recvArray = *_ghostArrays[eIndex];
-             int from_where  = oSite.getGatherProcID();
-             if ( from_where != -1 ){
-                 int mpi_tag = oSite.getTag();
-                 request_recv[recvIndx++] =  
-                       MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-             }
-      }
+  if (!_syncPlan)
+    createSyncPlans();
 
-   }
+  _syncInProgress = true;
 
-   int count   = get_request_size();
-   MPI::Request::Waitall( count, request_recv );
-   MPI::Request::Waitall( count, request_send );
+  syncScatter(*_syncPlan);
+  _syncPlan->start();
+}
 
-#endif
+void
+MultiField::finishSync()
+{
+  if (!_syncInProgress)
+    throw CException("MultiField::finishSync: not being synced");
+  _syncInProgress = false;
 
-  foreach(ArrayIndex i, _arrayIndices)
-    syncGather(i);
+  _syncPlan->finish();
+  syncGather(*_syncPlan);
 
   //syncLevel1
   syncLevel1();
-
-}
-
-
-int
-MultiField::get_request_size()
-{
-   int indx = 0;
-   foreach ( ArrayIndex i, _arrayIndices ){
-       const  StorageSite& thisSite = *i.second;
-       const StorageSite::ScatterMap& scatterMap = thisSite.getScatterMap();
-       foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-           const StorageSite& oSite = *mpos.first;
-           ArrayIndex oIndex(i.first,&oSite);
-          // arrays are stored with (Sender,receiver) as the key
-           if ( oSite.getGatherProcID() != -1 )
-              indx++;
-       }
-    }
-   return indx;
-
 }
 
-
 void
 MultiField::syncLevel1()
 {
-  foreach(ArrayIndex i, _arrayIndices)
-    syncScatterLevel1(i);
-
-  foreach(ArrayIndex i, _arrayIndices)
-        createSyncGatherArraysLevel1(i);
-
-#ifdef FVM_PARALLEL
-  //this communication is based on assumption that MPI communication will be only done inside the same field
-  //SENDING
-   int countScatter   = get_request_size_scatter_level1();
-   int countGather    = get_request_size_gather_level1();
-   MPI::Request   request_send[ countScatter ];
-   MPI::Request   request_recv[ countGather  ];
-   int sendIndx = 0;
-   int recvIndx = 0;
-   foreach ( ArrayIndex i, _arrayIndices ){
-       const  StorageSite& thisSite = *i.second;
-       const StorageSite::ScatterMap& scatterMap = thisSite.getScatterMapLevel1();
-       const ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-       if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-          foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-             const StorageSite& oSite = *mpos.first;
-             ArrayIndex oIndex(i.first,&oSite);
-             // arrays are stored with (Sender,receiver) as the key
-             EntryIndex eIndex(i,oIndex);
-             ArrayBase& sendArray = *_ghostArraysLevel1[eIndex];
-             int to_where  = oSite.getGatherProcID();
-             if ( to_where != -1 ){
-                int mpi_tag = oSite.getTag();
-                request_send[sendIndx++] =  
-                       MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-             }
-          }
-
-         //RECIEVING
-         const StorageSite::GatherMap& gatherMap = thisSite.getGatherMapLevel1();
-         foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-            const StorageSite& oSite = *mpos.first;
-            ArrayIndex oIndex(i.first,&oSite);
-            EntryIndex eIndex(oIndex,i);
-            ArrayBase& recvArray = *_ghostArraysLevel1[eIndex];
-            int from_where  = oSite.getGatherProcID();
-            if ( from_where != -1 ){
-               int mpi_tag = oSite.getTag();
-               request_recv[recvIndx++] =  
-                     MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-           }
-         }
- 
-     }
-   }
-
-   MPI::Request::Waitall( countGather, request_recv );
-   MPI::Request::Waitall( countScatter , request_send );
-
-#endif
-
-  foreach(ArrayIndex i, _arrayIndices)
-    syncGatherLevel1(i);
-
-}
-
-
-int
-MultiField::get_request_size_scatter_level1()
-{
-   int indx = 0;
-   foreach ( ArrayIndex i, _arrayIndices ){
-       const  StorageSite& thisSite = *i.second;
-       const StorageSite::ScatterMap& scatterMap = thisSite.getScatterMapLevel1();
-       const ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-       if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-          foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap){
-             const StorageSite& oSite = *mpos.first;
-             ArrayIndex oIndex(i.first,&oSite);
-             // arrays are stored with (Sender,receiver) as the key
-             if ( oSite.getGatherProcID() != -1 )
-               indx++;
-          }
-       }
-    }
-   return indx;
-
-}
-
-int
-MultiField::get_request_size_gather_level1()
-{
-   int indx = 0;
-   foreach ( ArrayIndex i, _arrayIndices ){
-       const  StorageSite& thisSite = *i.second;
-       const StorageSite::GatherMap& gatherMap = thisSite.getGatherMapLevel1();
-       const ArrayBase& thisArray = *_arrays[_arrayMap[i]];
-       if ( thisArray.getLength() == thisSite.getCountLevel1() ){
-          foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap){
-             const StorageSite& oSite = *mpos.first;
-             ArrayIndex oIndex(i.first,&oSite);
-             // arrays are stored with (Sender,receiver) as the key
-             if ( oSite.getGatherProcID() != -1 )
-                indx++;
-          }
-       }
-    }
-   return indx;
-
+  syncScatter(*_syncPlanLevel1);
+  _syncPlanLevel1->start();
+  _syncPlanLevel1->finish();
+  syncGather(*_syncPlanLevel1);
 }
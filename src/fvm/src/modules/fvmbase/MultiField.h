@@ -10,6 +10,7 @@
 
 #include "ArrayBase.h"
 #include "StorageSite.h"
+#include "SyncPlan.h"
 
 class MultiFieldReduction;
 class Field;
@@ -24,6 +25,7 @@ public:
   typedef vector<ArrayIndex> ArrayIndexList;
   typedef pair<ArrayIndex,ArrayIndex>  EntryIndex;
   typedef map <EntryIndex,shared_ptr<ArrayBase> > GhostArrayMap;
+  typedef SyncPlan<int> MultiFieldSyncPlan;
 
   MultiField();
   
@@ -60,10 +62,13 @@ public:
   MultiField& saxpy(const MultiFieldReduction& alphaMF, const MultiField& xMF);
   MultiField& msaxpy(const MultiFieldReduction& alphaMF, const MultiField& xMF);
 
-  shared_ptr<MultiFieldReduction> reduceSum() const;
-  shared_ptr<MultiFieldReduction> getOneNorm() const;
+  // with sync false the reductions are left as the sums over this
+  // process only, for the caller to combine with MultiFieldReductionSync
+  shared_ptr<MultiFieldReduction> reduceSum(const bool sync=true) const;
+  shared_ptr<MultiFieldReduction> getOneNorm(const bool sync=true) const;
 
-  shared_ptr<MultiFieldReduction> dotWith(const MultiField& ofield) const;
+  shared_ptr<MultiFieldReduction> dotWith(const MultiField& ofield,
+                                          const bool sync=true) const;
 
   const ArrayIndexList& getArrayIndices() const {return _arrayIndices;}
 
@@ -73,17 +78,22 @@ public:
   void  syncScatter(const ArrayIndex& i);
   void syncGather(const ArrayIndex& i);
   void sync();
+
+  // the two halves of sync, see Field::startSync
+  void startSync();
+  void finishSync();
   
 private:
 
-  void  createSyncGatherArrays(const ArrayIndex& i);
-  void  syncScatterLevel1(const ArrayIndex& i);
-  void  createSyncGatherArraysLevel1(const ArrayIndex& i);
-  void syncGatherLevel1(const ArrayIndex& i);
-
-  int  get_request_size();
-  int  get_request_size_scatter_level1();
-  int  get_request_size_gather_level1();
+  // the plans are keyed by the position of the array and are dropped
+  // whenever an array is added or removed
+  void createSyncPlans();
+  void addToSyncPlan(MultiFieldSyncPlan& plan, GhostArrayMap& ghostArrays,
+                     const int pos,
+                     const StorageSite::ScatterMap& scatterMap,
+                     const StorageSite::GatherMap& gatherMap);
+  void syncScatter(const MultiFieldSyncPlan& plan);
+  void syncGather(const MultiFieldSyncPlan& plan);
 
   void syncLevel1();
 
@@ -94,6 +104,10 @@ private:
   ArrayMap _arrayMap;
   GhostArrayMap _ghostArrays;
   GhostArrayMap _ghostArraysLevel1;
+
+  bool _syncInProgress;
+  shared_ptr<MultiFieldSyncPlan> _syncPlan;
+  shared_ptr<MultiFieldSyncPlan> _syncPlanLevel1;
 };
 
 #endif
@@ -4,6 +4,7 @@
 
 #include "MultiFieldMatrix.h"
 #include "CRConnectivity.h"
+#include "CRMatrixTranspose.h"
 #include "MultiField.h"
 #include "IContainer.h"
 #include "StorageSite.h"
@@ -13,6 +14,8 @@
   #include "mpi.h"
 #endif
 
+typedef CRMatrixTranspose<double,double,double> ProlongationMatrix;
+
 MultiFieldMatrix::MultiFieldMatrix() :
   _matrices(),
   _coarseSizes(),
@@ -20,7 +23,13 @@ MultiFieldMatrix::MultiFieldMatrix() :
   _coarseSites(),
   _coarseToFineMappings(),
   _coarseConnectivities(),
-  _coarseMatrices()
+  _coarseMatrices(),
+  _prolongationConnectivities(),
+  _prolongators(),
+  _prolongationStrengthThreshold(0),
+  _prolongationClassical(false),
+  _prolongationSmoothing(0),
+  _jacobiX()
 {
   logCtor();
 }
@@ -67,6 +76,14 @@ MultiFieldMatrix::multiply(IContainer& yB, const IContainer& xB) const
   MultiField& y = dynamic_cast<MultiField&>(yB);
   const MultiField& x = dynamic_cast<const MultiField&>(xB);
 
+#ifdef FVM_PARALLEL
+  if (hasRowProducts())
+  {
+      multiplyAndSync(y,x,false);
+      return;
+  }
+#endif
+
   const int yLen = y.getLength();
   const int xLen = x.getLength();
 
@@ -97,6 +114,14 @@ MultiFieldMatrix::multiplyAndAdd(IContainer& yB, const IContainer& xB) const
   MultiField& y = dynamic_cast<MultiField&>(yB);
   const MultiField& x = dynamic_cast<const MultiField&>(xB);
 
+#ifdef FVM_PARALLEL
+  if (hasRowProducts())
+  {
+      multiplyAndSync(y,x,true);
+      return;
+  }
+#endif
+
   const int yLen = y.getLength();
   const int xLen = x.getLength();
 
@@ -122,8 +147,79 @@ MultiFieldMatrix::multiplyAndAdd(IContainer& yB, const IContainer& xB) const
 
 }
 
+bool
+MultiFieldMatrix::hasRowProducts() const
+{
+  foreach(const MatrixMap::value_type& pos, _matrices)
+    if (!pos.second->hasRowProducts())
+      return false;
+  return true;
+}
+
+void
+MultiFieldMatrix::multiplyAndSync(MultiField& y, const MultiField& x,
+                                  const bool add) const
+{
+  const int yLen = y.getLength();
+  const int xLen = x.getLength();
+
+  if (!add)
+    for(int i=0; i<yLen; i++)
+      y[y.getArrayIndex(i)].zero();
+
+  // the rows sent to other processes first, then the rest while
+  // they are in transit
+  for(int pass=0; pass<2; pass++)
+  {
+      for(int i=0; i<yLen; i++)
+      {
+          const Index rowIndex = y.getArrayIndex(i);
+          const StorageSite& rowSite = *rowIndex.second;
+          const Array<int>& rows = (pass == 0) ?
+            rowSite.getInterfaceIndices() : rowSite.getInteriorIndices();
+
+          ArrayBase& yI = y[rowIndex];
+          for(int j=0; j<xLen; j++)
+          {
+              const Index colIndex = x.getArrayIndex(j);
+              if (hasMatrix(rowIndex,colIndex))
+                getMatrix(rowIndex,colIndex).multiplyAndAddRows(yI,x[colIndex],rows);
+          }
+      }
+
+      if (pass == 0)
+        y.startSync();
+  }
+
+  y.finishSync();
+}
+
 void 
 MultiFieldMatrix::forwardGS(IContainer& xB, const IContainer& bB, IContainer& tempB) const
+{
+  forwardSweep(xB,bB,tempB,&Matrix::forwardGS);
+}
+
+void 
+MultiFieldMatrix::forwardColoredGS(IContainer& xB, const IContainer& bB,
+                                   IContainer& tempB) const
+{
+  forwardSweep(xB,bB,tempB,&Matrix::forwardColoredGS);
+}
+
+void 
+MultiFieldMatrix::forwardBlockGS(IContainer& xB, const IContainer& bB,
+                                 IContainer& tempB) const
+{
+  forwardSweep(xB,bB,tempB,&Matrix::forwardBlockGS);
+}
+
+// the fields are visited in order, each one being updated using the
+// latest values of the others
+
+void 
+MultiFieldMatrix::forwardSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                               const GSUpdate update) const
 {
   MultiField& x = dynamic_cast<MultiField&>(xB);
   const MultiField& b = dynamic_cast<const MultiField&>(bB);
@@ -155,7 +251,7 @@ MultiFieldMatrix::forwardGS(IContainer& xB, const IContainer& bB, IContainer& te
 #ifndef FVM_PARALLEL
           x.syncGather(rowIndex);
 #endif
-          mII.forwardGS(x[rowIndex],r,r);
+          (mII.*update)(x[rowIndex],r,r);
 #ifndef FVM_PARALLEL
           x.syncScatter(rowIndex);
 #endif
@@ -166,14 +262,39 @@ MultiFieldMatrix::forwardGS(IContainer& xB, const IContainer& bB, IContainer& te
 
 void 
 MultiFieldMatrix::Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB) const
+{
+  jacobiSweep(xB,bB,tempB,&Matrix::Jacobi);
+}
+
+void 
+MultiFieldMatrix::l1Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB) const
+{
+  jacobiSweep(xB,bB,tempB,&Matrix::l1Jacobi);
+}
+
+void 
+MultiFieldMatrix::jacobiSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                              const JacobiUpdate update) const
 {
   MultiField& x = dynamic_cast<MultiField&>(xB);
   const MultiField& b = dynamic_cast<const MultiField&>(bB);
   MultiField& temp = dynamic_cast<MultiField&>(tempB);
   
-  shared_ptr<MultiField> xnew = dynamic_pointer_cast<MultiField>(x.newClone());
-  
   const int xLen = x.getLength();
+
+  // the arrays for the new values are only allocated for the first
+  // sweep or when x has a different layout
+  bool isCurrent = _jacobiX && _jacobiX->getLength() == xLen;
+  for(int i=0; isCurrent && i<xLen; i++)
+  {
+      const Index rowIndex = x.getArrayIndex(i);
+      isCurrent = _jacobiX->hasArray(rowIndex) &&
+        (*_jacobiX)[rowIndex].getLength() == x[rowIndex].getLength();
+  }
+  if (!isCurrent)
+    _jacobiX = dynamic_pointer_cast<MultiField>(x.newClone());
+  MultiField& xnew = *_jacobiX;
+  
   //#pragma omp parallel for
   for(int i=0; i<xLen; i++)
   {
@@ -196,7 +317,7 @@ MultiFieldMatrix::Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB
           }
           
           const Matrix& mII = getMatrix(rowIndex,rowIndex);
-          mII.Jacobi((*xnew)[rowIndex],x[rowIndex],r);
+          (mII.*update)(xnew[rowIndex],x[rowIndex],r);
 
       }
   }
@@ -207,7 +328,7 @@ MultiFieldMatrix::Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB
       const Index rowIndex = x.getArrayIndex(i);
       if (hasMatrix(rowIndex,rowIndex))
       {
-          const ArrayBase& xnewI = (*xnew)[rowIndex];
+          const ArrayBase& xnewI = xnew[rowIndex];
           ArrayBase& xI = x[rowIndex];
           const StorageSite& rowSite = *rowIndex.second;
           xI.copyPartial(xnewI,0,rowSite.getSelfCount());
@@ -356,6 +477,27 @@ MultiFieldMatrix::solveBoundary(IContainer& xB, const IContainer& bB, IContainer
 
 void
 MultiFieldMatrix::reverseGS(IContainer& xB, const IContainer& bB, IContainer& tempB) const
+{
+  reverseSweep(xB,bB,tempB,&Matrix::reverseGS);
+}
+
+void
+MultiFieldMatrix::reverseColoredGS(IContainer& xB, const IContainer& bB,
+                                   IContainer& tempB) const
+{
+  reverseSweep(xB,bB,tempB,&Matrix::reverseColoredGS);
+}
+
+void
+MultiFieldMatrix::reverseBlockGS(IContainer& xB, const IContainer& bB,
+                                 IContainer& tempB) const
+{
+  reverseSweep(xB,bB,tempB,&Matrix::reverseBlockGS);
+}
+
+void
+MultiFieldMatrix::reverseSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                               const GSUpdate update) const
 {
   MultiField& x = dynamic_cast<MultiField&>(xB);
   const MultiField& b = dynamic_cast<const MultiField&>(bB);
@@ -387,7 +529,7 @@ MultiFieldMatrix::reverseGS(IContainer& xB, const IContainer& bB, IContainer& te
 #ifndef FVM_PARALLEL
           x.syncGather(rowIndex);
 #endif
-          mII.reverseGS(x[rowIndex],r,r);
+          (mII.*update)(x[rowIndex],r,r);
 #ifndef FVM_PARALLEL
          x.syncScatter(rowIndex);
 #endif
@@ -472,6 +614,44 @@ MultiFieldMatrix::createCoarsening(MultiField& coarseIndex,
 
 
 
+void
+MultiFieldMatrix::createStrengthCoarsening(MultiField& coarseIndex,
+                                           const double strengthThreshold,
+                                           const bool classical)
+{
+  const int xLen = coarseIndex.getLength();
+
+  for(int i=0; i<xLen; i++)
+  {
+      const Index rowIndex = coarseIndex.getArrayIndex(i);
+      if (hasMatrix(rowIndex,rowIndex))
+      {
+          Matrix& mII = getMatrix(rowIndex,rowIndex);
+          _coarseSizes[rowIndex] =
+            mII.createStrengthCoarsening(coarseIndex[rowIndex],
+                                         strengthThreshold,classical);
+      }
+  }
+}
+
+void
+MultiFieldMatrix::clearCoarsening()
+{
+  _coarseSizes.clear();
+  _coarseGhostSizes.clear();
+  _coarseScatterMaps.clear();
+  _coarseGatherMaps.clear();
+  _coarseSites.clear();
+  _coarseToFineMappings.clear();
+  _coarseConnectivities.clear();
+  _coarseMatrices.clear();
+  _prolongationConnectivities.clear();
+  _prolongators.clear();
+  _prolongationStrengthThreshold = 0;
+  _prolongationClassical = false;
+  _prolongationSmoothing = 0;
+}
+
 void
 MultiFieldMatrix::syncGhostCoarsening(MultiField& coarseIndexField)
 {
@@ -666,6 +846,36 @@ MultiFieldMatrix::createCoarseToFineMapping(const MultiField& coarseIndexField)
   }
 }
 
+void
+MultiFieldMatrix::createProlongators(MultiField& coarseIndex,
+                                     const double strengthThreshold,
+                                     const bool classical,
+                                     const double smoothing)
+{
+  _prolongationStrengthThreshold = strengthThreshold;
+  _prolongationClassical = classical;
+  _prolongationSmoothing = smoothing;
+
+  const int xLen = coarseIndex.getLength();
+  for(int i=0; i<xLen; i++)
+  {
+      const Index rowIndex = coarseIndex.getArrayIndex(i);
+      const Matrix& mII = getMatrix(rowIndex,rowIndex);
+
+      shared_ptr<CRConnectivity> prolongation
+        (mII.createProlongationConnectivity(coarseIndex[rowIndex],
+                                            *_coarseSites[rowIndex],
+                                            strengthThreshold,classical));
+      shared_ptr<Matrix> prolongator(new ProlongationMatrix(*prolongation));
+
+      mII.updateProlongator(*prolongator,coarseIndex[rowIndex],
+                            strengthThreshold,classical,smoothing);
+
+      _prolongationConnectivities[rowIndex] = prolongation;
+      _prolongators[rowIndex] = prolongator;
+  }
+}
+
 void
 MultiFieldMatrix::createCoarseConnectivity(MultiField& coarseIndex)
 {
@@ -690,10 +900,17 @@ MultiFieldMatrix::createCoarseConnectivity(MultiField& coarseIndex)
 
               const StorageSite& coarseColSite = *_coarseSites[colIndex];
 
-              shared_ptr<CRConnectivity> coarseConnectivity
-                (mIJ.createCoarseConnectivity(coarseIndex[rowIndex],
-                                              coarseToFine,
-                                              coarseRowSite,coarseColSite));
+              shared_ptr<CRConnectivity> coarseConnectivity;
+              if (_prolongators.empty())
+                coarseConnectivity =
+                  mIJ.createCoarseConnectivity(coarseIndex[rowIndex],
+                                               coarseToFine,
+                                               coarseRowSite,coarseColSite);
+              else
+                coarseConnectivity =
+                  mIJ.createGalerkinConnectivity(*_prolongators[rowIndex],
+                                                 *_prolongators[colIndex],
+                                                 coarseRowSite,coarseColSite);
               EntryIndex e(rowIndex,colIndex);
               _coarseConnectivities[e]=coarseConnectivity;
           }
@@ -722,16 +939,65 @@ MultiFieldMatrix::createCoarseMatrices(MultiField& coarseIndex)
 
               const CRConnectivity& coarseConnectivity = *_coarseConnectivities[e];
 
-              shared_ptr<Matrix> coarseMatrix 
-                (mIJ.createCoarseMatrix(coarseIndex[rowIndex],
-                                        coarseToFine,
-                                        coarseConnectivity));
+              shared_ptr<Matrix> coarseMatrix;
+              if (_prolongators.empty())
+                coarseMatrix = mIJ.createCoarseMatrix(coarseIndex[rowIndex],
+                                                      coarseToFine,
+                                                      coarseConnectivity);
+              else
+                coarseMatrix = mIJ.createGalerkinMatrix(*_prolongators[rowIndex],
+                                                        *_prolongators[colIndex],
+                                                        coarseConnectivity);
               _coarseMatrices[e]=coarseMatrix;
           }
       }
   }
 }
 
+void
+MultiFieldMatrix::updateCoarseMatrices(MultiField& coarseIndex)
+{
+  const int xLen = coarseIndex.getLength();
+
+  // the prolongators depend on the matrix coefficients too
+  if (!_prolongators.empty())
+    for(int i=0; i<xLen; i++)
+    {
+        const Index rowIndex = coarseIndex.getArrayIndex(i);
+        getMatrix(rowIndex,rowIndex).updateProlongator(*_prolongators[rowIndex],
+                                                       coarseIndex[rowIndex],
+                                                       _prolongationStrengthThreshold,
+                                                       _prolongationClassical,
+                                                       _prolongationSmoothing);
+    }
+
+  for(int i=0; i<xLen; i++)
+  {
+      const Index rowIndex = coarseIndex.getArrayIndex(i);
+
+      const CRConnectivity& coarseToFine = *_coarseToFineMappings[rowIndex];
+
+      for(int j=0; j<xLen; j++)
+      {
+          const Index colIndex = coarseIndex.getArrayIndex(j);
+          if (hasMatrix(rowIndex,colIndex))
+          {
+              Matrix& mIJ = getMatrix(rowIndex,colIndex);
+              EntryIndex e(rowIndex,colIndex);
+
+              if (_prolongators.empty())
+                mIJ.updateCoarseMatrix(coarseIndex[rowIndex],
+                                       coarseToFine,
+                                       *_coarseMatrices[e]);
+              else
+                mIJ.updateGalerkinMatrix(*_prolongators[rowIndex],
+                                         *_prolongators[colIndex],
+                                         *_coarseMatrices[e]);
+          }
+      }
+  }
+}
+
 
 void
 MultiFieldMatrix::injectResidual(const MultiField& coarseIndex,
@@ -757,7 +1023,15 @@ MultiFieldMatrix::injectResidual(const MultiField& coarseIndex,
 
       ArrayBase& coarseB =  dynamic_cast<ArrayBase&>(coarseBField[coarseRowIndex]);
 
-      fineResidual.inject(coarseB,fineToCoarse,rowIndex.second->getSelfCount());
+      if (_prolongators.empty())
+        fineResidual.inject(coarseB,fineToCoarse,rowIndex.second->getSelfCount());
+      else
+      {
+          const ProlongationMatrix& prolongator =
+            dynamic_cast<const ProlongationMatrix&>(*_prolongators[rowIndex]);
+          prolongator.multiplyTransposeAndAdd(coarseB,fineResidual,
+                                              rowIndex.second->getSelfCount());
+      }
   }
 }
 
@@ -782,10 +1056,29 @@ MultiFieldMatrix::correctSolution(const MultiField& coarseIndex,
         scale = &((*scaleField)[*(coarseRowIndex.first)]);
       
       ArrayBase& fineSolution = dynamic_cast<ArrayBase&>(fineSolutionField[rowIndex]);
-      fineSolution.correct(coarseSolutionField[coarseRowIndex],
-                           coarseIndex[rowIndex],
-                           scale,
-                           rowIndex.second->getSelfCount());
+      if (_prolongators.empty())
+        fineSolution.correct(coarseSolutionField[coarseRowIndex],
+                             coarseIndex[rowIndex],
+                             scale,
+                             rowIndex.second->getSelfCount());
+      else
+      {
+          const ProlongationMatrix& prolongator =
+            dynamic_cast<const ProlongationMatrix&>(*_prolongators[rowIndex]);
+          const ArrayBase& coarseSolution = coarseSolutionField[coarseRowIndex];
+
+          if (scale)
+          {
+              shared_ptr<ArrayBase> scaledSolution =
+                dynamic_pointer_cast<ArrayBase>(coarseSolution.newCopy());
+              *scaledSolution *= *scale;
+              prolongator.multiplyAndAdd(fineSolution,*scaledSolution,
+                                         rowIndex.second->getSelfCount());
+          }
+          else
+            prolongator.multiplyAndAdd(fineSolution,coarseSolution,
+                                       rowIndex.second->getSelfCount());
+      }
   }
 }
 
@@ -885,7 +1178,7 @@ MultiFieldMatrix::getLocalSize( ) const
 }
 
 MFRPtr
-MultiFieldMatrix::quadProduct(const MultiField& x) const
+MultiFieldMatrix::quadProduct(const MultiField& x, const bool sync) const
 {
   const int xLen = x.getLength();
 
@@ -905,7 +1198,7 @@ MultiFieldMatrix::quadProduct(const MultiField& x) const
       }
   }
 
-  MFRPtr r = p->reduceSum();
+  MFRPtr r = p->reduceSum(sync);
   delete p;
   return r;
 }
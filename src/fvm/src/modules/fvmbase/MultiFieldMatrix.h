@@ -68,6 +68,7 @@ public:
   
   typedef map<Index,shared_ptr<CRConnectivity> > CoarseToFineMappingMap;
   typedef map<EntryIndex,shared_ptr<CRConnectivity> > CoarseConnectivitiesMap;
+  typedef map<Index,shared_ptr<Matrix> > ProlongatorMap;
   
   MultiFieldMatrix();
   virtual ~MultiFieldMatrix();
@@ -86,6 +87,13 @@ public:
 
   virtual void  Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB) const;
 
+  // threaded smoothers, see Matrix.h
+  void forwardColoredGS(IContainer& xB, const IContainer& bB, IContainer& temp) const;
+  void reverseColoredGS(IContainer& xB, const IContainer& bB, IContainer& temp) const;
+  void forwardBlockGS(IContainer& xB, const IContainer& bB, IContainer& temp) const;
+  void reverseBlockGS(IContainer& xB, const IContainer& bB, IContainer& temp) const;
+  void l1Jacobi(IContainer& xB, const IContainer& bB, IContainer& tempB) const;
+
   virtual void  iluSolve(IContainer& xB, const IContainer& bB, IContainer& tempB) const;
   virtual void  spikeSolve(IContainer& xB, const IContainer& bB, IContainer& tempB, const SpikeStorage& spike_storage) const;
 
@@ -105,15 +113,35 @@ public:
   void createCoarsening(MultiField& coarseIndex,
                         const int groupSize,
                         const double weightRatioThreshold);
+
+  void createStrengthCoarsening(MultiField& coarseIndex,
+                                const double strengthThreshold,
+                                const bool classical);
   
   void syncGhostCoarsening(MultiField& coarseIndexField);
 
+  void clearCoarsening();
+
   void createCoarseToFineMapping(const MultiField& coarseIndexField);
 
+  /**
+   * create prolongators for all the coarsened indices. When
+   * these are present the coarse matrices are the Galerkin products
+   * P^T A P and the residuals and corrections are transferred with
+   * them instead of the coarse index (see CRMatrix for details).
+   * 
+   */
+  void createProlongators(MultiField& coarseIndex,
+                          const double strengthThreshold,
+                          const bool classical,
+                          const double smoothing);
+
   void createCoarseConnectivity(MultiField& coarseIndex);
 
   void createCoarseMatrices(MultiField& coarseIndex);
 
+  void updateCoarseMatrices(MultiField& coarseIndex);
+
   void transpose();
   
   void
@@ -140,11 +168,31 @@ public:
     _matrices[e] = m;
   }
   
-  MFRPtr quadProduct(const MultiField& x) const;
+  // with sync false the product is only summed over this process, see
+  // MultiField::reduceSum
+  MFRPtr quadProduct(const MultiField& x, const bool sync=true) const;
   
   //MatrixMap& getMatrixMap() { return _matrices;}
   
 private:
+  typedef void (Matrix::*GSUpdate)(IContainer&, IContainer&, IContainer&) const;
+  typedef void (Matrix::*JacobiUpdate)(IContainer&, const IContainer&,
+                                       const IContainer&) const;
+
+  void forwardSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                    const GSUpdate update) const;
+  void reverseSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                    const GSUpdate update) const;
+  void jacobiSweep(IContainer& xB, const IContainer& bB, IContainer& tempB,
+                   const JacobiUpdate update) const;
+
+  // used by multiply and multiplyAndAdd to overlap the sync of y with
+  // the computation of its interior rows when all the matrices
+  // support products over a subset of rows
+  bool hasRowProducts() const;
+  void multiplyAndSync(MultiField& y, const MultiField& x,
+                       const bool add) const;
+
   MatrixMap _matrices;
   MatrixSizeMap _coarseSizes;
   MatrixSizeMap _coarseGhostSizes;
@@ -155,6 +203,14 @@ private:
   CoarseToFineMappingMap _coarseToFineMappings;
   CoarseConnectivitiesMap _coarseConnectivities;
   MatrixMap _coarseMatrices;
+  CoarseToFineMappingMap _prolongationConnectivities;
+  ProlongatorMap _prolongators;
+  double _prolongationStrengthThreshold;
+  bool _prolongationClassical;
+  double _prolongationSmoothing;
+
+  // the new values of a Jacobi sweep, kept for the next sweep
+  mutable shared_ptr<MultiField> _jacobiX;
 };
 
 
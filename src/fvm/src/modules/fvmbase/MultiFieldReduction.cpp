@@ -130,6 +130,18 @@ MultiFieldReduction::operator-() const
   return r;
 }
 
+MFRPtr
+MultiFieldReduction::sqrt() const
+{
+  MFRPtr r(new MultiFieldReduction());
+  
+  foreach(const ArrayMap::value_type& pos, _arrays)
+  {
+      r->addArray(*pos.first,pos.second->sqrt());
+  }
+  return r;
+}
+
 MFRPtr
 MultiFieldReduction::normalize(const MultiFieldReduction& o)
 {
@@ -214,12 +226,139 @@ void
 MultiFieldReduction::sync()
 {
 #ifdef FVM_PARALLEL
-   ArrayMap::const_iterator it;
-   for ( it = _arrays.begin(); it != _arrays.end(); it++ ){
-         ArrayBase&  myArray = *(it->second);
-         int count = myArray.getDataSize() / sizeof(double); 
-         MPI::COMM_WORLD.Allreduce( MPI::IN_PLACE, myArray.getData(), count, MPI::DOUBLE, MPI::SUM);
-   }
+  // all the fields in a single allreduce
+  MultiFieldReductionSync reduction;
+  reduction.add(*this);
+  reduction.start();
+  reduction.finish();
+#endif
+
+}
+
+#ifdef FVM_PARALLEL
+// number of values in a reduction array, the single precision ones are
+// summed in double precision
+static int
+getReductionCount(const ArrayBase& a)
+{
+  if (a.getPrimType() == PRIM_TYPE_FLOAT)
+    return a.getDataSize() / sizeof(float);
+  return a.getDataSize() / sizeof(double);
+}
+#endif
+
+MultiFieldReductionSync::MultiFieldReductionSync() :
+  _reductions(),
+  _buffer(),
+  _started(false)
+#ifdef FVM_PARALLEL
+  ,_comm(MPI::COMM_WORLD)
+#endif
+{}
+
+#ifdef FVM_PARALLEL
+MultiFieldReductionSync::MultiFieldReductionSync(const MPI::Intracomm& comm) :
+  _reductions(),
+  _buffer(),
+  _started(false),
+  _comm(comm)
+{}
+#endif
+
+MultiFieldReductionSync::~MultiFieldReductionSync()
+{
+  if (_started)
+    finish();
+}
+
+void
+MultiFieldReductionSync::add(MultiFieldReduction& r)
+{
+  if (_started)
+    throw CException("MultiFieldReductionSync: reduction already started");
+  _reductions.push_back(&r);
+}
+
+void
+MultiFieldReductionSync::start()
+{
+#ifdef FVM_PARALLEL
+  int count = 0;
+  foreach(const MultiFieldReduction* r, _reductions)
+    foreach(const MultiFieldReduction::ArrayMap::value_type& pos, r->_arrays)
+      count += getReductionCount(*pos.second);
+
+  _buffer.resize(count);
+  
+  int offset = 0;
+  foreach(const MultiFieldReduction* r, _reductions)
+    foreach(const MultiFieldReduction::ArrayMap::value_type& pos, r->_arrays)
+    {
+        const ArrayBase& myArray = *pos.second;
+        const int n = getReductionCount(myArray);
+        if (myArray.getPrimType() == PRIM_TYPE_FLOAT)
+        {
+            const float *data = (const float *) myArray.getData();
+            for(int i=0; i<n; i++)
+              _buffer[offset+i] = data[i];
+        }
+        else
+        {
+            const double *data = (const double *) myArray.getData();
+            for(int i=0; i<n; i++)
+              _buffer[offset+i] = data[i];
+        }
+        offset += n;
+    }
+
+  if (count > 0)
+  {
+#if MPI_VERSION >= 3
+      MPI_Iallreduce(MPI_IN_PLACE, &_buffer[0], count, MPI_DOUBLE, MPI_SUM,
+                     MPI_Comm(_comm), &_request);
+#else
+      _comm.Allreduce(MPI::IN_PLACE, &_buffer[0], count,
+                                MPI::DOUBLE, MPI::SUM);
+#endif
+  }
+#endif
+  _started = true;
+}
+
+void
+MultiFieldReductionSync::finish()
+{
+  if (!_started)
+    throw CException("MultiFieldReductionSync: reduction not started");
+  _started = false;
+  
+#ifdef FVM_PARALLEL
+  if (_buffer.empty())
+    return;
+  
+#if MPI_VERSION >= 3
+  MPI_Wait(&_request, MPI_STATUS_IGNORE);
 #endif
 
+  int offset = 0;
+  foreach(MultiFieldReduction* r, _reductions)
+    foreach(const MultiFieldReduction::ArrayMap::value_type& pos, r->_arrays)
+    {
+        ArrayBase& myArray = *pos.second;
+        const int n = getReductionCount(myArray);
+        if (myArray.getPrimType() == PRIM_TYPE_FLOAT)
+        {
+            float *data = (float *) myArray.getData();
+            for(int i=0; i<n; i++)
+              data[i] = float(_buffer[offset+i]);
+        }
+        else
+        {
+            double *data = (double *) myArray.getData();
+            for(int i=0; i<n; i++)
+              data[i] = _buffer[offset+i];
+        }
+        offset += n;
+    }
+#endif
 }
@@ -5,6 +5,10 @@
 #ifndef _MULTIFIELDREDUCTION_H_
 #define _MULTIFIELDREDUCTION_H_
 
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
 #include "Field.h"
 #include "ArrayBase.h"
 
@@ -35,6 +39,7 @@ public:
   shared_ptr<MultiFieldReduction> normalize(const MultiFieldReduction& o);
   shared_ptr<MultiFieldReduction> operator*(const MultiFieldReduction& o);
   shared_ptr<MultiFieldReduction> operator-() const;
+  shared_ptr<MultiFieldReduction> sqrt() const;
 
   void setMax(const MultiFieldReduction& o);
   void limit(const double min, const double max);
@@ -43,9 +48,51 @@ public:
   void sync();
 
 private:
+  friend class MultiFieldReductionSync;
+  
   ArrayMap _arrays;
 };
 
+/**
+ * sums a number of reductions over all processes using a single
+ * allreduce. start() begins the reduction, non blocking if the MPI
+ * library supports it, so that work that doesn't need the results can
+ * be done before calling finish(). The reductions must have been
+ * computed without syncing them, e.g. by MultiField::dotWith(x,false),
+ * and several dot products and norms needed at the same point of an
+ * iteration should be added to the same sync. The sums are over the
+ * processes of comm when one is given, e.g. for the coarse levels of
+ * AMG that have been agglomerated onto fewer processes.
+ * 
+ */
+
+class MultiFieldReductionSync
+{
+public:
+  MultiFieldReductionSync();
+#ifdef FVM_PARALLEL
+  explicit MultiFieldReductionSync(const MPI::Intracomm& comm);
+#endif
+  ~MultiFieldReductionSync();
+
+  void add(MultiFieldReduction& r);
+  void start();
+  void finish();
+
+private:
+  MultiFieldReductionSync(const MultiFieldReductionSync&);
+  
+  vector<MultiFieldReduction*> _reductions;
+  vector<double> _buffer;
+  bool _started;
+#ifdef FVM_PARALLEL
+  MPI::Intracomm _comm;
+#if MPI_VERSION >= 3
+  MPI_Request _request;
+#endif
+#endif
+};
+
 inline ostream& operator<<(ostream &os,
                            const MultiFieldReduction &x)
 {
@@ -128,7 +128,7 @@ struct NumTypeTraits<float>
   static string getTypeName() {return "float";}
   static int getDimension() {return 0;}
   static void getShape(int *shp) {}
-  static int getDataSize()  {return  sizeof(double);}
+  static int getDataSize()  {return  sizeof(float);}
   static float getZero() {return 0;}
   static float getUnity() {return 1.;}
   static float getNegativeUnity() {return -1.;}
@@ -149,6 +149,9 @@ struct ArrayScalarTraits
 {
   static void limit(T& val, const double min, const double max)
   {throw;}
+
+  static void sqrt(T& val)
+  {throw;}
   
 };
 
@@ -163,6 +166,8 @@ struct ArrayScalarTraits<double>
     else if (val > max)
       val = max;
   }
+
+  static void sqrt(double& val) {val = ::sqrt(val);}
 };
 
 template<>
@@ -175,5 +180,7 @@ struct ArrayScalarTraits<float>
     else if (val > max)
       val = max;
   }
+
+  static void sqrt(float& val) {val = ::sqrt(val);}
 };
 #endif
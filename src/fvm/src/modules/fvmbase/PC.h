@@ -381,6 +381,8 @@ struct ArrayScalarTraits<PC< ORDER, DIM > >
     else if (val._data[0] > max)
       val._data[0] = max;
   }
+
+  static void sqrt(PC<ORDER,DIM>& val) {val = ::sqrt(val);}
 };
 
 #endif
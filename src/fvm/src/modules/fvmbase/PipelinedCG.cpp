@@ -0,0 +1,185 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifdef  FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+
+#include "PipelinedCG.h"
+
+PipelinedCG::PipelinedCG() :
+  preconditioner(0),
+  _totalIterations(0)
+{}
+
+PipelinedCG::~PipelinedCG()
+{
+}
+
+void
+PipelinedCG::cleanup()
+{
+  preconditioner->cleanup();
+}
+
+MFRPtr
+PipelinedCG::solve(LinearSystem & ls)
+{
+  const MultiFieldMatrix& matrix = ls.getMatrix();
+
+  // original system is in delta form
+  shared_ptr<MultiField> x(ls.getDeltaPtr());
+  shared_ptr<MultiField> bOrig(ls.getBPtr());
+
+  matrix.computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+
+  MFRPtr rNorm0(ls.getResidual().getOneNorm());
+
+#ifndef  FVM_PARALLEL
+  if (verbosity >0)
+    cout << 0 << ": " << *rNorm0 << endl;
+#endif
+
+#ifdef  FVM_PARALLEL
+  if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+    cout << 0 << ": " << *rNorm0 << endl;
+#endif
+
+  shared_ptr<MultiField> r(dynamic_pointer_cast<MultiField>(ls.getResidual().newCopy()));
+
+  /**
+   * as in CG, the preconditioner approximates -A^-1 and the updates
+   * are subtracted. Besides r we keep u = M r, w = A u and the
+   * recurrences for m = M w and n = A m that let the next search
+   * direction be formed without waiting for the inner products.
+   *
+   */
+
+  shared_ptr<MultiField> u(dynamic_pointer_cast<MultiField>(x->newClone()));
+  shared_ptr<MultiField> w(dynamic_pointer_cast<MultiField>(x->newClone()));
+  shared_ptr<MultiField> m(dynamic_pointer_cast<MultiField>(x->newClone()));
+  shared_ptr<MultiField> n(dynamic_pointer_cast<MultiField>(x->newClone()));
+
+  shared_ptr<MultiField> p;
+  shared_ptr<MultiField> s;
+  shared_ptr<MultiField> q;
+  shared_ptr<MultiField> z;
+
+  u->zero();
+  ls.replaceDelta(u);
+  ls.replaceB(r);
+  preconditioner->smooth(ls);
+  matrix.multiply(*w,*u);
+
+  MFRPtr gamma;
+  MFRPtr gammaPrev;
+  MFRPtr alpha;
+  MFRPtr alphaPrev;
+
+  for(int i = 0; i<nMaxIterations; i++)
+  {
+      _totalIterations++;
+      gammaPrev = gamma;
+      alphaPrev = alpha;
+
+      gamma = r->dotWith(*u,false);
+      MFRPtr delta = w->dotWith(*u,false);
+      MFRPtr rNorm = r->getOneNorm(false);
+
+      MultiFieldReductionSync reductions;
+      reductions.add(*gamma);
+      reductions.add(*delta);
+      reductions.add(*rNorm);
+      reductions.start();
+
+      m->zero();
+      ls.replaceDelta(m);
+      ls.replaceB(w);
+      preconditioner->smooth(ls);
+      matrix.multiply(*n,*m);
+
+      reductions.finish();
+      gamma->reduceSum();
+      delta->reduceSum();
+
+      if (i > 0)
+      {
+          MFRPtr normRatio(rNorm->normalize(*rNorm0));
+
+#ifndef FVM_PARALLEL
+          if (verbosity >0)
+            cout << i << ": " << *rNorm << endl;
+#endif
+
+#ifdef  FVM_PARALLEL
+          if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+            cout << i << ": " << *rNorm << endl;
+#endif
+
+          if (*rNorm < absoluteTolerance || *normRatio < relativeTolerance)
+            break;
+      }
+      else if (*rNorm < absoluteTolerance)
+        break;
+
+      if (!p)
+      {
+          alpha = (*gamma)/(*delta);
+          z = dynamic_pointer_cast<MultiField>(n->newCopy());
+          q = dynamic_pointer_cast<MultiField>(m->newCopy());
+          s = dynamic_pointer_cast<MultiField>(w->newCopy());
+          p = dynamic_pointer_cast<MultiField>(u->newCopy());
+      }
+      else
+      {
+          MFRPtr beta = (*gamma) / (*gammaPrev);
+          MFRPtr betaGamma = (*beta) * (*gamma);
+          *delta += *(-*((*betaGamma) / (*alphaPrev)));
+          alpha = (*gamma)/(*delta);
+
+          *z *= *beta;
+          *z += *n;
+          *q *= *beta;
+          *q += *m;
+          *s *= *beta;
+          *s += *w;
+          *p *= *beta;
+          *p += *u;
+      }
+
+      x->msaxpy(*alpha,*p);
+      r->msaxpy(*alpha,*s);
+      u->msaxpy(*alpha,*q);
+      w->msaxpy(*alpha,*z);
+  }
+
+  ls.replaceDelta(x);
+  ls.replaceB(bOrig);
+#ifdef FVM_PARALLEL
+  x->sync();
+#endif
+
+  matrix.computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+  MFRPtr rNormn(ls.getResidual().getOneNorm());
+
+#ifndef FVM_PARALLEL
+  if (verbosity >0)
+    cout << "n" << ": " << *rNormn << endl;
+#endif
+
+
+#ifdef  FVM_PARALLEL
+  if (verbosity >0 && MPI::COMM_WORLD.Get_rank() == 0)
+    cout << "n" << ": " << *rNormn << endl;
+#endif
+
+  return rNorm0;
+}
+
+void
+PipelinedCG::smooth(LinearSystem& ls)
+{
+  throw CException("cannot use PipelinedCG as preconditioner");
+}
@@ -0,0 +1,54 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _PIPELINEDCG_H_
+#define _PIPELINEDCG_H_
+
+#include <vector>
+#include "LinearSystem.h"
+#include "MultiFieldReduction.h"
+#include "LinearSolver.h"
+
+using namespace std;
+
+/**
+ * Solve a symmetric linear system using the pipelined preconditioned
+ * conjugate gradient method of Ghysels and Vanroose. The inner products
+ * of an iteration are combined into one global reduction that is
+ * started before, and completed after, the preconditioner and matrix
+ * multiply of that iteration, so the latency of the reduction is
+ * hidden behind them.
+ *
+ * The residual norm used for the convergence checks is part of the same
+ * reduction and therefore lags by one iteration.
+ *
+ * The recurrences assume a fixed symmetric preconditioner, e.g. AMG
+ * with nPreSweeps equal to nPostSweeps; use FGMRES for others.
+ *
+ */
+
+class PipelinedCG : public LinearSolver
+{
+public:
+  
+  PipelinedCG();
+  virtual ~PipelinedCG();
+  virtual MFRPtr solve(LinearSystem & ls);
+
+  virtual void cleanup();
+  virtual void smooth(LinearSystem& ls);
+  
+  int getTotalIterations() const { return _totalIterations;}
+
+  DEFINE_TYPENAME("PipelinedCG");
+
+  LinearSolver *preconditioner;
+private:
+
+  PipelinedCG(const PipelinedCG&);
+
+  int _totalIterations;
+};
+
+#endif
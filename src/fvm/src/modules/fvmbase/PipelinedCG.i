@@ -0,0 +1,9 @@
+class PipelinedCG : public LinearSolver
+{
+public:
+
+  PipelinedCG();
+  int getTotalIterations() const;
+  LinearSolver *preconditioner;
+};
+
@@ -51,6 +51,7 @@ public:
     
     const int nCells = cells.getSelfCount();
     
+#pragma omp parallel for if (_threadedAssembly)
     for(int c=0; c<nCells; c++)
     {
         rCell[c] += cellVolume[c]*source[c];
@@ -47,6 +47,8 @@ struct SpeciesModelOptions : public FloatVarDict<T>
     this->transient = false;
     this->ButlerVolmer = false;
     this->timeDiscretizationOrder=1;
+    this->threadedAssembly = false;
+    this->persistentLinearSystem = false;
   }
   double relativeTolerance;
   double absoluteTolerance;
@@ -55,6 +57,8 @@ struct SpeciesModelOptions : public FloatVarDict<T>
   bool transient;
   bool ButlerVolmer;
   int timeDiscretizationOrder;
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 
 #ifndef SWIG
   LinearSolver& getLinearSolver()
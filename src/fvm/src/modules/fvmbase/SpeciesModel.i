@@ -28,6 +28,8 @@ struct SpeciesModelOptions : public FloatVarDict<T>
   bool transient;
   bool ButlerVolmer;
   int timeDiscretizationOrder;
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 }; 
 
 
@@ -47,7 +47,11 @@ public:
     _geomFields(geomFields),
     _niters(0),
     _nSpecies(nSpecies),
-    _speciesModelFields("speciesModel")
+    _speciesModelFields("speciesModel"),
+    _discretizations(nSpecies),
+    _discretizedTransient(false),
+    _discretizedTimeStep(0),
+    _discretizedCentralDifference(false)
   {
     
     const int numMeshes = _meshes.size();
@@ -64,6 +68,7 @@ public:
       _initialNormVector.push_back(iNorm);
       MFRPtr *rCurrent = new MFRPtr();
       _currentResidual.push_back(rCurrent); 
+      _linearSystems.push_back(shared_ptr<LinearSystem>());
         
       for (int n=0; n<numMeshes; n++)
       {
@@ -325,6 +330,8 @@ public:
     
     sFields.diffusivity.syncLocal();
     //iNorm = MFRPtr();
+    _linearSystems[m] = shared_ptr<LinearSystem>();
+    _discretizations[m].clear();
     }
     _niters  =0;    
   }
@@ -424,17 +431,11 @@ public:
     }
   }
 
-  void linearize(LinearSystem& ls, const int& m)
+  void createDiscretizations(const int m)
   {
-    const SpeciesVCMap& svcmap = *_vcMapVector[m];
-    const SpeciesBCMap& sbcmap = *_bcMapVector[m];
     SpeciesFields& sFields = *_speciesFieldsVector[m];
-
-    GradientModel<T> speciesGradientModel(_meshes,sFields.massFraction,
-					  _speciesModelFields.speciesGradient,_geomFields);
-    speciesGradientModel.compute();
-    
-    DiscrList discretizations;
+    DiscrList& discretizations = _discretizations[m];
+    discretizations.clear();
     
     shared_ptr<Discretization>
       dd(new DiffusionDiscretization<T,T,T>
@@ -483,9 +484,36 @@ public:
       
     discretizations.push_back(ibm);
 
-    Linearizer linearizer;
+    _discretizedTransient = _options.transient;
+    _discretizedTimeStep = _options["timeStep"];
+    _discretizedCentralDifference = _options.useCentralDifference;
+  }
 
-    linearizer.linearize(discretizations,_meshes,ls.getMatrix(),
+  // kept with persistent linear systems as in ThermalModel; advance
+  // recreates the ones of all the species together, so the options they
+  // were created with are the same for all of them
+  bool discretizationsAreCurrent() const
+  {
+    return _options.persistentLinearSystem &&
+      _nSpecies > 0 && !_discretizations[0].empty() &&
+      _discretizedTransient == _options.transient &&
+      _discretizedTimeStep == _options["timeStep"] &&
+      _discretizedCentralDifference == _options.useCentralDifference;
+  }
+
+  void linearize(LinearSystem& ls, const int& m)
+  {
+    const SpeciesVCMap& svcmap = *_vcMapVector[m];
+    const SpeciesBCMap& sbcmap = *_bcMapVector[m];
+    SpeciesFields& sFields = *_speciesFieldsVector[m];
+
+    GradientModel<T> speciesGradientModel(_meshes,sFields.massFraction,
+					  _speciesModelFields.speciesGradient,_geomFields);
+    speciesGradientModel.compute();
+
+    Linearizer linearizer(_options.threadedAssembly);
+
+    linearizer.linearize(_discretizations[m],_meshes,ls.getMatrix(),
                          ls.getX(), ls.getB());
 
     const int numMeshes = _meshes.size();
@@ -684,13 +712,25 @@ T getAverageMassFraction(const Mesh& mesh, const int m)
     for(int n=0; n<niter; n++)
     { 
       bool allConverged=true;
+      if (!discretizationsAreCurrent())
+        for (int m=0; m<_nSpecies; m++)
+          createDiscretizations(m);
+
       for (int m=0; m<_nSpecies; m++)
       {
         MFRPtr& iNorm = *_initialNormVector[m];
 	MFRPtr& rCurrent = *_currentResidual[m];
 
-        LinearSystem ls;
-        initLinearization(ls, m);
+        // each species keeps its own system when they are persistent
+        shared_ptr<LinearSystem> lsPtr(_linearSystems[m]);
+        if (!lsPtr || !_options.persistentLinearSystem)
+        {
+            lsPtr = shared_ptr<LinearSystem>(new LinearSystem());
+            initLinearization(*lsPtr, m);
+            if (_options.persistentLinearSystem)
+              _linearSystems[m] = lsPtr;
+        }
+        LinearSystem& ls = *lsPtr;
         
         ls.initAssembly();
 
@@ -778,6 +818,12 @@ private:
 
   //MFRPtr _currentResidual;
   vector<MFRPtr*> _currentResidual;
+  vector<shared_ptr<LinearSystem> > _linearSystems;
+
+  vector<DiscrList> _discretizations;
+  bool _discretizedTransient;
+  T _discretizedTimeStep;
+  bool _discretizedCentralDifference;
 };
 
 template<class T>
@@ -0,0 +1,79 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _SQUAREGRID_H_
+#define _SQUAREGRID_H_
+
+#include "Mesh.h"
+
+inline void
+addSquareGridFace(Array<int>& faceCells, Array<int>& faceNodes, int& f,
+                  const int c0, const int c1, const int n0, const int n1)
+{
+  faceCells[2*f] = c0;
+  faceCells[2*f+1] = c1;
+  faceNodes[2*f] = n0;
+  faceNodes[2*f+1] = n1;
+  f++;
+}
+
+/**
+ * An n x n grid of square cells on the unit square, used by the
+ * tests. The boundary faces are in one group per side, left, right,
+ * bottom and top, and their ghost cells are numbered after the cells.
+ *
+ */
+inline Mesh*
+createSquareGrid(const int n)
+{
+  typedef Vector<double,3> VecD3;
+  const int nCells = n*n;
+  const int nInteriorFaces = 2*n*(n-1);
+  const int nFaces = nInteriorFaces + 4*n;
+  const int nx = n+1;
+
+  Array<VecD3> coords(nx*nx);
+  for(int j=0; j<=n; j++)
+    for(int i=0; i<=n; i++)
+    {
+        VecD3& x = coords[j*nx+i];
+        x[0] = double(i)/n;
+        x[1] = double(j)/n;
+        x[2] = 0;
+    }
+
+  Array<int> faceCells(2*nFaces);
+  Array<int> faceNodes(2*nFaces);
+  Array<int> faceNodeCount(nFaces);
+  Array<int> groupSize(5);
+  faceNodeCount = 2;
+
+  int f = 0;
+  for(int j=0; j<n; j++)
+    for(int i=0; i<n-1; i++)
+      addSquareGridFace(faceCells,faceNodes,f,j*n+i,j*n+i+1,
+                        j*nx+i+1,(j+1)*nx+i+1);
+  for(int j=0; j<n-1; j++)
+    for(int i=0; i<n; i++)
+      addSquareGridFace(faceCells,faceNodes,f,j*n+i,(j+1)*n+i,
+                        (j+1)*nx+i+1,(j+1)*nx+i);
+
+  int g = nCells;
+  for(int j=0; j<n; j++)
+    addSquareGridFace(faceCells,faceNodes,f,j*n,g++,(j+1)*nx,j*nx);
+  for(int j=0; j<n; j++)
+    addSquareGridFace(faceCells,faceNodes,f,j*n+n-1,g++,j*nx+n,(j+1)*nx+n);
+  for(int i=0; i<n; i++)
+    addSquareGridFace(faceCells,faceNodes,f,i,g++,i,i+1);
+  for(int i=0; i<n; i++)
+    addSquareGridFace(faceCells,faceNodes,f,(n-1)*n+i,g++,n*nx+i+1,n*nx+i);
+
+  groupSize[0] = nInteriorFaces;
+  for(int side=1; side<5; side++)
+    groupSize[side] = n;
+
+  return new Mesh(2,nCells,coords,faceCells,faceNodes,faceNodeCount,groupSize);
+}
+
+#endif
@@ -431,6 +431,30 @@ void setFlatCoeffs(Array<double>& flatCoeffs,
   }
 }
 
+template<int N>
+void setFlatCoeffs(Array<double>& flatCoeffs,
+                   const Array<int>& flatPositions,
+                   const Array<SquareTensor<double,N> >& diag,
+                   const Array<SquareTensor<double,N> >& offDiag,
+                   const CRConnectivity& connectivity)
+{
+    const Array<int>& myRow = connectivity.getRow();
+    const int rowDim = connectivity.getRowDim();
+    
+    int np=0;
+    for(int i=0; i<rowDim; i++)
+    {
+        for(int ndr=0; ndr<N; ndr++)
+          for(int ndc=0; ndc<N; ndc++)
+            flatCoeffs[flatPositions[np++]] = diag[i](ndr,ndc);
+      
+        for(int jp=myRow[i]; jp<myRow[i+1]; jp++)
+          for(int ndr=0; ndr<N; ndr++)
+            for(int ndc=0; ndc<N; ndc++)
+              flatCoeffs[flatPositions[np++]] = offDiag[jp](ndr,ndc);
+    }
+}
+
 
 
 /*
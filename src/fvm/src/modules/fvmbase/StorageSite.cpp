@@ -31,4 +31,65 @@ StorageSite::clearGatherScatterMaps()
 {
   _gatherMap.clear();
   _scatterMap.clear();
+  _interfaceIndices.reset();
+  _interiorIndices.reset();
+}
+
+void
+StorageSite::clearInterfaceIndices()
+{
+  _interfaceIndices.reset();
+  _interiorIndices.reset();
+}
+
+const Array<int>&
+StorageSite::getInterfaceIndices() const
+{
+  if (!_interfaceIndices)
+    createInterfaceIndices();
+  return *_interfaceIndices;
+}
+
+const Array<int>&
+StorageSite::getInteriorIndices() const
+{
+  if (!_interiorIndices)
+    createInterfaceIndices();
+  return *_interiorIndices;
+}
+
+void
+StorageSite::createInterfaceIndices() const
+{
+  Array<bool> isInterface(_count);
+  isInterface = false;
+
+  int nInterface = 0;
+  foreach(const ScatterMap::value_type& mpos, _scatterMap)
+  {
+      const Array<int>& fromIndices = *mpos.second;
+      const int nFrom = fromIndices.getLength();
+      for(int i=0; i<nFrom; i++)
+      {
+          const int n = fromIndices[i];
+          if (n < _selfCount && !isInterface[n])
+          {
+              isInterface[n] = true;
+              nInterface++;
+          }
+      }
+  }
+
+  _interfaceIndices = shared_ptr<Array<int> >(new Array<int>(nInterface));
+  _interiorIndices = shared_ptr<Array<int> >(new Array<int>(_count-nInterface));
+
+  int nf = 0;
+  int ni = 0;
+  for(int n=0; n<_count; n++)
+  {
+      if (isInterface[n])
+        (*_interfaceIndices)[nf++] = n;
+      else
+        (*_interiorIndices)[ni++] = n;
+  }
 }
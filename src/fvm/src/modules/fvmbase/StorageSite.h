@@ -44,6 +44,8 @@ public:
     _count = selfCount+nGhost;
     _selfCount = selfCount;
     _countLevel1 = _count;
+    _interfaceIndices.reset();
+    _interiorIndices.reset();
   }
 
 
@@ -78,6 +80,22 @@ public:
 
 
   void clearGatherScatterMaps();
+
+  /**
+   * the indices of this site split for overlapping a sync with
+   * computation. The interface indices are the self indices sent to
+   * other meshes or processes, which for cells are also the ones next
+   * to the ghosts received from them. The interior indices are all the
+   * others, including the ghosts. Both are sorted and computed from
+   * the scatter map on first use, so they should only be asked for
+   * once it has been set up.
+   *
+   */
+  const Array<int>& getInterfaceIndices() const;
+  const Array<int>& getInteriorIndices() const;
+
+  // to be called when the indices in the scatter map are changed
+  void clearInterfaceIndices();
   
   int getScatterProcID() const { return _scatterProcID;}
   int getGatherProcID()  const { return _gatherProcID; }
@@ -109,6 +127,11 @@ private:
   int   _gatherProcID;
   int   _tag;
 
+  mutable shared_ptr<Array<int> > _interfaceIndices;
+  mutable shared_ptr<Array<int> > _interiorIndices;
+
+  void createInterfaceIndices() const;
+
 };
 
 typedef vector<const StorageSite*> StorageSiteList;
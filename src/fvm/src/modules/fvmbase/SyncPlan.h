@@ -0,0 +1,229 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef _SYNCPLAN_H_
+#define _SYNCPLAN_H_
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include "misc.h"
+#include "Array.h"
+#include "ArrayBase.h"
+
+/**
+ * The communication plan for the ghost exchange of a Field, MultiField
+ * or similar container. It is created once from the scatter and
+ * gather maps and lists the buffers that are packed from and unpacked
+ * into the container, together with the indices used for that and a
+ * key that the container uses to find the array they belong to.
+ *
+ * All the buffers exchanged with the same process and tag are sent as
+ * a single message, described by a datatype listing their addresses,
+ * so the exchange costs one persistent request per neighbour however
+ * many arrays and sites take part in it. The buffers must therefore be
+ * added in the same order on both sides and must not be reallocated
+ * while the plan exists.
+ *
+ */
+
+template<class Key>
+class SyncPlan
+{
+public:
+
+  struct Buffer
+  {
+    Buffer(const Key& key_, const Array<int>& indices_, ArrayBase& data_) :
+      key(key_),
+      indices(&indices_),
+      data(&data_)
+    {}
+
+    Key key;
+    const Array<int>* indices;
+    ArrayBase* data;
+  };
+
+  typedef vector<Buffer> BufferList;
+
+  SyncPlan() :
+    _sendBuffers(),
+    _recvBuffers(),
+    _started(false),
+    _requestsCreated(false)
+  {}
+
+  ~SyncPlan()
+  {
+#ifdef FVM_PARALLEL
+    // containers held by python may only go away after MPI is finalized
+    if (!MPI::Is_finalized())
+    {
+        for(size_t i=0; i<_requests.size(); i++)
+          _requests[i].Free();
+        for(size_t i=0; i<_types.size(); i++)
+          _types[i].Free();
+    }
+#endif
+  }
+
+  // a proc of -1 means the buffer is for another mesh on this process
+  void addSend(const Key& key, const Array<int>& fromIndices, ArrayBase& buffer,
+               const int proc, const int tag)
+  {
+    _sendBuffers.push_back(Buffer(key,fromIndices,buffer));
+    if (proc != -1)
+      addToMessage(_sendMessages,buffer,proc,tag);
+  }
+
+  void addRecv(const Key& key, const Array<int>& toIndices, ArrayBase& buffer,
+               const int proc, const int tag)
+  {
+    _recvBuffers.push_back(Buffer(key,toIndices,buffer));
+    if (proc != -1)
+      addToMessage(_recvMessages,buffer,proc,tag);
+  }
+
+  const BufferList& getSendBuffers() const {return _sendBuffers;}
+  const BufferList& getRecvBuffers() const {return _recvBuffers;}
+
+  int getMessageCount() const
+  {
+    return int(_sendMessages.size() + _recvMessages.size());
+  }
+
+  // to be called after the send buffers have been packed
+  void start()
+  {
+    if (_started)
+      throw CException("SyncPlan::start: exchange already in progress");
+    _started = true;
+#ifdef FVM_PARALLEL
+    if (!_requestsCreated)
+      createRequests();
+    if (!_requests.empty())
+      MPI::Prequest::Startall(int(_requests.size()), &_requests[0]);
+#endif
+  }
+
+  // after this the receive buffers can be unpacked
+  void finish()
+  {
+    if (!_started)
+      throw CException("SyncPlan::finish: exchange not started");
+    _started = false;
+#ifdef FVM_PARALLEL
+    if (!_requests.empty())
+      MPI::Request::Waitall(int(_requests.size()), &_requests[0]);
+#endif
+  }
+
+private:
+  SyncPlan(const SyncPlan&);
+  SyncPlan& operator=(const SyncPlan&);
+
+  struct Message
+  {
+    Message(const int proc_, const int tag_) :
+      proc(proc_),
+      tag(tag_),
+      buffers()
+    {}
+
+    int proc;
+    int tag;
+    vector<ArrayBase*> buffers;
+  };
+
+  typedef vector<Message> MessageList;
+
+  void addToMessage(MessageList& messages, ArrayBase& buffer,
+                    const int proc, const int tag)
+  {
+    if (_requestsCreated)
+      throw CException("SyncPlan: buffers added after the exchange started");
+
+    for(size_t m=0; m<messages.size(); m++)
+      if (messages[m].proc == proc && messages[m].tag == tag)
+      {
+          messages[m].buffers.push_back(&buffer);
+          return;
+      }
+    messages.push_back(Message(proc,tag));
+    messages.back().buffers.push_back(&buffer);
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Datatype createType(const Message& message)
+  {
+    const int count = int(message.buffers.size());
+    vector<int> lengths(count);
+    vector<MPI::Aint> addresses(count);
+    for(int i=0; i<count; i++)
+    {
+        lengths[i] = message.buffers[i]->getDataSize();
+        addresses[i] = MPI::Get_address(message.buffers[i]->getData());
+    }
+    MPI::Datatype type = MPI::BYTE.Create_hindexed(count, &lengths[0],
+                                                   &addresses[0]);
+    type.Commit();
+    _types.push_back(type);
+    return type;
+  }
+
+  void createRequests()
+  {
+    // messages with a single buffer are sent from it directly
+    for(size_t m=0; m<_sendMessages.size(); m++)
+    {
+        const Message& message = _sendMessages[m];
+        const ArrayBase& b = *message.buffers[0];
+        if (message.buffers.size() == 1)
+          _requests.push_back(MPI::COMM_WORLD.Send_init(b.getData(),
+                                                        b.getDataSize(),
+                                                        MPI::BYTE,
+                                                        message.proc,
+                                                        message.tag));
+        else
+          _requests.push_back(MPI::COMM_WORLD.Send_init(MPI::BOTTOM, 1,
+                                                        createType(message),
+                                                        message.proc,
+                                                        message.tag));
+    }
+
+    for(size_t m=0; m<_recvMessages.size(); m++)
+    {
+        const Message& message = _recvMessages[m];
+        const ArrayBase& b = *message.buffers[0];
+        if (message.buffers.size() == 1)
+          _requests.push_back(MPI::COMM_WORLD.Recv_init(b.getData(),
+                                                        b.getDataSize(),
+                                                        MPI::BYTE,
+                                                        message.proc,
+                                                        message.tag));
+        else
+          _requests.push_back(MPI::COMM_WORLD.Recv_init(MPI::BOTTOM, 1,
+                                                        createType(message),
+                                                        message.proc,
+                                                        message.tag));
+    }
+    _requestsCreated = true;
+  }
+#endif
+
+  BufferList _sendBuffers;
+  BufferList _recvBuffers;
+  MessageList _sendMessages;
+  MessageList _recvMessages;
+  bool _started;
+  bool _requestsCreated;
+#ifdef FVM_PARALLEL
+  vector<MPI::Prequest> _requests;
+  vector<MPI::Datatype> _types;
+#endif
+};
+
+#endif
@@ -45,6 +45,8 @@ struct ThermalModelOptions : public FloatVarDict<T>
     this->useCentralDifference=false;
     this->transient=false;
     this->timeDiscretizationOrder = 1;
+    this->threadedAssembly = false;
+    this->persistentLinearSystem = false;
   }
   double relativeTolerance;
   double absoluteTolerance;
@@ -52,6 +54,8 @@ struct ThermalModelOptions : public FloatVarDict<T>
   LinearSolver *linearSolver;
   bool transient;
   int timeDiscretizationOrder;
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 #ifndef SWIG
   LinearSolver& getLinearSolver()
   {
@@ -27,6 +27,8 @@ struct ThermalModelOptions : public FloatVarDict<T>
   LinearSolver *linearSolver;
   bool useCentralDifference;
   bool transient;
+  bool threadedAssembly;
+  bool persistentLinearSystem;
 }; 
 
 
@@ -47,7 +47,11 @@ public:
     _temperatureGradientModel(_meshes,_thermalFields.temperature,
                               _thermalFields.temperatureGradient,_geomFields),
     _initialNorm(),
-    _niters(0)
+    _niters(0),
+    _discretizations(),
+    _discretizedTransient(false),
+    _discretizedTimeStep(0),
+    _discretizedCentralDifference(false)
   {
     const int numMeshes = _meshes.size();
     for (int n=0; n<numMeshes; n++)
@@ -169,6 +173,8 @@ public:
     _thermalFields.conductivity.syncLocal();
     _niters  =0;
     _initialNorm = MFRPtr();
+    _ls = shared_ptr<LinearSystem>();
+    _discretizations.clear();
   }
   
   ThermalBCMap& getBCMap() {return _bcMap;}
@@ -233,11 +239,10 @@ public:
     }
   }
 
-  void linearize(LinearSystem& ls)
+  void createDiscretizations()
   {
-    _temperatureGradientModel.compute();
-    
-    DiscrList discretizations;
+    DiscrList& discretizations = _discretizations;
+    discretizations.clear();
    
     shared_ptr<Discretization>
       dd(new DiffusionDiscretization<T,T,T>
@@ -284,11 +289,34 @@ public:
 	  (_meshes,_geomFields,_thermalFields.temperature));
       
     discretizations.push_back(ibm);
+
+    _discretizedTransient = _options.transient;
+    _discretizedTimeStep = _options["timeStep"];
+    _discretizedCentralDifference = _options.useCentralDifference;
+  }
+
+  // with a persistent linear system the discretizations are also kept
+  // across iterations; they only hold references to the fields, so they
+  // only need to be recreated when one of the options they copy changes
+  bool discretizationsAreCurrent() const
+  {
+    return _options.persistentLinearSystem &&
+      !_discretizations.empty() &&
+      _discretizedTransient == _options.transient &&
+      _discretizedTimeStep == _options["timeStep"] &&
+      _discretizedCentralDifference == _options.useCentralDifference;
+  }
+
+  void linearize(LinearSystem& ls)
+  {
+    _temperatureGradientModel.compute();
     
+    if (!discretizationsAreCurrent())
+      createDiscretizations();
 
-    Linearizer linearizer;
+    Linearizer linearizer(_options.threadedAssembly);
 
-    linearizer.linearize(discretizations,_meshes,ls.getMatrix(),
+    linearizer.linearize(_discretizations,_meshes,ls.getMatrix(),
                          ls.getX(), ls.getB());
 
     const int numMeshes = _meshes.size();
@@ -425,8 +453,18 @@ public:
   {
     for(int n=0; n<niter; n++)
     { 
-        LinearSystem ls;
-        initLinearization(ls);
+        // with a persistent linear system the matrices and vectors
+        // are only created the first time and their values are reset
+        // by initAssembly in later iterations
+        shared_ptr<LinearSystem> lsPtr(_ls);
+        if (!lsPtr || !_options.persistentLinearSystem)
+        {
+            lsPtr = shared_ptr<LinearSystem>(new LinearSystem());
+            initLinearization(*lsPtr);
+            if (_options.persistentLinearSystem)
+              _ls = lsPtr;
+        }
+        LinearSystem& ls = *lsPtr;
         
         ls.initAssembly();
 
@@ -625,6 +663,12 @@ private:
   
   MFRPtr _initialNorm;
   int _niters;
+  shared_ptr<LinearSystem> _ls;
+
+  DiscrList _discretizations;
+  bool _discretizedTransient;
+  T _discretizedTimeStep;
+  bool _discretizedCentralDifference;
 };
 
 template<class T>
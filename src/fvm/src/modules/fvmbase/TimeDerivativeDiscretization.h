@@ -85,6 +85,7 @@ public:
 	      dynamic_cast<const TArray&>(_geomFields.volumeN1[cells]);
 	    const TArray& cellVolumeN2 = 
               dynamic_cast<const TArray&>(_geomFields.volumeN2[cells]);
+#pragma omp parallel for if (_threadedAssembly)
             for(int c=0; c<nCells; c++)
 	    {
                 const T_Scalar rhoVbydT = density[c]*cellVolume[c]/_dT;
@@ -99,6 +100,7 @@ public:
 	}
 	else
 	{
+#pragma omp parallel for if (_threadedAssembly)
             for(int c=0; c<nCells; c++)
             {
                 const T_Scalar rhoVbydT = density[c]*cellVolume[c]/_dT;
@@ -114,6 +116,7 @@ public:
 	{
 	    const TArray& cellVolumeN1 =
 	      dynamic_cast<const TArray&>(_geomFields.volumeN1[cells]);
+#pragma omp parallel for if (_threadedAssembly)
 	    for(int c=0; c<nCells; c++)
             {	    
 	        const T_Scalar rhoVbydT = density[c]*cellVolume[c]/_dT;
@@ -132,6 +135,7 @@ public:
 	      dynamic_cast<const IntArray&>(_geomFields.ibTypeN1[cells]);
 	    const IntArray& ibType =
 	      dynamic_cast<const IntArray&>(_geomFields.ibType[cells]);
+#pragma omp parallel for if (_threadedAssembly)
 	    for(int c=0; c<nCells; c++)
             {	    
 	        const T_Scalar rhoVbydT = density[c]*cellVolume[c]/_dT;
@@ -146,6 +150,7 @@ public:
 	}
         else
 	{
+#pragma omp parallel for if (_threadedAssembly)
             for(int c=0; c<nCells; c++)
             {
                 const T_Scalar rhoVbydT = density[c]*cellVolume[c]/_dT;
@@ -340,6 +340,12 @@ struct ArrayScalarTraits<Vector<T,N> >
           val[i] = max;
     }
   }
+
+  static void sqrt(Vector<T,N>& val)
+  {
+    for(int i=0; i<N; i++)
+      ArrayScalarTraits<T>::sqrt(val[i]);
+  }
 };
 
 #endif
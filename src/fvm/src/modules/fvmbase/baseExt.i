@@ -9,6 +9,8 @@
 #include "AMG.h"
 #include "BCGStab.h"
 #include "CG.h"
+#include "FGMRES.h"
+#include "PipelinedCG.h"
 #include "ILU0Solver.h"
 #include "JacobiSolver.h"
 #include "DirectSolver.h"
@@ -66,12 +68,15 @@ typedef Vector<double,3> VecD3;
 %template(VecD3) Vector<double,3>;
 
 %include "Field.i"
+%include "FieldGroup.i"
 %include "CRConnectivity.i"
 %include "Mesh.i"
 %include "LinearSolver.i"
 %include "AMG.i"
 %include "BCGStab.i"
 %include "CG.i"
+%include "FGMRES.i"
+%include "PipelinedCG.i"
 %include "JacobiSolver.i"
 %include "DirectSolver.i"
 %include "SpikeSolver.i"
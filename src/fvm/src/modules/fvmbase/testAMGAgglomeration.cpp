@@ -0,0 +1,252 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Compares AMG agglomerating its coarse levels with AMG without it.
+//
+// usage: mpirun -np N testAMGAgglomeration [n]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "AMG.h"
+#include "CRConnectivity.h"
+#include "CRMatrix.h"
+#include "LinearSystem.h"
+
+namespace
+{
+  // the planes of a process, with the plane below it, if any, as the
+  // first ghosts and the one above it as the last
+  struct Slab
+  {
+    Slab(const int n, const int nProcs, const int rank) :
+      n(n),
+      kBegin((rank*n)/nProcs),
+      kEnd(((rank+1)*n)/nProcs),
+      nSelf(n*n*(kEnd-kBegin)),
+      cells(nSelf, n*n*((kBegin > 0) + (kEnd < n))),
+      below(-1),
+      above(-1)
+    {
+      int ghost = nSelf;
+      if (kBegin > 0)
+      {
+          couple(below,rank-1,rank,0,ghost);
+          ghost += n*n;
+      }
+      if (kEnd < n)
+        couple(above,rank+1,rank,nSelf-n*n,ghost);
+    }
+
+    void couple(StorageSite& site, const int proc, const int rank,
+                const int first, const int firstGhost)
+    {
+      site.setGatherProcID(proc);
+      site.setScatterProcID(rank);
+      site.setTag((max(rank,proc) << 16) | min(rank,proc));
+
+      shared_ptr<Array<int> > fromIndices(new Array<int>(n*n));
+      shared_ptr<Array<int> > toIndices(new Array<int>(n*n));
+      for(int i=0; i<n*n; i++)
+      {
+          (*fromIndices)[i] = first + i;
+          (*toIndices)[i] = firstGhost + i;
+      }
+      cells.getScatterMap()[&site] = fromIndices;
+      cells.getGatherMap()[&site] = toIndices;
+    }
+
+    // the row of the cell (i,j,k), the neighbours outside the grid
+    // being -1
+    int getRow(const int i, const int j, const int k) const
+    {
+      if (i < 0 || i >= n || j < 0 || j >= n || k < 0 || k >= n)
+        return -1;
+      if (k < kBegin)
+        return nSelf + i + j*n;
+      if (k >= kEnd)
+        return cells.getCount() - n*n + i + j*n;
+      return i + (j + (k-kBegin)*n)*n;
+    }
+
+    shared_ptr<CRConnectivity> createStencil() const
+    {
+      shared_ptr<CRConnectivity> conn(new CRConnectivity(cells,cells));
+      conn->initCount();
+      for(int pass=0; pass<2; pass++)
+      {
+          for(int k=kBegin; k<kEnd; k++)
+            for(int j=0; j<n; j++)
+              for(int i=0; i<n; i++)
+              {
+                  const int c = getRow(i,j,k);
+                  const int nb[6] = {getRow(i-1,j,k), getRow(i+1,j,k),
+                                     getRow(i,j-1,k), getRow(i,j+1,k),
+                                     getRow(i,j,k-1), getRow(i,j,k+1)};
+                  for(int m=0; m<6; m++)
+                    if (nb[m] >= 0)
+                    {
+                        if (pass == 0)
+                          conn->addCount(c,1);
+                        else
+                          conn->add(c,nb[m]);
+                    }
+              }
+          if (pass == 0)
+            conn->finishCount();
+      }
+      conn->finishAdd();
+      return conn;
+    }
+
+    const int n;
+    const int kBegin;
+    const int kEnd;
+    const int nSelf;
+    StorageSite cells;
+    StorageSite below;
+    StorageSite above;
+  };
+
+  struct Result
+  {
+    int nCycles;
+    bool converged;
+    vector<double> x;
+  };
+
+  Result solve(const Slab& slab, const bool symmetric,
+               const int mergeRowsPerProcess, const int factor)
+  {
+    const StorageSite& cells = slab.cells;
+    shared_ptr<CRConnectivity> conn(slab.createStencil());
+
+    Field x("x");
+    x.addArray(cells,shared_ptr<ArrayBase>(new Array<double>(cells.getCount())));
+    x[cells].zero();
+
+    MultiField::ArrayIndex xIndex(&x,&cells);
+    LinearSystem ls;
+    ls.getX().addArray(xIndex,x.getArrayPtr(cells));
+    shared_ptr<CRMatrix<double,double,double> >
+      m(new CRMatrix<double,double,double>(*conn));
+    ls.getMatrix().addMatrix(xIndex,xIndex,m);
+    ls.initAssembly();
+
+    // a Laplacian with the boundary cells coupled to a fixed value, with
+    // an upwinded flow along i added to the unsymmetric one
+    const int n = slab.n;
+    const double upwind = symmetric ? 0 : 0.5;
+    Array<double>& diag = m->getDiag();
+    Array<double>& offDiag = m->getOffDiag();
+    const Array<int>& row = conn->getRow();
+    const Array<int>& col = conn->getCol();
+    Array<double>& b = dynamic_cast<Array<double>&>(ls.getB()[xIndex]);
+    for(int c=0; c<slab.nSelf; c++)
+    {
+        const int i = c%n;
+        const int j = (c/n)%n;
+        const int k = slab.kBegin + c/(n*n);
+        diag[c] = -6.0;
+        for(int nb=row[c]; nb<row[c+1]; nb++)
+        {
+            offDiag[nb] = 1.0;
+            if (col[nb] == slab.getRow(i-1,j,k))
+              offDiag[nb] += upwind;
+            else if (col[nb] == slab.getRow(i+1,j,k))
+              offDiag[nb] -= upwind;
+        }
+        b[c] = ((c + slab.kBegin*n*n)%7) - 3.0;
+    }
+    ls.initSolve();
+    ls.isSymmetric = symmetric;
+
+    AMG amg;
+    amg.mergeRowsPerProcess = mergeRowsPerProcess;
+    amg.agglomerationFactor = factor;
+    amg.relativeTolerance = 1e-10;
+    amg.nMaxIterations = 200;
+    amg.verbosity = 0;
+    MFRPtr rNorm0 = amg.solve(ls);
+
+    Result r;
+    r.nCycles = amg.getTotalIterations();
+    amg.cleanup();
+
+    ls.getMatrix().computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+    MFRPtr rNorm = ls.getResidual().getOneNorm();
+    r.converged = *(rNorm->normalize(*rNorm0)) < 1e-9;
+
+    const Array<double>& delta =
+      dynamic_cast<const Array<double>&>(ls.getDelta()[xIndex]);
+    r.x.resize(slab.nSelf);
+    for(int c=0; c<slab.nSelf; c++)
+      r.x[c] = delta[c];
+    return r;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+  const int rank = MPI::COMM_WORLD.Get_rank();
+  const int nProcs = MPI::COMM_WORLD.Get_size();
+#else
+  const int rank = 0;
+  const int nProcs = 1;
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 24;
+  Slab slab(n,nProcs,rank);
+
+  // agglomerate from the start, each time the processes are halved or
+  // quartered
+  const int nRows = n*n*n;
+
+  int nFailed = 0;
+  for(int symmetric=0; symmetric<2; symmetric++)
+  {
+      const Result reference = solve(slab,symmetric == 1,0,4);
+      for(int factor=2; factor<=4; factor+=2)
+      {
+          const Result r = solve(slab,symmetric == 1,nRows,factor);
+
+          double diff = 0;
+          double norm = 0;
+          for(int c=0; c<slab.nSelf; c++)
+          {
+              diff = max(diff,fabs(r.x[c]-reference.x[c]));
+              norm = max(norm,fabs(reference.x[c]));
+          }
+#ifdef FVM_PARALLEL
+          MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,&diff,1,MPI::DOUBLE,MPI::MAX);
+          MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,&norm,1,MPI::DOUBLE,MPI::MAX);
+#endif
+
+          const bool ok = r.converged && reference.converged &&
+            r.nCycles < 2*reference.nCycles + 5 && diff <= 1e-6*norm;
+          if (rank == 0)
+            cout << (symmetric ? "symmetric" : "unsymmetric")
+                 << ", factor " << factor << ": " << r.nCycles
+                 << " cycles against " << reference.nCycles
+                 << ", difference " << diff/norm
+                 << (ok ? "" : "  FAILED") << endl;
+          if (!ok)
+            nFailed++;
+      }
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Counts the heap allocations of AMG cycles and of ThermalModel iterations.
+//
+// usage: testAMGAllocations [n] [nCycles]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <sys/time.h>
+
+using namespace std;
+
+#include "AMG.h"
+#include "CRConnectivity.h"
+#include "CRMatrix.h"
+#include "LinearSystem.h"
+#include "SquareGrid.h"
+#include "GeomFields.h"
+#include "ThermalFields.h"
+#include "MeshMetricsCalculator.h"
+#include "MeshMetricsCalculator_impl.h"
+#include "ThermalModel.h"
+#include "ThermalModel_impl.h"
+
+namespace
+{
+  long nAllocations = 0;
+  size_t largestAllocation = 0;
+}
+
+// noinline keeps the compiler from pairing the inlined malloc and free
+// with the new and delete expressions in this file
+__attribute__((noinline)) void* operator new(size_t size)
+{
+  nAllocations++;
+  largestAllocation = max(largestAllocation,size);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+__attribute__((noinline)) void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) throw()
+{
+  free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) throw()
+{
+  operator delete(p);
+}
+
+namespace
+{
+  double wallTime()
+  {
+    struct timeval tv;
+    gettimeofday(&tv,0);
+    return tv.tv_sec + 1.0e-6*tv.tv_usec;
+  }
+
+  shared_ptr<CRConnectivity> createStencil(const StorageSite& cells, const int n)
+  {
+    shared_ptr<CRConnectivity> conn(new CRConnectivity(cells,cells));
+    const int nCells = n*n*n;
+
+    conn->initCount();
+    for(int pass=0; pass<2; pass++)
+    {
+        for(int k=0; k<n; k++)
+          for(int j=0; j<n; j++)
+            for(int i=0; i<n; i++)
+            {
+                const int c = (k*n+j)*n+i;
+                const int nb[6] = {i>0 ? c-1 : -1, i<n-1 ? c+1 : -1,
+                                   j>0 ? c-n : -1, j<n-1 ? c+n : -1,
+                                   k>0 ? c-n*n : -1, k<n-1 ? c+n*n : -1};
+                for(int m=0; m<6; m++)
+                  if (nb[m] >= 0)
+                  {
+                      if (pass == 0)
+                        conn->addCount(c,1);
+                      else
+                        conn->add(c,nb[m]);
+                  }
+            }
+        if (pass == 0)
+          conn->finishCount();
+    }
+    conn->finishAdd();
+
+    if (conn->getRowDim() != nCells)
+      throw CException("createStencil: wrong row count");
+    return conn;
+  }
+
+  // a Laplacian with the boundary cells coupled to a fixed value
+  void setCoeffs(CRMatrix<double,double,double>& m, const CRConnectivity& conn)
+  {
+    Array<double>& diag = m.getDiag();
+    Array<double>& offDiag = m.getOffDiag();
+    const Array<int>& row = conn.getRow();
+    for(int c=0; c<conn.getRowDim(); c++)
+    {
+        diag[c] = -6.0;
+        for(int nb=row[c]; nb<row[c+1]; nb++)
+          offDiag[nb] = 1.0;
+    }
+  }
+
+  struct Case
+  {
+    const char* name;
+    AMG::CycleType cycleType;
+    AMG::SmootherType smootherType;
+    bool singlePrecision;
+    bool directSolve;
+    bool symmetric;
+    bool mayAllocate;
+  };
+
+  bool runCase(const Case& c, const int n, const int nCycles)
+  {
+    StorageSite cells(n*n*n);
+    shared_ptr<CRConnectivity> conn(createStencil(cells,n));
+    Field x("x");
+    x.addArray(cells,shared_ptr<ArrayBase>(new Array<double>(cells.getCount())));
+    x[cells].zero();
+
+    MultiField::ArrayIndex xIndex(&x,&cells);
+    LinearSystem ls;
+    ls.getX().addArray(xIndex,x.getArrayPtr(cells));
+    shared_ptr<CRMatrix<double,double,double> >
+      m(new CRMatrix<double,double,double>(*conn));
+    ls.getMatrix().addMatrix(xIndex,xIndex,m);
+    ls.initAssembly();
+    setCoeffs(*m,*conn);
+    Array<double>& b = dynamic_cast<Array<double>&>(ls.getB()[xIndex]);
+    for(int i=0; i<b.getLength(); i++)
+      b[i] = (i%7) - 3.0;
+    ls.initSolve();
+    ls.isSymmetric = c.symmetric;
+
+    AMG amg;
+    amg.cycleType = c.cycleType;
+    amg.smootherType = c.smootherType;
+    amg.singlePrecision = c.singlePrecision;
+    amg.coarsestLevelDirectSolve = c.directSolve;
+    amg.reuseCoarseLevels = true;
+    amg.verbosity = 0;
+
+    // the first cycle creates the hierarchy and the work arrays
+    amg.smooth(ls);
+
+    const long nAllocations0 = nAllocations;
+    const double t0 = wallTime();
+    for(int i=0; i<nCycles; i++)
+      amg.smooth(ls);
+    const double tCycle = (wallTime()-t0)/nCycles;
+    const long perCycle = (nAllocations - nAllocations0 + nCycles - 1)/nCycles;
+
+    amg.cleanup();
+
+    const bool ok = perCycle == 0 || c.mayAllocate;
+    cout << c.name << ": " << perCycle << " allocations per cycle, "
+         << tCycle << " s per cycle" << (ok ? "" : "  FAILED") << endl;
+    return ok;
+  }
+
+  // the allocations per iteration with nCycles AMG cycles per solve, and
+  // the size of the largest of them
+  long countModelAllocations(const MeshList& meshes,
+                             const GeomFields& geomFields,
+                             const int nIterations, const int nCycles,
+                             const bool persistent, size_t& largest)
+  {
+    ThermalFields thermalFields("therm");
+    ThermalModel<double> model(geomFields,thermalFields,meshes);
+    model.getBC(1).bcType = "SpecifiedTemperature";
+    model.getBC(2).bcType = "SpecifiedTemperature";
+    model.getBC(2).find("specifiedTemperature")->second.constant = 400.0;
+
+    AMG amg;
+    amg.relativeTolerance = 0;
+    amg.absoluteTolerance = 0;
+    amg.nMaxIterations = nCycles;
+    amg.verbosity = 0;
+    amg.reuseCoarseLevels = persistent;
+
+    ThermalModelOptions<double>& options = model.getOptions();
+    options.persistentLinearSystem = persistent;
+    options.linearSolver = &amg;
+
+    model.init();
+    model.advance(2);
+
+    const long nAllocations0 = nAllocations;
+    largestAllocation = 0;
+    model.advance(nIterations);
+    largest = largestAllocation;
+    const long perIteration = (nAllocations - nAllocations0)/nIterations;
+
+    cout << "ThermalModel, " << (persistent ? "" : "not ")
+         << "persistent, " << nCycles << " cycles per solve: " << perIteration
+         << " allocations per iteration, the largest of " << largest
+         << " bytes" << endl;
+    return perIteration;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 24;
+  const int nCycles = argc > 2 ? atoi(argv[2]) : 10;
+
+  const Case cases[] =
+    {
+      {"V cycle, GaussSeidel", AMG::V_CYCLE, AMG::GAUSS_SEIDEL,
+       false, false, false, false},
+      {"W cycle, GaussSeidel", AMG::W_CYCLE, AMG::GAUSS_SEIDEL,
+       false, false, false, false},
+      {"F cycle, GaussSeidel", AMG::F_CYCLE, AMG::GAUSS_SEIDEL,
+       false, false, false, false},
+      {"V cycle, Jacobi", AMG::V_CYCLE, AMG::JACOBI,
+       false, false, false, false},
+      {"V cycle, hybrid GaussSeidel", AMG::V_CYCLE, AMG::HYBRID_GAUSS_SEIDEL,
+       false, false, false, false},
+      {"V cycle, l1 Jacobi", AMG::V_CYCLE, AMG::L1_JACOBI,
+       false, false, false, false},
+      {"V cycle, multicolor GaussSeidel", AMG::V_CYCLE,
+       AMG::MULTICOLOR_GAUSS_SEIDEL, false, false, false, false},
+      {"V cycle, direct coarsest solve", AMG::V_CYCLE, AMG::GAUSS_SEIDEL,
+       false, true, false, false},
+      {"V cycle, single precision", AMG::V_CYCLE, AMG::GAUSS_SEIDEL,
+       true, false, false, false},
+      {"V cycle, symmetric, scaled corrections", AMG::V_CYCLE,
+       AMG::GAUSS_SEIDEL, false, false, true, true}
+    };
+
+  cout << n << "^3 cells" << endl;
+
+  bool ok = true;
+  for(size_t i=0; i<sizeof(cases)/sizeof(cases[0]); i++)
+    ok = runCase(cases[i],n,nCycles) && ok;
+
+  // the gradient matrices are cached by mesh address, so both models
+  // share the one mesh
+  shared_ptr<Mesh> mesh(createSquareGrid(4*n));
+  MeshList meshes;
+  meshes.push_back(mesh.get());
+  GeomFields geomFields("geom");
+  MeshMetricsCalculator<double> metrics(geomFields,meshes);
+  metrics.init();
+
+  // A persistent iteration still allocates small objects. The residual
+  // norms that AMG::solve checks after every cycle are returned as new
+  // MultiFieldReductions. LinearSystem::initSolve and postSolve extract
+  // and merge the MultiFields of the system. Neither depends on the size
+  // of the mesh, so the count per cycle and the count of the rest of the
+  // iteration are bounded, and no allocation may be as large as an array
+  // over the cells.
+  const int nModelCycles = 5;
+  size_t largest[3];
+  const long nTransient =
+    countModelAllocations(meshes,geomFields,nCycles,nModelCycles,false,largest[0]);
+  const long nPersistent =
+    countModelAllocations(meshes,geomFields,nCycles,nModelCycles,true,largest[1]);
+  const long nPersistent2 =
+    countModelAllocations(meshes,geomFields,nCycles,2*nModelCycles,true,largest[2]);
+  const long perCycle = (nPersistent2 - nPersistent)/nModelCycles;
+  const long perSolve = nPersistent - nModelCycles*perCycle;
+  const size_t nCells = mesh->getCells().getSelfCount();
+  cout << "persistent ThermalModel: " << perCycle << " allocations per cycle, "
+       << perSolve << " per iteration besides" << endl;
+  if (nPersistent >= nTransient || perCycle > 25 || perSolve > 100 ||
+      max(largest[1],largest[2]) >= nCells)
+  {
+      cout << "persistent ThermalModel iteration allocates more than the norms "
+           << "and the MultiFields  FAILED" << endl;
+      ok = false;
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return ok ? 0 : 1;
+}
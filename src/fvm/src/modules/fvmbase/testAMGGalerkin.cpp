@@ -0,0 +1,232 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks the Galerkin matrices and convergence of the AMG coarsenings.
+//
+// usage: testAMGGalerkin [n]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "AMG.h"
+#include "CRConnectivity.h"
+#include "CRMatrix.h"
+#include "LinearSystem.h"
+
+namespace
+{
+  typedef CRMatrix<double,double,double> ScalarMatrix;
+
+  const int nMaxCycles = 40;
+
+  shared_ptr<CRConnectivity> createStencil(const StorageSite& cells, const int n)
+  {
+    shared_ptr<CRConnectivity> conn(new CRConnectivity(cells,cells));
+
+    conn->initCount();
+    for(int pass=0; pass<2; pass++)
+    {
+        for(int k=0; k<n; k++)
+          for(int j=0; j<n; j++)
+            for(int i=0; i<n; i++)
+            {
+                const int c = (k*n+j)*n+i;
+                const int nb[6] = {i>0 ? c-1 : -1, i<n-1 ? c+1 : -1,
+                                   j>0 ? c-n : -1, j<n-1 ? c+n : -1,
+                                   k>0 ? c-n*n : -1, k<n-1 ? c+n*n : -1};
+                for(int m=0; m<6; m++)
+                  if (nb[m] >= 0)
+                  {
+                      if (pass == 0)
+                        conn->addCount(c,1);
+                      else
+                        conn->add(c,nb[m]);
+                  }
+            }
+        if (pass == 0)
+          conn->finishCount();
+    }
+    conn->finishAdd();
+    return conn;
+  }
+
+  // the couplings are 1 along x, 0.1 along y and 0.01 along z, and the
+  // boundary cells are coupled to fixed values outside the grid
+  void setCoeffs(ScalarMatrix& m, const CRConnectivity& conn, const int n)
+  {
+    const double coupling[3] = {1.0, 0.1, 0.01};
+    const int stride[3] = {1, n, n*n};
+    Array<double>& diag = m.getDiag();
+    Array<double>& offDiag = m.getOffDiag();
+    const Array<int>& row = conn.getRow();
+    const Array<int>& col = conn.getCol();
+    for(int c=0; c<conn.getRowDim(); c++)
+    {
+        diag[c] = -2.0*(coupling[0] + coupling[1] + coupling[2]);
+        for(int nb=row[c]; nb<row[c+1]; nb++)
+        {
+            const int d = abs(col[nb] - c);
+            offDiag[nb] = d == stride[0] ? coupling[0] :
+              (d == stride[1] ? coupling[1] : coupling[2]);
+        }
+    }
+  }
+
+  struct Problem
+  {
+    Problem(const int n) :
+      cells(n*n*n),
+      conn(createStencil(cells,n)),
+      x("x"),
+      xIndex(&x,&cells),
+      ls()
+    {
+      x.addArray(cells,shared_ptr<ArrayBase>(new Array<double>(cells.getCount())));
+      x[cells].zero();
+      ls.getX().addArray(xIndex,x.getArrayPtr(cells));
+
+      shared_ptr<ScalarMatrix> m(new ScalarMatrix(*conn));
+      ls.getMatrix().addMatrix(xIndex,xIndex,m);
+      ls.initAssembly();
+      setCoeffs(*m,*conn,n);
+      Array<double>& b = dynamic_cast<Array<double>&>(ls.getB()[xIndex]);
+      for(int i=0; i<b.getLength(); i++)
+        b[i] = (i%7) - 3.0;
+      ls.initSolve();
+    }
+
+    StorageSite cells;
+    shared_ptr<CRConnectivity> conn;
+    Field x;
+    MultiField::ArrayIndex xIndex;
+    LinearSystem ls;
+  };
+
+  // the largest difference between the Galerkin matrix and P^T A P,
+  // relative to the largest coefficient of the latter
+  double checkGalerkin(const int n, const bool classical)
+  {
+    Problem p(n);
+    LinearSystem& ls = p.ls;
+    shared_ptr<LinearSystem> coarseLS =
+      ls.createCoarse(2,0.65,classical ? 0.25 : 0.08,classical,
+                      classical ? 0 : 4.0/3.0);
+
+    MultiFieldMatrix& fineMatrix = ls.getMatrix();
+    MultiFieldMatrix& coarseMatrix = coarseLS->getMatrix();
+    MultiField& coarseB = coarseLS->getB();
+    const MultiField::ArrayIndex coarseIndex = coarseB.getArrayIndex(0);
+    const int nCoarse = coarseB[coarseIndex].getLength();
+
+    shared_ptr<MultiField> e(dynamic_pointer_cast<MultiField>(coarseB.newClone()));
+    shared_ptr<MultiField> ae(dynamic_pointer_cast<MultiField>(coarseB.newClone()));
+    shared_ptr<MultiField> ptape(dynamic_pointer_cast<MultiField>(coarseB.newClone()));
+    shared_ptr<MultiField> pe(dynamic_pointer_cast<MultiField>(ls.getB().newClone()));
+    shared_ptr<MultiField> ape(dynamic_pointer_cast<MultiField>(ls.getB().newClone()));
+    Array<double>& eArray = dynamic_cast<Array<double>&>((*e)[coarseIndex]);
+    const Array<double>& aeArray = dynamic_cast<const Array<double>&>((*ae)[coarseIndex]);
+    const Array<double>& ptapeArray =
+      dynamic_cast<const Array<double>&>((*ptape)[coarseIndex]);
+
+    double maxCoeff = 0;
+    double maxDiff = 0;
+    e->zero();
+    for(int j=0; j<nCoarse; j++)
+    {
+        eArray[j] = 1.0;
+
+        coarseMatrix.multiply(*ae,*e);
+
+        pe->zero();
+        fineMatrix.correctSolution(ls.getCoarseIndex(),*pe,MFRPtr(),*e);
+        fineMatrix.multiply(*ape,*pe);
+        ptape->zero();
+        fineMatrix.injectResidual(ls.getCoarseIndex(),*ape,*ptape);
+
+        for(int i=0; i<nCoarse; i++)
+        {
+            maxCoeff = max(maxCoeff,fabs(ptapeArray[i]));
+            maxDiff = max(maxDiff,fabs(ptapeArray[i] - aeArray[i]));
+        }
+        eArray[j] = 0;
+    }
+
+    cout << (classical ? "classical" : "smoothed aggregation") << ": "
+         << n*n*n << " rows coarsened to " << nCoarse
+         << ", Galerkin matrix differs from P^T A P by " << maxDiff/maxCoeff << endl;
+    return maxDiff/maxCoeff;
+  }
+
+  // the residual reduction after solving with the given coarsening
+  double solve(const int n, const AMG::CoarseningType coarseningType,
+               const char* name, int& nCycles)
+  {
+    Problem p(n);
+    LinearSystem& ls = p.ls;
+
+    AMG amg;
+    amg.coarseningType = coarseningType;
+    amg.relativeTolerance = 1e-8;
+    amg.nMaxIterations = nMaxCycles;
+    amg.verbosity = 0;
+    amg.solve(ls);
+    nCycles = amg.getTotalIterations();
+
+    ls.getMatrix().computeResidual(ls.getDelta(),ls.getB(),ls.getResidual());
+    const Array<double>& b = dynamic_cast<const Array<double>&>(ls.getB()[p.xIndex]);
+    const Array<double>& r = dynamic_cast<const Array<double>&>(ls.getResidual()[p.xIndex]);
+    double bNorm = 0;
+    double rNorm = 0;
+    for(int i=0; i<b.getLength(); i++)
+    {
+        bNorm += fabs(b[i]);
+        rNorm += fabs(r[i]);
+    }
+
+    cout << name << ": residual reduced by " << rNorm/bNorm
+         << " in " << nCycles << " cycles" << endl;
+    amg.cleanup();
+    return rNorm/bNorm;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 8;
+
+  bool ok = true;
+  for(int classical=1; classical>=0; classical--)
+    if (!(checkGalerkin(n,classical == 1) < 1e-12))
+      ok = false;
+
+  const AMG::CoarseningType types[3] =
+    {AMG::GROUPING, AMG::CLASSICAL, AMG::SMOOTHED_AGGREGATION};
+  const char* names[3] = {"grouping", "classical", "smoothed aggregation"};
+  for(int i=0; i<3; i++)
+  {
+      int nCycles = 0;
+      const double reduction = solve(2*n,types[i],names[i],nCycles);
+      if (!(reduction < 1e-7) || nCycles >= nMaxCycles)
+      {
+          cout << names[i] << " did not converge  FAILED" << endl;
+          ok = false;
+      }
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Times the CRMatrix row kernels and checks them against the generic ones.
+//
+// usage: testCRMatrixKernels [n] [nRepeat]
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <sys/time.h>
+
+using namespace std;
+
+#include "CRMatrixKernels.h"
+
+namespace
+{
+  double wallTime()
+  {
+    struct timeval tv;
+    gettimeofday(&tv,0);
+    return tv.tv_sec + 1.0e-6*tv.tv_usec;
+  }
+
+  void createStencil(const int n, Array<int>*& row, Array<int>*& col)
+  {
+    const int nRows = n*n*n;
+    row = new Array<int>(nRows+1);
+    col = new Array<int>(6*nRows);
+    int nnz = 0;
+    for(int k=0; k<n; k++)
+      for(int j=0; j<n; j++)
+        for(int i=0; i<n; i++)
+        {
+            const int nr = (k*n+j)*n+i;
+            (*row)[nr] = nnz;
+            if (k>0) (*col)[nnz++] = nr-n*n;
+            if (j>0) (*col)[nnz++] = nr-n;
+            if (i>0) (*col)[nnz++] = nr-1;
+            if (i<n-1) (*col)[nnz++] = nr+1;
+            if (j<n-1) (*col)[nnz++] = nr+n;
+            if (k<n-1) (*col)[nnz++] = nr+n*n;
+        }
+    (*row)[nRows] = nnz;
+  }
+
+  // a diagonally dominant matrix with the given stencil
+  void setCoeffs(Array<double>& diag, Array<double>& offDiag)
+  {
+    for(int i=0; i<offDiag.getLength(); i++)
+      offDiag[i] = -1.0 - 0.01*(i%7);
+    for(int i=0; i<diag.getLength(); i++)
+      diag[i] = 6.5 + 0.01*(i%5);
+  }
+
+  void setCoeffs(Array<SquareTensor<double,3> >& diag,
+                 Array<SquareTensor<double,3> >& offDiag)
+  {
+    for(int i=0; i<offDiag.getLength(); i++)
+    {
+        offDiag[i] = -0.1;
+        for(int r=0; r<3; r++)
+          offDiag[i](r,r) = -1.0 - 0.01*(i%7);
+    }
+    for(int i=0; i<diag.getLength(); i++)
+    {
+        diag[i] = 0.2;
+        for(int r=0; r<3; r++)
+          diag[i](r,r) = 7.5 + 0.01*((i+r)%5);
+    }
+  }
+
+  void setCoeffs(Array<DiagonalTensor<double,3> >& diag,
+                 Array<double>& offDiag)
+  {
+    for(int i=0; i<offDiag.getLength(); i++)
+      offDiag[i] = -1.0 - 0.01*(i%7);
+    for(int i=0; i<diag.getLength(); i++)
+      for(int r=0; r<3; r++)
+        diag[i][r] = 6.5 + 0.01*((i+r)%5);
+  }
+
+  template<class X>
+  void setX(Array<X>& x)
+  {
+    double* xd = (double*) x.getData();
+    const int n = x.getDataSize()/sizeof(double);
+    for(int i=0; i<n; i++)
+      xd[i] = sin(0.1*i);
+  }
+
+  template<class X>
+  double maxDiff(const Array<X>& a, const Array<X>& b)
+  {
+    const double* ad = (const double*) a.getData();
+    const double* bd = (const double*) b.getData();
+    const int n = a.getDataSize()/sizeof(double);
+    double d = 0;
+    for(int i=0; i<n; i++)
+      d = max(d,fabs(ad[i]-bd[i]));
+    return d;
+  }
+
+  template<class X>
+  double oneNorm(const Array<X>& a, const int nRows)
+  {
+    const double* ad = (const double*) a.getData();
+    const int n = nRows*int(sizeof(X)/sizeof(double));
+    double s = 0;
+    for(int i=0; i<n; i++)
+      s += fabs(ad[i]);
+    return s;
+  }
+
+  // one l1 sweep over the rows of nBlocks consecutive blocks, as done
+  // by CRMatrix::blockGS
+  template<class Kernels, class X>
+  void hybridSweep(const Kernels& k, const int nRows, const int nBlocks,
+                   const bool reverse, Array<X>& x, Array<X>& xOld,
+                   const Array<X>& b)
+  {
+    xOld = x;
+    for(int n=0; n<nBlocks; n++)
+    {
+        const int nBegin = int((long(nRows)*n)/nBlocks);
+        const int nEnd = int((long(nRows)*(n+1))/nBlocks);
+        if (reverse)
+          for(int nr=nEnd-1; nr>=nBegin; nr--)
+            k.relaxRowL1(nr,nBegin,nEnd,nRows,x,xOld,b);
+        else
+          for(int nr=nBegin; nr<nEnd; nr++)
+            k.relaxRowL1(nr,nBegin,nEnd,nRows,x,xOld,b);
+    }
+  }
+
+  // the seven point stencil is coloured by the parity of i+j+k
+  template<class Kernels, class X>
+  void coloredSweep(const Kernels& k, const int n, const int nRows,
+                    const bool reverse, Array<X>& x, const Array<X>& b)
+  {
+    for(int c=0; c<2; c++)
+      for(int nr=0; nr<nRows; nr++)
+        if ((nr%n + (nr/n)%n + nr/(n*n))%2 == (reverse ? 1-c : c))
+          k.relaxRow(nr,x,b);
+  }
+
+  template<class Kernels, class X>
+  void l1JacobiSweep(const Kernels& k, const int nRows,
+                     Array<X>& x, Array<X>& xOld, const Array<X>& b)
+  {
+    xOld = x;
+    for(int nr=0; nr<nRows; nr++)
+      k.relaxRowL1(nr,nr,nr+1,nRows,x,xOld,b);
+  }
+
+  // the last plane of the grid is treated as ghost cells so that the
+  // columns beyond nRows are exercised as well. A single block of the
+  // hybrid smoother must be the same as a GaussSeidel sweep and the
+  // others must converge at a comparable rate
+  template<class Diag, class OffDiag, class X>
+  bool checkSmoothers(const char* name, const int n, const Array<int>& row,
+                      const Array<int>& col)
+  {
+    const int nCells = row.getLength()-1;
+    const int nRows = nCells - n*n;
+    const int nSweeps = 10;
+    
+    Array<Diag> diag(nCells);
+    Array<OffDiag> offDiag(col.getLength());
+    setCoeffs(diag,offDiag);
+
+    Array<X> b(nCells), xInit(nCells), r(nCells);
+    setX(b);
+    setX(xInit);
+    for(int nr=0; nr<nRows; nr++)
+      xInit[nr] = NumTypeTraits<X>::getZero();
+
+    const CRMatrixKernels<Diag,OffDiag,X> k(row,col,diag,offDiag);
+
+    Array<X> xGS(nCells), xH(nCells), xOld(nCells);
+    xGS = xInit;
+    xH = xInit;
+    k.GS(0,nRows,1,xGS,b);
+    k.GS(nRows-1,-1,-1,xGS,b);
+    hybridSweep(k,nRows,1,false,xH,xOld,b);
+    hybridSweep(k,nRows,1,true,xH,xOld,b);
+    const double diffSingle = maxDiff(xGS,xH);
+
+    Array<X> xC(nCells), xL1(nCells);
+    xGS = xInit;
+    xH = xInit;
+    xC = xInit;
+    xL1 = xInit;
+    for(int i=0; i<nSweeps; i++)
+    {
+        k.GS(0,nRows,1,xGS,b);
+        k.GS(nRows-1,-1,-1,xGS,b);
+        hybridSweep(k,nRows,4,false,xH,xOld,b);
+        hybridSweep(k,nRows,4,true,xH,xOld,b);
+        coloredSweep(k,n,nRows,false,xC,b);
+        coloredSweep(k,n,nRows,true,xC,b);
+        l1JacobiSweep(k,nRows,xL1,xOld,b);
+        l1JacobiSweep(k,nRows,xL1,xOld,b);
+    }
+
+    k.computeResidual(nRows,xInit,b,r);
+    const double r0 = oneNorm(r,nRows);
+    k.computeResidual(nRows,xGS,b,r);
+    const double rGS = oneNorm(r,nRows)/r0;
+    k.computeResidual(nRows,xH,b,r);
+    const double rH = oneNorm(r,nRows)/r0;
+    k.computeResidual(nRows,xC,b,r);
+    const double rC = oneNorm(r,nRows)/r0;
+    k.computeResidual(nRows,xL1,b,r);
+    const double rL1 = oneNorm(r,nRows)/r0;
+
+    // the parallel smoothers must gain at least a given fraction of
+    // the digits that GaussSeidel does
+    const double digitsGS = -log10(rGS);
+    const bool ok = diffSingle < 1e-12 && digitsGS > 2 &&
+      -log10(rH) > 0.6*digitsGS && -log10(rC) > 0.6*digitsGS &&
+      -log10(rL1) > 0.4*digitsGS;
+
+    cout << name << " smoothers" << endl
+         << "  single block hybrid vs GaussSeidel, max difference "
+         << diffSingle << endl
+         << "  residual reduction after " << nSweeps
+         << " symmetric sweeps: GaussSeidel " << rGS
+         << ", hybrid " << rH << ", multicolor " << rC
+         << ", l1 Jacobi " << rL1 << endl
+         << (ok ? "  passed" : "  FAILED") << endl;
+    return ok;
+  }
+
+  // the fastest of the repeats, which is the least disturbed by
+  // whatever else the machine is doing
+  template<class Kernels, class X>
+  void runKernels(const Kernels& k, const int nRows, const int nRepeat,
+                  Array<X>& x, const Array<X>& b, Array<X>& y,
+                  double& tMultiply, double& tGS)
+  {
+    tMultiply = tGS = 1e30;
+    for(int n=0; n<nRepeat; n++)
+    {
+        double t0 = wallTime();
+        k.computeResidual(nRows,x,b,y);
+        tMultiply = min(tMultiply,wallTime()-t0);
+
+        t0 = wallTime();
+        k.GS(0,nRows,1,x,b);
+        k.GS(nRows-1,-1,-1,x,b);
+        tGS = min(tGS,wallTime()-t0);
+    }
+  }
+
+  // the kernels must give the same values and not be slower than the
+  // generic ones, allowing 10% for the noise of the timings
+  template<class Diag, class OffDiag, class X>
+  bool compare(const char* name, const Array<int>& row, const Array<int>& col,
+               const int nRepeat)
+  {
+    const int nRows = row.getLength()-1;
+    Array<Diag> diag(nRows);
+    Array<OffDiag> offDiag(col.getLength());
+    setCoeffs(diag,offDiag);
+
+    Array<X> b(nRows), x0(nRows), x1(nRows), y0(nRows), y1(nRows);
+    setX(b);
+    x0.zero();
+    x1.zero();
+
+    CRMatrixGenericKernels<Diag,OffDiag,X> generic(row,col,diag,offDiag);
+    CRMatrixKernels<Diag,OffDiag,X> specialized(row,col,diag,offDiag);
+
+    double tMultiply0, tGS0, tMultiply1, tGS1;
+    runKernels(generic,nRows,nRepeat,x0,b,y0,tMultiply0,tGS0);
+    runKernels(specialized,nRows,nRepeat,x1,b,y1,tMultiply1,tGS1);
+
+    const double diff = max(maxDiff(x0,x1),maxDiff(y0,y1));
+    const bool ok = diff == 0 && tMultiply1 < 1.1*tMultiply0 && tGS1 < 1.1*tGS0;
+
+    cout << name << endl
+         << "  residual: generic " << tMultiply0 << " s, kernel "
+         << tMultiply1 << " s, speedup " << tMultiply0/tMultiply1 << endl
+         << "  symmetric GS: generic " << tGS0 << " s, kernel "
+         << tGS1 << " s, speedup " << tGS0/tGS1 << endl
+         << "  max difference " << diff << endl
+         << (ok ? "  passed" : "  FAILED") << endl;
+    return ok;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const int n = argc > 1 ? atoi(argv[1]) : 50;
+  const int nRepeat = argc > 2 ? atoi(argv[2]) : 10;
+
+  Array<int>* row;
+  Array<int>* col;
+  createStencil(n,row,col);
+
+  cout << n << "^3 cells, " << col->getLength() << " off diagonal entries"
+       << endl;
+
+  bool ok = true;
+  ok = checkSmoothers<double,double,double>("scalar",n,*row,*col) && ok;
+  ok = checkSmoothers<DiagonalTensor<double,3>,double,Vector<double,3> >
+    ("diagonal 3x3 / scalar",n,*row,*col) && ok;
+  ok = checkSmoothers<SquareTensor<double,3>,SquareTensor<double,3>,
+    Vector<double,3> >("3x3 blocks",n,*row,*col) && ok;
+
+  ok = compare<double,double,double>("scalar",*row,*col,nRepeat) && ok;
+  ok = compare<DiagonalTensor<double,3>,double,Vector<double,3> >
+    ("diagonal 3x3 / scalar",*row,*col,nRepeat) && ok;
+  ok = compare<SquareTensor<double,3>,SquareTensor<double,3>,Vector<double,3> >
+    ("3x3 blocks",*row,*col,nRepeat) && ok;
+
+  delete row;
+  delete col;
+  return ok ? 0 : 1;
+}
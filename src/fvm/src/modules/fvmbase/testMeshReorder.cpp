@@ -0,0 +1,302 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks that Mesh::reorder keeps the geometry and the ThermalModel solution.
+//
+// usage: testMeshReorder [n]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "AMG.h"
+#include "Mesh.h"
+#include "GeomFields.h"
+#include "ThermalFields.h"
+#include "MeshMetricsCalculator.h"
+#include "MeshMetricsCalculator_impl.h"
+#include "ThermalModel.h"
+#include "ThermalModel_impl.h"
+
+namespace
+{
+  typedef Vector<double,3> VecD3;
+  typedef Array<double> DArray;
+
+  // the same sequence on every platform
+  class Random
+  {
+  public:
+    Random() : _state(12345) {}
+    int operator()(const int n)
+    {
+      _state = _state*1103515245u + 12345u;
+      return int((_state >> 8) % unsigned(n));
+    }
+  private:
+    unsigned _state;
+  };
+
+  vector<int> shuffled(const int n, Random& random)
+  {
+    vector<int> v(n);
+    for(int i=0; i<n; i++)
+      v[i] = i;
+    for(int i=n-1; i>0; i--)
+      swap(v[i],v[random(i+1)]);
+    return v;
+  }
+
+  // an n x n grid of square cells with one boundary face group per side
+  Mesh* createShuffledGrid(const int n)
+  {
+    const int nCells = n*n;
+    const int nInteriorFaces = 2*n*(n-1);
+    const int nFaces = nInteriorFaces + 4*n;
+    const int nx = n+1;
+
+    Random random;
+    const vector<int> newCell(shuffled(nCells,random));
+    const vector<int> newNode(shuffled(nx*nx,random));
+    const vector<int> newInteriorFace(shuffled(nInteriorFaces,random));
+
+    Array<VecD3> coords(nx*nx);
+    for(int j=0; j<=n; j++)
+      for(int i=0; i<=n; i++)
+      {
+          VecD3& x = coords[newNode[j*nx+i]];
+          x[0] = double(i)/n;
+          x[1] = double(j)/n;
+          x[2] = 0;
+      }
+
+    Array<int> faceCells(2*nFaces);
+    Array<int> faceNodes(2*nFaces);
+    Array<int> faceNodeCount(nFaces);
+    Array<int> groupSize(5);
+    faceNodeCount = 2;
+
+    // the cells on either side of each face and its nodes, with the
+    // normal pointing from the first cell to the second
+    vector<int> c0(nFaces), c1(nFaces), n0(nFaces), n1(nFaces);
+    int f = 0;
+    for(int j=0; j<n; j++)
+      for(int i=0; i<n-1; i++, f++)
+      {
+          c0[f] = j*n+i; c1[f] = j*n+i+1;
+          n0[f] = j*nx+i+1; n1[f] = (j+1)*nx+i+1;
+      }
+    for(int j=0; j<n-1; j++)
+      for(int i=0; i<n; i++, f++)
+      {
+          c0[f] = j*n+i; c1[f] = (j+1)*n+i;
+          n0[f] = (j+1)*nx+i+1; n1[f] = (j+1)*nx+i;
+      }
+
+    // boundary faces get the ghost cells numbered after the interior ones
+    for(int j=0; j<n; j++, f++)
+    {
+        c0[f] = j*n; n0[f] = (j+1)*nx; n1[f] = j*nx;
+    }
+    for(int j=0; j<n; j++, f++)
+    {
+        c0[f] = j*n+n-1; n0[f] = j*nx+n; n1[f] = (j+1)*nx+n;
+    }
+    for(int i=0; i<n; i++, f++)
+    {
+        c0[f] = i; n0[f] = i; n1[f] = i+1;
+    }
+    for(int i=0; i<n; i++, f++)
+    {
+        c0[f] = (n-1)*n+i; n0[f] = n*nx+i+1; n1[f] = n*nx+i;
+    }
+
+    for(f=0; f<nFaces; f++)
+    {
+        const bool interior = f < nInteriorFaces;
+        const int nf = interior ? newInteriorFace[f] : f;
+        int a0 = newCell[c0[f]];
+        int a1 = interior ? newCell[c1[f]] : nCells + f - nInteriorFaces;
+        int m0 = newNode[n0[f]];
+        int m1 = newNode[n1[f]];
+        if (interior && random(2))
+        {
+            swap(a0,a1);
+            swap(m0,m1);
+        }
+        faceCells[2*nf] = a0;
+        faceCells[2*nf+1] = a1;
+        faceNodes[2*nf] = m0;
+        faceNodes[2*nf+1] = m1;
+    }
+
+    groupSize[0] = nInteriorFaces;
+    for(int side=1; side<5; side++)
+      groupSize[side] = n;
+
+    return new Mesh(2,nCells,coords,faceCells,faceNodes,faceNodeCount,groupSize);
+  }
+
+  double meanFaceGap(const Mesh& mesh)
+  {
+    const StorageSite& faces = mesh.getInteriorFaceGroup().site;
+    const CRConnectivity& faceCells = mesh.getAllFaceCells();
+    double gap = 0;
+    for(int f=faces.getOffset(); f<faces.getOffset()+faces.getCount(); f++)
+      gap += abs(faceCells(f,0) - faceCells(f,1));
+    return gap/faces.getCount();
+  }
+
+  // an array holding the index of each entry of the site
+  void setIndices(Field& field, const StorageSite& site)
+  {
+    shared_ptr<DArray> a(new DArray(site.getCountLevel1()));
+    for(int i=0; i<a->getLength(); i++)
+      (*a)[i] = i;
+    field.addArray(site,a);
+  }
+
+  template<class X>
+  const Array<X>& getArray(const Field& field, const StorageSite& site)
+  {
+    return dynamic_cast<const Array<X>&>(field[site]);
+  }
+
+  double difference(const double a, const double b) {return fabs(a-b);}
+  double difference(const VecD3& a, const VecD3& b) {return mag(a-b);}
+
+  // the number of entries of the reordered array that differ from the
+  // original entry
+  template<class X>
+  int countDifferent(const Array<X>& a, const Array<X>& b,
+                     const DArray& original)
+  {
+    int nDifferent = 0;
+    for(int i=0; i<b.getLength(); i++)
+      if (difference(b[i],a[int(original[i])]) > 1e-12)
+        nDifferent++;
+    return nDifferent;
+  }
+
+  void solve(ThermalFields& thermalFields, const GeomFields& geomFields,
+             const MeshList& meshes)
+  {
+    ThermalModel<double> model(geomFields,thermalFields,meshes);
+    model.getBC(1).bcType = "SpecifiedTemperature";
+    model.getBC(2).bcType = "SpecifiedTemperature";
+    model.getBC(2).find("specifiedTemperature")->second.constant = 400.0;
+    model.getBC(3).bcType = "SpecifiedTemperature";
+    model.getBC(3).find("specifiedTemperature")->second.constant = 350.0;
+
+    AMG amg;
+    amg.relativeTolerance = 1e-12;
+    amg.nMaxIterations = 200;
+    amg.verbosity = 0;
+    model.getOptions().linearSolver = &amg;
+
+    model.init();
+    model.advance(3);
+  }
+
+  bool checkOrdering(Mesh& original, const GeomFields& geomFields,
+                     const Field& temperature,
+                     const Mesh::CellOrdering ordering, const char* name)
+  {
+    const int n = int(sqrt(double(original.getCells().getSelfCount())) + 0.5);
+    Mesh& mesh = *createShuffledGrid(n);
+    MeshList meshes(1,&mesh);
+
+    const StorageSite& cells = mesh.getCells();
+    const StorageSite& faces = mesh.getFaces();
+    const StorageSite& nodes = mesh.getNodes();
+    Field ids("ids");
+    setIndices(ids,cells);
+    setIndices(ids,faces);
+    setIndices(ids,nodes);
+
+    const double gapBefore = meanFaceGap(mesh);
+    mesh.reorder(ordering);
+    mesh.reorderField(ids);
+    const double gapAfter = meanFaceGap(mesh);
+
+    GeomFields reorderedGeomFields("geom");
+    MeshMetricsCalculator<double> metrics(reorderedGeomFields,meshes);
+    metrics.init();
+
+    const DArray& originalCell = getArray<double>(ids,cells);
+    const DArray& originalFace = getArray<double>(ids,faces);
+    const DArray& originalNode = getArray<double>(ids,nodes);
+    const StorageSite& cells0 = original.getCells();
+    const StorageSite& faces0 = original.getFaces();
+    const GeomFields& g0 = geomFields;
+    const GeomFields& g1 = reorderedGeomFields;
+
+    int nWrong = countDifferent(original.getNodeCoordinates(),
+                                mesh.getNodeCoordinates(),originalNode);
+    nWrong += countDifferent(getArray<VecD3>(g0.coordinate,cells0),
+                             getArray<VecD3>(g1.coordinate,cells),originalCell);
+    nWrong += countDifferent(getArray<double>(g0.volume,cells0),
+                             getArray<double>(g1.volume,cells),originalCell);
+    nWrong += countDifferent(getArray<VecD3>(g0.coordinate,faces0),
+                             getArray<VecD3>(g1.coordinate,faces),originalFace);
+    nWrong += countDifferent(getArray<VecD3>(g0.area,faces0),
+                             getArray<VecD3>(g1.area,faces),originalFace);
+
+    ThermalFields thermalFields("therm");
+    solve(thermalFields,reorderedGeomFields,meshes);
+    const DArray& t0 = getArray<double>(temperature,cells0);
+    const DArray& t1 = getArray<double>(thermalFields.temperature,cells);
+    double maxDiff = 0;
+    for(int c=0; c<cells.getSelfCount(); c++)
+      maxDiff = max(maxDiff,fabs(t1[c] - t0[int(originalCell[c])]));
+
+    const bool ok = nWrong == 0 && gapAfter < gapBefore/2 && maxDiff < 1e-8;
+    cout << name << ": mean cell index gap across interior faces "
+         << gapBefore << " before, " << gapAfter << " after, "
+         << nWrong << " wrong coordinates, centroids, volumes or areas, "
+         << "temperatures differ by " << maxDiff
+         << (ok ? "" : "  FAILED") << endl;
+
+    delete &mesh;
+    return ok;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 32;
+
+  bool ok = true;
+  {
+      Mesh* original = createShuffledGrid(n);
+      MeshList meshes(1,original);
+      GeomFields geomFields("geom");
+      MeshMetricsCalculator<double> metrics(geomFields,meshes);
+      metrics.init();
+
+      ThermalFields thermalFields("therm");
+      solve(thermalFields,geomFields,meshes);
+
+      ok = checkOrdering(*original,geomFields,thermalFields.temperature,
+                         Mesh::CELL_ORDER_RCM,"RCM") && ok;
+      ok = checkOrdering(*original,geomFields,thermalFields.temperature,
+                         Mesh::CELL_ORDER_HILBERT,"Hilbert") && ok;
+      delete original;
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,380 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks the SyncPlan ghost exchanges against plain Isend and Irecv.
+//
+// usage: mpirun -np N testSyncPlan [nSelf]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "Field.h"
+#include "MultiField.h"
+#include "StorageSite.h"
+#include "Vector.h"
+
+typedef Vector<double,3> VectorT3;
+typedef Array<double> ScalarArray;
+typedef Array<VectorT3> VectorT3Array;
+
+namespace
+{
+  const int nInterface = 3;
+
+  // two meshes per process in a ring, the second coupled through MPI to
+  // the first mesh of the next process
+  struct Ring
+  {
+    Ring(const int nSelf, const int nProcs, const int rank) :
+      a(nSelf,2*nInterface),
+      b(nSelf,2*nInterface),
+      prevB(0),
+      nextA(0)
+    {
+      const int prev = (rank+nProcs-1)%nProcs;
+      const int next = (rank+1)%nProcs;
+
+      // local interface, ghosts nSelf+nInterface onwards
+      couple(a,b,nSelf-1,-1,nSelf+nInterface);
+      couple(b,a,0,1,nSelf+nInterface);
+
+      // the sites standing for the meshes on the other processes. The
+      // tag is that of the interface, the rank owning its b side
+      if (nProcs > 1)
+      {
+          prevB.setGatherProcID(prev);
+          prevB.setTag(100+prev);
+          nextA.setGatherProcID(next);
+          nextA.setTag(100+rank);
+          sendTo(a,prevB,0,1);
+          recvFrom(a,prevB,nSelf);
+          sendTo(b,nextA,nSelf-1,-1);
+          recvFrom(b,nextA,nSelf);
+      }
+    }
+
+    static shared_ptr<Array<int> > indices(const int first, const int step)
+    {
+      shared_ptr<Array<int> > i(new Array<int>(nInterface));
+      for(int n=0; n<nInterface; n++)
+        (*i)[n] = first + n*step;
+      return i;
+    }
+
+    static void sendTo(StorageSite& from, const StorageSite& to,
+                       const int first, const int step)
+    {
+      from.getScatterMap()[&to] = indices(first,step);
+    }
+
+    static void recvFrom(StorageSite& to, const StorageSite& from,
+                         const int firstGhost)
+    {
+      to.getGatherMap()[&from] = indices(firstGhost,1);
+    }
+
+    static void couple(StorageSite& from, StorageSite& to,
+                       const int first, const int step, const int firstGhost)
+    {
+      sendTo(from,to,first,step);
+      recvFrom(to,from,firstGhost);
+    }
+
+    StorageSite a;
+    StorageSite b;
+    StorageSite prevB;
+    StorageSite nextA;
+  };
+
+  typedef pair<const StorageSite*, const StorageSite*> EntryIndex;
+
+  // the exchange as it was done before the SyncPlans, one message per
+  // array and neighbour
+  template<class X>
+  void referenceSync(const StorageSite* const* sites, Array<X>* const* arrays,
+                     const int nSites)
+  {
+    map<EntryIndex, shared_ptr<Array<X> > > ghostArrays;
+
+    for(int s=0; s<nSites; s++)
+    {
+        const StorageSite& site = *sites[s];
+        const Array<X>& a = *arrays[s];
+        foreach(const StorageSite::ScatterMap::value_type& mpos,
+                site.getScatterMap())
+        {
+            const Array<int>& from = *mpos.second;
+            shared_ptr<Array<X> > g(new Array<X>(from.getLength()));
+            for(int i=0; i<from.getLength(); i++)
+              (*g)[i] = a[from[i]];
+            ghostArrays[EntryIndex(&site,mpos.first)] = g;
+        }
+        foreach(const StorageSite::GatherMap::value_type& mpos,
+                site.getGatherMap())
+        {
+            const EntryIndex e(mpos.first,&site);
+            if (ghostArrays.find(e) == ghostArrays.end())
+              ghostArrays[e] = shared_ptr<Array<X> >
+                (new Array<X>(mpos.second->getLength()));
+        }
+    }
+
+#ifdef FVM_PARALLEL
+    vector<MPI::Request> requests;
+    for(int s=0; s<nSites; s++)
+    {
+        const StorageSite& site = *sites[s];
+        foreach(const StorageSite::ScatterMap::value_type& mpos,
+                site.getScatterMap())
+        {
+            const StorageSite& oSite = *mpos.first;
+            if (oSite.getGatherProcID() == -1)
+              continue;
+            ArrayBase& g = *ghostArrays[EntryIndex(&site,&oSite)];
+            requests.push_back(MPI::COMM_WORLD.Isend(g.getData(),
+                                                     g.getDataSize(),
+                                                     MPI::BYTE,
+                                                     oSite.getGatherProcID(),
+                                                     oSite.getTag()));
+        }
+        foreach(const StorageSite::GatherMap::value_type& mpos,
+                site.getGatherMap())
+        {
+            const StorageSite& oSite = *mpos.first;
+            if (oSite.getGatherProcID() == -1)
+              continue;
+            ArrayBase& g = *ghostArrays[EntryIndex(&oSite,&site)];
+            requests.push_back(MPI::COMM_WORLD.Irecv(g.getData(),
+                                                     g.getDataSize(),
+                                                     MPI::BYTE,
+                                                     oSite.getGatherProcID(),
+                                                     oSite.getTag()));
+        }
+    }
+    if (!requests.empty())
+      MPI::Request::Waitall(int(requests.size()), &requests[0]);
+#endif
+
+    for(int s=0; s<nSites; s++)
+    {
+        const StorageSite& site = *sites[s];
+        Array<X>& a = *arrays[s];
+        foreach(const StorageSite::GatherMap::value_type& mpos,
+                site.getGatherMap())
+        {
+            const Array<int>& to = *mpos.second;
+            const Array<X>& g = *ghostArrays[EntryIndex(mpos.first,&site)];
+            for(int i=0; i<to.getLength(); i++)
+              a[to[i]] = g[i];
+        }
+    }
+  }
+
+  // distinct values for every cell, process and call; the ghosts are
+  // set to something that no owned cell has
+  void setValues(ScalarArray& a, const int site, const int rank,
+                 const int call, const int component=0)
+  {
+    const int nSelf = a.getLength() - 2*nInterface;
+    for(int i=0; i<a.getLength(); i++)
+      a[i] = i < nSelf ? 10000*rank + 1000*site + 100*call + 10*component + i
+        : -1;
+  }
+
+  void setValues(VectorT3Array& a, const int site, const int rank,
+                 const int call)
+  {
+    ScalarArray c(a.getLength());
+    for(int k=0; k<3; k++)
+    {
+        setValues(c,site,rank,call,k+1);
+        for(int i=0; i<a.getLength(); i++)
+          a[i][k] = c[i];
+    }
+  }
+
+  template<class X>
+  double maxDiff(const Array<X>& a, const Array<X>& b)
+  {
+    const double* ad = (const double*) a.getData();
+    const double* bd = (const double*) b.getData();
+    const int n = a.getDataSize()/sizeof(double);
+    double d = 0;
+    for(int i=0; i<n; i++)
+      d = max(d,fabs(ad[i]-bd[i]));
+    return d;
+  }
+
+  template<class X>
+  shared_ptr<Array<X> > newArray(const StorageSite& site)
+  {
+    return shared_ptr<Array<X> >(new Array<X>(site.getCount()));
+  }
+
+  template<class X>
+  double compare(const StorageSite* const* sites, const Field& f,
+                 Array<X>* const* ref)
+  {
+    double d = 0;
+    for(int s=0; s<2; s++)
+      d = max(d,maxDiff(dynamic_cast<const Array<X>&>(f[*sites[s]]),*ref[s]));
+    return d;
+  }
+
+  bool report(const char* name, const double diff)
+  {
+    const bool ok = (diff == 0);
+    int rank = 0;
+#ifdef FVM_PARALLEL
+    rank = MPI::COMM_WORLD.Get_rank();
+#endif
+    if (rank == 0 || !ok)
+      cout << "rank " << rank << ": " << name << ", max difference "
+           << diff << (ok ? "" : "  FAILED") << endl;
+    return ok;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int nProcs = 1;
+  int rank = 0;
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+  nProcs = MPI::COMM_WORLD.Get_size();
+  rank = MPI::COMM_WORLD.Get_rank();
+#endif
+
+  const int nSelf = argc > 1 ? atoi(argv[1]) : 10;
+  bool ok = true;
+  {
+    Ring ring(nSelf,nProcs,rank);
+    const StorageSite* sites[] = {&ring.a, &ring.b};
+
+    Field scalar("scalar");
+    Field vectorField("vector");
+    shared_ptr<ScalarArray> sRef[2];
+    shared_ptr<VectorT3Array> vRef[2];
+    for(int s=0; s<2; s++)
+    {
+        scalar.addArray(*sites[s],newArray<double>(*sites[s]));
+        vectorField.addArray(*sites[s],newArray<VectorT3>(*sites[s]));
+        sRef[s] = newArray<double>(*sites[s]);
+        vRef[s] = newArray<VectorT3>(*sites[s]);
+    }
+    ScalarArray* sRefs[] = {sRef[0].get(), sRef[1].get()};
+    VectorT3Array* vRefs[] = {vRef[0].get(), vRef[1].get()};
+
+    // repeated exchanges reuse the plans created by the first one
+    for(int call=0; call<3; call++)
+    {
+        for(int s=0; s<2; s++)
+        {
+            setValues(dynamic_cast<ScalarArray&>(scalar[*sites[s]]),s,rank,call);
+            setValues(*sRef[s],s,rank,call);
+            setValues(dynamic_cast<VectorT3Array&>(vectorField[*sites[s]]),
+                      s,rank,call);
+            setValues(*vRef[s],s,rank,call);
+        }
+
+        if (call == 1)
+        {
+            scalar.startSync();
+            vectorField.startSync();
+            vectorField.finishSync();
+            scalar.finishSync();
+        }
+        else
+        {
+            scalar.syncLocal();
+            vectorField.syncLocal();
+        }
+        referenceSync(sites,sRefs,2);
+        referenceSync(sites,vRefs,2);
+
+        ok = report("Field::syncLocal scalar",compare(sites,scalar,sRefs)) && ok;
+        ok = report("Field::syncLocal vector",compare(sites,vectorField,vRefs)) && ok;
+    }
+
+    // a new array of another size makes the field create a new plan
+    const StorageSite wider(nSelf+1,2*nInterface);
+    scalar.addArray(wider,newArray<double>(wider));
+    for(int s=0; s<2; s++)
+    {
+        setValues(dynamic_cast<ScalarArray&>(scalar[*sites[s]]),s,rank,3);
+        setValues(*sRef[s],s,rank,3);
+    }
+    scalar.syncLocal();
+    referenceSync(sites,sRefs,2);
+    ok = report("Field::syncLocal new plan",compare(sites,scalar,sRefs)) && ok;
+    scalar.removeArray(wider);
+
+    // the components of a vector field as separate fields in one exchange
+    Field fx("fx"), fy("fy"), fz("fz");
+    std::vector<Field*> components;
+    components.push_back(&fx);
+    components.push_back(&fy);
+    components.push_back(&fz);
+    for(int s=0; s<2; s++)
+      for(int k=0; k<3; k++)
+      {
+          shared_ptr<ScalarArray> c(newArray<double>(*sites[s]));
+          setValues(*c,s,rank,4,k);
+          (*components[k]).addArray(*sites[s],c);
+      }
+    Field::syncLocalVectorFields(components);
+    for(int k=0; k<3; k++)
+    {
+        for(int s=0; s<2; s++)
+          setValues(*sRef[s],s,rank,4,k);
+        referenceSync(sites,sRefs,2);
+        ok = report("Field::syncLocalVectorFields",
+                    compare(sites,*components[k],sRefs)) && ok;
+    }
+
+    // both fields in a MultiField
+    MultiField mf;
+    for(int s=0; s<2; s++)
+    {
+        mf.addArray(MultiField::ArrayIndex(&scalar,sites[s]),
+                    scalar.getArrayPtr(*sites[s]));
+        mf.addArray(MultiField::ArrayIndex(&vectorField,sites[s]),
+                    vectorField.getArrayPtr(*sites[s]));
+    }
+    for(int call=5; call<7; call++)
+    {
+        for(int s=0; s<2; s++)
+        {
+            setValues(dynamic_cast<ScalarArray&>(scalar[*sites[s]]),s,rank,call);
+            setValues(*sRef[s],s,rank,call);
+            setValues(dynamic_cast<VectorT3Array&>(vectorField[*sites[s]]),
+                      s,rank,call);
+            setValues(*vRef[s],s,rank,call);
+        }
+        mf.sync();
+        referenceSync(sites,sRefs,2);
+        referenceSync(sites,vRefs,2);
+        ok = report("MultiField::sync scalar",compare(sites,scalar,sRefs)) && ok;
+        ok = report("MultiField::sync vector",compare(sites,vectorField,vRefs)) && ok;
+    }
+  }
+
+#ifdef FVM_PARALLEL
+  int allOk = ok ? 1 : 0;
+  MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,&allOk,1,MPI::INT,MPI::MIN);
+  ok = (allOk == 1);
+  MPI::Finalize();
+#endif
+
+  if (rank == 0)
+    cout << (ok ? "passed" : "FAILED") << endl;
+  return ok ? 0 : 1;
+}
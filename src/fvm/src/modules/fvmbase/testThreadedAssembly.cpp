@@ -0,0 +1,167 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Compares the thermal discretizations assembled with and without threadedAssembly.
+//
+// usage: testThreadedAssembly [n]
+
+#ifdef FVM_PARALLEL
+#include <mpi.h>
+#endif
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "SquareGrid.h"
+#include "GeomFields.h"
+#include "ThermalFields.h"
+#include "LinearSystem.h"
+#include "Linearizer.h"
+#include "MeshMetricsCalculator.h"
+#include "MeshMetricsCalculator_impl.h"
+#include "ThermalModel.h"
+#include "ThermalModel_impl.h"
+
+namespace
+{
+  typedef Array<double> DArray;
+  typedef CRMatrix<double,double,double> TMatrix;
+
+  // values that differ from entry to entry so that every term of the
+  // discretizations contributes something different
+  void fill(Field& field, const StorageSite& site, const double offset)
+  {
+    DArray& a = dynamic_cast<DArray&>(field[site]);
+    for(int i=0; i<a.getLength(); i++)
+      a[i] = offset + sin(0.37*i + offset);
+  }
+
+  void fillGradient(Field& field, const StorageSite& site)
+  {
+    Array<Gradient<double> >& a =
+      dynamic_cast<Array<Gradient<double> >&>(field[site]);
+    for(int i=0; i<a.getLength(); i++)
+      for(int d=0; d<3; d++)
+        a[i][d] = cos(0.11*i + d);
+  }
+
+  // the diagonal, the off diagonal coefficients and the residual in one
+  // array
+  DArray* assemble(ThermalFields& thermalFields, const GeomFields& geomFields,
+                   const MeshList& meshes, const bool threadedAssembly)
+  {
+    const StorageSite& cells = meshes[0]->getCells();
+    MultiField::ArrayIndex tIndex(&thermalFields.temperature,&cells);
+
+    LinearSystem ls;
+    ls.getX().addArray(tIndex,thermalFields.temperature.getArrayPtr(cells));
+    shared_ptr<TMatrix> m(new TMatrix(meshes[0]->getCellCells()));
+    ls.getMatrix().addMatrix(tIndex,tIndex,m);
+    ls.initAssembly();
+
+    DiscrList discretizations;
+    discretizations.push_back(shared_ptr<Discretization>
+      (new DiffusionDiscretization<double,double,double>
+       (meshes,geomFields,thermalFields.temperature,
+        thermalFields.conductivity,thermalFields.temperatureGradient)));
+    discretizations.push_back(shared_ptr<Discretization>
+      (new ConvectionDiscretization<double,double,double>
+       (meshes,geomFields,thermalFields.temperature,
+        thermalFields.convectionFlux,thermalFields.zero,
+        thermalFields.temperatureGradient)));
+    discretizations.push_back(shared_ptr<Discretization>
+      (new SourceDiscretization<double>
+       (meshes,geomFields,thermalFields.temperature,thermalFields.source)));
+    discretizations.push_back(shared_ptr<Discretization>
+      (new TimeDerivativeDiscretization<double,double,double>
+       (meshes,geomFields,thermalFields.temperature,
+        thermalFields.temperatureN1,thermalFields.temperatureN2,
+        thermalFields.specificHeat,0.1)));
+
+    Linearizer linearizer(threadedAssembly);
+    linearizer.linearize(discretizations,meshes,ls.getMatrix(),
+                         ls.getX(),ls.getB());
+
+    const DArray& diag = m->getDiag();
+    const DArray& offDiag = m->getOffDiag();
+    const DArray& b = dynamic_cast<const DArray&>(ls.getB()[tIndex]);
+    const int nDiag = diag.getLength();
+    const int nOffDiag = offDiag.getLength();
+    DArray* coeffs = new DArray(nDiag + nOffDiag + b.getLength());
+    for(int i=0; i<nDiag; i++)
+      (*coeffs)[i] = diag[i];
+    for(int i=0; i<nOffDiag; i++)
+      (*coeffs)[nDiag+i] = offDiag[i];
+    for(int i=0; i<b.getLength(); i++)
+      (*coeffs)[nDiag+nOffDiag+i] = b[i];
+    return coeffs;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef FVM_PARALLEL
+  MPI::Init(argc,argv);
+#endif
+
+  const int n = argc > 1 ? atoi(argv[1]) : 64;
+
+  bool ok = true;
+  {
+      Mesh* mesh = createSquareGrid(n);
+      MeshList meshes(1,mesh);
+      GeomFields geomFields("geom");
+      MeshMetricsCalculator<double> metrics(geomFields,meshes);
+      metrics.init();
+
+      ThermalFields thermalFields("therm");
+      ThermalModel<double> model(geomFields,thermalFields,meshes);
+      model.getOptions().transient = true;
+      model.getOptions().timeDiscretizationOrder = 2;
+      model.init();
+
+      const StorageSite& cells = mesh->getCells();
+      fill(thermalFields.temperature,cells,300);
+      fill(thermalFields.temperatureN1,cells,299);
+      fill(thermalFields.temperatureN2,cells,298);
+      fill(thermalFields.conductivity,cells,2);
+      fill(thermalFields.source,cells,0);
+      fill(thermalFields.specificHeat,cells,3);
+      fill(thermalFields.convectionFlux,mesh->getFaces(),0);
+      fillGradient(thermalFields.temperatureGradient,cells);
+
+      DArray* serial = assemble(thermalFields,geomFields,meshes,false);
+      DArray* threaded = assemble(thermalFields,geomFields,meshes,true);
+
+      // the coloured face loops add the faces of a cell in a different
+      // order, so the sums may differ in the last bits
+      double maxCoeff = 0;
+      double maxDiff = 0;
+      int nDifferent = 0;
+      for(int i=0; i<serial->getLength(); i++)
+      {
+          maxCoeff = max(maxCoeff,fabs((*serial)[i]));
+          maxDiff = max(maxDiff,fabs((*threaded)[i] - (*serial)[i]));
+          if ((*threaded)[i] != (*serial)[i])
+            nDifferent++;
+      }
+
+      ok = maxDiff <= 1e-13*maxCoeff;
+      cout << n*n << " cells, " << nDifferent << " of " << serial->getLength()
+           << " coefficients differ, by at most " << maxDiff/maxCoeff
+           << " of the largest" << (ok ? "" : "  FAILED") << endl;
+
+      delete serial;
+      delete threaded;
+      delete mesh;
+  }
+
+#ifdef FVM_PARALLEL
+  MPI::Finalize();
+#endif
+  return ok ? 0 : 1;
+}
@@ -11,13 +11,15 @@
 #include "OneToOneIndexMap.h"
 
 #include "Cell.h"
+#include <boost/cstdint.hpp>
 
 enum
   {
     READ_SIZES,
     READ_COUNTS,
     READ_MESH,
-    READ_DATA
+    READ_DATA,
+    READ_SLICE
   };
 
 enum
@@ -45,7 +47,10 @@ FluentReader::FluentReader(const string& fileName) :
   _faceZones(),
   _cellZones(),
   _coords(0),
-  _rpVarStringLength(0)
+  _rpVarStringLength(0),
+  _slice(),
+  _sliceFaceBegin(0),
+  _sliceFaceEnd(0)
 {}
 
 FluentReader::~FluentReader()
@@ -117,6 +122,50 @@ void FluentReader::readVectorData(Array<Vec3>& a,
       delete [] buff;
   }
 }
+
+// like readVectorData but one node at a time, keeping only the nodes
+// of the slice
+void FluentReader::readVectorDataSlice(const int iBeg, const int iEnd,
+                                       const bool isBinary, const bool isDP)
+{
+  moveToListOpen();
+
+  const int nodeBegin = _slice.nodeOffset;
+  const int nodeEnd = nodeBegin + int(_slice.coords.size());
+  for(int i=iBeg; i<=iEnd; i++)
+  {
+      double x[3] = {0,0,0};
+      for(int d=0; d<_dimension; d++)
+      {
+          if (isDP)
+          {
+              if (isBinary)
+              {
+                  if (fread(&x[d],sizeof(double),1,_fp) != 1)
+                    cerr << "error reading dp binary nodes" << endl;
+              }
+              else if (fscanf(_fp,"%le",&x[d]) != 1)
+                cerr << "error reading dp formatted nodes" << endl;
+          }
+          else
+          {
+              float xf = 0;
+              if (isBinary)
+              {
+                  if (fread(&xf,sizeof(float),1,_fp) != 1)
+                    cerr << "error reading sp binary nodes" << endl;
+              }
+              else if (fscanf(_fp,"%e",&xf) != 1)
+                cerr << "error reading sp formatted nodes" << endl;
+              x[d] = xf;
+          }
+      }
+
+      if (i-1 >= nodeBegin && i-1 < nodeEnd)
+        for(int d=0; d<3; d++)
+          _slice.coords[i-1-nodeBegin][d] = x[d];
+  }
+}
                                   
 void
 FluentReader::readNodes(const int pass, const bool isBinary,
@@ -161,6 +210,17 @@ FluentReader::readNodes(const int pass, const bool isBinary,
       else
         closeSection();
   }
+  else if (pass == READ_SLICE)
+  {
+      if (threadId != 0)
+      {
+          readVectorDataSlice(iBeg,iEnd,isBinary,isDP);
+      }
+      if (isBinary)
+        closeSectionBinary(sectionID);
+      else
+        closeSection();
+  }
   
   return;
 }
@@ -361,6 +421,63 @@ FluentReader::readFaces(const int pass, const bool isBinary,
     closeSection();
 
   }
+  else if (pass == READ_SLICE)
+  {
+      if  (threadId != 0)
+        moveToListOpen();
+
+      if ((threadId != 0) && (type != 0) && (type != 31))
+      {
+          if (shape < 0) shape = _dimension;
+
+          const int maxNodes = 100;
+          int fnodes[maxNodes];
+          for(int f=iBeg; f<=iEnd; f++)
+          {
+              int numNodes = shape;
+              if (shape == 0 || shape == 5)
+                numNodes = readInt(isBinary);
+
+              for(int i=0; i<numNodes; i++)
+                fnodes[i] = readInt(isBinary)-1;
+
+              int c0 = readInt(isBinary);
+              int c1 = readInt(isBinary);
+
+              if (f-1 < _sliceFaceBegin || f-1 >= _sliceFaceEnd)
+                continue;
+
+              if ((c0 == 0) && (c1 == 0))
+                throw CException("readMeshSlice: faces without cells are not supported");
+
+              // the cell inside goes first, as in readMesh
+              bool reverseNodes = _dimension == 3;
+              if (c0 == 0)
+              {
+                  reverseNodes = !reverseNodes;
+                  c0 = c1;
+                  c1 = 0;
+              }
+
+              _slice.faceCells.push_back(c0-1);
+              _slice.faceCells.push_back(c1-1);
+              
+              if (reverseNodes)
+                for(int i=0; i<numNodes; i++)
+                  _slice.faceNodesCol.push_back(fnodes[numNodes-i-1]);
+              else
+                for(int i=0; i<numNodes; i++)
+                  _slice.faceNodesCol.push_back(fnodes[i]);
+              _slice.faceNodesRow.push_back(int(_slice.faceNodesCol.size()));
+              _slice.faceGroups.push_back(threadId);
+          }
+      }
+
+      if (isBinary)
+        closeSectionBinary(sectionID);
+      else
+        closeSection();
+  }
   
 #if 0
   if (isBinary)
@@ -409,7 +526,8 @@ FluentReader::readFacePairs(const int pass, const bool isBinary,
       
 
   }
-  else if ((pass == READ_COUNTS) || (pass == READ_MESH))
+  else if ((pass == READ_COUNTS) || (pass == READ_MESH) ||
+           (pass == READ_SLICE))
   {
       moveToListOpen();
       if (isBinary)
@@ -607,6 +725,57 @@ FluentReader::readMesh()
   buildZones();
 }
 
+// the first of the count items that belong to the given one of nSlices
+// equal slices
+static int
+getSliceBegin(const int count, const int slice, const int nSlices)
+{
+  return int((boost::int64_t(count)*slice)/nSlices);
+}
+
+/**
+ * The first pass only finds the sizes and the zones; the faces and the
+ * node coordinates are read in a second pass that keeps those in the
+ * slice and skips the rest, so the memory needed doesn't grow with the
+ * size of the mesh. The faces are sliced in the order of their ids and
+ * the nodes likewise. Only meshes with a single cell zone and without
+ * periodic faces can be read this way. Every process still reads the
+ * whole file, twice, so the time to read a mesh does not go down with
+ * the number of processes.
+ *
+ */
+
+void
+FluentReader::readMeshSlice(const int slice, const int nSlices)
+{
+  read(READ_SIZES);
+
+  if (_cellZones.size() != 1)
+    throw CException("readMeshSlice: only meshes with one cell zone are supported");
+  if (!_facePairs.empty())
+    throw CException("readMeshSlice: periodic faces are not supported");
+
+  _slice = MeshSlice();
+  _slice.dimension = _dimension;
+  _slice.cellCount = _numCells;
+
+  _sliceFaceBegin = getSliceBegin(_numFaces,slice,nSlices);
+  _sliceFaceEnd = getSliceBegin(_numFaces,slice+1,nSlices);
+
+  _slice.nodeOffset = getSliceBegin(_numNodes,slice,nSlices);
+  _slice.coords.resize(getSliceBegin(_numNodes,slice+1,nSlices) -
+                       _slice.nodeOffset, Vec3::getZero());
+
+  foreach(const FaceZonesMap::value_type& pos, _faceZones)
+  {
+      const FluentFaceZone& fz = *(pos.second);
+      _slice.groupTypes[fz.ID] = fz.zoneType;
+  }
+
+  resetFilePtr();
+  read(READ_SLICE);
+}
+
 int
 FluentReader::getCellZoneID(const int c) const
 {
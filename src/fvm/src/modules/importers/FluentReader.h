@@ -12,6 +12,7 @@
 #include "Vector.h"
 #include "CRConnectivity.h"
 #include "Mesh.h"
+#include "MeshSlice.h"
 
 class OneToOneIndexMap;
 
@@ -85,6 +86,13 @@ public:
   void readMesh();
   //void orderCellFacesAndNodes();
 
+  // reads only the faces and nodes of one of nSlices equal slices of
+  // the mesh, for partitioning with DistributedMeshPartitioner, instead
+  // of the whole mesh like readMesh, though each process still reads
+  // the whole file
+  void readMeshSlice(const int slice, const int nSlices);
+  const MeshSlice& getMeshSlice() const {return _slice;}
+
 
   MeshList getMeshList();
 
@@ -121,6 +129,10 @@ protected:
   string _rpVars;
   map<int,int> _zoneVarStringLength;
 
+  MeshSlice _slice;
+  int _sliceFaceBegin;
+  int _sliceFaceEnd;
+
   void read(const int pass);
   void readNodes(const int pass, const bool isBinary,
                  const bool isDP, const int id);
@@ -132,6 +144,8 @@ protected:
   void readVectorData(Array<Vec3>& a,
                       const int iBeg, const int iEnd, const bool isBinary,
                       const bool isDP);
+  void readVectorDataSlice(const int iBeg, const int iEnd,
+                           const bool isBinary, const bool isDP);
 
   void buildZones();
 
@@ -50,6 +50,8 @@ public:
 
   FluentReader(const string& fileName);
   void readMesh();
+  void readMeshSlice(const int slice, const int nSlices);
+  const MeshSlice& getMeshSlice() const;
   int getNumCells();
   MeshList getMeshList();
   string getVars();
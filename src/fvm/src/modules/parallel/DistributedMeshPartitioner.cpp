@@ -0,0 +1,675 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#include <algorithm>
+#include <set>
+#include <boost/cstdint.hpp>
+#include "DistributedMeshPartitioner.h"
+#include "CRConnectivity.h"
+#include "StorageSite.h"
+#include "Array.h"
+#include "CException.h"
+#include <parmetis.h>
+
+namespace
+{
+  // sends sendBuffers[p] to every process p and returns what p sent to
+  // this one in recvBuffers[p]
+  template<class T>
+  void exchange(const vector<vector<T> >& sendBuffers,
+                vector<vector<T> >& recvBuffers, const MPI::Datatype& type)
+  {
+    const int nProcs = int(sendBuffers.size());
+    vector<int> sendCounts(nProcs);
+    vector<int> sendDispls(nProcs);
+    vector<T> sendBuffer;
+    for(int p=0; p<nProcs; p++)
+    {
+        sendCounts[p] = int(sendBuffers[p].size());
+        sendDispls[p] = int(sendBuffer.size());
+        sendBuffer.insert(sendBuffer.end(),sendBuffers[p].begin(),
+                          sendBuffers[p].end());
+    }
+
+    vector<int> recvCounts(nProcs);
+    MPI::COMM_WORLD.Alltoall(&sendCounts[0], 1, MPI::INT,
+                             &recvCounts[0], 1, MPI::INT);
+    vector<int> recvDispls(nProcs,0);
+    for(int p=1; p<nProcs; p++)
+      recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+    vector<T> recvBuffer(recvDispls[nProcs-1] + recvCounts[nProcs-1]);
+
+    MPI::COMM_WORLD.Alltoallv(sendBuffer.empty() ? 0 : &sendBuffer[0],
+                              &sendCounts[0], &sendDispls[0], type,
+                              recvBuffer.empty() ? 0 : &recvBuffer[0],
+                              &recvCounts[0], &recvDispls[0], type);
+
+    recvBuffers.assign(nProcs,vector<T>());
+    for(int p=0; p<nProcs; p++)
+      recvBuffers[p].assign(recvBuffer.begin() + recvDispls[p],
+                            recvBuffer.begin() + recvDispls[p] + recvCounts[p]);
+  }
+
+  // the offset of the items of this process when those of all the
+  // processes are numbered in the order of their ranks
+  int getOffset(const int count)
+  {
+    int offset = 0;
+    MPI::COMM_WORLD.Exscan(&count, &offset, 1, MPI::INT, MPI::SUM);
+    if (MPI::COMM_WORLD.Get_rank() == 0)
+      offset = 0;
+    return offset;
+  }
+
+  int getTag(const int procID, const int otherProcID)
+  {
+    return (std::max(procID,otherProcID) << 16) | std::min(procID,otherProcID);
+  }
+}
+
+DistributedMeshPartitioner::DistributedMeshPartitioner(const MeshSlice& slice) :
+  _slice(slice)
+{
+   if ( !MPI::Is_initialized() )  MPI::Init_thread( MPI::THREAD_MULTIPLE );
+   _procID = MPI::COMM_WORLD.Get_rank();
+   _nProcs = MPI::COMM_WORLD.Get_size();
+   compute_dist();
+}
+
+DistributedMeshPartitioner::~DistributedMeshPartitioner()
+{
+   vector< Mesh* >::iterator it_mesh;
+   for ( it_mesh = _meshListLocal.begin(); it_mesh != _meshListLocal.end(); it_mesh++)
+        delete *it_mesh;
+}
+
+void
+DistributedMeshPartitioner::partition()
+{
+   if ( _slice.cellCount < _nProcs )
+      throw CException("DistributedMeshPartitioner: fewer cells than processes");
+   parmetis_graph();
+}
+
+void
+DistributedMeshPartitioner::mesh()
+{
+   face_parts();
+   exchange_cells();
+   exchange_faces();
+   order_faces();
+   coordinates();
+   mappers();
+   set_local_global();
+   level1_scatter_gather_cells();
+   set_local_global();
+}
+
+//contiguous blocks of cells, and the node ranges of the slices
+void
+DistributedMeshPartitioner::compute_dist()
+{
+   _cellDist.resize( _nProcs+1 );
+   for ( int p = 0; p <= _nProcs; p++ )
+      _cellDist[p] = int( (boost::int64_t(_slice.cellCount)*p)/_nProcs );
+
+   const int nodeRange[2] = { _slice.nodeOffset, int(_slice.coords.size()) };
+   vector<int> nodeRanges( 2*_nProcs );
+   MPI::COMM_WORLD.Allgather( nodeRange, 2, MPI::INT, &nodeRanges[0], 2, MPI::INT );
+   _nodeDist.resize( _nProcs+1 );
+   for ( int p = 0; p < _nProcs; p++ )
+      _nodeDist[p] = nodeRanges[2*p];
+   _nodeDist[_nProcs] = nodeRanges[2*_nProcs-2] + nodeRanges[2*_nProcs-1];
+}
+
+int
+DistributedMeshPartitioner::getCellOwner(const int cell) const
+{
+   return int( upper_bound(_cellDist.begin(), _cellDist.end(), cell) - _cellDist.begin() ) - 1;
+}
+
+int
+DistributedMeshPartitioner::getNodeOwner(const int node) const
+{
+   return int( upper_bound(_nodeDist.begin(), _nodeDist.end(), node) - _nodeDist.begin() ) - 1;
+}
+
+int
+DistributedMeshPartitioner::getLocalCell(const int cell) const
+{
+   vector<int>::const_iterator it = lower_bound(_cells.begin(), _cells.end(), cell);
+   if ( it == _cells.end() || *it != cell )
+      throw CException("DistributedMeshPartitioner: face of a cell of another part");
+   return int( it - _cells.begin() );
+}
+
+//the neighbours of each cell of the block of this process, from the
+//interior faces of all the slices
+void
+DistributedMeshPartitioner::cell_graph(vector<int>& xadj, vector<int>& adjncy)
+{
+   const vector<int>& faceCells = _slice.faceCells;
+   const int nFaces = _slice.getFaceCount();
+   vector< vector<int> > sendEdges( _nProcs );
+   for ( int f = 0; f < nFaces; f++ ){
+      const int c0 = faceCells[2*f];
+      const int c1 = faceCells[2*f+1];
+      if ( c1 < 0 )
+         continue;
+      vector<int>& edges0 = sendEdges[ getCellOwner(c0) ];
+      edges0.push_back(c0);
+      edges0.push_back(c1);
+      vector<int>& edges1 = sendEdges[ getCellOwner(c1) ];
+      edges1.push_back(c1);
+      edges1.push_back(c0);
+   }
+   vector< vector<int> > recvEdges;
+   exchange( sendEdges, recvEdges, MPI::INT );
+   sendEdges.clear();
+
+   const int cellBegin = _cellDist[_procID];
+   const int nCells = _cellDist[_procID+1] - cellBegin;
+   xadj.assign( nCells+1, 0 );
+   for ( int p = 0; p < _nProcs; p++ )
+      for ( int i = 0; i < int(recvEdges[p].size()); i += 2 )
+         xadj[ recvEdges[p][i] - cellBegin + 1 ]++;
+   for ( int n = 0; n < nCells; n++ )
+      xadj[n+1] += xadj[n];
+
+   adjncy.resize( xadj[nCells] );
+   vector<int> pos( xadj.begin(), xadj.end()-1 );
+   for ( int p = 0; p < _nProcs; p++ )
+      for ( int i = 0; i < int(recvEdges[p].size()); i += 2 )
+         adjncy[ pos[recvEdges[p][i] - cellBegin]++ ] = recvEdges[p][i+1];
+
+   //cells sharing several faces are only neighbours once
+   int count = 0;
+   for ( int n = 0; n < nCells; n++ ){
+      const int begin = xadj[n];
+      sort( adjncy.begin() + begin, adjncy.begin() + xadj[n+1] );
+      const int end = int( unique(adjncy.begin() + begin, adjncy.begin() + xadj[n+1]) - adjncy.begin() );
+      xadj[n] = count;
+      for ( int i = begin; i < end; i++ )
+         adjncy[count++] = adjncy[i];
+   }
+   xadj[nCells] = count;
+   adjncy.resize( count );
+}
+
+void
+DistributedMeshPartitioner::parmetis_graph()
+{
+   vector<int> xadj;
+   vector<int> adjncy;
+   cell_graph( xadj, adjncy );
+
+   const int nCells = _cellDist[_procID+1] - _cellDist[_procID];
+   _part.assign( nCells, 0 );
+   //a single part needs no partitioning
+   if ( _nProcs == 1 )
+      return;
+
+   if ( adjncy.empty() )
+      adjncy.push_back( 0 );
+
+   int wghtFlag = 0;
+   int numFlag  = 0;
+   int ncon     = 1;
+   int nPart    = _nProcs;
+   int options  = 0;
+   int edgecut  = -1;
+   vector<float> tpwgts( _nProcs, 1.0f / float(_nProcs) );
+   float ubvec = 1.05f; //1.05 suggested value from parMetis manual
+   MPI_Comm comm_world = MPI::COMM_WORLD;
+   ParMETIS_V3_PartKway( &_cellDist[0], &xadj[0], &adjncy[0], NULL, NULL,
+        &wghtFlag, &numFlag, &ncon, &nPart, &tpwgts[0], &ubvec, &options,
+        &edgecut, &_part[0], &comm_world );
+}
+
+//the parts of the cells of the faces of the slice, asked from the
+//processes that have them
+void
+DistributedMeshPartitioner::face_parts()
+{
+   const vector<int>& faceCells = _slice.faceCells;
+   const int nFaces = _slice.getFaceCount();
+   vector< vector<int> > requests( _nProcs );
+   for ( int i = 0; i < 2*nFaces; i++ )
+      if ( faceCells[i] >= 0 )
+         requests[ getCellOwner(faceCells[i]) ].push_back( faceCells[i] );
+
+   vector< vector<int> > cells;
+   exchange( requests, cells, MPI::INT );
+   const int cellBegin = _cellDist[_procID];
+   for ( int p = 0; p < _nProcs; p++ )
+      for ( int i = 0; i < int(cells[p].size()); i++ )
+         cells[p][i] = _part[ cells[p][i] - cellBegin ];
+
+   vector< vector<int> > parts;
+   exchange( cells, parts, MPI::INT );
+
+   //the answers come in the order of the requests
+   vector<int> next( _nProcs, 0 );
+   _sliceFaceParts.assign( 2*nFaces, -1 );
+   for ( int i = 0; i < 2*nFaces; i++ ){
+      if ( faceCells[i] >= 0 ){
+         const int owner = getCellOwner( faceCells[i] );
+         _sliceFaceParts[i] = parts[owner][ next[owner]++ ];
+      }
+   }
+}
+
+//every cell goes to its part
+void
+DistributedMeshPartitioner::exchange_cells()
+{
+   vector< vector<int> > sendCells( _nProcs );
+   const int cellBegin = _cellDist[_procID];
+   for ( int i = 0; i < int(_part.size()); i++ )
+      sendCells[ _part[i] ].push_back( cellBegin + i );
+
+   vector< vector<int> > recvCells;
+   exchange( sendCells, recvCells, MPI::INT );
+   _cells.clear();
+   for ( int p = 0; p < _nProcs; p++ )
+      _cells.insert( _cells.end(), recvCells[p].begin(), recvCells[p].end() );
+   sort( _cells.begin(), _cells.end() );
+}
+
+//every face goes to the parts of its cells, as
+//  id, group, cell 0, cell 1, part 0, part 1, node count, nodes
+//with the global ids of the faces and of the boundary ghost cells
+//numbered in the order of the slices
+void
+DistributedMeshPartitioner::exchange_faces()
+{
+   const vector<int>& faceCells = _slice.faceCells;
+   const int nFaces = _slice.getFaceCount();
+   int nBoundaryFaces = 0;
+   for ( int f = 0; f < nFaces; f++ )
+      if ( faceCells[2*f+1] < 0 )
+         nBoundaryFaces++;
+
+   const int faceOffset = getOffset( nFaces );
+   int boundaryCell = _slice.cellCount + getOffset( nBoundaryFaces );
+
+   vector< vector<int> > sendFaces( _nProcs );
+   for ( int f = 0; f < nFaces; f++ ){
+      const int part0 = _sliceFaceParts[2*f];
+      const int part1 = _sliceFaceParts[2*f+1];
+      const int cell1 = part1 >= 0 ? faceCells[2*f+1] : boundaryCell++;
+      for ( int n = 0; n < 2; n++ ){
+         const int p = n == 0 ? part0 : part1;
+         if ( p < 0 || (n == 1 && p == part0) )
+            continue;
+         vector<int>& buffer = sendFaces[p];
+         buffer.push_back( faceOffset + f );
+         buffer.push_back( _slice.faceGroups[f] );
+         buffer.push_back( faceCells[2*f] );
+         buffer.push_back( cell1 );
+         buffer.push_back( part0 );
+         buffer.push_back( part1 );
+         buffer.push_back( _slice.faceNodesRow[f+1] - _slice.faceNodesRow[f] );
+         buffer.insert( buffer.end(), _slice.faceNodesCol.begin() + _slice.faceNodesRow[f],
+                        _slice.faceNodesCol.begin() + _slice.faceNodesRow[f+1] );
+      }
+   }
+
+   vector< vector<int> > recvFaces;
+   exchange( sendFaces, recvFaces, MPI::INT );
+   sendFaces.clear();
+
+   //the cell of this part goes first; the nodes of the faces that are
+   //turned around are reversed so that the normal still points from
+   //the first cell to the second
+   _faceNodesRow.assign( 1, 0 );
+   for ( int p = 0; p < _nProcs; p++ ){
+      const vector<int>& buffer = recvFaces[p];
+      int i = 0;
+      while ( i < int(buffer.size()) ){
+         const bool turn = buffer[i+4] != _procID;
+         const int nNodes = buffer[i+6];
+         _faceIDs.push_back( buffer[i] );
+         _faceGroups.push_back( buffer[i+1] );
+         _faceCells.push_back( buffer[turn ? i+3 : i+2] );
+         _faceCells.push_back( buffer[turn ? i+2 : i+3] );
+         _faceParts.push_back( buffer[turn ? i+4 : i+5] );
+         const int begin = i + 7;
+         if ( turn ){
+            for ( int n = nNodes-1; n >= 0; n-- )
+               _faceNodesCol.push_back( buffer[begin+n] );
+         } else {
+            for ( int n = 0; n < nNodes; n++ )
+               _faceNodesCol.push_back( buffer[begin+n] );
+         }
+         _faceNodesRow.push_back( int(_faceNodesCol.size()) );
+         i = begin + nNodes;
+      }
+   }
+}
+
+//interior faces first, then the boundary faces by group and then the
+//interface faces by neighbouring part, each in the order of their
+//global ids; the ghost cells are numbered in the same order
+void
+DistributedMeshPartitioner::order_faces()
+{
+   typedef pair< pair<int,int>, pair<int,int> > FaceKey;
+   const int nFaces = int( _faceIDs.size() );
+   vector<FaceKey> keys( nFaces );
+   for ( int f = 0; f < nFaces; f++ ){
+      const int part = _faceParts[f];
+      const int kind = part == _procID ? 0 : ( part < 0 ? 1 : 2 );
+      const int sub  = kind == 0 ? 0 : ( kind == 1 ? _faceGroups[f] : part );
+      keys[f] = make_pair( make_pair(kind,sub), make_pair(_faceIDs[f],f) );
+   }
+   sort( keys.begin(), keys.end() );
+   _faceOrder.resize( nFaces );
+   int nInteriorFaces = 0;
+   for ( int f = 0; f < nFaces; f++ ){
+      _faceOrder[f] = keys[f].second.second;
+      if ( keys[f].first.first == 0 )
+         nInteriorFaces++;
+   }
+
+   Mesh* mesh = new Mesh( _slice.dimension );
+   _meshListLocal.push_back( mesh );
+   const int nCells = int( _cells.size() );
+   mesh->getFaces().setCount( nFaces );
+   mesh->getCells().setCount( nCells, nFaces - nInteriorFaces );
+
+   mesh->createInteriorFaceGroup( nInteriorFaces );
+   int offset = nInteriorFaces;
+   while ( offset < nFaces ){
+      int end = offset;
+      while ( end < nFaces && keys[end].first == keys[offset].first )
+         end++;
+      const int sub = keys[offset].first.second;
+      if ( keys[offset].first.first == 1 ){
+         map<int,string>::const_iterator it = _slice.groupTypes.find( sub );
+         const string groupType = it == _slice.groupTypes.end() ? string("wall") : it->second;
+         mesh->createBoundaryFaceGroup( end-offset, offset, sub, groupType );
+      } else {
+         //negative as in MeshPartitioner::mesh_setup
+         mesh->createInterfaceGroup( end-offset, offset, -sub );
+      }
+      offset = end;
+   }
+
+   _localToGlobal = _cells;
+   shared_ptr<CRConnectivity> faceCells( new CRConnectivity(mesh->getFaces(), mesh->getCells()) );
+   faceCells->initCount();
+   for ( int f = 0; f < nFaces; f++ )
+      faceCells->addCount( f, 2 );
+   faceCells->finishCount();
+   for ( int f = 0; f < nFaces; f++ ){
+      const int face = _faceOrder[f];
+      faceCells->add( f, getLocalCell(_faceCells[2*face]) );
+      if ( f < nInteriorFaces ){
+         faceCells->add( f, getLocalCell(_faceCells[2*face+1]) );
+      } else {
+         faceCells->add( f, int(_localToGlobal.size()) );
+         _localToGlobal.push_back( _faceCells[2*face+1] );
+      }
+   }
+   faceCells->finishAdd();
+   mesh->setFaceCells( faceCells );
+}
+
+//the coordinates of the nodes of the faces, from the slices that have
+//them
+void
+DistributedMeshPartitioner::coordinates()
+{
+   _nodes = _faceNodesCol;
+   sort( _nodes.begin(), _nodes.end() );
+   _nodes.erase( unique(_nodes.begin(), _nodes.end()), _nodes.end() );
+   const int nNodes = int( _nodes.size() );
+
+   vector< vector<int> > requests( _nProcs );
+   for ( int n = 0; n < nNodes; n++ )
+      requests[ getNodeOwner(_nodes[n]) ].push_back( _nodes[n] );
+
+   vector< vector<int> > asked;
+   exchange( requests, asked, MPI::INT );
+   vector< vector<double> > sendCoords( _nProcs );
+   for ( int p = 0; p < _nProcs; p++ ){
+      for ( int i = 0; i < int(asked[p].size()); i++ ){
+         const MeshSlice::VecD3& x = _slice.coords[ asked[p][i] - _slice.nodeOffset ];
+         for ( int d = 0; d < 3; d++ )
+            sendCoords[p].push_back( x[d] );
+      }
+   }
+   vector< vector<double> > recvCoords;
+   exchange( sendCoords, recvCoords, MPI::DOUBLE );
+
+   //the nodes are sorted, so the answers come in their order
+   Mesh& mesh = *_meshListLocal.at(0);
+   StorageSite& nodes = mesh.getNodes();
+   nodes.setCount( nNodes );
+   shared_ptr< Array<Mesh::VecD3> > coords( new Array<Mesh::VecD3>(nNodes) );
+   int n = 0;
+   for ( int p = 0; p < _nProcs; p++ )
+      for ( int i = 0; i < int(recvCoords[p].size()); i += 3, n++ )
+         for ( int d = 0; d < 3; d++ )
+            (*coords)[n][d] = recvCoords[p][i+d];
+   mesh.setCoordinates( coords );
+
+   const int nFaces = int( _faceOrder.size() );
+   shared_ptr<CRConnectivity> faceNodes( new CRConnectivity(mesh.getFaces(), nodes) );
+   faceNodes->initCount();
+   for ( int f = 0; f < nFaces; f++ ){
+      const int face = _faceOrder[f];
+      faceNodes->addCount( f, _faceNodesRow[face+1] - _faceNodesRow[face] );
+   }
+   faceNodes->finishCount();
+   for ( int f = 0; f < nFaces; f++ ){
+      const int face = _faceOrder[f];
+      for ( int i = _faceNodesRow[face]; i < _faceNodesRow[face+1]; i++ )
+         faceNodes->add( f, int(lower_bound(_nodes.begin(), _nodes.end(), _faceNodesCol[i]) - _nodes.begin()) );
+   }
+   faceNodes->finishAdd();
+   mesh.setFaceNodes( faceNodes );
+
+   mesh.createLocalToGlobalNodesArray();
+   Array<int>& localToGlobalNodes = *mesh.getLocalToGlobalNodesPtr();
+   for ( int i = 0; i < nNodes; i++ )
+      localToGlobalNodes[i] = _nodes[i];
+
+   set<int>& boundaryNodeSet = mesh.getBoundaryNodesSet();
+   foreach(const FaceGroupPtr fgPtr, mesh.getBoundaryFaceGroups() ){
+      const StorageSite& faces = fgPtr->site;
+      const CRConnectivity& bFaceNodes = mesh.getFaceNodes(faces);
+      for ( int f = 0; f < faces.getCount(); f++ )
+         for ( int nn = 0; nn < bFaceNodes.getCount(f); nn++ )
+            boundaryNodeSet.insert( bFaceNodes(f,nn) );
+   }
+}
+
+//the interface faces of a neighbour are in the order of their global
+//ids on both sides, so the cells of the faces on one side scatter to
+//the ghost cells of the faces on the other
+void
+DistributedMeshPartitioner::mappers()
+{
+   Mesh& mesh = *_meshListLocal.at(0);
+   StorageSite& cellSite = mesh.getCells();
+   StorageSite::ScatterMap& cellScatterMap = cellSite.getScatterMap();
+   StorageSite::GatherMap&  cellGatherMap  = cellSite.getGatherMap();
+   const CRConnectivity& faceCells = mesh.getAllFaceCells();
+   foreach(const FaceGroupPtr fgPtr, mesh.getInterfaceGroups() ){
+      const StorageSite& faces = fgPtr->site;
+      const int neighID = -fgPtr->id;
+      const int size = faces.getCount();
+      const int offset = faces.getOffset();
+
+      shared_ptr<StorageSite> site( new StorageSite(size) );
+      site->setScatterProcID( _procID );
+      site->setGatherProcID ( neighID );
+      site->setTag( getTag(_procID,neighID) );
+      Mesh::PartIDMeshIDPair pairID = make_pair( neighID, 0 );
+      mesh.createGhostCellSiteScatter( pairID, site );
+      mesh.createGhostCellSiteGather ( pairID, site );
+
+      shared_ptr< Array<int> > fromIndices( new Array<int>(size) );
+      shared_ptr< Array<int> > toIndices  ( new Array<int>(size) );
+      for ( int f = 0; f < size; f++ ){
+         (*fromIndices)[f] = faceCells(offset+f,0);
+         (*toIndices)[f]   = faceCells(offset+f,1);
+      }
+      cellScatterMap[ site.get() ] = fromIndices;
+      cellGatherMap [ site.get() ] = toIndices;
+   }
+}
+
+void
+DistributedMeshPartitioner::set_local_global()
+{
+   Mesh& mesh = *_meshListLocal.at(0);
+   mesh.createLocalGlobalArray();
+   Array<int>& localToGlobal = mesh.getLocalToGlobal();
+   map<int,int>& globalToLocal = mesh.getGlobalToLocal();
+   globalToLocal.clear();
+   for ( int i = 0; i < localToGlobal.getLength(); i++ ){
+      localToGlobal[i] = _localToGlobal.at(i);
+      globalToLocal[ localToGlobal[i] ] = i;
+   }
+}
+
+//the second layer of ghost cells: the neighbours of the interface ghost
+//cells in the parts they come from. Every part sends each neighbour the
+//global ids and parts of the cells around the cells it scatters to it,
+//and then asks the parts of the ones it doesn't have for them
+void
+DistributedMeshPartitioner::level1_scatter_gather_cells()
+{
+   Mesh& mesh = *_meshListLocal.at(0);
+   StorageSite& cellSite = mesh.getCells();
+   const int nCells = cellSite.getCount();
+   const CRConnectivity& cellCells = mesh.getCellCells();
+   const CRConnectivity& faceCells = mesh.getAllFaceCells();
+   const FaceGroupList& interfaceGroups = mesh.getInterfaceGroups();
+
+   vector<int> cellParts( nCells, _procID );
+   set<int> level0Cells( _cells.begin(), _cells.end() );
+   foreach(const FaceGroupPtr fgPtr, interfaceGroups ){
+      const StorageSite& faces = fgPtr->site;
+      for ( int f = faces.getOffset(); f < faces.getOffset() + faces.getCount(); f++ ){
+         cellParts[ faceCells(f,1) ] = -fgPtr->id;
+         level0Cells.insert( _localToGlobal[faceCells(f,1)] );
+      }
+   }
+
+   vector< vector<int> > sendCells( _nProcs );
+   foreach(const FaceGroupPtr fgPtr, interfaceGroups ){
+      const StorageSite& faces = fgPtr->site;
+      vector<int>& buffer = sendCells[ -fgPtr->id ];
+      for ( int f = faces.getOffset(); f < faces.getOffset() + faces.getCount(); f++ ){
+         const int cell = faceCells(f,0);
+         buffer.push_back( cellCells.getCount(cell) );
+         for ( int j = 0; j < cellCells.getCount(cell); j++ ){
+            buffer.push_back( _localToGlobal[cellCells(cell,j)] );
+            buffer.push_back( cellParts[cellCells(cell,j)] );
+         }
+      }
+   }
+   vector< vector<int> > recvCells;
+   exchange( sendCells, recvCells, MPI::INT );
+   sendCells.clear();
+
+   //cellCellsGlobal has the neighbours of the interface ghost cells in
+   //the parts they come from
+   Mesh::multiMap& cellCellsGlobal = mesh.getCellCellsGlobal();
+   cellCellsGlobal.clear();
+   for ( int n = 0; n < nCells; n++ )
+      for ( int j = 0; j < cellCells.getCount(n); j++ )
+         cellCellsGlobal.insert( pair<int,int>(n, _localToGlobal[cellCells(n,j)]) );
+
+   map<int,int> level1Parts;
+   foreach(const FaceGroupPtr fgPtr, interfaceGroups ){
+      const StorageSite& faces = fgPtr->site;
+      const vector<int>& buffer = recvCells[ -fgPtr->id ];
+      int i = 0;
+      for ( int f = faces.getOffset(); f < faces.getOffset() + faces.getCount(); f++ ){
+         const int ghost = faceCells(f,1);
+         cellCellsGlobal.erase( ghost );
+         const int count = buffer[i++];
+         for ( int j = 0; j < count; j++, i += 2 ){
+            const int globalID = buffer[i];
+            const int partID   = buffer[i+1];
+            cellCellsGlobal.insert( pair<int,int>(ghost, globalID) );
+            if ( partID != _procID && level0Cells.count(globalID) == 0 )
+               level1Parts[globalID] = partID;
+         }
+      }
+   }
+
+   //ask for the level1 cells from their parts
+   vector< vector<int> > gatherArrays( _nProcs );
+   for ( map<int,int>::const_iterator it = level1Parts.begin(); it != level1Parts.end(); ++it )
+      gatherArrays[ it->second ].push_back( it->first );
+   vector< vector<int> > scatterArrays;
+   exchange( gatherArrays, scatterArrays, MPI::INT );
+
+   StorageSite::ScatterMap & cellScatterMapLevel1 = cellSite.getScatterMapLevel1();
+   StorageSite::GatherMap  & cellGatherMapLevel1  = cellSite.getGatherMapLevel1();
+   map<int,int>&  globalToLocal = mesh.getGlobalToLocal();
+   for ( int p = 0; p < _nProcs; p++ ){
+      const vector<int>& scatter_array = scatterArrays[p];
+      const int scatterSize = int( scatter_array.size() );
+      if ( scatterSize == 0 )
+         continue;
+      shared_ptr< Array<int> > from_indices( new Array<int>(scatterSize) );
+      for ( int i = 0; i < scatterSize; i++ )
+         (*from_indices)[i] = globalToLocal[ scatter_array[i] ];
+
+      shared_ptr<StorageSite> siteScatter( new StorageSite(scatterSize) );
+      siteScatter->setScatterProcID( _procID );
+      siteScatter->setGatherProcID ( p );
+      siteScatter->setTag( getTag(_procID,p) );
+      Mesh::PartIDMeshIDPair pairID = make_pair( p, 0 );
+      mesh.createGhostCellSiteScatterLevel1( pairID, siteScatter );
+      cellScatterMapLevel1[ siteScatter.get() ] = from_indices;
+   }
+
+   int gatherIndx = nCells;
+   for ( int p = 0; p < _nProcs; p++ ){
+      const vector<int>& gather_array = gatherArrays[p];
+      const int gatherSize = int( gather_array.size() );
+      if ( gatherSize == 0 )
+         continue;
+      shared_ptr< Array<int> > to_indices( new Array<int>(gatherSize) );
+      for ( int i = 0; i < gatherSize; i++ ){
+         (*to_indices)[i] = gatherIndx;
+         globalToLocal[ gather_array[i] ] = gatherIndx;
+         _localToGlobal.push_back( gather_array[i] );
+         gatherIndx++;
+      }
+
+      shared_ptr<StorageSite> siteGather( new StorageSite(gatherSize) );
+      siteGather->setScatterProcID( _procID );
+      siteGather->setGatherProcID ( p );
+      siteGather->setTag( getTag(_procID,p) );
+      Mesh::PartIDMeshIDPair pairID = make_pair( p, 0 );
+      mesh.createGhostCellSiteGatherLevel1( pairID, siteGather );
+      cellGatherMapLevel1[ siteGather.get() ] = to_indices;
+   }
+
+   cellSite.setCountLevel1( gatherIndx );
+
+   const StorageSite& faceSite = mesh.getFaces();
+   mesh.eraseConnectivity( cellSite, cellSite );
+   mesh.eraseConnectivity( cellSite, faceSite );
+   mesh.uniqueFaceCells();
+
+   mesh.createScatterGatherCountsBuffer();
+   mesh.syncCounts();
+   mesh.recvScatterGatherCountsBufferLocal();
+
+   mesh.createScatterGatherIndicesBuffer();
+   mesh.syncIndices();
+   mesh.recvScatterGatherIndicesBufferLocal();
+
+   mesh.createCellCellsGhostExt();
+}
@@ -0,0 +1,107 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef DISTRIBUTEDMESHPARTITIONER_H
+#define DISTRIBUTEDMESHPARTITIONER_H
+
+#include <vector>
+#include "Mesh.h"
+#include "MeshSlice.h"
+#include <mpi.h>
+
+using namespace std;
+
+/**
+ * Partitions a mesh that is read in slices, one per process, e.g. by
+ * FluentReader::readMeshSlice, into one part per process, without any
+ * process ever holding the whole mesh or an array over all its cells,
+ * so the memory needed by each process only grows with the size of its
+ * part. MeshPartitioner needs the whole mesh on every process instead.
+ *
+ * The cells start out distributed in contiguous blocks of global ids.
+ * partition builds the dual graph of the cells of each block from the
+ * faces of the slices and gives it to ParMETIS_V3_PartKway. mesh then
+ * moves every cell, and every face with its nodes, to the part of its
+ * cells with all-to-all exchanges, fetches the coordinates of the nodes
+ * from the slices that have them and builds the local meshes the same
+ * way as MeshPartitioner::mesh does: interior faces first, then the
+ * boundary groups and then one interface group per neighbouring part,
+ * with the ghost cells of both layers and their scatter and gather
+ * maps, and the global ids of the cells and nodes.
+ *
+ * The boundary ghost cells are numbered after the cells of the mesh, in
+ * the order of the slices and of their faces.
+ *
+ */
+
+class DistributedMeshPartitioner
+{
+public:
+
+  explicit DistributedMeshPartitioner(const MeshSlice& slice);
+  ~DistributedMeshPartitioner();
+
+  void partition();
+  void mesh();
+  const MeshList& meshList() const { return _meshListLocal; }
+
+private:
+  DistributedMeshPartitioner(const DistributedMeshPartitioner&);
+
+  void compute_dist();
+  void cell_graph(vector<int>& xadj, vector<int>& adjncy);
+  void parmetis_graph();
+  void face_parts();
+  void exchange_cells();
+  void exchange_faces();
+  void order_faces();
+  void coordinates();
+  void mappers();
+  void set_local_global();
+  void level1_scatter_gather_cells();
+
+  int getCellOwner(const int cell) const;
+  int getNodeOwner(const int node) const;
+  int getLocalCell(const int cell) const;
+
+  const MeshSlice& _slice;
+  int _procID;
+  int _nProcs;
+
+  // the first cell of each block and the first node of each slice, with
+  // the counts of all of them at the end
+  vector<int> _cellDist;
+  vector<int> _nodeDist;
+
+  // the part of each cell of the block of this process
+  vector<int> _part;
+
+  // the parts of the two cells of the faces of the slice, -1 for the
+  // outside of boundary faces
+  vector<int> _sliceFaceParts;
+
+  // the cells of this part, in the order of their global ids
+  vector<int> _cells;
+
+  // the faces of this part, with their own cell first and the part of
+  // the second, -1 for boundary faces
+  vector<int> _faceIDs;
+  vector<int> _faceGroups;
+  vector<int> _faceCells;
+  vector<int> _faceParts;
+  vector<int> _faceNodesRow;
+  vector<int> _faceNodesCol;
+
+  // the faces of this part in the order they are in the mesh and the
+  // global ids of the cells of the mesh
+  vector<int> _faceOrder;
+  vector<int> _localToGlobal;
+
+  // the nodes of this part, in the order of their global ids
+  vector<int> _nodes;
+
+  MeshList _meshListLocal;
+};
+
+#endif
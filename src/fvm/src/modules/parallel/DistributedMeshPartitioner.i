@@ -0,0 +1,16 @@
+%{
+#include "DistributedMeshPartitioner.h"
+%}
+
+%import "Mesh.i"
+using namespace std;
+
+class DistributedMeshPartitioner
+{
+public:
+
+  DistributedMeshPartitioner(const MeshSlice& slice);
+  void partition();
+  void mesh();
+  const MeshList& meshList();
+};
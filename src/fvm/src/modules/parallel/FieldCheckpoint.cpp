@@ -0,0 +1,430 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#include "FieldCheckpoint.h"
+#include "Array.h"
+#include "CRConnectivity.h"
+#include "CException.h"
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+  const int checkpointMagic = 0x464d5643;
+
+  void appendInt(vector<char>& bytes, const int i)
+  {
+    const char* p = reinterpret_cast<const char*>(&i);
+    bytes.insert(bytes.end(), p, p + sizeof(int));
+  }
+
+  int extractInt(const vector<char>& bytes, size_t& pos)
+  {
+    if (pos + sizeof(int) > bytes.size())
+      throw CException("FieldCheckpoint: truncated header");
+    int i;
+    copy(&bytes[pos], &bytes[pos] + sizeof(int), reinterpret_cast<char*>(&i));
+    pos += sizeof(int);
+    return i;
+  }
+
+  // the records of all meshes follow the header, each one starting at an
+  // offset aligned to 8 bytes
+  MPI::Offset alignOffset(const MPI::Offset offset)
+  {
+    return ((offset + 7) / 8) * 8;
+  }
+}
+
+FieldCheckpoint::FieldCheckpoint(const MeshList& meshes,
+                                 const MPI::Intracomm& comm) :
+  collectiveRead(true),
+  _meshes(meshes),
+  _comm(comm),
+  _fields()
+{}
+
+FieldCheckpoint::~FieldCheckpoint()
+{}
+
+void
+FieldCheckpoint::addField(Field& field)
+{
+  _fields.push_back(&field);
+}
+
+void
+FieldCheckpoint::getCells(Mesh& mesh, const bool writing,
+                          vector<pair<int,int> >& cells) const
+{
+  const StorageSite& site = mesh.getCells();
+  cells.clear();
+
+  // a mesh that has not been partitioned numbers its cells globally
+  shared_ptr<ArrayBase> localToGlobalPtr = mesh.getLocalToGlobalPtr();
+  if (!localToGlobalPtr)
+  {
+      for(int i=0; i<site.getCount(); i++)
+        cells.push_back(make_pair(i,i));
+      return;
+  }
+
+  const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+  if (writing)
+  {
+      // each value is written by exactly one process: the one owning
+      // the cell, or the interior cell next to a boundary ghost
+      for(int i=0; i<site.getSelfCount(); i++)
+        cells.push_back(make_pair(localToGlobal[i],i));
+
+      const CRConnectivity& faceCells = mesh.getAllFaceCells();
+      foreach(const FaceGroupPtr fgPtr, mesh.getBoundaryFaceGroups())
+      {
+          const StorageSite& faces = fgPtr->site;
+          const int ibeg = faces.getOffset();
+          const int iend = ibeg + faces.getCount();
+          for(int f=ibeg; f<iend; f++)
+          {
+              const int c = faceCells(f,1);
+              cells.push_back(make_pair(localToGlobal[c],c));
+          }
+      }
+  }
+  else
+  {
+      for(int i=0; i<localToGlobal.getLength(); i++)
+        if (localToGlobal[i] >= 0)
+          cells.push_back(make_pair(localToGlobal[i],i));
+  }
+
+  sort(cells.begin(),cells.end());
+}
+
+MPI::Info
+FieldCheckpoint::createHints() const
+{
+  // the records of a process are scattered over the file, so let the
+  // aggregators do large contiguous accesses for everyone
+  MPI::Info info = MPI::Info::Create();
+  info.Set("romio_cb_write","enable");
+  info.Set("romio_cb_read",collectiveRead ? "enable" : "disable");
+  return info;
+}
+
+int
+FieldCheckpoint::accessCells(MPI::File& file, const MeshRecord& record,
+                             const vector<int>& globalIDs, char* buffer,
+                             const bool writing) const
+{
+  // the cells are addressed in units of whole records so that the
+  // displacements of a large mesh still fit in an int
+  MPI::Datatype recordType = MPI::BYTE.Create_contiguous(record.recordSize);
+  recordType.Commit();
+
+  const int count = int(globalIDs.size());
+  const int* displacements = count > 0 ? &globalIDs[0] : 0;
+  MPI::Datatype fileType = recordType.Create_indexed_block(count, 1,
+                                                           displacements);
+  fileType.Commit();
+
+  file.Set_view(record.dataOffset, recordType, fileType, "native",
+                MPI::INFO_NULL);
+
+  MPI::Status status;
+  if (writing)
+    file.Write_all(buffer, count, recordType, status);
+  else if (collectiveRead)
+    file.Read_all(buffer, count, recordType, status);
+  else
+    file.Read_at(0, buffer, count, recordType, status);
+
+  int nDone = status.Get_count(recordType);
+
+  // some collective read implementations (OpenMPI's ompio with the
+  // vulcan fcoll component) can miss the last records of an indexed view
+  if (!writing && collectiveRead && nDone != count)
+  {
+      file.Read_at(0, buffer, count, recordType, status);
+      nDone = status.Get_count(recordType);
+  }
+
+  fileType.Free();
+  recordType.Free();
+
+  int nShort = nDone == count ? 0 : 1;
+  _comm.Allreduce(MPI::IN_PLACE, &nShort, 1, MPI::INT, MPI::SUM);
+  return nShort;
+}
+
+void
+FieldCheckpoint::write(const string& fileName)
+{
+  const int nMeshes = int(_meshes.size());
+  vector<MeshRecord> records(nMeshes);
+  vector<vector<pair<int,int> > > meshCells(nMeshes);
+
+  vector<char> header;
+  appendInt(header,checkpointMagic);
+  appendInt(header,0);
+  appendInt(header,nMeshes);
+
+  for(int id=0; id<nMeshes; id++)
+  {
+      Mesh& mesh = *_meshes[id];
+      const StorageSite& cells = mesh.getCells();
+      MeshRecord& record = records[id];
+
+      vector<pair<int,int> >& localCells = meshCells[id];
+      getCells(mesh,true,localCells);
+
+      record.nGlobal = localCells.empty() ? 0 : localCells.back().first + 1;
+      _comm.Allreduce(MPI::IN_PLACE, &record.nGlobal, 1, MPI::INT, MPI::MAX);
+
+      // a field only needs to have an array on some of the partitions
+      const int nFields = int(_fields.size());
+      vector<int> elemSizes(nFields,0);
+      for(int n=0; n<nFields; n++)
+        if (_fields[n]->hasArray(cells))
+        {
+            const ArrayBase& a = (*_fields[n])[cells];
+            if (a.getLength() > 0)
+              elemSizes[n] = a.getDataSize() / a.getLength();
+        }
+      if (nFields > 0)
+        _comm.Allreduce(MPI::IN_PLACE, &elemSizes[0], nFields,
+                        MPI::INT, MPI::MAX);
+
+      record.recordSize = 0;
+      for(int n=0; n<nFields; n++)
+        if (elemSizes[n] > 0)
+        {
+            record.names.push_back(_fields[n]->getName());
+            record.elemSizes.push_back(elemSizes[n]);
+            record.offsets.push_back(record.recordSize);
+            record.recordSize += elemSizes[n];
+        }
+
+      appendInt(header,record.nGlobal);
+      appendInt(header,record.recordSize);
+      appendInt(header,int(record.names.size()));
+      for(int n=0; n<int(record.names.size()); n++)
+      {
+          const string& name = record.names[n];
+          appendInt(header,record.elemSizes[n]);
+          appendInt(header,int(name.size()));
+          header.insert(header.end(), name.begin(), name.end());
+      }
+  }
+
+  const int headerSize = int(header.size());
+  copy(reinterpret_cast<const char*>(&headerSize),
+       reinterpret_cast<const char*>(&headerSize) + sizeof(int),
+       &header[sizeof(int)]);
+
+  MPI::Offset offset = alignOffset(headerSize);
+  for(int id=0; id<nMeshes; id++)
+  {
+      records[id].dataOffset = offset;
+      offset = alignOffset(offset + MPI::Offset(records[id].nGlobal) *
+                           records[id].recordSize);
+  }
+
+  MPI::Info hints = createHints();
+  MPI::File file = MPI::File::Open(_comm, fileName.c_str(),
+                                   MPI::MODE_CREATE | MPI::MODE_WRONLY, hints);
+  hints.Free();
+  file.Set_size(0);
+  if (_comm.Get_rank() == 0)
+    file.Write_at(0, &header[0], headerSize, MPI::BYTE);
+
+  for(int id=0; id<nMeshes; id++)
+  {
+      const MeshRecord& record = records[id];
+      if (record.recordSize == 0)
+        continue;
+
+      const StorageSite& cells = _meshes[id]->getCells();
+      const vector<pair<int,int> >& localCells = meshCells[id];
+      const int count = int(localCells.size());
+
+      vector<int> globalIDs(count);
+      vector<char> buffer(size_t(count)*record.recordSize + 1, 0);
+      for(int n=0; n<int(record.names.size()); n++)
+      {
+          for(int f=0; f<int(_fields.size()); f++)
+          {
+              const Field& field = *_fields[f];
+              if (field.getName() != record.names[n] || !field.hasArray(cells))
+                continue;
+
+              const ArrayBase& a = field[cells];
+              const char* data = static_cast<const char*>(a.getData());
+              const int elemSize = record.elemSizes[n];
+              for(int i=0; i<count; i++)
+              {
+                  const int c = localCells[i].second;
+                  if (c < a.getLength())
+                    copy(data + size_t(c)*elemSize,
+                         data + size_t(c+1)*elemSize,
+                         &buffer[size_t(i)*record.recordSize + record.offsets[n]]);
+              }
+              break;
+          }
+      }
+
+      for(int i=0; i<count; i++)
+        globalIDs[i] = localCells[i].first;
+
+      const int nShort = accessCells(file,record,globalIDs,&buffer[0],true);
+      if (nShort > 0)
+      {
+          file.Close();
+          ostringstream e;
+          e << "FieldCheckpoint::write: " << nShort << " processes wrote"
+            << " fewer records than expected to " << fileName;
+          throw CException(e.str());
+      }
+  }
+
+  file.Close();
+}
+
+void
+FieldCheckpoint::read(const string& fileName)
+{
+  MPI::Info hints = createHints();
+  MPI::File file = MPI::File::Open(_comm, fileName.c_str(),
+                                   MPI::MODE_RDONLY, hints);
+  hints.Free();
+
+  int start[2] = {0, 0};
+  MPI::Status status;
+  file.Read_at_all(0, start, 2, MPI::INT, status);
+  if (status.Get_count(MPI::INT) != 2 || start[0] != checkpointMagic)
+  {
+      file.Close();
+      throw CException("FieldCheckpoint::read: " + fileName +
+                       " is not a checkpoint file");
+  }
+
+  const int headerSize = start[1];
+  vector<char> header(headerSize);
+  file.Read_at_all(0, &header[0], headerSize, MPI::BYTE, status);
+  if (status.Get_count(MPI::BYTE) != headerSize)
+  {
+      file.Close();
+      throw CException("FieldCheckpoint: truncated header");
+  }
+
+  size_t pos = 2*sizeof(int);
+  const int nMeshes = extractInt(header,pos);
+  if (nMeshes != int(_meshes.size()))
+  {
+      file.Close();
+      throw CException("FieldCheckpoint::read: number of meshes does not match");
+  }
+
+  vector<MeshRecord> records(nMeshes);
+  MPI::Offset offset = alignOffset(headerSize);
+  for(int id=0; id<nMeshes; id++)
+  {
+      MeshRecord& record = records[id];
+      record.nGlobal = extractInt(header,pos);
+      record.recordSize = extractInt(header,pos);
+      const int nFields = extractInt(header,pos);
+      int recordOffset = 0;
+      for(int n=0; n<nFields; n++)
+      {
+          const int elemSize = extractInt(header,pos);
+          const int nameLength = extractInt(header,pos);
+          if (pos + nameLength > header.size())
+            throw CException("FieldCheckpoint: truncated header");
+          record.names.push_back(string(&header[pos], nameLength));
+          record.elemSizes.push_back(elemSize);
+          record.offsets.push_back(recordOffset);
+          recordOffset += elemSize;
+          pos += nameLength;
+      }
+      record.dataOffset = offset;
+      offset = alignOffset(offset + MPI::Offset(record.nGlobal) *
+                           record.recordSize);
+  }
+
+  for(int id=0; id<nMeshes; id++)
+  {
+      const MeshRecord& record = records[id];
+      if (record.recordSize == 0)
+        continue;
+
+      Mesh& mesh = *_meshes[id];
+      const StorageSite& cells = mesh.getCells();
+      vector<pair<int,int> > localCells;
+      getCells(mesh,false,localCells);
+
+      // a cell may appear more than once locally but is read only once;
+      // cells beyond those in the file keep their values
+      vector<int> globalIDs;
+      vector<int> position(localCells.size());
+      for(int i=0; i<int(localCells.size()); i++)
+      {
+          const int glblID = localCells[i].first;
+          if (glblID >= record.nGlobal)
+          {
+              position[i] = -1;
+              continue;
+          }
+          if (globalIDs.empty() || globalIDs.back() != glblID)
+            globalIDs.push_back(glblID);
+          position[i] = int(globalIDs.size()) - 1;
+      }
+
+      vector<char> buffer(globalIDs.size()*record.recordSize + 1);
+      const int nShort = accessCells(file,record,globalIDs,&buffer[0],false);
+      if (nShort > 0)
+      {
+          file.Close();
+          ostringstream e;
+          e << "FieldCheckpoint::read: " << nShort << " processes read"
+            << " fewer records than expected from " << fileName;
+          throw CException(e.str());
+      }
+
+      foreach(Field* fieldPtr, _fields)
+      {
+          Field& field = *fieldPtr;
+          if (!field.hasArray(cells))
+            continue;
+
+          for(int n=0; n<int(record.names.size()); n++)
+          {
+              if (field.getName() != record.names[n])
+                continue;
+
+              ArrayBase& a = field[cells];
+              const int elemSize = record.elemSizes[n];
+              if (a.getLength() > 0 && a.getDataSize() != a.getLength()*elemSize)
+              {
+                  file.Close();
+                  throw CException("FieldCheckpoint::read: type of " +
+                                 field.getName() + " does not match the checkpoint");
+              }
+
+              char* data = static_cast<char*>(a.getData());
+              for(int i=0; i<int(localCells.size()); i++)
+              {
+                  const int c = localCells[i].second;
+                  if (position[i] >= 0 && c < a.getLength())
+                  {
+                      const char* value = &buffer[size_t(position[i])*record.recordSize +
+                                                  record.offsets[n]];
+                      copy(value, value + elemSize, data + size_t(c)*elemSize);
+                  }
+              }
+              break;
+          }
+      }
+  }
+
+  file.Close();
+}
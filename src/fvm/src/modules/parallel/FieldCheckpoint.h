@@ -0,0 +1,83 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+#ifndef FIELDCHECKPOINT_H
+#define FIELDCHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include "Mesh.h"
+#include "Field.h"
+#include <mpi.h>
+
+using namespace std;
+
+/**
+ * Writes the cell values of a set of fields on the partitioned meshes
+ * into a single file with collective MPI-IO, and reads them back.
+ *
+ * The values of each mesh are stored by global cell id, all the fields
+ * of a cell next to each other, so the file does not depend on how the
+ * mesh was partitioned and a run can be restarted on a different number
+ * of processes. Every process writes its own cells and the ghost cells
+ * of its boundary faces; on reading it gets the values of all the cells
+ * it has a global id for, interface ghosts included.
+ *
+ * The meshes are matched by their position in the list and the fields
+ * by name; fields that are not in the file are left alone. The arrays
+ * must already exist on the cells of the meshes, i.e. read is called
+ * after the models are initialized.
+ *
+ * The file is opened with collective buffering hints for ROMIO. Every
+ * access checks the number of records transferred; a collective read
+ * that comes back short is retried with independent reads, and if that
+ * is short as well all the processes throw. Setting collectiveRead to
+ * false always uses independent reads.
+ *
+ */
+
+class FieldCheckpoint
+{
+public:
+
+  FieldCheckpoint(const MeshList& meshes,
+                  const MPI::Intracomm& comm = MPI::COMM_WORLD);
+  ~FieldCheckpoint();
+
+  void addField(Field& field);
+
+  void write(const string& fileName);
+  void read(const string& fileName);
+
+  bool collectiveRead;
+
+private:
+  FieldCheckpoint(const FieldCheckpoint&);
+
+  struct MeshRecord
+  {
+    int nGlobal;
+    int recordSize;
+    MPI::Offset dataOffset;
+    vector<string> names;
+    vector<int> elemSizes;
+    vector<int> offsets;
+  };
+
+  void getCells(Mesh& mesh, const bool writing,
+                vector<pair<int,int> >& cells) const;
+  MPI::Info createHints() const;
+
+  // returns the number of processes that transferred fewer records than
+  // they asked for
+  int accessCells(MPI::File& file, const MeshRecord& record,
+                  const vector<int>& globalIDs, char* buffer,
+                  const bool writing) const;
+
+  const MeshList _meshes;
+  MPI::Intracomm _comm;
+  vector<Field*> _fields;
+};
+
+#endif
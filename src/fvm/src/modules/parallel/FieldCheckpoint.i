@@ -0,0 +1,22 @@
+%{
+#include "FieldCheckpoint.h"
+%}
+
+%include "std_string.i"
+%import "Mesh.i"
+%import "Field.i"
+using namespace std;
+
+class FieldCheckpoint
+{
+public:
+
+  FieldCheckpoint(const MeshList& meshes);
+
+  void addField(Field& field);
+
+  void write(const string& fileName);
+  void read(const string& fileName);
+
+  bool collectiveRead;
+};
@@ -27,7 +27,7 @@
 MeshPartitioner::MeshPartitioner( const MeshList &mesh_list, vector<int> nPart,  vector<int> eType ):
 _meshList(mesh_list), _nPart(nPart), _eType(eType), _options(0), _bMesh(NULL)
 {
-   if ( !MPI::Is_initialized() )  MPI::Init();
+   if ( !MPI::Is_initialized() )  MPI::Init_thread( MPI::THREAD_MULTIPLE );
    init();
    assert( _meshList.size() == 1 );
 }
@@ -103,6 +103,8 @@ MeshPartitioner::partition()
      elem_connectivity();
      if ( _partTYPE == PARMETIS )
         parmetis_mesh();
+     if ( _partTYPE == PARMETIS_ADAPTIVE )
+        parmetis_adaptive_repart();
      map_part_elms();
      count_elems_part();
      exchange_part_elems();
@@ -293,6 +295,253 @@ MeshPartitioner::setNumFlag( int num_flag )
 
 }
 
+void
+MeshPartitioner::setCellWeights( const ArrayBase& weightsBase, int ncon )
+{
+   const Array<double>& weights = dynamic_cast< const Array<double>& >( weightsBase );
+   //only one mesh is supported (see the constructor)
+   const int id = 0;
+   const int nelems = _totElems.at(id);
+   if ( ncon < 1 || weights.getLength() != ncon * nelems )
+      throw CException("MeshPartitioner::setCellWeights: ncon weights per cell expected");
+
+   //ParMETIS takes integer weights, the largest weight of each constraint
+   //becomes maxWeight and the positive ones at least one
+   const double maxWeight = 1000.0;
+   vector<double> wmax( ncon, 0.0 );
+   for ( int n = 0; n < ncon * nelems; n++ ){
+      if ( weights[n] < 0.0 )
+         throw CException("MeshPartitioner::setCellWeights: negative weight");
+      wmax[n % ncon] = max( wmax[n % ncon], weights[n] );
+   }
+   for ( int i = 0; i < ncon; i++ )
+      if ( wmax[i] == 0.0 )
+         throw CException("MeshPartitioner::setCellWeights: all weights of a constraint are zero");
+
+   ArrayIntPtr cellWeights( new Array<int>( ncon * nelems ) );
+   for ( int n = 0; n < ncon * nelems; n++ ){
+      const double w = weights[n];
+      (*cellWeights)[n] = ( w > 0.0 ) ? max( 1, int( w / wmax[n % ncon] * maxWeight + 0.5 ) ) : 0;
+   }
+   _cellWeights.at(id) = cellWeights;
+   set_ncon( id, ncon );
+}
+
+void
+MeshPartitioner::setPreviousPartition( const MeshList& localMeshes )
+{
+   for ( int id = 0; id < _nmesh; id++ ){
+      const Mesh& mesh = *localMeshes.at(id);
+      const int nelems = _totElems.at(id);
+      const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+      const int selfCount = mesh.getCells().getSelfCount();
+
+      ArrayIntPtr cellParts( new Array<int>( nelems ) );
+      *cellParts = -1;
+      for ( int i = 0; i < selfCount; i++ )
+         (*cellParts)[ localToGlobal[i] ] = _procID;
+      MPI::COMM_WORLD.Allreduce( MPI::IN_PLACE, cellParts->getData(), nelems, MPI::INT, MPI::MAX );
+
+      for ( int n = 0; n < nelems; n++ )
+         if ( (*cellParts)[n] < 0 )
+            throw CException("MeshPartitioner::setPreviousPartition: local meshes don't cover the mesh");
+      _prevCellParts.at(id) = cellParts;
+   }
+   _partTYPE = PARMETIS_ADAPTIVE;
+}
+
+//sends sendCounts[p] items of blockSize values each from sendBuf to process p, in
+//process order, and returns in recvBuf the items received from all processes in
+//process order, recvCounts[p] of them from process p
+template<class T>
+static void
+exchange_items( const vector<T>& sendBuf, const vector<int>& sendCounts,
+                vector<T>& recvBuf, vector<int>& recvCounts,
+                const MPI::Datatype& type, const int blockSize = 1 )
+{
+   const int nprocs = MPI::COMM_WORLD.Get_size();
+   recvCounts.resize( nprocs );
+   MPI::COMM_WORLD.Alltoall( &sendCounts[0], 1, MPI::INT, &recvCounts[0], 1, MPI::INT );
+
+   vector<int> counts( nprocs ), offsets( nprocs, 0 );
+   vector<int> recvBlockCounts( nprocs ), recvOffsets( nprocs, 0 );
+   for ( int p = 0; p < nprocs; p++ ){
+      counts[p]          = sendCounts[p] * blockSize;
+      recvBlockCounts[p] = recvCounts[p] * blockSize;
+      if ( p > 0 ){
+         offsets[p]     = offsets[p-1] + counts[p-1];
+         recvOffsets[p] = recvOffsets[p-1] + recvBlockCounts[p-1];
+      }
+   }
+   const int nrecv = recvOffsets[nprocs-1] + recvBlockCounts[nprocs-1];
+   recvBuf.resize( nrecv+1 );
+   MPI::COMM_WORLD.Alltoallv( sendBuf.empty() ? 0 : &sendBuf[0], &counts[0], &offsets[0], type,
+                              &recvBuf[0], &recvBlockCounts[0], &recvOffsets[0], type );
+   recvBuf.resize( nrecv );
+}
+
+void
+MeshPartitioner::migrateField( Field& field, const MeshList& fromMeshes, const MeshList& toMeshes )
+{
+   const int nprocs = MPI::COMM_WORLD.Get_size();
+   const int procID = MPI::COMM_WORLD.Get_rank();
+   for ( int id = 0; id < int( fromMeshes.size() ); id++ ){
+      const Mesh& fromMesh = *fromMeshes.at(id);
+      const Mesh& toMesh   = *toMeshes.at(id);
+      const StorageSite& fromCells = fromMesh.getCells();
+      const StorageSite& toCells   = toMesh.getCells();
+      //all processes take part in the exchanges below, so they have to agree on
+      //skipping the mesh: [some process has the array, some process lacks it]
+      int hasArray[2] = { field.hasArray( fromCells ), !field.hasArray( fromCells ) };
+      MPI::COMM_WORLD.Allreduce( MPI::IN_PLACE, hasArray, 2, MPI::INT, MPI::MAX );
+      if ( !hasArray[0] )
+         continue;
+      if ( hasArray[1] )
+         throw CException("MeshPartitioner::migrateField: field has cell arrays on some processes only");
+
+      const ArrayBase& fromArray = field[fromCells];
+      int elemSize = ( fromArray.getLength() > 0 ) ? fromArray.getDataSize() / fromArray.getLength() : 0;
+      MPI::COMM_WORLD.Allreduce( MPI::IN_PLACE, &elemSize, 1, MPI::INT, MPI::MAX );
+
+      //the values this process is responsible for: those of its own cells and
+      //of the ghost cells of its boundary faces, as (globalID, cell) sorted by globalID
+      const Array<int>& fromLocalToGlobal = fromMesh.getLocalToGlobal();
+      vector< pair<int,int> > ownedCells;
+      for ( int i = 0; i < fromCells.getSelfCount(); i++ )
+         ownedCells.push_back( make_pair( fromLocalToGlobal[i], i ) );
+      const CRConnectivity& faceCells = fromMesh.getAllFaceCells();
+      foreach( const FaceGroupPtr fgPtr, fromMesh.getBoundaryFaceGroups() ){
+         const StorageSite& faces = fgPtr->site;
+         const int ibeg = faces.getOffset();
+         const int iend = ibeg + faces.getCount();
+         for ( int f = ibeg; f < iend; f++ ){
+            const int c = faceCells(f,1);
+            ownedCells.push_back( make_pair( fromLocalToGlobal[c], c ) );
+         }
+      }
+      sort( ownedCells.begin(), ownedCells.end() );
+
+      //arrays that include the second layer of ghosts keep it
+      const int length = ( fromArray.getLength() == fromCells.getCountLevel1() ) ?
+                           toCells.getCountLevel1() : toCells.getCount();
+      const Array<int>& toLocalToGlobal = toMesh.getLocalToGlobal();
+      const int nmapped = min( length, toLocalToGlobal.getLength() );
+      vector< pair<int,int> > neededCells;
+      for ( int i = 0; i < nmapped; i++ )
+         if ( toLocalToGlobal[i] >= 0 )
+            neededCells.push_back( make_pair( toLocalToGlobal[i], i ) );
+      sort( neededCells.begin(), neededCells.end() );
+
+      int nglobal = 0;
+      if ( !ownedCells.empty() )
+         nglobal = ownedCells.back().first + 1;
+      if ( !neededCells.empty() )
+         nglobal = max( nglobal, neededCells.back().first + 1 );
+      MPI::COMM_WORLD.Allreduce( MPI::IN_PLACE, &nglobal, 1, MPI::INT, MPI::MAX );
+
+      //the old and the new owners of a cell meet at the process that has its globalID
+      //in a block distribution of the ids, so no process needs a map of all the cells
+      const int blockSize = nglobal / nprocs + 1;
+      vector<int> ownedIDs, neededIDs;
+      vector<int> ownedCounts( nprocs, 0 ), neededCounts( nprocs, 0 );
+      for ( int n = 0; n < int( ownedCells.size() ); n++ ){
+         ownedIDs.push_back( ownedCells[n].first );
+         ownedCounts[ ownedCells[n].first / blockSize ]++;
+      }
+      for ( int n = 0; n < int( neededCells.size() ); n++ )
+         if ( neededIDs.empty() || neededIDs.back() != neededCells[n].first ){
+            neededIDs.push_back( neededCells[n].first );
+            neededCounts[ neededCells[n].first / blockSize ]++;
+         }
+
+      vector<int> homeOwnedIDs, homeOwnedCounts, homeNeededIDs, homeNeededCounts;
+      exchange_items( ownedIDs,  ownedCounts,  homeOwnedIDs,  homeOwnedCounts,  MPI::INT );
+      exchange_items( neededIDs, neededCounts, homeNeededIDs, homeNeededCounts, MPI::INT );
+
+      const int blockStart = procID * blockSize;
+      vector<int> oldOwner( blockSize, -1 );
+      int n = 0;
+      for ( int p = 0; p < nprocs; p++ )
+         for ( int i = 0; i < homeOwnedCounts[p]; i++, n++ )
+            oldOwner[ homeOwnedIDs[n] - blockStart ] = p;
+
+      //send each old owner the (globalID, new owner) pairs of the values it has to send
+      vector<int> routeCounts( nprocs, 0 );
+      for ( n = 0; n < int( homeNeededIDs.size() ); n++ ){
+         const int owner = oldOwner[ homeNeededIDs[n] - blockStart ];
+         if ( owner >= 0 )
+            routeCounts[owner]++;
+      }
+      vector<int> routeOffsets( nprocs, 0 );
+      for ( int p = 1; p < nprocs; p++ )
+         routeOffsets[p] = routeOffsets[p-1] + routeCounts[p-1];
+      vector<int> routes( 2*( routeOffsets[nprocs-1] + routeCounts[nprocs-1] ) );
+      n = 0;
+      for ( int p = 0; p < nprocs; p++ )
+         for ( int i = 0; i < homeNeededCounts[p]; i++, n++ ){
+            const int owner = oldOwner[ homeNeededIDs[n] - blockStart ];
+            if ( owner >= 0 ){
+               const int pos = routeOffsets[owner]++;
+               routes[2*pos]   = homeNeededIDs[n];
+               routes[2*pos+1] = p;
+            }
+         }
+      vector<int> myRoutes, myRouteCounts;
+      exchange_items( routes, routeCounts, myRoutes, myRouteCounts, MPI::INT, 2 );
+
+      //the old owners send the values straight to the new owners
+      const int nroutes = int( myRoutes.size() ) / 2;
+      vector<int> sendCounts( nprocs, 0 );
+      for ( n = 0; n < nroutes; n++ )
+         sendCounts[ myRoutes[2*n+1] ]++;
+      vector<int> sendOffsets( nprocs, 0 );
+      for ( int p = 1; p < nprocs; p++ )
+         sendOffsets[p] = sendOffsets[p-1] + sendCounts[p-1];
+
+      const char* fromData = static_cast<const char*>( fromArray.getData() );
+      vector<int>  sendIDs( nroutes );
+      vector<char> sendValues( size_t(nroutes)*elemSize );
+      for ( n = 0; n < nroutes; n++ ){
+         const int glblID = myRoutes[2*n];
+         const int pos = sendOffsets[ myRoutes[2*n+1] ]++;
+         const int c = lower_bound( ownedCells.begin(), ownedCells.end(),
+                                    make_pair( glblID, -1 ) )->second;
+         sendIDs[pos] = glblID;
+         copy( fromData + size_t(c)*elemSize, fromData + size_t(c+1)*elemSize,
+               &sendValues[ size_t(pos)*elemSize ] );
+      }
+      for ( int p = 0; p < nprocs; p++ )
+         sendOffsets[p] -= sendCounts[p];
+
+      vector<int>  recvIDs, recvCounts;
+      vector<char> recvValues;
+      exchange_items( sendIDs,    sendCounts, recvIDs,    recvCounts, MPI::INT );
+      exchange_items( sendValues, sendCounts, recvValues, recvCounts, MPI::BYTE, elemSize );
+
+      vector< pair<int,int> > received( recvIDs.size() );
+      for ( n = 0; n < int( recvIDs.size() ); n++ )
+         received[n] = make_pair( recvIDs[n], n );
+      sort( received.begin(), received.end() );
+
+      shared_ptr<ArrayBase> toArray = fromArray.newSizedClone( length );
+      toArray->zero();
+      char* toData = static_cast<char*>( toArray->getData() );
+      vector< pair<int,int> >::const_iterator r = received.begin();
+      for ( n = 0; n < int( neededCells.size() ); n++ ){
+         const int glblID = neededCells[n].first;
+         while ( r != received.end() && r->first < glblID )
+            r++;
+         if ( r != received.end() && r->first == glblID ){
+            const char* value = &recvValues[ size_t(r->second)*elemSize ];
+            copy( value, value + elemSize, toData + size_t(neededCells[n].second)*elemSize );
+         }
+      }
+
+      field.removeArray( fromCells );
+      field.addArray( toCells, toArray );
+   }
+}
+
            // PRIVATE METHODS
 
 void
@@ -327,6 +576,8 @@ MeshPartitioner::init()
    _windowSize.resize( _nmesh );
    _fromIndices.resize( _nmesh );
    _toIndices.resize( _nmesh );
+   _cellWeights.resize( _nmesh );
+   _prevCellParts.resize( _nmesh );
    _cleanup = false;
    _debugMode = false;
     for ( int id = 0; id < _nmesh; id++){
@@ -340,11 +591,10 @@ MeshPartitioner::init()
        if (  _meshList.at(id)->isMergedMesh() )
            _ncon.at(id)     = _meshList.at(id)->getNumOfAssembleMesh();
 
-       //assign ubvec
-       _ubvec.push_back( new float[_ncon.at(id) ] );
-       for ( int n = 0; n < _ncon.at(id); n++)
-         _ubvec.at(id)[n] = 1.05f; //1.05 suggested value from parMetis manual
-
+       //assign ubvec and tpwgts
+       _ubvec.push_back( NULL );
+       _tpwgts.push_back( NULL );
+       set_ncon( id, _ncon.at(id) );
 
         //assign elementy type
         switch (_eType.at(id) ){
@@ -365,13 +615,6 @@ MeshPartitioner::init()
                     endl;     abort(); 
         } 
 
-        //get tpwgts
-        int ncon_by_nparts = _ncon.at(id) * _nPart.at(id);
-        _tpwgts.push_back( new float[ ncon_by_nparts ] );
-        for (int n = 0; n < ncon_by_nparts; n++){
-            _tpwgts.at(id)[n] = 1.0f / float( ncon_by_nparts );
-        }
-
        //edgecut
         _edgecut.at(id) = -1;
 
@@ -383,6 +626,24 @@ MeshPartitioner::init()
 
 }
 
+void
+MeshPartitioner::set_ncon( int id, int ncon )
+{
+   _ncon.at(id) = ncon;
+
+   delete [] _ubvec.at(id);
+   _ubvec.at(id) = new float[ncon];
+   for ( int n = 0; n < ncon; n++)
+     _ubvec.at(id)[n] = 1.05f; //1.05 suggested value from parMetis manual
+
+   //the target weights of the parts add up to one for each constraint
+   int ncon_by_nparts = ncon * _nPart.at(id);
+   delete [] _tpwgts.at(id);
+   _tpwgts.at(id) = new float[ncon_by_nparts];
+   for ( int n = 0; n < ncon_by_nparts; n++)
+      _tpwgts.at(id)[n] = 1.0f / float( _nPart.at(id) );
+}
+
 
 
 void 
@@ -468,7 +729,13 @@ MeshPartitioner::elem_connectivity()
       _eElm.push_back( new int[mesh_nlocal+1] );
        //element weights  
       _elmWght.push_back( new int[_ncon.at(id)*mesh_nlocal] );
-       if (  !_meshList.at(id)->isMergedMesh() ){
+       if ( _cellWeights.at(id) ){
+          _wghtFlag.at(id) = int( WEIGTHS_ONLY_VERTICES );
+          const Array<int>& cellWeights = *_cellWeights.at(id);
+          const int offset = _ncon.at(id) * (*_globalIndx.at(id))[_procID];
+          for ( int n = 0; n < _ncon.at(id)*mesh_nlocal; n++)
+             _elmWght.at(id)[n] = cellWeights[offset+n];
+       } else if (  !_meshList.at(id)->isMergedMesh() ){
           _wghtFlag.at(id) = int( NOWEIGHTS ); //No Weights : default value
           for ( int n = 0; n < _ncon.at(id)*mesh_nlocal; n++)
              _elmWght.at(id)[n] = 1;
@@ -585,6 +852,48 @@ MeshPartitioner::parmetis_mesh()
 
 }
 
+//ParMETIS adaptive repartitioning works on the dual graph of the cells, taken from
+//the global mesh that every process has
+void
+MeshPartitioner::parmetis_adaptive_repart()
+{
+   MPI_Comm comm_world = MPI::COMM_WORLD;
+   for ( int id = 0; id < _nmesh; id++){
+       const CRConnectivity& cellCells = _meshList.at(id)->getCellCells();
+       const Array<int>& prevCellParts = *_prevCellParts.at(id);
+       const int nelems      = _totElems.at(id);
+       const int elem_start  = (*_globalIndx.at(id))[_procID];
+       const int mesh_nlocal = (*_elemDist.at(id))[_procID];
+
+       vector<int> xadj( mesh_nlocal+1 );
+       vector<int> adjncy;
+       vector<int> vsize( mesh_nlocal+1, 1 );
+       xadj[0] = 0;
+       for ( int n = 0; n < mesh_nlocal; n++ ){
+          const int elem = elem_start + n;
+          for ( int j = 0; j < cellCells.getCount(elem); j++ )
+             if ( cellCells(elem,j) < nelems )
+                adjncy.push_back( cellCells(elem,j) );
+          xadj[n+1] = int( adjncy.size() );
+          //starting partition
+          _part.at(id)[n] = prevCellParts[elem];
+       }
+       if ( adjncy.empty() )
+          adjncy.push_back( 0 );
+
+       //ratio of inter-processor communication to data redistribution time
+       float ipc2redist = 1000.0f; //1000 suggested value from parMetis manual
+       ParMETIS_V3_AdaptiveRepart( &(*_globalIndx.at(id))[0], &xadj[0], &adjncy[0],
+        _elmWght.at(id), &vsize[0], NULL, &_wghtFlag.at(id), &_numFlag.at(id), &_ncon.at(id),
+        &_nPart.at(id), _tpwgts.at(id), _ubvec.at(id), &ipc2redist, &_options, &_edgecut.at(id),
+        _part.at(id), &comm_world );
+   }
+
+   if ( _debugMode )
+      DEBUG_parmetis_mesh();
+
+}
+
 //debuggin parmetis_mesh
 void
 MeshPartitioner::DEBUG_parmetis_mesh()
@@ -725,23 +1034,18 @@ void
 MeshPartitioner::count_elems_part()
 {
    for ( int id = 0; id < _nmesh; id++){
-       for ( int partID = 0; partID < _nPart.at(id); partID++){
-          int nelems_local = _mapPartAndElms.at(id).count(partID);
-
-          //sum to find size of ncol
-          multimap<int,int>::const_iterator it = _mapPartAndElms.at(id).find(partID);
-          multimap<int,int>::const_iterator itlow = _mapPartAndElms.at(id).lower_bound(partID);
-          multimap<int,int>::const_iterator itup = _mapPartAndElms.at(id).upper_bound(partID);
-          int ncol_local = 0;
-          for ( it = itlow; it != itup; it++){
-              int pos = it->second;  // element number
-              ncol_local += _ePtr.at(id)[pos+1] - _ePtr.at(id)[pos];
-          }
-
-          MPI::COMM_WORLD.Reduce(&nelems_local, &_nelems.at(id), 1, MPI::INT, MPI::SUM, partID);
-          MPI::COMM_WORLD.Reduce(&ncol_local, &_colDim.at(id), 1, MPI::INT, MPI::SUM, partID);
+       //one exchange with all processes instead of a reduction rooted at each partition
+       vector<int> sendCounts;
+       vector<int> recvCounts;
+       part_elem_counts( id, sendCounts, recvCounts );
 
+      _nelems.at(id) = 0;
+      _colDim.at(id) = 0;
+       for ( int partID = 0; partID < _nPart.at(id); partID++){
+          _nelems.at(id) += recvCounts[2*partID];
+          _colDim.at(id) += recvCounts[2*partID+1];
        }
+
        //now each processor now how many elements and nodes
       _row.push_back ( new int[_nelems.at(id)+1] );
       _elem.push_back( new int[_nelems.at(id) ] );
@@ -760,6 +1064,25 @@ MeshPartitioner::count_elems_part()
 
 }
 
+//number of elements and element nodes this process sends to each partition (sendCounts[2*partID] and
+//sendCounts[2*partID+1]) and receives from each process if it owns the partition (recvCounts)
+void
+MeshPartitioner::part_elem_counts( int id, vector<int>& sendCounts, vector<int>& recvCounts )
+{
+   sendCounts.assign( 2*_nPart.at(id), 0 );
+   recvCounts.assign( 2*_nPart.at(id), 0 );
+
+   multimap<int,int>::const_iterator it;
+   for ( it = _mapPartAndElms.at(id).begin(); it != _mapPartAndElms.at(id).end(); it++){
+       int partID = it->first;
+       int pos    = it->second;  // element number
+       sendCounts[2*partID]++;
+       sendCounts[2*partID+1] += _ePtr.at(id)[pos+1] - _ePtr.at(id)[pos];
+   }
+
+   MPI::COMM_WORLD.Alltoall(&sendCounts[0], 2, MPI::INT, &recvCounts[0], 2, MPI::INT);
+}
+
 //debug count_elems_part
 void
 MeshPartitioner::DEBUG_count_elems_part()
@@ -785,80 +1108,55 @@ MeshPartitioner::exchange_part_elems()
 {
 
    for ( int id = 0; id < _nmesh; id++){
+       const int npart = _nPart.at(id);
+       vector<int> counts;
+       vector<int> recvCounts;
+       part_elem_counts( id, counts, recvCounts );
+
+       vector<int> countsRow( npart ),  countsCol( npart );
+       vector<int> offsetsRow( npart ), offsetsCol( npart );
+       vector<int> recvCountsRow( npart ),  recvCountsCol( npart );
+       vector<int> recvOffsetsRow( npart ), recvOffsetsCol( npart );
+       for ( int p = 0; p < npart; p++ ){
+          countsRow[p] = counts[2*p];
+          countsCol[p] = counts[2*p+1];
+          recvCountsRow[p] = recvCounts[2*p];
+          recvCountsCol[p] = recvCounts[2*p+1];
+          if ( p > 0 ){
+             offsetsRow[p] = offsetsRow[p-1] + countsRow[p-1];
+             offsetsCol[p] = offsetsCol[p-1] + countsCol[p-1];
+             recvOffsetsRow[p] = recvOffsetsRow[p-1] + recvCountsRow[p-1];
+             recvOffsetsCol[p] = recvOffsetsCol[p-1] + recvCountsCol[p-1];
+          }
+       }
 
-       int *countsRow  =  new int[_nPart.at(id)];
-       int *countsCol  =  new int[_nPart.at(id)];
-       int *offsetsRow =  new int[_nPart.at(id)];
-       int *offsetsCol =  new int[_nPart.at(id)];
-
-
-       for ( int partID = 0; partID < _nPart.at(id); partID++){
-          int nelems_local = _mapPartAndElms.at(id).count(partID);
-          int *row_local  = new int[nelems_local];
-          int *elem_local = new int[nelems_local];
-
-           multimap<int,int>::const_iterator it = _mapPartAndElms.at(id).find(partID);
-           multimap<int,int>::const_iterator itlow = _mapPartAndElms.at(id).lower_bound(partID);
-           multimap<int,int>::const_iterator itup = _mapPartAndElms.at(id).upper_bound(partID);
-
-           //fill row array
-           int indx = 0;
-           int ncol_local = 0; 
-           for ( it = itlow; it != itup; it++){
-              int pos         = it->second;  // element number
-              ncol_local     += _ePtr.at(id)[pos+1] - _ePtr.at(id)[pos];
-              row_local[indx]  = _ePtr.at(id)[pos+1]-_ePtr.at(id)[pos]; //aggregation before shipping
-              elem_local[indx] = _eElm.at(id)[pos];  //globalID stored in _eElm
-              indx++;
-           }
-
-           //fill col array
-           int *col_local = new int[ncol_local];
-           indx = 0;
-           for ( it = itlow; it != itup; it++ ){
-              int elID = it->second;
-              int node_start = _ePtr.at(id)[elID];
-              int node_end   = _ePtr.at(id)[elID+1];
-              for ( int node = node_start; node < node_end; node++){
-                 col_local[indx++] = _eInd.at(id)[node];
-              }
-           }
-
-         //forming counts
-         int nrow_local = nelems_local;
-         MPI::COMM_WORLD.Allgather(&nrow_local, 1, MPI::INT, countsRow, 1, MPI::INT);
-         MPI::COMM_WORLD.Allgather(&ncol_local, 1, MPI::INT, countsCol, 1, MPI::INT);
-
-
-        //form offsets
-        offsetsRow[0]  = 0;
-        offsetsCol[0]  = 0;
-        for ( int p = 1; p < int(_nPart.at(id)); p++ ){
-           offsetsRow[p]  = countsRow[p-1]  + offsetsRow[p-1];
-           offsetsCol[p]  = countsCol[p-1]  + offsetsCol[p-1];
-        } 
-
-        //gathering partial partions for _row and _col
-        MPI::COMM_WORLD.Gatherv(row_local, countsRow[_procID], MPI::INT, _row.at(id), 
-                                countsRow, offsetsRow, MPI::INT, partID);
-
-        MPI::COMM_WORLD.Gatherv(col_local, countsCol[_procID], MPI::INT, _col.at(id), 
-                                countsCol, offsetsCol, MPI::INT, partID);
- 
-        MPI::COMM_WORLD.Gatherv(elem_local, countsRow[_procID], MPI::INT, _elem.at(id),
-                                countsRow, offsetsRow, MPI::INT, partID);
-
+       //elements are already sorted by partition in _mapPartAndElms
+       const int nelems_local = (*_elemDist.at(id))[_procID];
+       const int ncol_local   = _ePtr.at(id)[nelems_local];
+       vector<int> row_local ( std::max(nelems_local,1) );
+       vector<int> elem_local( std::max(nelems_local,1) );
+       vector<int> col_local ( std::max(ncol_local,1) );
+       int indxRow = 0;
+       int indxCol = 0;
+       multimap<int,int>::const_iterator it;
+       for ( it = _mapPartAndElms.at(id).begin(); it != _mapPartAndElms.at(id).end(); it++){
+          int pos         = it->second;  // element number
+          row_local[indxRow]  = _ePtr.at(id)[pos+1]-_ePtr.at(id)[pos]; //aggregation before shipping
+          elem_local[indxRow] = _eElm.at(id)[pos];  //globalID stored in _eElm
+          indxRow++;
+          for ( int node = _ePtr.at(id)[pos]; node < _ePtr.at(id)[pos+1]; node++)
+             col_local[indxCol++] = _eInd.at(id)[node];
+       }
 
-        delete [] row_local;
-        delete [] col_local;
-        delete [] elem_local;
+       //each partition receives its elements from all processes in process order
+       MPI::COMM_WORLD.Alltoallv(&row_local[0], &countsRow[0], &offsetsRow[0], MPI::INT,
+                                 _row.at(id), &recvCountsRow[0], &recvOffsetsRow[0], MPI::INT);
 
-       }  // for::partID
+       MPI::COMM_WORLD.Alltoallv(&col_local[0], &countsCol[0], &offsetsCol[0], MPI::INT,
+                                 _col.at(id), &recvCountsCol[0], &recvOffsetsCol[0], MPI::INT);
 
-       delete [] countsRow ;
-       delete [] countsCol ;
-       delete [] offsetsRow;
-       delete [] offsetsCol;
+       MPI::COMM_WORLD.Alltoallv(&elem_local[0], &countsRow[0], &offsetsRow[0], MPI::INT,
+                                 _elem.at(id), &recvCountsRow[0], &recvOffsetsRow[0], MPI::INT);
 
     }  // for::meshID
 
@@ -1227,7 +1525,6 @@ MeshPartitioner::CRConnectivity_cellParts()
       }
 
       _cellParts.at(id)->finishAdd();
-      _partCells.push_back( _cellParts.at(id)->getTranspose() );
    }
 
 
@@ -1271,7 +1568,9 @@ MeshPartitioner::DEBUG_CRConnectivity_cellParts()
 
 }
 
-//construct CRConnectivity faceParts
+//construct CRConnectivity faceParts, partFaces and partNodes
+//only the rows for the faces and nodes of this partition are filled, which is all that is used
+//later, so that they do not hold the connectivity of the whole mesh on every process
 void
 MeshPartitioner::CRConnectivity_faceParts()
 {
@@ -1279,9 +1578,77 @@ MeshPartitioner::CRConnectivity_faceParts()
           _faceCellsGlobal.push_back( &_meshList.at(id)->getAllFaceCells() );
           _faceNodesGlobal.push_back( &_meshList.at(id)->getAllFaceNodes() );
 
-          _faceParts.push_back( _faceCellsGlobal.at(id)->multiply( *_cellParts.at(id), false) );
-          _partFaces.push_back( _faceParts.at(id)->getTranspose() );
-          _partNodes.push_back( _partFaces.at(id)->multiply( *_faceNodesGlobal.at(id), false) );
+          const CRConnectivity& faceCells = *_faceCellsGlobal.at(id);
+          const CRConnectivity& faceNodes = *_faceNodesGlobal.at(id);
+          const CRConnectivity& cellParts = *_cellParts.at(id);
+
+          //faces with at least one cell in this partition, in global order
+          vector<int> localFaces;
+          for ( int face = 0; face < faceCells.getRowDim(); face++ ){
+             for ( int n = 0; n < faceCells.getCount(face); n++ ){
+                if ( cellParts( faceCells(face,n), 0 ) == _procID ){
+                   localFaces.push_back( face );
+                   break;
+                }
+             }
+          }
+          const int nface_local = int( localFaces.size() );
+
+          //faceParts, partitions in the order of the face cells
+          _faceParts.push_back( CRConnectivityPtr( new CRConnectivity( faceCells.getRowSite(), *_partSite.at(id) ) ) );
+          CRConnectivity& faceParts = *_faceParts.at(id);
+          faceParts.initCount();
+          for ( int n = 0; n < nface_local; n++ ){
+             const int face = localFaces[n];
+             set<int> parts;
+             for ( int c = 0; c < faceCells.getCount(face); c++ )
+                parts.insert( cellParts( faceCells(face,c), 0 ) );
+             faceParts.addCount( face, int(parts.size()) );
+          }
+          faceParts.finishCount();
+          for ( int n = 0; n < nface_local; n++ ){
+             const int face = localFaces[n];
+             set<int> parts;
+             for ( int c = 0; c < faceCells.getCount(face); c++ ){
+                const int part = cellParts( faceCells(face,c), 0 );
+                if ( parts.insert(part).second )
+                   faceParts.add( face, part );
+             }
+          }
+          faceParts.finishAdd();
+
+          //partFaces
+          _partFaces.push_back( CRConnectivityPtr( new CRConnectivity( *_partSite.at(id), faceCells.getRowSite() ) ) );
+          CRConnectivity& partFaces = *_partFaces.at(id);
+          partFaces.initCount();
+          partFaces.addCount( _procID, nface_local );
+          partFaces.finishCount();
+          for ( int n = 0; n < nface_local; n++ )
+             partFaces.add( _procID, localFaces[n] );
+          partFaces.finishAdd();
+
+          //partNodes, nodes in the order they are first reached from the faces
+          vector<int> localNodes;
+          vector<bool> marker( faceNodes.getColDim(), false );
+          for ( int n = 0; n < nface_local; n++ ){
+             const int face = localFaces[n];
+             for ( int node = 0; node < faceNodes.getCount(face); node++ ){
+                const int nodeID = faceNodes(face,node);
+                if ( !marker[nodeID] ){
+                   marker[nodeID] = true;
+                   localNodes.push_back( nodeID );
+                }
+             }
+          }
+
+          _partNodes.push_back( CRConnectivityPtr( new CRConnectivity( *_partSite.at(id), faceNodes.getColSite() ) ) );
+          CRConnectivity& partNodes = *_partNodes.at(id);
+          partNodes.initCount();
+          partNodes.addCount( _procID, int(localNodes.size()) );
+          partNodes.finishCount();
+          for ( int n = 0; n < int(localNodes.size()); n++ )
+             partNodes.add( _procID, localNodes[n] );
+          partNodes.finishAdd();
     }
 
     if ( _debugMode )
@@ -17,6 +17,8 @@
 
 using namespace std;
 
+class Field;
+
 //Warning globalToLocal seems have a bug..........
 
 class MeshPartitioner{
@@ -37,7 +39,7 @@ public:
                 WEIGHTS_BOTH_VERTICES_EDGES = 3};
     enum NUMFLAG{ C_STYLE = 0, FORTRAN_STYLE = 1 };
     enum CELLTYPE{ INTERIOR = 1, GHOST_BOUNDARY_CELL = 2, GHOST_INTERFACE_CELL};
-    enum PARTTYPE{ PARMETIS = 1, FIEDLER =2};
+    enum PARTTYPE{ PARMETIS = 1, FIEDLER =2, PARMETIS_ADAPTIVE = 3};
 
    explicit MeshPartitioner( const MeshList& mesh_list, vector<int> npart, vector<int> eType);
    ~MeshPartitioner();
@@ -61,6 +63,40 @@ public:
     void setWeightType( int weight_type );
     void setNumFlag( int num_flag);
 
+    /**
+     * costs of the cells of the (global) mesh used as ParMETIS vertex
+     * weights, ncon values per cell for a multi-constraint partition,
+     * e.g. the solve cost of each cell and a flag for the IB fluid
+     * cells. Measured timings can be used as well; each constraint is
+     * scaled to integers before partitioning.
+     */
+    void setCellWeights( const ArrayBase& weights, int ncon );
+
+    /**
+     * makes partition() adapt the partition of the given local meshes,
+     * created by another partitioner of the same mesh, with ParMETIS
+     * adaptive repartitioning instead of starting from scratch, so that
+     * only the cells needed to restore the balance are moved.
+     *
+     * Like the rest of MeshPartitioner this needs the global mesh on every
+     * process: the cell graph given to ParMETIS is taken from it and the
+     * previous partition is gathered into an array over all its cells.
+     * Repartitioning a mesh that only fits in memory as slices, as read
+     * for DistributedMeshPartitioner, is therefore not possible this way.
+     */
+    void setPreviousPartition( const MeshList& localMeshes );
+
+    /**
+     * moves the cell arrays of the field from the local meshes of one
+     * partition of a mesh to those of another, including the values of
+     * the boundary and interface ghost cells. The values are sent
+     * straight from their old owners to the processes that need them
+     * with all-to-all exchanges, so no process stores data for the
+     * whole mesh.
+     */
+    static void migrateField( Field& field, const MeshList& fromMeshes,
+                              const MeshList& toMeshes );
+
     //clean up memory 
     void cleanup();
     void isCleanup(bool clean_up) { _cleanup = clean_up;  }
@@ -101,12 +137,15 @@ private:
    void compute_elem_dist();
    void elem_connectivity();
    void parmetis_mesh();
+   void parmetis_adaptive_repart();
+   void set_ncon( int id, int ncon );
    void fiedler_partition();
    int  get_local_nodes(int id);
    void set_eptr_eind(int id);
    void map_part_elms();
    void count_elems_part();
    void exchange_part_elems();
+   void part_elem_counts( int id, vector<int>& sendCounts, vector<int>& recvCounts );
    void shift_sum_row();
    void mesh_setup();
    int global_offset();
@@ -176,6 +215,8 @@ private:
    vector< int > _eType;
    vector< float* > _tpwgts;
    vector< float* > _ubvec;
+   vector< ArrayIntPtr > _cellWeights;   //scaled weights of all cells, ncon per cell
+   vector< ArrayIntPtr > _prevCellParts; //partition adapted by PARMETIS_ADAPTIVE
    int _options;
    int _procID;
    //output variables
@@ -214,9 +255,8 @@ private:
    vector< CRConnectivityPtr >  _faceNodesOrdered;
 
    vector< CRConnectivityPtr >  _cellParts;
-   vector< CRConnectivityPtr >  _partCells;
-   vector< CRConnectivityPtr >  _faceParts; 
-   vector< CRConnectivityPtr >  _partFaces; //transpose of _faceParts
+   vector< CRConnectivityPtr >  _faceParts; //rows of the faces of this partition only
+   vector< CRConnectivityPtr >  _partFaces; //transpose of _faceParts (rows of this partition only)
    vector< CRConnectivityPtr >  _partNodes;
 
 
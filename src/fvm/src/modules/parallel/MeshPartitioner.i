@@ -1,11 +1,14 @@
 %{
 #include "MeshPartitioner.h"
+#include "Field.h"
 #include "mpi.h"
 %}
 
 %include "std_vector.i"
 %include "std_string.i"
 %import "Mesh.i"
+%import "ArrayBase.i"
+%import "Field.i"
 using namespace std;
 
 
@@ -13,6 +16,7 @@ class MeshPartitioner{
 
 public:
 
+    enum PARTTYPE{ PARMETIS = 1, FIEDLER =2, PARMETIS_ADAPTIVE = 3};
     enum ETYPE{ TRI = 1, TETRA = 2, HEXA = 3, QUAD = 4 };
     enum WTYPE{ NOWEIGHTS = 0, WEIGHTS_ONLY_EDGES = 1, WEIGTHS_ONLY_VERTICES  = 2,
                 WEIGHTS_BOTH_VERTICES_EDGES = 3};
@@ -60,6 +64,10 @@ public:
     // set property methods
     void setWeightType(MeshPartitioner::WTYPE weight_type);
     void setNumFlag(MeshPartitioner::NUMFLAG num_flag);
+    void setCellWeights(const ArrayBase& weights, int ncon);
+    void setPreviousPartition(const MeshList& localMeshes);
+    static void migrateField(Field& field, const MeshList& fromMeshes,
+                             const MeshList& toMeshes);
  
 };
 
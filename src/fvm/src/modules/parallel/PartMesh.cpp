@@ -24,7 +24,7 @@
 PartMesh::PartMesh( const MeshList &mesh_list, vector<int> nPart,  vector<int> eType ):
 _meshList(mesh_list), _nPart(nPart), _eType(eType), _options(0)
 {
-   if ( !MPI::Is_initialized() )  MPI::Init();
+   if ( !MPI::Is_initialized() )  MPI::Init_thread( MPI::THREAD_MULTIPLE );
    init();
    assert( _meshList.size() == 1 );
 }
@@ -5,7 +5,11 @@
 %{
   #include "PartMesh.h"
   #include "MeshPartitioner.h"
+  #include "FieldCheckpoint.h"
+  #include "DistributedMeshPartitioner.h"
 %}
 
 %include "PartMesh.i"
 %include "MeshPartitioner.i"
+%include "FieldCheckpoint.i"
+%include "DistributedMeshPartitioner.i"
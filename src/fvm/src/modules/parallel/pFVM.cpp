@@ -31,7 +31,7 @@ int main(int argc, char *argv[])
   solver.solve(*ls); */
 
 
-   MPI::Init(argc, argv);
+   MPI::Init_thread(argc, argv, MPI::THREAD_MULTIPLE);
 
    //PartMesh*  partMesh = new PartMesh( MPI::COMM_WORLD.Get_rank() );
 
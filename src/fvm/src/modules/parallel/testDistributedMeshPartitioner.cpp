@@ -0,0 +1,306 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks the parts DistributedMeshPartitioner makes of an n x n x n grid.
+//
+// usage: mpirun -np N testDistributedMeshPartitioner [n]
+
+#include <mpi.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#include "DistributedMeshPartitioner.h"
+#include "CRConnectivity.h"
+#include "MultiField.h"
+
+namespace
+{
+  typedef Vector<double,3> VecD3;
+
+  // the faces normal to x, then to y and then to z, each numbered like
+  // the nodes at their lower corner. Interior faces are in group 1, the
+  // boundary faces in groups 2 to 7 by side
+  struct Grid
+  {
+    explicit Grid(const int n) : n(n) {}
+
+    int getFaceCount() const {return 3*n*n*(n+1);}
+    int getNodeCount() const {return (n+1)*(n+1)*(n+1);}
+    int getCell(const int i, const int j, const int k) const
+    {
+      return i + n*(j + n*k);
+    }
+    int getNode(const int i, const int j, const int k) const
+    {
+      return i + (n+1)*(j + (n+1)*k);
+    }
+    VecD3 getNodeCoords(const int node) const
+    {
+      VecD3 x;
+      x[0] = node%(n+1);
+      x[1] = (node/(n+1))%(n+1);
+      x[2] = node/((n+1)*(n+1));
+      return x;
+    }
+    VecD3 getCellCentroid(const int cell) const
+    {
+      VecD3 x;
+      x[0] = cell%n + 0.5;
+      x[1] = (cell/n)%n + 0.5;
+      x[2] = cell/(n*n) + 0.5;
+      return x;
+    }
+
+    void addFace(MeshSlice& slice, const int face) const
+    {
+      const int perDirection = n*n*(n+1);
+      const int d = face/perDirection;
+      int r = face%perDirection;
+      // the position along d, then the other two in cyclic order
+      int ijk[3];
+      ijk[d] = r/(n*n);
+      r %= n*n;
+      ijk[(d+1)%3] = r%n;
+      ijk[(d+2)%3] = r/n;
+
+      int lower[3] = {ijk[0],ijk[1],ijk[2]};
+      lower[d]--;
+      const int upper = ijk[d] < n ? getCell(ijk[0],ijk[1],ijk[2]) : -1;
+      const int below = ijk[d] > 0 ? getCell(lower[0],lower[1],lower[2]) : -1;
+
+      // the corners going around the normal along d
+      int e1[3] = {0,0,0};
+      int e2[3] = {0,0,0};
+      e1[(d+1)%3] = 1;
+      e2[(d+2)%3] = 1;
+      int nodes[4];
+      nodes[0] = getNode(ijk[0],ijk[1],ijk[2]);
+      nodes[1] = getNode(ijk[0]+e1[0],ijk[1]+e1[1],ijk[2]+e1[2]);
+      nodes[2] = getNode(ijk[0]+e1[0]+e2[0],ijk[1]+e1[1]+e2[1],ijk[2]+e1[2]+e2[2]);
+      nodes[3] = getNode(ijk[0]+e2[0],ijk[1]+e2[1],ijk[2]+e2[2]);
+
+      const bool reverse = below < 0;
+      slice.faceCells.push_back(reverse ? upper : below);
+      slice.faceCells.push_back(reverse ? below : upper);
+      for(int m=0; m<4; m++)
+        slice.faceNodesCol.push_back(nodes[reverse ? 3-m : m]);
+      slice.faceNodesRow.push_back(int(slice.faceNodesCol.size()));
+      if (below >= 0 && upper >= 0)
+        slice.faceGroups.push_back(1);
+      else
+        slice.faceGroups.push_back(2 + 2*d + (upper < 0));
+    }
+
+    void createSlice(MeshSlice& slice, const int rank, const int nProcs) const
+    {
+      slice.dimension = 3;
+      slice.cellCount = n*n*n;
+      const int nFaces = getFaceCount();
+      for(int f=(rank*nFaces)/nProcs; f<((rank+1)*nFaces)/nProcs; f++)
+        addFace(slice,f);
+
+      const int nNodes = getNodeCount();
+      slice.nodeOffset = (rank*nNodes)/nProcs;
+      for(int v=slice.nodeOffset; v<((rank+1)*nNodes)/nProcs; v++)
+        slice.coords.push_back(getNodeCoords(v));
+
+      slice.groupTypes[1] = "interior";
+      for(int g=2; g<8; g++)
+        slice.groupTypes[g] = g == 2 ? "velocity-inlet" : "wall";
+    }
+
+    const int n;
+  };
+
+  // the cells of all the parts, counted by the processes that have the
+  // blocks they are in, so that none of them has all the cells
+  int countMisplacedCells(const Mesh& mesh, const int nCells)
+  {
+    const int nProcs = MPI::COMM_WORLD.Get_size();
+    const int rank = MPI::COMM_WORLD.Get_rank();
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+
+    vector<int> sendCounts(nProcs,0);
+    for(int c=0; c<cells.getSelfCount(); c++)
+      sendCounts[(localToGlobal[c]*nProcs)/nCells]++;
+    vector<int> sendDispls(nProcs,0);
+    for(int p=1; p<nProcs; p++)
+      sendDispls[p] = sendDispls[p-1] + sendCounts[p-1];
+    vector<int> sendCells(cells.getSelfCount()+1);
+    vector<int> next(sendDispls);
+    for(int c=0; c<cells.getSelfCount(); c++)
+      sendCells[next[(localToGlobal[c]*nProcs)/nCells]++] = localToGlobal[c];
+
+    vector<int> recvCounts(nProcs);
+    MPI::COMM_WORLD.Alltoall(&sendCounts[0],1,MPI::INT,&recvCounts[0],1,MPI::INT);
+    vector<int> recvDispls(nProcs,0);
+    for(int p=1; p<nProcs; p++)
+      recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+    vector<int> recvCells(recvDispls[nProcs-1] + recvCounts[nProcs-1] + 1);
+    MPI::COMM_WORLD.Alltoallv(&sendCells[0],&sendCounts[0],&sendDispls[0],MPI::INT,
+                              &recvCells[0],&recvCounts[0],&recvDispls[0],MPI::INT);
+
+    const int begin = (rank*nCells + nProcs - 1)/nProcs;
+    const int end = ((rank+1)*nCells + nProcs - 1)/nProcs;
+    vector<int> counts(end-begin,0);
+    int nErrors = 0;
+    for(int i=0; i<recvDispls[nProcs-1] + recvCounts[nProcs-1]; i++)
+    {
+        if (recvCells[i] < begin || recvCells[i] >= end)
+          nErrors++;
+        else
+          counts[recvCells[i]-begin]++;
+    }
+    for(int i=0; i<end-begin; i++)
+      if (counts[i] != 1)
+        nErrors++;
+    return nErrors;
+  }
+
+  // the faces, their groups and their geometry
+  int countWrongFaces(Mesh& mesh, const Grid& grid, int faceCounts[3])
+  {
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+    const Array<VecD3>& coords = mesh.getNodeCoordinates();
+    const Array<int>& localToGlobalNodes = *mesh.getLocalToGlobalNodesPtr();
+    const CRConnectivity& faceCells = mesh.getAllFaceCells();
+    const CRConnectivity& faceNodes = mesh.getAllFaceNodes();
+    const int nCells = grid.n*grid.n*grid.n;
+
+    int nErrors = 0;
+    for(int v=0; v<coords.getLength(); v++)
+    {
+        const VecD3 x = grid.getNodeCoords(localToGlobalNodes[v]);
+        if (coords[v][0] != x[0] || coords[v][1] != x[1] || coords[v][2] != x[2])
+          nErrors++;
+    }
+
+    faceCounts[0] = mesh.getInteriorFaceGroup().site.getCount();
+    faceCounts[1] = 0;
+    faceCounts[2] = 0;
+    foreach(const FaceGroupPtr fgPtr, mesh.getBoundaryFaceGroups())
+    {
+        const StorageSite& faces = fgPtr->site;
+        faceCounts[1] += faces.getCount();
+        if (fgPtr->groupType != (fgPtr->id == 2 ? "velocity-inlet" : "wall"))
+          nErrors++;
+        for(int f=faces.getOffset(); f<faces.getOffset()+faces.getCount(); f++)
+          if (localToGlobal[faceCells(f,1)] < nCells ||
+              faceCells(f,1) < cells.getSelfCount())
+            nErrors++;
+    }
+    foreach(const FaceGroupPtr fgPtr, mesh.getInterfaceGroups())
+      faceCounts[2] += fgPtr->site.getCount();
+
+    for(int f=0; f<faceCells.getRowDim(); f++)
+    {
+        VecD3 centroid = VecD3::getZero();
+        for(int m=0; m<4; m++)
+          centroid += coords[faceNodes(f,m)]*0.25;
+        const VecD3 d0 = coords[faceNodes(f,2)] - coords[faceNodes(f,0)];
+        const VecD3 d1 = coords[faceNodes(f,3)] - coords[faceNodes(f,1)];
+        const VecD3 area = cross(d0,d1)*0.5;
+
+        const VecD3 toFace = centroid - grid.getCellCentroid(localToGlobal[faceCells(f,0)]);
+        if (fabs(mag(area) - 1.0) > 1e-12 || fabs(mag(toFace) - 0.5) > 1e-12 ||
+            dot(area,toFace) < 0.5 - 1e-12)
+          nErrors++;
+
+        const int global1 = localToGlobal[faceCells(f,1)];
+        if (global1 < nCells)
+        {
+            const VecD3 across = grid.getCellCentroid(global1) - centroid;
+            if (fabs(mag(across) - 0.5) > 1e-12 || dot(area,across) < 0.5 - 1e-12)
+              nErrors++;
+        }
+    }
+    return nErrors;
+  }
+
+  // the global ids of the cells synced into the ghosts of both layers
+  int countWrongGhosts(const Mesh& mesh)
+  {
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+
+    Field ids("ids");
+    shared_ptr<Array<double> > a(new Array<double>(cells.getCountLevel1()));
+    *a = -1.0;
+    for(int c=0; c<cells.getSelfCount(); c++)
+      (*a)[c] = localToGlobal[c];
+    // the boundary ghosts are not synced
+    foreach(const FaceGroupPtr fgPtr, mesh.getBoundaryFaceGroups())
+    {
+        const StorageSite& faces = fgPtr->site;
+        const CRConnectivity& faceCells = mesh.getFaceCells(faces);
+        for(int f=0; f<faces.getCount(); f++)
+          (*a)[faceCells(f,1)] = localToGlobal[faceCells(f,1)];
+    }
+
+    MultiField::ArrayIndex index(&ids,&cells);
+    MultiField mf;
+    mf.addArray(index,a);
+    mf.sync();
+
+    int nErrors = 0;
+    for(int c=0; c<cells.getCountLevel1(); c++)
+      if ((*a)[c] != localToGlobal[c])
+        nErrors++;
+    return nErrors;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  MPI::Init(argc,argv);
+
+  const int n = argc > 1 ? atoi(argv[1]) : 12;
+  const int rank = MPI::COMM_WORLD.Get_rank();
+  const int nProcs = MPI::COMM_WORLD.Get_size();
+
+  Grid grid(n);
+  int nFailed = 0;
+  {
+      MeshSlice slice;
+      grid.createSlice(slice,rank,nProcs);
+
+      DistributedMeshPartitioner partitioner(slice);
+      partitioner.partition();
+      partitioner.mesh();
+      Mesh& mesh = *partitioner.meshList().at(0);
+
+      int counts[6];
+      counts[0] = countMisplacedCells(mesh,n*n*n);
+      counts[1] = countWrongFaces(mesh,grid,&counts[3]);
+      counts[2] = countWrongGhosts(mesh);
+      MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,counts,6,MPI::INT,MPI::SUM);
+
+      const bool facesOK = counts[3] + counts[4] + counts[5]/2 == grid.getFaceCount() &&
+        counts[4] == 6*n*n && counts[5]%2 == 0;
+      const char* labels[3] = {"misplaced cells", "wrong faces", "wrong ghost cells"};
+      for(int i=0; i<3; i++)
+      {
+          if (rank == 0)
+            cout << labels[i] << ": " << counts[i]
+                 << (counts[i] == 0 ? "" : "  FAILED") << endl;
+          if (counts[i] != 0)
+            nFailed++;
+      }
+      if (rank == 0)
+        cout << "faces: " << counts[3] << " interior, " << counts[4]
+             << " boundary, " << counts[5] << " interface"
+             << (facesOK ? "" : "  FAILED") << endl;
+      if (!facesOK)
+        nFailed++;
+  }
+
+  MPI::Finalize();
+  return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks FieldCheckpoint restarts on every number of processes up to N.
+//
+// usage: mpirun -np N testFieldCheckpoint [nCells] [fileName]
+
+#include <mpi.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+
+#include "FieldCheckpoint.h"
+#include "Array.h"
+#include "Vector.h"
+#include "CRConnectivity.h"
+
+namespace
+{
+  typedef Vector<double,3> VecD3;
+
+  // the block of cells of a strip of nGlobal cells owned by part; the
+  // boundary ghosts are numbered nGlobal and nGlobal+1
+  Mesh* createPartMesh(const int nGlobal, const int nParts, const int part)
+  {
+    const int lo = (part*nGlobal)/nParts;
+    const int hi = ((part+1)*nGlobal)/nParts;
+    const int nSelf = hi - lo;
+
+    Mesh* mesh = new Mesh(1);
+    StorageSite& faces = mesh->getFaces();
+    StorageSite& cells = mesh->getCells();
+    faces.setCount(nSelf+1);
+    cells.setCount(nSelf,2);
+
+    mesh->createInteriorFaceGroup(nSelf-1);
+    if (lo == 0)
+      mesh->createBoundaryFaceGroup(1,nSelf-1,1,"wall");
+    else
+      mesh->createInterfaceGroup(1,nSelf-1,part-1);
+    if (hi == nGlobal)
+      mesh->createBoundaryFaceGroup(1,nSelf,2,"wall");
+    else
+      mesh->createInterfaceGroup(1,nSelf,part+1);
+
+    shared_ptr<CRConnectivity> faceCells(new CRConnectivity(faces,cells));
+    faceCells->initCount();
+    for(int f=0; f<=nSelf; f++)
+      faceCells->addCount(f,2);
+    faceCells->finishCount();
+    for(int f=0; f<nSelf-1; f++)
+    {
+        faceCells->add(f,f);
+        faceCells->add(f,f+1);
+    }
+    faceCells->add(nSelf-1,0);
+    faceCells->add(nSelf-1,nSelf);
+    faceCells->add(nSelf,nSelf-1);
+    faceCells->add(nSelf,nSelf+1);
+    faceCells->finishAdd();
+    mesh->setFaceCells(faceCells);
+
+    mesh->createLocalGlobalArray();
+    Array<int>& localToGlobal = mesh->getLocalToGlobal();
+    for(int i=0; i<nSelf; i++)
+      localToGlobal[i] = lo + i;
+    localToGlobal[nSelf] = lo == 0 ? nGlobal : lo - 1;
+    localToGlobal[nSelf+1] = hi == nGlobal ? nGlobal + 1 : hi;
+    return mesh;
+  }
+
+  double scalarValue(const int meshID, const int globalID)
+  {
+    return 1000.0*(meshID+1) + globalID;
+  }
+
+  VecD3 vectorValue(const int meshID, const int globalID)
+  {
+    VecD3 v;
+    v[0] = globalID;
+    v[1] = -2.0*globalID;
+    v[2] = meshID + 0.5;
+    return v;
+  }
+
+  struct Model
+  {
+    MeshList meshes;
+    Field temperature;
+    Field velocity;
+    Field other;
+
+    Model(const int nGlobal, const int nParts, const int part) :
+      meshes(),
+      temperature("temperature"),
+      velocity("velocity"),
+      other("other")
+    {
+        meshes.push_back(createPartMesh(nGlobal,nParts,part));
+        meshes.push_back(createPartMesh(nGlobal/2+3,nParts,part));
+        for(int id=0; id<int(meshes.size()); id++)
+        {
+            const StorageSite& cells = meshes[id]->getCells();
+            const int n = cells.getCount();
+            temperature.addArray(cells,
+                                 shared_ptr<ArrayBase>(new Array<double>(n)));
+            velocity.addArray(cells,
+                              shared_ptr<ArrayBase>(new Array<VecD3>(n)));
+            other.addArray(cells,shared_ptr<ArrayBase>(new Array<double>(n)));
+        }
+    }
+
+    ~Model()
+    {
+        for(int id=0; id<int(meshes.size()); id++)
+          delete meshes[id];
+    }
+
+    void setValues(const bool written)
+    {
+        for(int id=0; id<int(meshes.size()); id++)
+        {
+            const StorageSite& cells = meshes[id]->getCells();
+            const Array<int>& localToGlobal = meshes[id]->getLocalToGlobal();
+            Array<double>& t = dynamic_cast<Array<double>&>(temperature[cells]);
+            Array<VecD3>& v = dynamic_cast<Array<VecD3>&>(velocity[cells]);
+            Array<double>& o = dynamic_cast<Array<double>&>(other[cells]);
+            for(int c=0; c<cells.getCount(); c++)
+            {
+                const int g = localToGlobal[c];
+                t[c] = written ? scalarValue(id,g) : -1.0;
+                v[c] = written ? vectorValue(id,g) : VecD3::getZero();
+                o[c] = -3.0;
+            }
+        }
+    }
+
+    int countErrors()
+    {
+        int nErrors = 0;
+        for(int id=0; id<int(meshes.size()); id++)
+        {
+            const StorageSite& cells = meshes[id]->getCells();
+            const Array<int>& localToGlobal = meshes[id]->getLocalToGlobal();
+            const Array<double>& t =
+              dynamic_cast<const Array<double>&>(temperature[cells]);
+            const Array<VecD3>& v =
+              dynamic_cast<const Array<VecD3>&>(velocity[cells]);
+            const Array<double>& o =
+              dynamic_cast<const Array<double>&>(other[cells]);
+            for(int c=0; c<cells.getCount(); c++)
+            {
+                const int g = localToGlobal[c];
+                const VecD3 vExpected = vectorValue(id,g);
+                if (t[c] != scalarValue(id,g) || o[c] != -3.0 ||
+                    v[c][0] != vExpected[0] || v[c][1] != vExpected[1] ||
+                    v[c][2] != vExpected[2])
+                  nErrors++;
+            }
+        }
+        return nErrors;
+    }
+  };
+}
+
+int main(int argc, char *argv[])
+{
+  MPI::Init(argc,argv);
+
+  const int nGlobal = argc > 1 ? atoi(argv[1]) : 1000;
+  const string fileName = argc > 2 ? argv[2] : "testFieldCheckpoint.dat";
+
+  const int rank = MPI::COMM_WORLD.Get_rank();
+  const int nProcs = MPI::COMM_WORLD.Get_size();
+
+  int nFailed = 0;
+  for(int nWrite=1; nWrite<=nProcs; nWrite++)
+  {
+      MPI::Intracomm writeComm =
+        MPI::COMM_WORLD.Split(rank < nWrite ? 0 : MPI::UNDEFINED, rank);
+      if (rank < nWrite)
+      {
+          Model model(nGlobal,nWrite,rank);
+          model.setValues(true);
+          FieldCheckpoint checkpoint(model.meshes,writeComm);
+          checkpoint.addField(model.temperature);
+          checkpoint.addField(model.velocity);
+          checkpoint.write(fileName);
+          writeComm.Free();
+      }
+      MPI::COMM_WORLD.Barrier();
+
+      for(int nRead=1; nRead<=nProcs; nRead++)
+        for(int collective=1; collective>=0; collective--)
+        {
+            MPI::Intracomm readComm =
+              MPI::COMM_WORLD.Split(rank < nRead ? 0 : MPI::UNDEFINED, rank);
+            int nErrors = 0;
+            if (rank < nRead)
+            {
+                Model model(nGlobal,nRead,rank);
+                model.setValues(false);
+                FieldCheckpoint checkpoint(model.meshes,readComm);
+                checkpoint.collectiveRead = collective == 1;
+                checkpoint.addField(model.temperature);
+                checkpoint.addField(model.velocity);
+                checkpoint.addField(model.other);
+                checkpoint.read(fileName);
+                nErrors = model.countErrors();
+                readComm.Free();
+            }
+            MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,&nErrors,1,
+                                      MPI::INT,MPI::SUM);
+
+            if (rank == 0)
+              cout << "written on " << nWrite << ", read on " << nRead
+                   << (collective ? " collectively" : " independently")
+                   << ": " << nErrors << " wrong cells"
+                   << (nErrors == 0 ? "" : "  FAILED") << endl;
+            if (nErrors > 0)
+              nFailed++;
+        }
+  }
+
+  if (rank == 0)
+    remove(fileName.c_str());
+
+  MPI::Finalize();
+  return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks that migrateField moves a field to the meshes of an adapted partition.
+//
+// usage: mpirun -np N testMeshRepartition [n]
+
+#include <mpi.h>
+
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+#include "MeshPartitioner.h"
+#include "CRConnectivity.h"
+#include "SquareGrid.h"
+#include "MultiField.h"
+
+namespace
+{
+  // the global ids in the owned and boundary ghost cells, synced into the
+  // interface ghosts
+  void setGlobalIDs(Field& ids, const Mesh& mesh)
+  {
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+    const CRConnectivity& faceCells = mesh.getAllFaceCells();
+
+    shared_ptr<Array<double> > a(new Array<double>(cells.getCountLevel1()));
+    *a = -1.0;
+    for(int c=0; c<cells.getSelfCount(); c++)
+      (*a)[c] = localToGlobal[c];
+    foreach(const FaceGroupPtr fgPtr, mesh.getBoundaryFaceGroups())
+    {
+        const StorageSite& faces = fgPtr->site;
+        for(int f=faces.getOffset(); f<faces.getOffset()+faces.getCount(); f++)
+          (*a)[faceCells(f,1)] = localToGlobal[faceCells(f,1)];
+    }
+    ids.addArray(cells,a);
+    ids.syncLocal();
+  }
+
+  int countWrongValues(const Field& ids, const Mesh& mesh)
+  {
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+    if (!ids.hasArray(cells))
+      return cells.getCountLevel1();
+
+    const Array<double>& a = dynamic_cast<const Array<double>&>(ids[cells]);
+    int nErrors = 0;
+    if (a.getLength() != cells.getCountLevel1())
+      nErrors++;
+    for(int c=0; c<cells.getCountLevel1() && c<a.getLength(); c++)
+      if (a[c] != localToGlobal[c])
+        nErrors++;
+    return nErrors;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  MPI::Init(argc,argv);
+
+  const int n = argc > 1 ? atoi(argv[1]) : 24;
+  const int rank = MPI::COMM_WORLD.Get_rank();
+  const int nProcs = MPI::COMM_WORLD.Get_size();
+
+  int nFailed = 0;
+  {
+      MeshList globalMeshes;
+      globalMeshes.push_back(createSquareGrid(n));
+      vector<int> nParts(1,nProcs);
+      vector<int> eTypes(1,MeshPartitioner::QUAD);
+
+      MeshPartitioner partitioner(globalMeshes,nParts,eTypes);
+      partitioner.setWeightType(0);
+      partitioner.setNumFlag(0);
+      partitioner.partition();
+      partitioner.mesh();
+      const MeshList& fromMeshes = partitioner.meshList();
+
+      Field ids("ids");
+      Field unused("unused");
+      setGlobalIDs(ids,*fromMeshes.at(0));
+
+      // the lower half of the grid becomes four times as expensive
+      Array<double> weights(n*n);
+      for(int c=0; c<n*n; c++)
+        weights[c] = c < n*n/2 ? 4.0 : 1.0;
+
+      MeshList globalMeshes2;
+      globalMeshes2.push_back(createSquareGrid(n));
+      MeshPartitioner repartitioner(globalMeshes2,nParts,eTypes);
+      repartitioner.setWeightType(0);
+      repartitioner.setNumFlag(0);
+      repartitioner.setCellWeights(weights,1);
+      repartitioner.setPreviousPartition(fromMeshes);
+      repartitioner.partition();
+      repartitioner.mesh();
+      const MeshList& toMeshes = repartitioner.meshList();
+
+      MeshPartitioner::migrateField(ids,fromMeshes,toMeshes);
+      MeshPartitioner::migrateField(unused,fromMeshes,toMeshes);
+
+      Field partial("partial");
+      const StorageSite& fromCells = fromMeshes.at(0)->getCells();
+      if (rank == 0)
+        partial.addArray(fromCells,shared_ptr<ArrayBase>
+                         (new Array<double>(fromCells.getCountLevel1())));
+      bool refused = false;
+      try
+      {
+          MeshPartitioner::migrateField(partial,fromMeshes,toMeshes);
+      }
+      catch (CException&)
+      {
+          refused = true;
+      }
+
+      const Mesh& toMesh = *toMeshes.at(0);
+      const StorageSite& toCells = toMesh.getCells();
+      int counts[6];
+      counts[0] = countWrongValues(ids,toMesh);
+      counts[1] = ids.hasArray(fromCells) ? 1 : 0;
+      counts[2] = unused.hasArray(toCells) ? 1 : 0;
+      counts[3] = refused || nProcs == 1 ? 0 : 1;
+      counts[4] = fromCells.getSelfCount();
+      counts[5] = toCells.getSelfCount();
+
+      vector<int> allCounts(6*nProcs);
+      MPI::COMM_WORLD.Allgather(counts,6,MPI::INT,&allCounts[0],6,MPI::INT);
+
+      int sums[4] = {0,0,0,0};
+      for(int p=0; p<nProcs; p++)
+        for(int i=0; i<4; i++)
+          sums[i] += allCounts[6*p+i];
+
+      const char* labels[4] = {"wrong migrated values", "arrays left on the old meshes",
+                               "arrays created for a field without any",
+                               "processes migrating a field missing elsewhere"};
+      for(int i=0; i<4; i++)
+      {
+          if (rank == 0)
+            cout << labels[i] << ": " << sums[i]
+                 << (sums[i] == 0 ? "" : "  FAILED") << endl;
+          if (sums[i] != 0)
+            nFailed++;
+      }
+      if (rank == 0)
+        for(int p=0; p<nProcs; p++)
+          cout << "process " << p << ": " << allCounts[6*p+4] << " cells before, "
+               << allCounts[6*p+5] << " after" << endl;
+
+      delete globalMeshes[0];
+      delete globalMeshes2[0];
+  }
+
+  MPI::Finalize();
+  return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// This file os part of FVM
+// Copyright (c) 2012 FVM Authors
+// See LICENSE file for terms.
+
+// Checks Mesh::reorder on the meshes MeshPartitioner makes of an n x n grid.
+//
+// usage: mpirun -np N testPartitionedMeshReorder [n]
+
+#include <mpi.h>
+
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+#include "MeshPartitioner.h"
+#include "CRConnectivity.h"
+#include "SquareGrid.h"
+#include "GeomFields.h"
+#include "MeshMetricsCalculator.h"
+#include "MeshMetricsCalculator_impl.h"
+
+namespace
+{
+  typedef Vector<double,3> VecD3;
+  typedef Array<VecD3> VecD3Array;
+
+  double meanFaceGap(const Mesh& mesh)
+  {
+    const StorageSite& faces = mesh.getInteriorFaceGroup().site;
+    const CRConnectivity& faceCells = mesh.getAllFaceCells();
+    double gap = 0;
+    for(int f=faces.getOffset(); f<faces.getOffset()+faces.getCount(); f++)
+      gap += abs(faceCells(f,0) - faceCells(f,1));
+    return faces.getCount() > 0 ? gap/faces.getCount() : 0;
+  }
+
+  // the number of owned and interface ghost cells whose synced centroid
+  // is not that of their global cell
+  int countWrongCentroids(const Mesh& mesh, const GeomFields& geomFields,
+                          const int n)
+  {
+    const StorageSite& cells = mesh.getCells();
+    const Array<int>& localToGlobal = mesh.getLocalToGlobal();
+    const VecD3Array& coordinate =
+      dynamic_cast<const VecD3Array&>(geomFields.coordinate[cells]);
+
+    Field centroid("centroid");
+    shared_ptr<VecD3Array> a(new VecD3Array(cells.getCountLevel1()));
+    *a = VecD3::getZero();
+    for(int c=0; c<cells.getSelfCount(); c++)
+      (*a)[c] = coordinate[c];
+    centroid.addArray(cells,a);
+    centroid.syncLocal();
+
+    int nWrong = 0;
+    for(int c=0; c<cells.getCountLevel1(); c++)
+    {
+        const int g = localToGlobal[c];
+        // boundary ghost cells
+        if (g >= n*n)
+          continue;
+        VecD3 expected;
+        expected[0] = (g%n + 0.5)/n;
+        expected[1] = (g/n + 0.5)/n;
+        expected[2] = 0;
+        if (mag((*a)[c] - expected) > 1e-12)
+          nWrong++;
+    }
+    return nWrong;
+  }
+
+  int checkOrdering(const int n, const Mesh::CellOrdering ordering,
+                    const char* name)
+  {
+    const int rank = MPI::COMM_WORLD.Get_rank();
+    const int nProcs = MPI::COMM_WORLD.Get_size();
+
+    MeshList globalMeshes;
+    globalMeshes.push_back(createSquareGrid(n));
+    vector<int> nParts(1,nProcs);
+    vector<int> eTypes(1,MeshPartitioner::QUAD);
+
+    MeshPartitioner partitioner(globalMeshes,nParts,eTypes);
+    partitioner.setWeightType(0);
+    partitioner.setNumFlag(0);
+    partitioner.partition();
+    partitioner.mesh();
+    const MeshList& meshes = partitioner.meshList();
+    Mesh& mesh = *meshes.at(0);
+
+    double gaps[2];
+    gaps[0] = meanFaceGap(mesh);
+    mesh.reorder(ordering);
+    gaps[1] = meanFaceGap(mesh);
+
+    GeomFields geomFields("geom");
+    MeshMetricsCalculator<double> metrics(geomFields,meshes);
+    metrics.init();
+
+    int nWrong = countWrongCentroids(mesh,geomFields,n);
+    MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,&nWrong,1,MPI::INT,MPI::SUM);
+    MPI::COMM_WORLD.Allreduce(MPI::IN_PLACE,gaps,2,MPI::DOUBLE,MPI::SUM);
+
+    if (rank == 0)
+      cout << name << ": mean cell index gap across interior faces "
+           << gaps[0]/nProcs << " before, " << gaps[1]/nProcs << " after, "
+           << nWrong << " wrong centroids"
+           << (nWrong == 0 ? "" : "  FAILED") << endl;
+
+    delete globalMeshes[0];
+    return nWrong == 0 ? 0 : 1;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  MPI::Init(argc,argv);
+
+  const int n = argc > 1 ? atoi(argv[1]) : 24;
+
+  int nFailed = 0;
+  nFailed += checkOrdering(n,Mesh::CELL_ORDER_RCM,"RCM");
+  nFailed += checkOrdering(n,Mesh::CELL_ORDER_HILBERT,"Hilbert");
+
+  MPI::Finalize();
+  return nFailed == 0 ? 0 : 1;
+}
@@ -52,6 +52,7 @@ struct COMETModelOptions : public FloatVarDict<T>
     this->maxNewton=15;
     this->Scattering="SMRT";
     this->Source=false;
+    this->sweepThreads=1;
   }
   
   bool printNormalizedResiduals;
@@ -74,6 +75,9 @@ struct COMETModelOptions : public FloatVarDict<T>
   int maxNewton;
   string Scattering;
   bool Source;
+  // threads sharing each sweep of the smoother; with more than one the
+  // cells are swept one colour at a time, in a different order
+  int sweepThreads;
 
 };
 
@@ -88,8 +88,20 @@ class COMETDiscretizer
     _resArray(kspace.getResArray())
     {}
 
+  /**
+   * Gauss-Seidel sweep over the owned cells with the second order
+   * convection, forward (dir=1) or backward (dir=-1). With sweepThreads
+   * above one the cells are visited by colour instead, see
+   * COMETSolveColored.
+   */
   void COMETSolveFine(const int dir,const int level)
   {
+    if(_options.sweepThreads>1)
+      {
+	COMETSolveColored(dir,level,true);
+	return;
+      }
+
     const int cellcount=_cells.getSelfCount();
     int start;
 
@@ -101,303 +113,368 @@ class COMETDiscretizer
     TArray Bvec(totalmodes+1);
     TArray Resid(totalmodes+1);
     TArrow AMat(totalmodes+1);
-    const T newTol=_options.NewtonTol;
-    const int maxNew=_options.maxNewton;
-    const int minNew=_options.minNewton;
 
     const GradMatrix& gradMatrix=GradModelType::getGradientMatrix(_mesh,_geomFields);
     
     for(int c=start;((c<cellcount)&&(c>-1));c+=dir)
-      {	
-		
-	if(_BCArray[c]==0)  //no reflections at all--interior cell or temperature boundary
+      COMETSolveCellFine(c,level,gradMatrix,Bvec,Resid,AMat);
+  }
+
+  void COMETSolveCoarse(const int dir,const int level)
+  {
+    if(_options.sweepThreads>1)
+      {
+	COMETSolveColored(dir,level,false);
+	return;
+      }
+
+    const int cellcount=_cells.getSelfCount();
+    int start;
+
+    if(dir==1)
+      start=0;
+    if(dir==-1)
+      start=cellcount-1;
+    const int totalmodes=_kspace.gettotmodes();
+    TArray Bvec(totalmodes+1);
+    TArray Resid(totalmodes+1);
+    TArrow AMat(totalmodes+1);
+    
+    for(int c=start;((c<cellcount)&&(c>-1));c+=dir)
+      COMETSolveCellCoarse(c,level,Bvec,Resid,AMat);
+  }
+
+  /**
+   * Multicolour variant of COMETSolveFine and COMETSolveCoarse. The
+   * Newton iterations of a cell change its own values and those of its
+   * boundary and interface ghosts; the first order scheme reads the
+   * neighbours, the second order one their neighbours as well. Cells of
+   * the same colour, at least two cells (coarse) or three cells (fine)
+   * apart, are therefore shared among sweepThreads threads, each with its
+   * own system. The colours are taken in reverse order when dir=-1. The
+   * cells are updated in a different order than in the sequential sweep.
+   */
+  void COMETSolveColored(const int dir,const int level,const bool fine)
+  {
+    const CRConnectivity& cellColors=_mesh.getCellColoring(fine ? 2 : 1);
+    const int nColors=cellColors.getRowDim();
+    const int totalmodes=_kspace.gettotmodes();
+
+    const GradMatrix* gradMatrix=
+      fine ? &GradModelType::getGradientMatrix(_mesh,_geomFields) : 0;
+
+    string error;
+#pragma omp parallel num_threads(_options.sweepThreads)
+    {
+      TArray Bvec(totalmodes+1);
+      TArray Resid(totalmodes+1);
+      TArrow AMat(totalmodes+1);
+
+      for(int n=0;n<nColors;n++)
+	{
+	  const int color=(dir==1) ? n : nColors-1-n;
+	  const int colorCount=cellColors.getCount(color);
+#pragma omp for schedule(dynamic)
+	  for(int i=0;i<colorCount;i++)
+	    {
+	      const int c=cellColors(color,i);
+	      try
+		{
+		  if(fine)
+		    COMETSolveCellFine(c,level,*gradMatrix,Bvec,Resid,AMat);
+		  else
+		    COMETSolveCellCoarse(c,level,Bvec,Resid,AMat);
+		}
+	      catch(std::exception& e)
+		{
+#pragma omp critical
+		  error=e.what();
+		}
+	    }
+	}
+    }
+    if(!error.empty())
+      throw CException(error);
+  }
+
+  void COMETSolveCellFine(const int c, const int level, const GradMatrix& gradMatrix,
+			  TArray& Bvec, TArray& Resid, TArrow& AMat)
+  {
+    const int totalmodes=_kspace.gettotmodes();
+    const T newTol=_options.NewtonTol;
+    const int maxNew=_options.maxNewton;
+    const int minNew=_options.minNewton;
+
+    if(_BCArray[c]==0)  //no reflections at all--interior cell or temperature boundary
+      {
+	T dt=1;
+	int NewtonIters=0;
+
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
-	  
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		
-		Bvec.zero();
-		Resid.zero();
-		AMat.zero();
-		
-		updateGhostFine(c, gradMatrix);
-		COMETConvectionFine(c,AMat,Bvec,gradMatrix);
-		COMETCollision(c,&AMat,Bvec);
-		COMETEquilibrium(c,&AMat,Bvec);
 
-		if(_options.withNormal)
-		  COMETShifted(c,&AMat,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-		
-		Resid=Bvec;
-		AMat.Solve(Bvec);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMat.zero();
 
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		NewtonIters++;
-		dt=fabs(Bvec[totalmodes]);
-	      }
+	    updateGhostFine(c, gradMatrix);
+	    COMETConvectionFine(c,AMat,Bvec,gradMatrix);
+	    COMETCollision(c,&AMat,Bvec);
+	    COMETEquilibrium(c,&AMat,Bvec);
+
+	    if(_options.withNormal)
+	      COMETShifted(c,&AMat,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMat.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
+	    NewtonIters++;
+	    dt=fabs(Bvec[totalmodes]);
 	  }
-	else if(_BCArray[c]==1) //Implicit reflecting boundary only
+      }
+    else if(_BCArray[c]==1) //Implicit reflecting boundary only
+      {
+	T dt=1;
+	int NewtonIters=0;
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		TSquare AMatS(totalmodes+1);
-		Bvec.zero();
-		Resid.zero();
-		AMatS.zero();
-		
-		COMETConvection(c,AMatS,Bvec);
-		COMETCollision(c,&AMatS,Bvec);
-		COMETEquilibrium(c,&AMatS,Bvec);
-		  
-		if(level>0)
-		  addFAS(c,Bvec);
-	       
-		Resid=Bvec;
-		AMatS.Solve(Bvec);
-		
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		NewtonIters++;
-		dt=fabs(Bvec[totalmodes]);
-	      }
+	    TSquare AMatS(totalmodes+1);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMatS.zero();
+
+	    COMETConvection(c,AMatS,Bvec);
+	    COMETCollision(c,&AMatS,Bvec);
+	    COMETEquilibrium(c,&AMatS,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMatS.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
+	    NewtonIters++;
+	    dt=fabs(Bvec[totalmodes]);
 	  }
-	else if(_BCArray[c]==2)  //Explicit boundary only
+      }
+    else if(_BCArray[c]==2)  //Explicit boundary only
+      {
+	T dt=1;
+	int NewtonIters=0;
+	updateGhostFine(c, gradMatrix);
+	//updateGhostCoarse(c);
+
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
-	    updateGhostFine(c, gradMatrix);
-	    //updateGhostCoarse(c);
-	  
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
 
-		Bvec.zero();
-		Resid.zero();
-		AMat.zero();
-		
-		COMETConvectionFine(c,AMat,Bvec,gradMatrix);
-		COMETCollision(c,&AMat,Bvec);
-		COMETEquilibrium(c,&AMat,Bvec);
-		
-		if(_options.withNormal)
-		  COMETShifted(c,&AMat,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-		
-		Resid=Bvec;
-		AMat.Solve(Bvec);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMat.zero();
 
-		Distribute(c,Bvec,Resid);
-		dt=fabs(Bvec[totalmodes]);
-		updatee0(c);
-		updateGhostFine(c, gradMatrix);
-		if(!_FaceToKSC.empty())
-		  correctInterface(c,Bvec);
-		NewtonIters++;
-	      }
+	    COMETConvectionFine(c,AMat,Bvec,gradMatrix);
+	    COMETCollision(c,&AMat,Bvec);
+	    COMETEquilibrium(c,&AMat,Bvec);
+
+	    if(_options.withNormal)
+	      COMETShifted(c,&AMat,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMat.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    dt=fabs(Bvec[totalmodes]);
+	    updatee0(c);
+	    updateGhostFine(c, gradMatrix);
+	    if(!_FaceToKSC.empty())
+	      correctInterface(c,Bvec);
+	    NewtonIters++;
 	  }
-	else if(_BCArray[c]==3) //Mix Implicit/Explicit reflecting boundary
+      }
+    else if(_BCArray[c]==3) //Mix Implicit/Explicit reflecting boundary
+      {
+	T dt=1;
+	int NewtonIters=0;
+	updateGhostFine(c,gradMatrix);
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
-	    updateGhostFine(c,gradMatrix);
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		TSquare AMatS(totalmodes+1);
-		Bvec.zero();
-		Resid.zero();
-		AMatS.zero();
-		
-		COMETConvection(c,AMatS,Bvec);
-		COMETCollision(c,&AMatS,Bvec);
-		COMETEquilibrium(c,&AMatS,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-	       
-		Resid=Bvec;
-		AMatS.Solve(Bvec);
-		
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		updateGhostFine(c, gradMatrix);
-		NewtonIters++;
-		dt=fabs(Bvec[totalmodes]);
-	      }
-	  }
-	else
-	  throw CException("Unexpected value for boundary cell map.");
+	    TSquare AMatS(totalmodes+1);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMatS.zero();
+
+	    COMETConvection(c,AMatS,Bvec);
+	    COMETCollision(c,&AMatS,Bvec);
+	    COMETEquilibrium(c,&AMatS,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
 
+	    Resid=Bvec;
+	    AMatS.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
+	    updateGhostFine(c, gradMatrix);
+	    NewtonIters++;
+	    dt=fabs(Bvec[totalmodes]);
+	  }
       }
-    
+    else
+      throw CException("Unexpected value for boundary cell map.");
   }
 
-  void COMETSolveCoarse(const int dir,const int level)
+  void COMETSolveCellCoarse(const int c, const int level,
+			    TArray& Bvec, TArray& Resid, TArrow& AMat)
   {
-    const int cellcount=_cells.getSelfCount();
-    int start;
-
-    if(dir==1)
-      start=0;
-    if(dir==-1)
-      start=cellcount-1;
     const int totalmodes=_kspace.gettotmodes();
-    TArray Bvec(totalmodes+1);
-    TArray Resid(totalmodes+1);
-    TArrow AMat(totalmodes+1);
     const T newTol=_options.NewtonTol;
     const int maxNew=_options.maxNewton;
     const int minNew=_options.minNewton;
     TArray& Tl=dynamic_cast<TArray&>(_macro.temperature[_cells]);
-    
-    for(int c=start;((c<cellcount)&&(c>-1));c+=dir)
-      {	
-		
-	if(_BCArray[c]==0)  //no reflections at all--interior cell or temperature boundary
+
+    if(_BCArray[c]==0)  //no reflections at all--interior cell or temperature boundary
+      {
+	T dt=1;
+	T rscaled=10;
+	int NewtonIters=0;
+
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    T rscaled=10;
-	    int NewtonIters=0;
-	  
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		
-		Bvec.zero();
-		Resid.zero();
-		AMat.zero();
-		
-		COMETConvectionCoarse(c,AMat,Bvec);
-		COMETCollision(c,&AMat,Bvec);
-		COMETEquilibrium(c,&AMat,Bvec);
-		COMETSource(c,Bvec);
 
-		if(_options.withNormal)
-		  COMETShifted(c,&AMat,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-		
-		Resid=Bvec;
-		AMat.Solve(Bvec);
-		rscaled=scaledResid(Bvec,c);
-		
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		if(!_FaceToKSC.empty())
-		  correctInterface(c,Bvec);
-		NewtonIters++;
-		dt=0.5*fabs(Bvec[totalmodes]/Tl[c])+rscaled*0.5;
-	      }
+	    Bvec.zero();
+	    Resid.zero();
+	    AMat.zero();
 
+	    COMETConvectionCoarse(c,AMat,Bvec);
+	    COMETCollision(c,&AMat,Bvec);
+	    COMETEquilibrium(c,&AMat,Bvec);
+	    COMETSource(c,Bvec);
+
+	    if(_options.withNormal)
+	      COMETShifted(c,&AMat,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMat.Solve(Bvec);
+	    rscaled=scaledResid(Bvec,c);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
+	    if(!_FaceToKSC.empty())
+	      correctInterface(c,Bvec);
+	    NewtonIters++;
+	    dt=0.5*fabs(Bvec[totalmodes]/Tl[c])+rscaled*0.5;
 	  }
-	else if(_BCArray[c]==1) //Implicit reflecting boundary only
+
+      }
+    else if(_BCArray[c]==1) //Implicit reflecting boundary only
+      {
+	T dt=1;
+	int NewtonIters=0;
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		TSquare AMatS(totalmodes+1);
-		Bvec.zero();
-		Resid.zero();
-		AMatS.zero();
-		
-		COMETConvection(c,AMatS,Bvec);
-		COMETCollision(c,&AMatS,Bvec);
-		COMETEquilibrium(c,&AMatS,Bvec);
-		  
-		if(level>0)
-		  addFAS(c,Bvec);
-	       
-		Resid=Bvec;
-		AMatS.Solve(Bvec);
-		
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		NewtonIters++;
-		dt=fabs(Bvec[totalmodes]);
-	      }
+	    TSquare AMatS(totalmodes+1);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMatS.zero();
+
+	    COMETConvection(c,AMatS,Bvec);
+	    COMETCollision(c,&AMatS,Bvec);
+	    COMETEquilibrium(c,&AMatS,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMatS.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
+	    NewtonIters++;
+	    dt=fabs(Bvec[totalmodes]);
 	  }
-	else if(_BCArray[c]==2)  //Explicit boundary only
+      }
+    else if(_BCArray[c]==2)  //Explicit boundary only
+      {
+	T dt=1;
+	T rscaled=10;
+	int NewtonIters=0;
+	updateGhostCoarse(c);
+
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    T rscaled=10;
-	    int NewtonIters=0;
-	    updateGhostCoarse(c);
-	  
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
 
-		Bvec.zero();
-		Resid.zero();
-		AMat.zero();
-		
-		COMETConvectionCoarse(c,AMat,Bvec);
-		COMETCollision(c,&AMat,Bvec);
-		COMETEquilibrium(c,&AMat,Bvec);
-		COMETSource(c,Bvec);
-		
-		if(_options.withNormal)
-		  COMETShifted(c,&AMat,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-		
-		Resid=Bvec;
-		AMat.Solve(Bvec);
-		rscaled=scaledResid(Bvec,c);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMat.zero();
 
-		Distribute(c,Bvec,Resid);
-		dt=0.5*fabs(Bvec[totalmodes]/Tl[c])+0.5*rscaled;
-		updatee0(c);
-		updateGhostCoarse(c);
-		if(!_FaceToKSC.empty())
-		  correctInterface(c,Bvec);
-		NewtonIters++;
-	      }
+	    COMETConvectionCoarse(c,AMat,Bvec);
+	    COMETCollision(c,&AMat,Bvec);
+	    COMETEquilibrium(c,&AMat,Bvec);
+	    COMETSource(c,Bvec);
+
+	    if(_options.withNormal)
+	      COMETShifted(c,&AMat,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMat.Solve(Bvec);
+	    rscaled=scaledResid(Bvec,c);
+
+	    Distribute(c,Bvec,Resid);
+	    dt=0.5*fabs(Bvec[totalmodes]/Tl[c])+0.5*rscaled;
+	    updatee0(c);
+	    updateGhostCoarse(c);
+	    if(!_FaceToKSC.empty())
+	      correctInterface(c,Bvec);
+	    NewtonIters++;
 	  }
-	else if(_BCArray[c]==3) //Mix Implicit/Explicit reflecting boundary
+      }
+    else if(_BCArray[c]==3) //Mix Implicit/Explicit reflecting boundary
+      {
+	T dt=1;
+	int NewtonIters=0;
+	updateGhostCoarse(c);
+	while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
 	  {
-	    T dt=1;
-	    int NewtonIters=0;
+	    TSquare AMatS(totalmodes+1);
+	    Bvec.zero();
+	    Resid.zero();
+	    AMatS.zero();
+
+	    COMETConvection(c,AMatS,Bvec);
+	    COMETCollision(c,&AMatS,Bvec);
+	    COMETEquilibrium(c,&AMatS,Bvec);
+
+	    if(level>0)
+	      addFAS(c,Bvec);
+
+	    Resid=Bvec;
+	    AMatS.Solve(Bvec);
+
+	    Distribute(c,Bvec,Resid);
+	    updatee0(c);
 	    updateGhostCoarse(c);
-	    while((dt>newTol && NewtonIters<maxNew) || NewtonIters<minNew)
-	      {
-		TSquare AMatS(totalmodes+1);
-		Bvec.zero();
-		Resid.zero();
-		AMatS.zero();
-		
-		COMETConvection(c,AMatS,Bvec);
-		COMETCollision(c,&AMatS,Bvec);
-		COMETEquilibrium(c,&AMatS,Bvec);
-		
-		if(level>0)
-		  addFAS(c,Bvec);
-	       
-		Resid=Bvec;
-		AMatS.Solve(Bvec);
-		
-		Distribute(c,Bvec,Resid);
-		updatee0(c);
-		updateGhostCoarse(c);
-		NewtonIters++;
-		dt=fabs(Bvec[totalmodes]);
-	      }
+	    NewtonIters++;
+	    dt=fabs(Bvec[totalmodes]);
 	  }
-	else
-	  throw CException("Unexpected value for boundary cell map.");
-
       }
-    
+    else
+      throw CException("Unexpected value for boundary cell map.");
   }
 
   void COMETSolveFull(const int dir,const int level)
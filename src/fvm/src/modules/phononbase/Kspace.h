@@ -20,6 +20,7 @@
 #include "SquareTensor.h"
 #include "ScatteringKernel.h"
 #include "RelaxationTimeFunction.h"
+#include "SyncPlan.h"
 
 template<class T>
 class DensityOfStates;
@@ -53,6 +54,8 @@ class Kspace
   typedef typename Tkspace::TransmissionMap::iterator TransIt;
   typedef pair<const StorageSite*, const StorageSite*> EntryIndex;
   typedef map<EntryIndex, shared_ptr<ArrayBase> > GhostArrayMap;
+  typedef SyncPlan<const StorageSite*> KspaceSyncPlan;
+  typedef map<const StorageSite*, shared_ptr<KspaceSyncPlan> > SyncPlanMap;
 
  Kspace(T a, T tau, T vgmag, T omega, int ntheta, int nphi, const bool full) :
   _length(ntheta*nphi),
@@ -1290,78 +1293,67 @@ class Kspace
 
   void syncLocal(const StorageSite& site)
   {
+    KspaceSyncPlan& plan = getSyncPlan(site);
+
     //package values to be sent/received
-    syncScatter(site);
-    createSyncGather(site);
+    syncScatter(plan);
+    plan.start();
+    plan.finish();
+    syncGather(plan);
+  }
 
-#ifdef FVM_PARALLEL
-    //SENDING
-    MPI::Request   request_send[get_request_size(site)];
-    MPI::Request   request_recv[get_request_size(site)];
-    int indxSend = 0;
-    int indxRecv = 0;
+  // the ghost arrays and requests for a site are set up the first time
+  // it is synced and reused after that
+  KspaceSyncPlan& getSyncPlan(const StorageSite& site)
+  {
+    typename SyncPlanMap::iterator pos = _syncPlans.find(&site);
+    if (pos != _syncPlans.end())
+      return *pos->second;
+
+    shared_ptr<KspaceSyncPlan> plan(new KspaceSyncPlan());
+    const int totModes=gettotmodes();
 
     const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
     foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
       {
-	const StorageSite&  oSite = *mpos.first;
-	//checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-	EntryIndex e(&site,&oSite);
-	ArrayBase& sendArray = *_ghostArrays[e];
-	int to_where  = oSite.getGatherProcID();
-	if ( to_where != -1 )
-	  {
-	    int mpi_tag = oSite.getTag();
-	    request_send[indxSend++] =  
-	      MPI::COMM_WORLD.Isend( sendArray.getData(), sendArray.getDataSize(), MPI::BYTE, to_where, mpi_tag );
-	  }
+	const StorageSite& oSite = *mpos.first;
+	EntryIndex e(&site, &oSite);
+	const Array<int>& fromIndices = *(mpos.second);
+
+	if (_ghostArrays.find(e) == _ghostArrays.end())
+	  _ghostArrays[e] = _e->newSizedClone( fromIndices.getLength()*totModes);
+
+	plan->addSend(&site, fromIndices, *_ghostArrays[e],
+		      oSite.getGatherProcID(), oSite.getTag());
       }
 
-    //RECIEVING
-    //getting values from other meshes to fill g
     const StorageSite::GatherMap& gatherMap = site.getGatherMap();
     foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
       {
-	const StorageSite&  oSite = *mpos.first;
-	//checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-	EntryIndex e(&oSite,&site);
-	ArrayBase& recvArray = *_ghostArrays[e];
-	int from_where       = oSite.getGatherProcID();
-	if ( from_where != -1 )
-	  {
-	    int mpi_tag = oSite.getTag();
-	    request_recv[indxRecv++] =  
-	      MPI::COMM_WORLD.Irecv( recvArray.getData(), recvArray.getDataSize(), MPI::BYTE, from_where, mpi_tag );
-	  }
-      }
-    
+	const StorageSite& oSite = *mpos.first;
+	EntryIndex e(&oSite, &site);
+	const Array<int>& toIndices = *(mpos.second);
 
-    int count  = get_request_size(site);
-    MPI::Request::Waitall( count, request_recv );
-    MPI::Request::Waitall( count, request_send );
-#endif
+	if (_ghostArrays.find(e) == _ghostArrays.end())
+	  _ghostArrays[e] = _e->newSizedClone(toIndices.getLength()*totModes);
 
-    syncGather(site);
+	plan->addRecv(&site, toIndices, *_ghostArrays[e],
+		      oSite.getGatherProcID(), oSite.getTag());
+      }
 
+    _syncPlans[&site] = plan;
+    return *plan;
   }
 
-  void syncScatter(const StorageSite& site)
+  void syncScatter(const KspaceSyncPlan& plan)
   {
-    const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-
     const int totModes=gettotmodes();
 
-    foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
+    foreach(const typename KspaceSyncPlan::Buffer& b, plan.getSendBuffers())
       {
-	const StorageSite& oSite = *mpos.first;
-	EntryIndex e(&site, &oSite);	
-	const Array<int>& fromIndices = *(mpos.second);
-
-	if (_ghostArrays.find(e) == _ghostArrays.end())
-	  _ghostArrays[e] = _e->newSizedClone( fromIndices.getLength()*totModes);
-
-	const int cellCount = fromIndices.getLength();	 
-	TArray& ghostArray = dynamic_cast<TArray&>(*_ghostArrays[e]);
+	const Array<int>& fromIndices = *b.indices;
+	const int cellCount = fromIndices.getLength();
+	TArray& ghostArray = dynamic_cast<TArray&>(*b.data);
 	
 	int ghostIndex(0);
 	for(int index=0;index<cellCount;index++)
@@ -1379,42 +1371,14 @@ class Kspace
       }
   }
 
-  void createSyncGather(const StorageSite& site)
-  {
-    const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-
-    foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
-      {
-	const StorageSite& oSite = *mpos.first;
-	EntryIndex e(&oSite, &site);
-	const Array<int>& toIndices = *(mpos.second);
-	if (_ghostArrays.find(e) == _ghostArrays.end())
-	  _ghostArrays[e] = _e->newSizedClone(toIndices.getLength()*gettotmodes());
-      }
-
-  }
-  
-  void syncGather(const StorageSite& site)
+  void syncGather(const KspaceSyncPlan& plan)
   {
-    const StorageSite::GatherMap& gatherMap = site.getGatherMap();
-
     const int totModes=gettotmodes();
 
-    foreach(const StorageSite::GatherMap::value_type& mpos, gatherMap)
+    foreach(const typename KspaceSyncPlan::Buffer& b, plan.getRecvBuffers())
       {
-	const StorageSite& oSite = *mpos.first;
-	const Array<int>& toIndices = *(mpos.second);
-	EntryIndex e(&oSite, &site);
-
-	if (_ghostArrays.find(e) == _ghostArrays.end())
-	  {
-	    ostringstream err;
-	    err << "Kspace::syncScatter: ghost array not found for"
-		<< &oSite << endl;
-	    throw CException(err.str());
-	  }
-
-	const TArray& ghostArray=dynamic_cast<const TArray&>(*_ghostArrays[e]);
+	const Array<int>& toIndices = *b.indices;
+	const TArray& ghostArray=dynamic_cast<const TArray&>(*b.data);
 	const int cellCount=toIndices.getLength();
 
 	int ghostIndex(0);
@@ -1434,20 +1398,6 @@ class Kspace
 
   }
 
-  int get_request_size(const StorageSite& site)
-  {
-    int indx(0);
-    const StorageSite::ScatterMap& scatterMap = site.getScatterMap();
-    foreach(const StorageSite::ScatterMap::value_type& mpos, scatterMap)
-      {
-	const StorageSite&  oSite = *mpos.first;
-	//checking if storage site is only site or ghost site, we only communicate ghost site ( oSite.getCount() == -1 ) 
-	if ( oSite.getGatherProcID() != -1 )
-	  indx++;
-      }
-    return indx++;
-  }
-
   void getEquilibriumArray(TArray& vals, const T Tl)
   {
     for(int k=0;k<_length;k++)
@@ -1724,6 +1674,7 @@ class Kspace
   TArrPtr _FASCorrection;
   TArrPtr _Tau;
   GhostArrayMap _ghostArrays;
+  SyncPlanMap _syncPlans;
   TArray _freqArray;
   RelTimeFun<T> _relFun;
   